@@ -21,6 +21,10 @@
 #------------------------------------------------------------------
 #   This file contains the code to perform an orderly shutdown and startup
 #   of the RDKB CCSP components.
+#   Deprecated: rdkbPowerMgr itself stops and starts the units one by one,
+#   over D-Bus or with systemctl, and no longer runs this script. It only
+#   knows the AC, battery and hot/cooled transitions, not the graded
+#   thermal states of the policy.
 #------------------------------------------------------------------
 
 if [ -f /etc/device.properties ]
@@ -32,16 +32,20 @@
  *  Transition from AC to Battery if Device Supports Battery. Note: As of Now this is XBB Battery Only
  *  sysevent set rdkb-power-transition POWER_TRANS_BATTERY
  *
- *  Transition to Thermal Hot:
+ *  Graded thermal levels, each sheds more components than the one before:
+ *  sysevent set rdkb-power-transition POWER_TRANS_WARM
  *  sysevent set rdkb-power-transition POWER_TRANS_HOT
+ *  sysevent set rdkb-power-transition POWER_TRANS_CRITICAL
  *
- *  Transition from Thermal Hot to Thermal Cooled:
+ *  Transition from a thermal level to Thermal Cooled:
  *  sysevent set rdkb-power-transition POWER_TRANS_COOLED
  *
  *  When the transition is complete, the rdkb power state will change:
  *  rdkb-power-state AC
  *  rdkb-power-state BATTERY
+ *  rdkb-power-state ThermalWarm
  *  rdkb-power-state ThermalHot
+ *  rdkb-power-state ThermalCritical
  *  rdkb-power-state ThermalCooled
  *
  */
@@ -50,6 +54,10 @@
 #ifndef _RDKB_POWER_MGR_H_
 #define _RDKB_POWER_MGR_H_
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 typedef enum
 {
     PWRMGR_STATE_UNKNOWN = 0,
@@ -59,6 +67,8 @@ typedef enum
 #endif
     PWRMGR_STATE_HOT,
     PWRMGR_STATE_COOLED,
+    PWRMGR_STATE_WARM,
+    PWRMGR_STATE_CRITICAL,
     PWRMGR_STATE_TOTAL
 } PWRMGR_PwrState;
 
@@ -70,5 +80,12 @@ typedef struct
 } PWRMGR_PwrStateItem;
 
 int PwrMgr_SyseventSetStr(const char *name, unsigned char *value, int bufsz);
+int PwrMgr_Init();
+int PwrMgr_Run();
+void PwrMgr_Term();
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif
@@ -0,0 +1,66 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+/**
+ *  @file pwrMgr_arbiter.h
+ *  @brief RDKB Power Manger power state arbitration
+ *
+ *  The power supply and the temperature are independent: the box can be hot
+ *  while on battery. Each power state belongs to one axis, AC and Battery to
+ *  the supply axis and the thermal levels to the thermal axis. A request only
+ *  moves its own axis, so cooling down while on battery leaves the battery
+ *  constraint in place.
+ *
+ *  The components that run are the union of what every axis sheds: a
+ *  component runs only if the state of each axis runs it. An axis nobody
+ *  has requested yet sits in its unconstrained state, AC or ThermalCooled.
+ */
+
+#ifndef _RDKB_POWER_MGR_ARBITER_H_
+#define _RDKB_POWER_MGR_ARBITER_H_
+
+#include "pwrMgr.h"
+#include "pwrMgr_compgraph.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+    PWRMGR_AXIS_SUPPLY = 0,     // AC or Battery
+    PWRMGR_AXIS_THERMAL,        // ThermalCooled up to ThermalCritical
+    PWRMGR_AXIS_TOTAL
+} PWRMGR_Axis;
+
+typedef struct
+{
+    PWRMGR_PwrState axis[PWRMGR_AXIS_TOTAL];    // State of each axis
+} PWRMGR_PowerVector;
+
+PWRMGR_Axis PwrMgr_Arbiter_Axis(PWRMGR_PwrState state);
+void PwrMgr_Arbiter_Init(PWRMGR_PowerVector *vec, PWRMGR_PwrState state);
+PWRMGR_PwrState PwrMgr_Arbiter_Set(PWRMGR_PowerVector *vec, PWRMGR_PwrState state);
+PWRMGR_PwrState PwrMgr_Arbiter_Get(const PWRMGR_PowerVector *vec, PWRMGR_PwrState state);
+PWRMGR_CompMask PwrMgr_Arbiter_RunMask(const PWRMGR_PowerVector *vec, const PWRMGR_CompMask runMask[PWRMGR_STATE_TOTAL]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
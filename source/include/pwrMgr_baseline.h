@@ -0,0 +1,51 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+/**
+ *  @file pwrMgr_baseline.h
+ *  @brief RDKB Power Manger actuator baseline file
+ *
+ *  The CPU and Wi-Fi actuators keep the settings the first instance of the
+ *  boot found in a file, one line per core or radio, so a restarted
+ *  instance does not take its own caps for the baseline. The file is
+ *  written to a temporary and renamed over, a crash leaves either the old
+ *  file or the new one.
+ */
+
+#ifndef _RDKB_POWER_MGR_BASELINE_H_
+#define _RDKB_POWER_MGR_BASELINE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PWRMGR_BASELINE_LINE_LEN 128
+
+// Parse one line, returns the entry it covers or -1 to skip it
+typedef int (*PWRMGR_BaselineParseFn)(void *ctx, const char *line);
+// Format entry index into buf, newline included
+typedef void (*PWRMGR_BaselineFormatFn)(const void *ctx, int index, char *buf, int len);
+
+int PwrMgr_Baseline_Load(const char *path, int count, PWRMGR_BaselineParseFn parse, void *ctx);
+int PwrMgr_Baseline_Save(const char *path, int count, PWRMGR_BaselineFormatFn format, const void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
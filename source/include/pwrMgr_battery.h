@@ -0,0 +1,111 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+/**
+ *  @file pwrMgr_battery.h
+ *  @brief RDKB Power Manger battery policy
+ *
+ *  Polls the battery through the mta HAL getters while the box runs on
+ *  battery and sheds components in tiers as the projected runtime gets
+ *  shorter. Level 0 is AC, level 1 is on battery, level i + 2 is entered
+ *  once the runtime drops to tierMinutes[i]. Which components each level
+ *  sheds comes from battery_shed in the component graph; CcspMtaAgent is
+ *  not in the graph so voice outlives everything else.
+ *
+ *  The projected runtime is the lower of the HAL estimate and the charge
+ *  divided by a moving average of the measured drain, so it follows the
+ *  lower load once components are shed. Levels only go up while on
+ *  battery, a longer projection after shedding does not restore anything
+ *  until AC is back.
+ *
+ *  Polling is adaptive: every acMs on AC, every batteryMs on battery and
+ *  every fastMs within marginMinutes of the next tier.
+ *
+ *  Like the thermal monitor it is driven by a timerfd, see pwrMgr_thermal.h.
+ */
+
+#ifndef _RDKB_POWER_MGR_BATTERY_H_
+#define _RDKB_POWER_MGR_BATTERY_H_
+
+#include <stdbool.h>
+#include "pwrMgr_compgraph.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PWRMGR_BATTERY_MAX_TIERS (PWRMGR_BATT_SHED_MAX - 1)
+
+typedef struct
+{
+    bool onBattery;
+    long chargeMah;             // Remaining charge, -1 if unknown
+    long capacityMah;           // Actual capacity, -1 if unknown
+    long minutes;               // HAL runtime estimate, -1 if unknown
+} PWRMGR_BatteryReading;
+
+// Battery HAL, backed by mta_hal in the daemon
+typedef struct
+{
+    int (*read)(void *ctx, PWRMGR_BatteryReading *reading);
+} PWRMGR_BatteryOps;
+
+typedef struct
+{
+    int tierMinutes[PWRMGR_BATTERY_MAX_TIERS];  // Descending
+    int tierCount;
+    int acMs;
+    int batteryMs;
+    int fastMs;
+    int marginMinutes;
+} PWRMGR_BatteryConfig;
+
+// The level or the projection changed, minutes and percent are -1 when unknown
+typedef void (*PWRMGR_BatteryFn)(void *ctx, int level, long minutes, int percent);
+
+typedef struct
+{
+    PWRMGR_BatteryConfig cfg;
+    const PWRMGR_BatteryOps *ops;
+    void *opsCtx;
+    PWRMGR_BatteryFn notify;
+    void *ctx;
+    int timerFd;
+    int level;
+    long minutes;               // Projected runtime
+    int percent;
+    long lastChargeMah;
+    long lastSampleMs;
+    double drainMahPerMin;      // Moving average, 0 until measured
+    int intervalMs;
+    unsigned long samples;
+} PWRMGR_BatteryMonitor;
+
+void PwrMgr_Battery_DefaultConfig(PWRMGR_BatteryConfig *cfg);
+int PwrMgr_Battery_Open(PWRMGR_BatteryMonitor *mon, const PWRMGR_BatteryConfig *cfg, const PWRMGR_BatteryOps *ops,
+                        void *opsCtx, PWRMGR_BatteryFn notify, void *ctx);
+int PwrMgr_Battery_Fd(PWRMGR_BatteryMonitor *mon);
+int PwrMgr_Battery_Dispatch(PWRMGR_BatteryMonitor *mon);
+int PwrMgr_Battery_Sample(PWRMGR_BatteryMonitor *mon, long nowMs);
+void PwrMgr_Battery_Close(PWRMGR_BatteryMonitor *mon);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
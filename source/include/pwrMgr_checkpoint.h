@@ -0,0 +1,75 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+/**
+ *  @file pwrMgr_checkpoint.h
+ *  @brief RDKB Power Manger state checkpoint
+ *
+ *  The executor's progress is saved to PWRMGR_CHECKPOINT_FILE: the state
+ *  last reached, the state being worked towards, the state each axis is
+ *  heading for and the components running right now. Each save writes a
+ *  temporary file and renames it over the old one, so a crash leaves
+ *  either the previous or the new checkpoint. A checksum rejects anything
+ *  else.
+ *
+ *  After a restart the daemon carries on from the checkpoint. It does not
+ *  assume AC with everything running, and it only stops or starts the
+ *  components that still differ from the target.
+ *
+ *  PwrMgr_Checkpoint_Lock holds an flock on the pid file for the lifetime
+ *  of the process. A pid file left behind by a crash does not keep the
+ *  service from starting again.
+ */
+
+#ifndef _RDKB_POWER_MGR_CHECKPOINT_H_
+#define _RDKB_POWER_MGR_CHECKPOINT_H_
+
+#include <stdint.h>
+#include "pwrMgr.h"
+#include "pwrMgr_arbiter.h"
+#include "pwrMgr_compgraph.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PWRMGR_CHECKPOINT_FILE "/tmp/.rdkbPowerMgr.state"
+#define PWRMGR_PID_FILE "/tmp/.rdkbPowerMgr.pid"
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t seq;               // Incremented on every save
+    int32_t state;              // Last state reached
+    int32_t target;             // Differs from state while a transition is in flight
+    int32_t axes[PWRMGR_AXIS_TOTAL];    // State each axis is heading for
+    PWRMGR_CompMask running;
+    int32_t compCount;          // Component graph size the mask refers to
+    uint32_t checksum;
+} PWRMGR_Checkpoint;
+
+int PwrMgr_Checkpoint_Save(const char *path, PWRMGR_Checkpoint *cp);
+int PwrMgr_Checkpoint_Load(const char *path, PWRMGR_Checkpoint *cp);
+int PwrMgr_Checkpoint_Lock(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,83 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+/**
+ *  @file pwrMgr_coalesce.h
+ *  @brief RDKB Power Manger transition coalescing
+ *
+ *  Keeps only the latest requested power state. A request is acted on once it
+ *  has been stable for the hysteresis time of its target state and the current
+ *  state has been held for its minimum dwell time. A request for the state we
+ *  are already in is dropped, so AC/battery or thermal flapping does not cycle
+ *  the components. A request for a more severe state, such as a higher
+ *  thermal level, does not wait for the current state's minimum dwell.
+ *
+ *  The coalescer holds no lock and reads no clock, the caller passes the
+ *  monotonic time in.
+ */
+
+#ifndef _RDKB_POWER_MGR_COALESCE_H_
+#define _RDKB_POWER_MGR_COALESCE_H_
+
+#include "pwrMgr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    long hysteresisMs;  // A request for this state has to be stable this long
+    long minDwellMs;    // Once in this state stay at least this long
+    int severity;       // Moving to a more severe state skips the minimum dwell
+} PWRMGR_StateTiming;
+
+typedef struct
+{
+    unsigned long received;    // Requests posted
+    unsigned long executed;    // Requests handed out for execution
+    unsigned long coalesced;   // Pending requests replaced by a newer one
+    unsigned long sameState;   // Requests for the state already reached
+    unsigned long flapped;     // Pending requests cancelled by a return to the current state
+} PWRMGR_CoalesceStats;
+
+typedef struct
+{
+    PWRMGR_PwrState current;
+    long enteredMs;
+    PWRMGR_PwrState pending;   // PWRMGR_STATE_UNKNOWN when nothing is pending
+    long requestedMs;
+    PWRMGR_StateTiming timing[PWRMGR_STATE_TOTAL];
+    PWRMGR_CoalesceStats stats;
+} PWRMGR_Coalescer;
+
+void PwrMgr_Coalesce_DefaultTiming(PWRMGR_StateTiming timing[PWRMGR_STATE_TOTAL]);
+void PwrMgr_Coalesce_Init(PWRMGR_Coalescer *co, PWRMGR_PwrState current, long nowMs);
+void PwrMgr_Coalesce_SetTiming(PWRMGR_Coalescer *co, PWRMGR_PwrState state, long hysteresisMs, long minDwellMs);
+void PwrMgr_Coalesce_SetSeverity(PWRMGR_Coalescer *co, PWRMGR_PwrState state, int severity);
+void PwrMgr_Coalesce_Post(PWRMGR_Coalescer *co, PWRMGR_PwrState target, long nowMs);
+long PwrMgr_Coalesce_Next(PWRMGR_Coalescer *co, long nowMs, PWRMGR_PwrState *target);
+void PwrMgr_Coalesce_Hold(PWRMGR_Coalescer *co, PWRMGR_PwrState target);
+void PwrMgr_Coalesce_Done(PWRMGR_Coalescer *co, PWRMGR_PwrState reached, long nowMs);
+unsigned long PwrMgr_Coalesce_Suppressed(const PWRMGR_Coalescer *co);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,159 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+/**
+ *  @file pwrMgr_compgraph.h
+ *  @brief RDKB Power Manger component graph
+ *
+ *  Declarative description of the CCSP components the power manager sheds and
+ *  of the ordering constraints between them. The graph is part of the power
+ *  policy loaded from PWRMGR_COMPONENTS_FILE, see pwrMgr_policy.h:
+ *
+ *  component <name> <systemd unit>
+ *  stop_before <a> <b>    a must be stopped before b is stopped
+ *  start_after <a> <b>    a must only be started once b is running
+ *  thermal_shed <a> <warm|hot|critical>
+ *                         lowest thermal level that sheds a, hot when unset
+ *  battery_shed <a> <1..PWRMGR_BATT_SHED_MAX>
+ *                         battery tier that sheds a, 1 (on battery) when unset
+ *  freeze <a> <dwell ms>  shed a by freezing its cgroup and only stop it once
+ *                         it has been frozen for dwell ms, see pwrMgr_freezer.h
+ *  power <a> <mW>         nominal power a draws, for the energy saved estimate
+ *  ready <a> <deadline ms> [<file>]
+ *                         a has to be up within deadline ms of its start, and
+ *                         is only up once file exists, the job timeout when unset
+ *  stop_budget <a> <ms>   how long a's stop may take in an emergency before it
+ *                         is escalated, the rest of the deadline when unset
+ *
+ *  The scheduler walks the graph as a DAG and keeps every component whose
+ *  prerequisites are satisfied in flight at the same time. A run can be
+ *  cancelled: no further jobs are submitted and the ones in flight are
+ *  allowed to finish.
+ *
+ *  A started component only counts once it is up. Without a ready file that
+ *  is when its start job is done, with one once the file exists and its
+ *  unit is active. The file is checked first, the unit is only asked once
+ *  it is there, and the checks back off while the component comes up.
+ *  Components that start after it wait for that. One that is not up by its
+ *  deadline counts as failed. The ready file is the component's to create,
+ *  and its unit's to remove when it stops, so a stale one is not mistaken
+ *  for a restart.
+ *
+ *  An emergency sheds with PwrMgr_CompGraph_Shed instead, which has to be
+ *  done by a deadline. A component that overruns its stop budget, because
+ *  it ignores SIGTERM or hangs in its shutdown, is sent SIGKILL and, if that
+ *  does not end it either, frozen where it stands.
+ */
+
+#ifndef _RDKB_POWER_MGR_COMPGRAPH_H_
+#define _RDKB_POWER_MGR_COMPGRAPH_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pwrMgr.h"
+#include "pwrMgr_unitctl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PWRMGR_COMPONENTS_FILE "/usr/ccsp/pwrMgr/pwrMgr_components.conf"
+#define PWRMGR_MAX_COMPONENTS  PWRMGR_UNIT_MAX_JOBS
+#define PWRMGR_COMP_NAME_LEN   32
+#define PWRMGR_UNIT_NAME_LEN   64
+#define PWRMGR_READY_FILE_LEN  128
+// First check of a started component that is not up yet, doubled after each miss
+#define PWRMGR_READY_POLL_MS   20
+#define PWRMGR_READY_POLL_MAX_MS 1000
+// How long a component that overran its stop budget gets after SIGKILL before it is frozen
+#define PWRMGR_KILL_GRACE_MS   500
+
+// One bit per component index
+typedef uint32_t PWRMGR_CompMask;
+
+#define PWRMGR_COMP_BIT(i) ((PWRMGR_CompMask)1 << (i))
+
+// Thermal level at which a component is shed, the levels above shed it too
+typedef enum
+{
+    PWRMGR_SHED_WARM = 1,
+    PWRMGR_SHED_HOT,
+    PWRMGR_SHED_CRITICAL
+} PWRMGR_ShedLevel;
+
+// Deepest battery tier, see pwrMgr_battery.h
+#define PWRMGR_BATT_SHED_MAX 4
+
+// Default time a built-in freeze component stays frozen before it is stopped
+#define PWRMGR_FREEZE_DWELL_MS 300000
+
+// Polled between jobs, returns true once the caller wants the run to stop early
+typedef bool (*PWRMGR_CancelFn)(void *arg);
+
+typedef struct
+{
+    char name[PWRMGR_COMP_NAME_LEN];
+    char unit[PWRMGR_UNIT_NAME_LEN];
+    PWRMGR_CompMask stopPrereq;   // Components that have to be stopped before this one
+    PWRMGR_CompMask startPrereq;  // Components that have to be running before this one starts
+    PWRMGR_ShedLevel shedLevel;
+    int battShedTier;             // Battery tier that sheds this one
+    long freezeDwellMs;           // Frozen rather than stopped for this long, 0 to stop at once
+    int powerMw;                  // Nominal draw while running
+    long readyDeadlineMs;         // Has to be up this long after its start, 0 for the job timeout
+    char readyFile[PWRMGR_READY_FILE_LEN];  // Exists once it is up, empty if the start job is enough
+    long stopBudgetMs;            // Its stop may take this long in an emergency, 0 for the deadline
+} PWRMGR_Component;
+
+typedef struct
+{
+    int count;
+    PWRMGR_Component comps[PWRMGR_MAX_COMPONENTS];
+} PWRMGR_CompGraph;
+
+void PwrMgr_CompGraph_Init(PWRMGR_CompGraph *graph);
+int PwrMgr_CompGraph_AddComponent(PWRMGR_CompGraph *graph, const char *name, const char *unit);
+int PwrMgr_CompGraph_Find(const PWRMGR_CompGraph *graph, const char *name);
+int PwrMgr_CompGraph_AddStopBefore(PWRMGR_CompGraph *graph, const char *first, const char *then);
+int PwrMgr_CompGraph_AddStartAfter(PWRMGR_CompGraph *graph, const char *later, const char *first);
+int PwrMgr_CompGraph_SetShedLevel(PWRMGR_CompGraph *graph, const char *name, PWRMGR_ShedLevel level);
+int PwrMgr_CompGraph_SetBattShedTier(PWRMGR_CompGraph *graph, const char *name, int tier);
+int PwrMgr_CompGraph_SetFreeze(PWRMGR_CompGraph *graph, const char *name, long dwellMs);
+int PwrMgr_CompGraph_SetPower(PWRMGR_CompGraph *graph, const char *name, int powerMw);
+int PwrMgr_CompGraph_SetReady(PWRMGR_CompGraph *graph, const char *name, long deadlineMs, const char *file);
+int PwrMgr_CompGraph_SetStopBudget(PWRMGR_CompGraph *graph, const char *name, long budgetMs);
+int PwrMgr_CompGraph_ParseLine(PWRMGR_CompGraph *graph, char *line);
+void PwrMgr_CompGraph_LoadDefaults(PWRMGR_CompGraph *graph);
+int PwrMgr_CompGraph_Validate(const PWRMGR_CompGraph *graph);
+PWRMGR_CompMask PwrMgr_CompGraph_AllMask(const PWRMGR_CompGraph *graph);
+PWRMGR_CompMask PwrMgr_CompGraph_ShedMask(const PWRMGR_CompGraph *graph, PWRMGR_ShedLevel level);
+PWRMGR_CompMask PwrMgr_CompGraph_BattShedMask(const PWRMGR_CompGraph *graph, int tier);
+PWRMGR_CompMask PwrMgr_CompGraph_StateMask(const PWRMGR_CompGraph *graph, PWRMGR_PwrState state);
+int PwrMgr_CompGraph_PowerMw(const PWRMGR_CompGraph *graph, PWRMGR_CompMask mask);
+int PwrMgr_CompGraph_Run(const PWRMGR_CompGraph *graph, PWRMGR_UnitCtl *ctl, PWRMGR_UnitOp op,
+                         PWRMGR_CompMask mask, int timeoutMs, PWRMGR_CancelFn cancelled, void *cancelArg,
+                         PWRMGR_CompMask *completed, PWRMGR_CompMask *failed);
+int PwrMgr_CompGraph_Shed(const PWRMGR_CompGraph *graph, PWRMGR_UnitCtl *ctl, PWRMGR_CompMask mask,
+                          int deadlineMs, PWRMGR_CancelFn cancelled, void *cancelArg,
+                          PWRMGR_CompMask *completed, PWRMGR_CompMask *failed, PWRMGR_CompMask *overrun);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,94 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+/**
+ *  @file pwrMgr_cpu.h
+ *  @brief RDKB Power Manger CPU actuator
+ *
+ *  Caps the CPU per power state rather than only shedding components: the
+ *  cpufreq governor and scaling_max_freq of every core, and how many cores
+ *  stay online through CPU hotplug. A mild thermal state can then be met
+ *  with a lower clock alone.
+ *
+ *  A profile only names what it changes. Anything left unset, and every
+ *  setting in a state without a profile such as AC, goes back to the
+ *  baseline. The baseline is what the cores were set to when the first
+ *  instance of the boot started. It is kept in a file, so an instance
+ *  restarted while capped does not mistake the cap for the baseline.
+ *
+ *  On battery and hot at the same time both profiles apply, merged field by
+ *  field: the lower clock cap, the fewer cores and powersave over any other
+ *  governor.
+ *
+ *  The highest numbered cores are parked first. Cores without an online
+ *  file, normally cpu0, always stay up.
+ */
+
+#ifndef _RDKB_POWER_MGR_CPU_H_
+#define _RDKB_POWER_MGR_CPU_H_
+
+#include <stdbool.h>
+#include "pwrMgr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PWRMGR_CPU_ROOT "/sys/devices/system/cpu"
+#define PWRMGR_CPU_BASELINE_FILE "/tmp/.rdkbPowerMgr.cpu"
+#define PWRMGR_CPU_MAX 16
+#define PWRMGR_CPU_GOV_LEN 32
+
+typedef struct
+{
+    char governor[PWRMGR_CPU_GOV_LEN];  // "" keeps the baseline governor
+    int maxFreqPercent;         // Of cpuinfo_max_freq, 0 keeps the baseline
+    int onlineCpus;             // Cores left online, 0 keeps the baseline
+} PWRMGR_CpuProfile;
+
+typedef struct
+{
+    bool hotplug;               // Has an online file
+    bool online;                // Baseline
+    char governor[PWRMGR_CPU_GOV_LEN];  // Baseline, "" without cpufreq
+    long maxKHz;                // Baseline scaling_max_freq
+    long hwMinKHz;              // cpuinfo limits, read while the core is online
+    long hwMaxKHz;
+} PWRMGR_Cpu;
+
+typedef struct
+{
+    char root[128];
+    PWRMGR_Cpu cpus[PWRMGR_CPU_MAX];
+    int count;
+    PWRMGR_CpuProfile profiles[PWRMGR_STATE_TOTAL];
+    PWRMGR_CpuProfile last;     // Merged profile of the last apply
+    bool applied;               // Set by the first apply
+} PWRMGR_CpuActuator;
+
+void PwrMgr_Cpu_DefaultProfiles(PWRMGR_CpuProfile profiles[PWRMGR_STATE_TOTAL]);
+int PwrMgr_Cpu_Open(PWRMGR_CpuActuator *act, const char *root, const char *baselinePath);
+void PwrMgr_Cpu_SetProfile(PWRMGR_CpuActuator *act, PWRMGR_PwrState state, const PWRMGR_CpuProfile *profile);
+int PwrMgr_Cpu_Apply(PWRMGR_CpuActuator *act, PWRMGR_PwrState state);
+int PwrMgr_Cpu_ApplyStates(PWRMGR_CpuActuator *act, const PWRMGR_PwrState *states, int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,155 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+/**
+ *  @file pwrMgr_executor.h
+ *  @brief RDKB Power Manger transition executor
+ *
+ *  The executor owns the transition thread. The sysevent handler only posts
+ *  requested states, the executor coalesces them and moves the components
+ *  towards the latest target.
+ *
+ *  Requests are coalesced per axis, see pwrMgr_arbiter.h: a thermal request
+ *  never replaces a pending supply request or the other way round. The
+ *  components that should run are arbitrated over the latest state of every
+ *  axis, and a transition only stops or starts the difference to what is
+ *  running.
+ *
+ *  It tracks which components are running. A new request arriving while a
+ *  transition is in flight cancels it: jobs already submitted finish, nothing
+ *  new is started, and the next transition only stops or starts the
+ *  components that still differ from its own target.
+ *
+ *  With a transition table set, requests it does not allow from the current
+ *  state of their axis are rejected and its entries order the stop and start
+ *  steps. Requests for a state the policy switched off are rejected as well.
+ *
+ *  A request that is due and would stop components can be held back by the
+ *  inhibited callback, see pwrMgr_inhibit.h. While held back it neither
+ *  holds up nor cancels the other axis, and it is acted on once the callback
+ *  lets it go or it is withdrawn, which saved the teardown altogether.
+ *
+ *  Progress is reported after every step so it can be checkpointed. Started
+ *  with the running set and target from a checkpoint, the executor only
+ *  finishes what is left.
+ *
+ *  Between transitions the idle callback runs on the same thread, so it may
+ *  use the component controller without racing a transition. Kicking the
+ *  executor runs it as soon as the transition in flight, if any, is done.
+ */
+
+#ifndef _RDKB_POWER_MGR_EXECUTOR_H_
+#define _RDKB_POWER_MGR_EXECUTOR_H_
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "pwrMgr.h"
+#include "pwrMgr_arbiter.h"
+#include "pwrMgr_coalesce.h"
+#include "pwrMgr_compgraph.h"
+#include "pwrMgr_fsm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    // Move the components in mask to op while heading for target. Return early once
+    // cancelled(cancelArg) is true, completed reports the components that reached op.
+    int  (*run)(void *ctx, PWRMGR_PwrState target, PWRMGR_UnitOp op, PWRMGR_CompMask mask,
+                PWRMGR_CancelFn cancelled, void *cancelArg, PWRMGR_CompMask *completed);
+    // Every component matches target, success is false if some of them failed
+    void (*reached)(void *ctx, PWRMGR_PwrState from, PWRMGR_PwrState target, bool success);
+    // The number of suppressed requests changed, may be NULL
+    void (*suppressed)(void *ctx, unsigned long count);
+    // A transition was published and the latency histograms updated, may be NULL
+    void (*stats)(void *ctx, PWRMGR_PwrState from, PWRMGR_PwrState target, uint64_t totalUs);
+    // A transition started, a step changed the running set or target was reached, may be NULL
+    void (*progress)(void *ctx, PWRMGR_PwrState state, PWRMGR_PwrState target, PWRMGR_CompMask running);
+    // Housekeeping between transitions, returns the ms until it is due again or -1, may be NULL
+    long (*idle)(void *ctx);
+    // A request for target is due and would stop the components in stops. Returns the ms to
+    // hold it back, 0 to go ahead. Called with the executor lock held, may be NULL.
+    long (*inhibited)(void *ctx, PWRMGR_PwrState target, PWRMGR_CompMask stops);
+    // A request was held back or let go, the counters add up all of them, may be NULL
+    void (*deferred)(void *ctx, unsigned long count, uint64_t totalMs);
+} PWRMGR_ExecOps;
+
+typedef struct
+{
+    unsigned long transitions;  // Transitions completed
+    unsigned long preempted;    // Transitions cancelled by a newer request
+    unsigned long rejected;     // Requests the transition table does not allow
+    unsigned long deferred;     // Requests held back by the inhibited callback
+    uint64_t deferredMs;        // How long they were held back, their components kept running
+} PWRMGR_ExecStats;
+
+typedef struct
+{
+    const PWRMGR_ExecOps *ops;
+    void *ctx;
+    const PWRMGR_Fsm *fsm;
+    pthread_t tid;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool started;
+    bool stop;
+    bool busy;
+    bool dirty;                 // running does not match target yet
+    PWRMGR_Coalescer co[PWRMGR_AXIS_TOTAL];       // Requests of each axis
+    PWRMGR_CompMask runMask[PWRMGR_STATE_TOTAL];  // Components running in each state
+    bool disabled[PWRMGR_STATE_TOTAL];            // States requests are rejected for
+    PWRMGR_CompMask running;
+    PWRMGR_PwrState state;      // Last state reached
+    PWRMGR_PwrState target;     // State being worked towards
+    PWRMGR_PowerVector reached; // State of each axis the running set was reconciled with
+    PWRMGR_PowerVector wanted;  // State of each axis being worked towards
+    unsigned long published;    // Suppressed count last reported
+    uint64_t postedUs[PWRMGR_AXIS_TOTAL];  // Latest request that changed the pending state of each axis
+    long deferredSinceMs[PWRMGR_AXIS_TOTAL];  // Request of the axis held back since, -1 if it is not
+    unsigned long publishedDeferred;       // Deferral counters last reported
+    uint64_t publishedDeferredMs;
+    uint64_t receivedUs;        // Request behind the current target
+    long idleDueMs;             // Next call of the idle callback
+    PWRMGR_ExecStats stats;
+} PWRMGR_Executor;
+
+void PwrMgr_Exec_Init(PWRMGR_Executor *ex, const PWRMGR_ExecOps *ops, void *ctx,
+                      PWRMGR_PwrState state, PWRMGR_CompMask running);
+void PwrMgr_Exec_Resume(PWRMGR_Executor *ex, PWRMGR_PwrState target);
+void PwrMgr_Exec_SetRunMask(PWRMGR_Executor *ex, PWRMGR_PwrState state, PWRMGR_CompMask mask);
+void PwrMgr_Exec_SetEnabled(PWRMGR_Executor *ex, PWRMGR_PwrState state, bool enabled);
+void PwrMgr_Exec_SetFsm(PWRMGR_Executor *ex, const PWRMGR_Fsm *fsm);
+void PwrMgr_Exec_SetTiming(PWRMGR_Executor *ex, PWRMGR_PwrState state, long hysteresisMs, long minDwellMs);
+void PwrMgr_Exec_SetSeverity(PWRMGR_Executor *ex, PWRMGR_PwrState state, int severity);
+int PwrMgr_Exec_Start(PWRMGR_Executor *ex);
+int PwrMgr_Exec_Post(PWRMGR_Executor *ex, PWRMGR_PwrState target);
+void PwrMgr_Exec_Kick(PWRMGR_Executor *ex);
+bool PwrMgr_Exec_WaitIdle(PWRMGR_Executor *ex, int timeoutMs);
+void PwrMgr_Exec_GetStatus(PWRMGR_Executor *ex, PWRMGR_PwrState *state, PWRMGR_CompMask *running,
+                           PWRMGR_ExecStats *stats, PWRMGR_CoalesceStats *coStats);
+void PwrMgr_Exec_GetVectors(PWRMGR_Executor *ex, PWRMGR_PowerVector *reached, PWRMGR_PowerVector *wanted);
+void PwrMgr_Exec_Stop(PWRMGR_Executor *ex);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,106 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+/**
+ *  @file pwrMgr_freezer.h
+ *  @brief RDKB Power Manger cgroup freezer
+ *
+ *  A unit controller backend that sits in front of another one. Stopping a
+ *  unit that opted in writes 1 to the cgroup.freeze of its cgroup v2 group
+ *  instead, and starting it again thaws it. The processes keep all their
+ *  state, so Wi-Fi comes back in milliseconds without re-initialising the
+ *  radios or re-associating clients. Every other unit, and any unit whose
+ *  cgroup cannot be frozen, is passed through to the wrapped backend.
+ *
+ *  A unit left frozen for longer than its dwell time is thawed and stopped
+ *  for real by PwrMgr_Freezer_Expire, so a long excursion still ends with
+ *  the component stopped.
+ *
+ *  Any other unit can be frozen by an emergency through the freeze op. It is
+ *  stopped by its dwell time like the others, and starting it thaws it and
+ *  then starts it for real, since it was not stopped cleanly.
+ *
+ *  Frozen cgroups outlive the daemon. PwrMgr_Freezer_AddUnit adopts one
+ *  that the caller considers shed and thaws one it considers running.
+ *
+ *  Nothing here is locked. Submit, wait and expire have to be called from
+ *  the same thread, the daemon uses the executor thread.
+ */
+
+#ifndef _RDKB_POWER_MGR_FREEZER_H_
+#define _RDKB_POWER_MGR_FREEZER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pwrMgr_unitctl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Where systemd puts the cgroups of system services
+#define PWRMGR_CGROUP_ROOT "/sys/fs/cgroup/system.slice"
+// How long to wait for cgroup.events to confirm a freeze or thaw
+#define PWRMGR_FREEZER_SETTLE_MS 1000
+#define PWRMGR_FREEZER_UNIT_LEN 64
+// How long a unit frozen by an emergency stays frozen before it is stopped
+#define PWRMGR_FREEZER_EMERGENCY_DWELL_MS 60000
+
+typedef struct
+{
+    char unit[PWRMGR_FREEZER_UNIT_LEN];
+    long dwellMs;               // Stopped once frozen this long
+    bool frozen;
+    long frozenAtMs;
+    bool emergency;             // Frozen by the freeze op, not opted in
+} PWRMGR_FreezerUnit;
+
+typedef struct
+{
+    unsigned long freezes;
+    unsigned long thaws;
+    unsigned long expired;      // Stopped after their dwell time
+    unsigned long fallbacks;    // Could not be frozen and were stopped instead
+    uint64_t lastFreezeUs;
+    uint64_t lastThawUs;
+} PWRMGR_FreezerStats;
+
+typedef struct
+{
+    PWRMGR_UnitCtl inner;
+    char root[128];
+    int settleMs;
+    PWRMGR_FreezerUnit units[PWRMGR_UNIT_MAX_JOBS];
+    int count;
+    // Jobs finished without the wrapped backend, handed out by the next waits
+    int doneIds[PWRMGR_UNIT_MAX_JOBS];
+    PWRMGR_UnitJobResult doneResults[PWRMGR_UNIT_MAX_JOBS];
+    int doneCount;
+    PWRMGR_FreezerStats stats;
+} PWRMGR_Freezer;
+
+int PwrMgr_Freezer_Open(PWRMGR_Freezer *fz, const char *root, const PWRMGR_UnitCtl *inner, PWRMGR_UnitCtl *ctl);
+int PwrMgr_Freezer_AddUnit(PWRMGR_Freezer *fz, const char *unit, long dwellMs, bool shed);
+bool PwrMgr_Freezer_IsFrozen(const PWRMGR_Freezer *fz, const char *unit);
+long PwrMgr_Freezer_Expire(PWRMGR_Freezer *fz, long nowMs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
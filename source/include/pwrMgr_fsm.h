@@ -0,0 +1,88 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+/**
+ *  @file pwrMgr_fsm.h
+ *  @brief RDKB Power Manger state machine tables
+ *
+ *  Power states and the transitions between them are data. Each state has
+ *  the rdkb-power-transition value that requests it and the rdkb-power-state
+ *  value published for it. The transition table is indexed by (current,
+ *  target): an entry lists the guard deciding whether the request is
+ *  accepted, the ordered actions taken and the state published when done.
+ *  Pairs without an entry are rejected. The executor only looks up pairs on
+ *  the same axis, see pwrMgr_arbiter.h.
+ *
+ *  Request strings are resolved through a perfect hash built when the tables
+ *  are loaded, one hash and one strcmp per lookup.
+ */
+
+#ifndef _RDKB_POWER_MGR_FSM_H_
+#define _RDKB_POWER_MGR_FSM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "pwrMgr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PWRMGR_FSM_MAX_ACTIONS 3
+#define PWRMGR_FSM_HASH_SIZE 16    // Power of two, at least twice the number of states
+
+typedef enum
+{
+    PWRMGR_FSM_ACT_NONE = 0,    // Ends the action list
+    PWRMGR_FSM_ACT_STOP,        // Stop components the target does not run
+    PWRMGR_FSM_ACT_START        // Start components the target runs
+} PWRMGR_FsmAction;
+
+typedef bool (*PWRMGR_FsmGuard)(PWRMGR_PwrState from, PWRMGR_PwrState to);
+
+typedef struct
+{
+    PWRMGR_FsmGuard guard;      // NULL accepts every request
+    PWRMGR_FsmAction actions[PWRMGR_FSM_MAX_ACTIONS];
+    PWRMGR_PwrState publish;    // PWRMGR_STATE_UNKNOWN marks an empty entry
+} PWRMGR_FsmTransition;
+
+typedef const PWRMGR_FsmTransition PWRMGR_FsmTable[PWRMGR_STATE_TOTAL][PWRMGR_STATE_TOTAL];
+
+typedef struct
+{
+    const PWRMGR_PwrStateItem *states;  // Indexed by state
+    PWRMGR_FsmTable *table;
+    uint32_t seed;
+    int8_t hash[PWRMGR_FSM_HASH_SIZE];  // State for each slot, -1 when free
+} PWRMGR_Fsm;
+
+int PwrMgr_Fsm_Init(PWRMGR_Fsm *fsm, const PWRMGR_PwrStateItem *states, PWRMGR_FsmTable *table);
+int PwrMgr_Fsm_InitDefault(PWRMGR_Fsm *fsm);
+PWRMGR_PwrState PwrMgr_Fsm_FromTransStr(const PWRMGR_Fsm *fsm, const char *transStr);
+const PWRMGR_FsmTransition *PwrMgr_Fsm_Lookup(const PWRMGR_Fsm *fsm, PWRMGR_PwrState from, PWRMGR_PwrState to);
+bool PwrMgr_Fsm_Allowed(const PWRMGR_Fsm *fsm, PWRMGR_PwrState from, PWRMGR_PwrState to);
+int PwrMgr_Fsm_Steps(const PWRMGR_Fsm *fsm, PWRMGR_PwrState from, PWRMGR_PwrState to, PWRMGR_FsmAction steps[2]);
+const char *PwrMgr_Fsm_StateStr(const PWRMGR_Fsm *fsm, PWRMGR_PwrState state);
+const char *PwrMgr_Fsm_TransStr(const PWRMGR_Fsm *fsm, PWRMGR_PwrState state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
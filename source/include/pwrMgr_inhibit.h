@@ -0,0 +1,109 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+/**
+ *  @file pwrMgr_inhibit.h
+ *  @brief RDKB Power Manger transition inhibitor
+ *
+ *  Lets a client hold off the transitions that would stop components while
+ *  it is doing something a teardown would break, a voice call on the MTA or
+ *  a firmware download. The daemon serves PWRMGR_INHIBIT_SOCKET, a
+ *  SOCK_SEQPACKET socket that takes one command per message:
+ *
+ *  inhibit <supply|thermal|all> <name> <ms>
+ *                     hold off the transitions of that class for at most
+ *                     ms, replies "ok <id>"
+ *  release <id>       drop a lock again, replies "ok"
+ *  list               replies "ok <count>" and a line per lock:
+ *                     <id> <class> <name> <ms left>
+ *
+ *  Anything else is answered with "error <reason>". A class is the axis the
+ *  transition moves, see pwrMgr_arbiter.h. Locks are dropped when their time
+ *  is up or their client disconnects, so a crashed client does not hold the
+ *  device hostage. Transitions that only start components and critical
+ *  thermal levels are never held off, the daemon decides that. At most
+ *  PWRMGR_INHIBIT_MAX_CLIENTS clients are connected at a time, the daemon
+ *  closes any connection beyond that.
+ *
+ *  The table is locked, it is changed on the loop thread and checked on the
+ *  executor thread.
+ */
+
+#ifndef _RDKB_POWER_MGR_INHIBIT_H_
+#define _RDKB_POWER_MGR_INHIBIT_H_
+
+#include <pthread.h>
+#include <stddef.h>
+#include "pwrMgr_arbiter.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PWRMGR_INHIBIT_SOCKET    "/var/run/pwrMgr_inhibit.sock"
+#define PWRMGR_INHIBIT_MAX_LOCKS 16
+// Leaves the daemon's own sources room in the event loop
+#define PWRMGR_INHIBIT_MAX_CLIENTS 4
+// Longest a client may hold a lock, longer requests are cut down to it
+#define PWRMGR_INHIBIT_MAX_MS    3600000
+#define PWRMGR_INHIBIT_NAME_LEN  32
+#define PWRMGR_INHIBIT_MSG_LEN   1024
+
+// Classes of transition, one bit per axis
+#define PWRMGR_INHIBIT_CLASS(axis) (1u << (axis))
+#define PWRMGR_INHIBIT_ALL         (PWRMGR_INHIBIT_CLASS(PWRMGR_AXIS_TOTAL) - 1)
+
+typedef struct
+{
+    int id;                     // 0 while the slot is free
+    int owner;                  // Client connection holding it
+    unsigned classes;
+    char name[PWRMGR_INHIBIT_NAME_LEN];
+    long expiresMs;
+} PWRMGR_InhibitLock;
+
+typedef struct
+{
+    unsigned long taken;
+    unsigned long released;
+    unsigned long expired;      // Ran out of time, or their client went away
+} PWRMGR_InhibitStats;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    PWRMGR_InhibitLock locks[PWRMGR_INHIBIT_MAX_LOCKS];
+    int nextId;
+    PWRMGR_InhibitStats stats;
+} PWRMGR_Inhibitor;
+
+void PwrMgr_Inhibit_Init(PWRMGR_Inhibitor *inh);
+int PwrMgr_Inhibit_Take(PWRMGR_Inhibitor *inh, int owner, const char *name, unsigned classes, long durationMs, long nowMs);
+int PwrMgr_Inhibit_Release(PWRMGR_Inhibitor *inh, int owner, int id);
+void PwrMgr_Inhibit_ReleaseOwner(PWRMGR_Inhibitor *inh, int owner);
+long PwrMgr_Inhibit_Check(PWRMGR_Inhibitor *inh, PWRMGR_Axis axis, long nowMs, char *who, size_t size);
+int PwrMgr_Inhibit_Command(PWRMGR_Inhibitor *inh, int owner, const char *cmd, long nowMs, char *reply, size_t size);
+int PwrMgr_Inhibit_Listen(const char *path);
+int PwrMgr_Inhibit_Serve(PWRMGR_Inhibitor *inh, int fd, long nowMs);
+void PwrMgr_Inhibit_Destroy(PWRMGR_Inhibitor *inh);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
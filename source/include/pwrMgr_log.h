@@ -0,0 +1,74 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+/**
+ *  @file pwrMgr_log.h
+ *  @brief RDKB Power Manger logging
+ *
+ *  Logging macros shared by the power manager daemon and its helper modules.
+ *
+ *  Levels below PWRMGR_LOG_MIN_LEVEL are compiled out, e.g. build with
+ *  -DPWRMGR_LOG_MIN_LEVEL=WARNING to drop the INFO tracing.
+ *
+ *  Without the RDK logger, messages go through pwrMgr_log.c: once
+ *  PwrMgr_Log_Start has been called, every thread formats into a ring
+ *  buffer of its own and a flusher thread writes them out, so logging on the
+ *  transition path never waits on the console. The flusher lingers a few ms
+ *  after a wake-up so that a burst is written at once. A full ring drops the
+ *  message and counts it. Before the start, and for threads beyond
+ *  PWRMGR_LOG_MAX_THREADS, messages are written synchronously.
+ */
+
+#ifndef _RDKB_POWER_MGR_LOG_H_
+#define _RDKB_POWER_MGR_LOG_H_
+
+#include <stdio.h>
+
+#define INFO  0
+#define WARNING  1
+#define ERROR 2
+
+#ifndef PWRMGR_LOG_MIN_LEVEL
+#define PWRMGR_LOG_MIN_LEVEL INFO
+#endif
+
+#ifdef FEATURE_SUPPORT_RDKLOG
+#include "ccsp_trace.h"
+#define PWRMGRLOG(x, ...) { if((x) < PWRMGR_LOG_MIN_LEVEL){}else if((x)==(INFO)){CcspTraceInfo((__VA_ARGS__));}else if((x)==(WARNING)){CcspTraceWarning((__VA_ARGS__));}else if((x)==(ERROR)){CcspTraceError((__VA_ARGS__));} }
+#else
+#define PWRMGRLOG(x, ...) { if((x) >= PWRMGR_LOG_MIN_LEVEL){PwrMgr_Log_Write(__FUNCTION__, __LINE__, __VA_ARGS__);} }
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PWRMGR_LOG_MAX_THREADS 16
+#define PWRMGR_LOG_RING_SLOTS  64
+#define PWRMGR_LOG_LINE_LEN    256
+
+void PwrMgr_Log_Write(const char *func, int line, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+int PwrMgr_Log_Start(int fd);
+void PwrMgr_Log_Stop(void);
+unsigned long PwrMgr_Log_Dropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
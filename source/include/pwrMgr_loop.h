@@ -0,0 +1,78 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+/**
+ *  @file pwrMgr_loop.h
+ *  @brief RDKB Power Manger event loop
+ *
+ *  A single epoll loop the daemon runs on its main thread. Sources are file
+ *  descriptors with a callback: the sysevent connection, the signalfd, the
+ *  timerfds of the monitors and of the reconnect backoff, and the inhibitor
+ *  socket with its clients. Callbacks run on the loop thread and must not
+ *  block.
+ *
+ *  PwrMgr_Loop_Quit may be called from any thread, the loop returns after
+ *  the callbacks of the current wakeup.
+ */
+
+#ifndef _RDKB_POWER_MGR_LOOP_H_
+#define _RDKB_POWER_MGR_LOOP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PWRMGR_LOOP_MAX_SOURCES 16
+
+// fd is readable or hung up, events holds the epoll flags
+typedef void (*PWRMGR_LoopFn)(void *arg, int fd, uint32_t events);
+
+typedef struct
+{
+    int fd;
+    PWRMGR_LoopFn fn;
+    void *arg;
+} PWRMGR_LoopSource;
+
+typedef struct
+{
+    int epollFd;
+    int wakeFd;
+    PWRMGR_LoopSource sources[PWRMGR_LOOP_MAX_SOURCES];
+    int count;
+    volatile bool quit;
+    unsigned long wakeups;
+} PWRMGR_Loop;
+
+int PwrMgr_Loop_Init(PWRMGR_Loop *loop);
+int PwrMgr_Loop_Add(PWRMGR_Loop *loop, int fd, PWRMGR_LoopFn fn, void *arg);
+void PwrMgr_Loop_Remove(PWRMGR_Loop *loop, int fd);
+int PwrMgr_Loop_Run(PWRMGR_Loop *loop);
+void PwrMgr_Loop_Quit(PWRMGR_Loop *loop);
+void PwrMgr_Loop_Close(PWRMGR_Loop *loop);
+int PwrMgr_Loop_TimerFd();
+void PwrMgr_Loop_Arm(int timerFd, int ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,101 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+/**
+ *  @file pwrMgr_policy.h
+ *  @brief RDKB Power Manger power policy
+ *
+ *  Everything that differs between devices is data in PWRMGR_POLICY_FILE:
+ *  the component graph (see pwrMgr_compgraph.h for its keywords) plus
+ *
+ *  state <state> <on|off>   whether the device has the state at all, requests
+ *                           for a state that is off are rejected
+ *  shed <state> [<a>...]    the components shed in a state, replaces the
+ *                           set thermal_shed and battery_shed derive for it
+ *  timing <state> <hysteresis ms> <min dwell ms>
+ *                           how long a request for the state has to be stable
+ *                           and how long the state is then held at least
+ *  timeout <ms>             how long a stop or start job may take
+ *  emergency <state> <deadline ms>
+ *                           shed for the state within deadline ms, escalating
+ *                           stops that overrun their budget, 0 to stop as usual
+ *  eco <HH:MM>-<HH:MM> [<a>...]
+ *                           shed the components daily between the two local
+ *                           times on top of what the state sheds, see
+ *                           pwrMgr_sched.h
+ *
+ *  States are named by their rdkb-power-state value. Lines naming a state
+ *  this build does not have are skipped, so one file can serve every build,
+ *  and components have to be declared before a shed line names them.
+ *
+ *  The file is compiled once into the run mask table the executor uses.
+ *  PwrMgr_Policy_Watch reports changes to it, the daemon then compiles the
+ *  new file on the side and adopts it between two transitions. A reload
+ *  that changes the components themselves, their units or freeze dwell is
+ *  refused since the checkpoint, freezer and statistics are indexed by them.
+ */
+
+#ifndef _RDKB_POWER_MGR_POLICY_H_
+#define _RDKB_POWER_MGR_POLICY_H_
+
+#include <stdbool.h>
+#include "pwrMgr.h"
+#include "pwrMgr_coalesce.h"
+#include "pwrMgr_compgraph.h"
+#include "pwrMgr_fsm.h"
+#include "pwrMgr_sched.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The component graph file grew into the policy, the name is kept for existing images
+#define PWRMGR_POLICY_FILE PWRMGR_COMPONENTS_FILE
+// How long shedding for ThermalCritical may take unless the policy says otherwise
+#define PWRMGR_EMERGENCY_DEADLINE_MS 10000
+
+typedef struct
+{
+    PWRMGR_CompGraph graph;
+    bool enabled[PWRMGR_STATE_TOTAL];
+    bool shedSet[PWRMGR_STATE_TOTAL];             // shed holds an explicit set for the state
+    PWRMGR_CompMask shed[PWRMGR_STATE_TOTAL];
+    PWRMGR_StateTiming timing[PWRMGR_STATE_TOTAL];
+    int jobTimeoutMs;
+    long emergencyMs[PWRMGR_STATE_TOTAL];         // Shedding deadline, 0 if the state is no emergency
+    PWRMGR_EcoWindow eco[PWRMGR_SCHED_MAX_WINDOWS];
+    int ecoCount;
+    // Compiled by PwrMgr_Policy_Compile
+    PWRMGR_CompMask runMask[PWRMGR_STATE_TOTAL];  // Components running in each state
+} PWRMGR_Policy;
+
+void PwrMgr_Policy_Init(PWRMGR_Policy *policy);
+int PwrMgr_Policy_ParseLine(PWRMGR_Policy *policy, const PWRMGR_Fsm *fsm, char *line);
+int PwrMgr_Policy_Compile(PWRMGR_Policy *policy);
+int PwrMgr_Policy_ParseEco(const PWRMGR_Policy *policy, const char *spec, PWRMGR_EcoWindow *windows, int *count);
+int PwrMgr_Policy_Load(PWRMGR_Policy *policy, const PWRMGR_Fsm *fsm, const char *path);
+void PwrMgr_Policy_LoadDefaults(PWRMGR_Policy *policy);
+bool PwrMgr_Policy_SameComponents(const PWRMGR_Policy *a, const PWRMGR_Policy *b);
+int PwrMgr_Policy_Watch(const char *path);
+bool PwrMgr_Policy_Changed(int fd, const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,97 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ *  @file pwrMgr_sched.h
+ *  @brief RDKB Power Manger eco schedule
+ *
+ *  Sheds components by the time of day, say harvester and LMLite from 01:00
+ *  to 05:00, without a cron job poking sysevent. A window is daily in local
+ *  time, one ending before it starts runs past midnight and one ending when
+ *  it starts runs all day. Windows may overlap, the components of every
+ *  open window are shed.
+ *
+ *  The next opening and closing of each window sit in a min-heap, and one
+ *  CLOCK_REALTIME timerfd is armed for the earliest. Nothing wakes up in
+ *  between. The timer is cancelled when the clock is set, an NTP sync
+ *  after boot for one, and the heap is then rebuilt for the new time.
+ *
+ *  The schedule itself is data, the policy's eco lines or the
+ *  PwrMgrEcoSchedule syscfg value, so it survives restarts. Which windows
+ *  are open is worked out from the clock and never stored.
+ */
+
+#ifndef _RDKB_POWER_MGR_SCHED_H_
+#define _RDKB_POWER_MGR_SCHED_H_
+
+#include <stdbool.h>
+#include <time.h>
+#include "pwrMgr_compgraph.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PWRMGR_SCHED_MAX_WINDOWS 8
+#define PWRMGR_SCHED_DAY_MIN     (24 * 60)
+
+typedef struct
+{
+    int startMin;               // Minutes after local midnight
+    int endMin;
+    PWRMGR_CompMask shed;
+} PWRMGR_EcoWindow;
+
+typedef struct
+{
+    time_t dueSec;
+    int window;
+    bool opens;                 // Else the window closes
+} PWRMGR_SchedTimer;
+
+// The components shed by the open windows changed
+typedef void (*PWRMGR_SchedFn)(void *ctx, PWRMGR_CompMask shed);
+
+typedef struct
+{
+    PWRMGR_EcoWindow windows[PWRMGR_SCHED_MAX_WINDOWS];
+    int count;
+    PWRMGR_SchedTimer heap[2 * PWRMGR_SCHED_MAX_WINDOWS];
+    int heapSize;
+    PWRMGR_CompMask shed;
+    PWRMGR_SchedFn notify;
+    void *ctx;
+    int timerFd;
+    unsigned long fired;
+} PWRMGR_Scheduler;
+
+bool PwrMgr_Sched_WindowOpen(const PWRMGR_EcoWindow *window, time_t t);
+PWRMGR_CompMask PwrMgr_Sched_ShedAt(const PWRMGR_EcoWindow *windows, int count, time_t t);
+int PwrMgr_Sched_Open(PWRMGR_Scheduler *sched, PWRMGR_SchedFn notify, void *ctx);
+int PwrMgr_Sched_Set(PWRMGR_Scheduler *sched, const PWRMGR_EcoWindow *windows, int count, time_t now);
+long PwrMgr_Sched_Run(PWRMGR_Scheduler *sched, time_t now);
+int PwrMgr_Sched_Fd(PWRMGR_Scheduler *sched);
+int PwrMgr_Sched_Dispatch(PWRMGR_Scheduler *sched);
+void PwrMgr_Sched_Close(PWRMGR_Scheduler *sched);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,150 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+/**
+ *  @file pwrMgr_sim.h
+ *  @brief RDKB Power Manger trace replay simulator
+ *
+ *  Replays a recorded trace of power and thermal events through the daemon's
+ *  coalescer, transition table, thermal trip points and component graph on
+ *  a virtual clock, so a week of field data takes well under a second and
+ *  policies can be compared offline. The trace has one event per line, #
+ *  starts a comment:
+ *
+ *  <ms> trans <rdkb-power-transition value>   e.g. 5000 trans POWER_TRANS_AC
+ *  <ms> temp <millidegrees C>                 a sample of the hottest zone
+ *
+ *  Timestamps are in ms and must not go backwards. Requests are coalesced
+ *  and arbitrated per axis like the executor does, see pwrMgr_arbiter.h.
+ *  Stopping or starting a component takes its modelled cost, the graph
+ *  edges are honoured and every component whose prerequisites are met is
+ *  in flight at once, like PwrMgr_CompGraph_Run. A request arriving during
+ *  a transition cancels it the same way: jobs already submitted finish,
+ *  nothing new is submitted.
+ *  Components that opt in to freezing are frozen and thawed at freezeMs
+ *  until they have been frozen for their dwell time, then they count as
+ *  stopped.
+ *
+ *  A policy is the daemon's power policy, see pwrMgr_policy.h, plus syscfg
+ *  style keys, see PwrMgr_Sim_SetOption. Requests for a state the power
+ *  policy switched off count as rejected.
+ */
+
+#ifndef _RDKB_POWER_MGR_SIM_H_
+#define _RDKB_POWER_MGR_SIM_H_
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "pwrMgr.h"
+#include "pwrMgr_arbiter.h"
+#include "pwrMgr_coalesce.h"
+#include "pwrMgr_compgraph.h"
+#include "pwrMgr_fsm.h"
+#include "pwrMgr_policy.h"
+#include "pwrMgr_thermal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Modelled costs when a policy does not give any
+#define PWRMGR_SIM_STOP_MS   2000
+#define PWRMGR_SIM_START_MS  5000
+#define PWRMGR_SIM_FREEZE_MS 50
+
+typedef struct
+{
+    long stopMs;
+    long startMs;
+} PWRMGR_SimCost;
+
+typedef struct
+{
+    PWRMGR_Policy power;        // Graph, run masks, states and timing as the daemon loads them
+    PWRMGR_Fsm fsm;
+    PWRMGR_ThermalConfig thermal;
+    PWRMGR_SimCost cost[PWRMGR_MAX_COMPONENTS];
+    bool freeze;                // Components with a freeze dwell are frozen first
+    long freezeMs;              // Cost of a freeze or a thaw
+} PWRMGR_SimPolicy;
+
+typedef struct
+{
+    long durationMs;            // Virtual time replayed
+    unsigned long events;       // Trace events
+    unsigned long requests;     // Power states requested, directly or by a thermal trip
+    unsigned long transitions;  // Transitions completed
+    unsigned long preempted;    // Transitions cancelled by a newer request
+    unsigned long rejected;     // Requests the transition table does not allow
+    unsigned long suppressed;   // Requests coalesced away
+    long timeInStateMs[PWRMGR_STATE_TOTAL];
+    long degradedMs;            // Time in states that shed components
+    long transitionMs;          // Time with a transition in flight
+    long downtimeMs[PWRMGR_MAX_COMPONENTS];  // From the stop submitted to the start done
+    long totalDowntimeMs;
+} PWRMGR_SimReport;
+
+typedef struct
+{
+    const PWRMGR_SimPolicy *policy;
+    PWRMGR_Coalescer co[PWRMGR_AXIS_TOTAL];
+    PWRMGR_CompMask runMask[PWRMGR_STATE_TOTAL];
+    PWRMGR_CompMask running;
+    PWRMGR_PwrState state;      // Last state reached
+    PWRMGR_PwrState target;     // State being worked towards
+    PWRMGR_PowerVector reached; // State of each axis last reached
+    PWRMGR_PowerVector wanted;  // State of each axis being worked towards
+    bool dirty;                 // running does not match target yet
+    int thermalLevel;
+    long startMs;               // -1 until the first event
+    long nowMs;
+    long lastEventMs;
+    long stateSinceMs;
+    // Transition in flight
+    bool busy;
+    bool cancelled;
+    PWRMGR_FsmAction steps[2];
+    int stepCount;
+    int step;
+    PWRMGR_FsmAction op;        // Step in flight, PWRMGR_FSM_ACT_NONE between steps
+    PWRMGR_CompMask opMask;
+    long opStartMs;
+    long opEndMs;
+    long busySinceMs;
+    long readyMs[PWRMGR_MAX_COMPONENTS];
+    long doneMs[PWRMGR_MAX_COMPONENTS];
+    // Per component
+    long downSinceMs[PWRMGR_MAX_COMPONENTS];
+    long frozenSinceMs[PWRMGR_MAX_COMPONENTS];  // -1 unless frozen
+    PWRMGR_SimReport report;
+} PWRMGR_Sim;
+
+void PwrMgr_Sim_DefaultPolicy(PWRMGR_SimPolicy *policy);
+int PwrMgr_Sim_SetOption(PWRMGR_SimPolicy *policy, const char *key, const char *value);
+void PwrMgr_Sim_Init(PWRMGR_Sim *sim, const PWRMGR_SimPolicy *policy, PWRMGR_PwrState state, long startMs);
+int PwrMgr_Sim_Request(PWRMGR_Sim *sim, long atMs, PWRMGR_PwrState target);
+int PwrMgr_Sim_Temperature(PWRMGR_Sim *sim, long atMs, int milliC);
+int PwrMgr_Sim_ReplayLine(PWRMGR_Sim *sim, char *line);
+int PwrMgr_Sim_Replay(PWRMGR_Sim *sim, FILE *fp, int *lineNo);
+void PwrMgr_Sim_Finish(PWRMGR_Sim *sim, PWRMGR_SimReport *report);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
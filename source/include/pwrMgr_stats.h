@@ -0,0 +1,92 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+/**
+ *  @file pwrMgr_stats.h
+ *  @brief RDKB Power Manger transition latency statistics
+ *
+ *  Fixed-bucket latency histograms, measured on the monotonic clock, for
+ *  every transition phase, every (from, to) state edge and every component
+ *  stop/start. All storage is static, recording never allocates.
+ *
+ *  Phases of a transition:
+ *  queue    request received until the executor picks it up
+ *  execute  picked up until every component matches the target
+ *  publish  rdkb-power-state update
+ *  total    request received until the new state is published
+ *
+ *  The daemon writes the histograms to PWRMGR_STATS_FILE after every
+ *  transition.
+ */
+
+#ifndef _RDKB_POWER_MGR_STATS_H_
+#define _RDKB_POWER_MGR_STATS_H_
+
+#include <stdint.h>
+#include "pwrMgr.h"
+#include "pwrMgr_compgraph.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PWRMGR_STATS_FILE "/tmp/rdkbPowerMgr_stats"
+#define PWRMGR_HIST_BUCKETS 16
+
+typedef enum
+{
+    PWRMGR_PHASE_QUEUE = 0,
+    PWRMGR_PHASE_EXECUTE,
+    PWRMGR_PHASE_PUBLISH,
+    PWRMGR_PHASE_TOTAL,
+    PWRMGR_PHASE_COUNT
+} PWRMGR_Phase;
+
+typedef struct
+{
+    uint32_t count;
+    uint64_t sumUs;
+    uint64_t maxUs;
+    uint32_t buckets[PWRMGR_HIST_BUCKETS];
+} PWRMGR_Histogram;
+
+typedef struct
+{
+    PWRMGR_Histogram phase[PWRMGR_PHASE_COUNT];
+    PWRMGR_Histogram edge[PWRMGR_STATE_TOTAL][PWRMGR_STATE_TOTAL];
+    PWRMGR_Histogram component[PWRMGR_MAX_COMPONENTS][2];  // Indexed by PWRMGR_UnitOp
+    uint64_t lastTotalUs;
+} PWRMGR_Stats;
+
+uint64_t PwrMgr_Stats_NowUs();
+void PwrMgr_Hist_Record(PWRMGR_Histogram *hist, uint64_t us);
+uint64_t PwrMgr_Hist_Percentile(const PWRMGR_Histogram *hist, int percent);
+uint64_t PwrMgr_Hist_BucketLimitUs(int bucket);
+
+void PwrMgr_Stats_Reset();
+void PwrMgr_Stats_RecordPhase(PWRMGR_Phase phase, uint64_t us);
+void PwrMgr_Stats_RecordEdge(PWRMGR_PwrState from, PWRMGR_PwrState to, uint64_t us);
+void PwrMgr_Stats_RecordComponent(int comp, PWRMGR_UnitOp op, uint64_t us);
+void PwrMgr_Stats_Get(PWRMGR_Stats *out);
+int PwrMgr_Stats_WriteFile(const char *path, const char *const *stateNames, const PWRMGR_CompGraph *graph);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
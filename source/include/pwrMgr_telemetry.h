@@ -0,0 +1,149 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+/**
+ *  @file pwrMgr_telemetry.h
+ *  @brief RDKB Power Manger shared memory telemetry
+ *
+ *  The daemon keeps its state and counters in the POSIX shared memory object
+ *  PWRMGR_TELEMETRY_SHM, so other processes can read them without a round
+ *  trip through syseventd. rdkb-power-state is still published as before.
+ *
+ *  The segment is guarded by a sequence lock. The only writer, the daemon,
+ *  makes seq odd while it updates and even again once done. Readers never
+ *  block the writer: PwrMgr_Telemetry_Read copies the segment and retries
+ *  if seq moved meanwhile. Consumers only need this header:
+ *
+ *      const PWRMGR_Telemetry *shm = PwrMgr_Telemetry_Attach(PWRMGR_TELEMETRY_SHM);
+ *      PWRMGR_Telemetry t;
+ *      if (shm != NULL && PwrMgr_Telemetry_Read(shm, &t) == 0)
+ *          printf("%s\n", t.stateNames[t.state]);
+ *
+ *  The layout does not depend on build options. New fields are only ever
+ *  appended and bump version; size tells readers how much is there.
+ *  Timestamps are CLOCK_MONOTONIC milliseconds. The time in each state is
+ *  accounted up to updatedMs, the current state has also been held since.
+ *  Energy saved is an estimate from the nominal power of the components
+ *  that are shed, see the power keyword in pwrMgr_compgraph.h.
+ */
+
+#ifndef _RDKB_POWER_MGR_TELEMETRY_H_
+#define _RDKB_POWER_MGR_TELEMETRY_H_
+
+#include <fcntl.h>
+#include <sched.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PWRMGR_TELEMETRY_SHM     "/rdkbPowerMgr.telemetry"
+#define PWRMGR_TELEMETRY_MAGIC   0x50574d54    // "PWMT"
+#define PWRMGR_TELEMETRY_VERSION 1
+#define PWRMGR_TELEMETRY_STATES  8
+#define PWRMGR_TELEMETRY_NAME_LEN 16
+#define PWRMGR_TELEMETRY_RETRIES 100
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;                  // Bytes of the segment in use
+    uint32_t seq;                   // Odd while the daemon is updating
+    uint32_t pid;
+    int32_t state;                  // Index into stateNames
+    int32_t target;                 // Differs from state during a transition
+    uint32_t running;               // Bit per shed component that is up
+    uint64_t updatedMs;
+    uint64_t stateSinceMs;
+    uint64_t timeInStateMs[PWRMGR_TELEMETRY_STATES];
+    uint32_t entries[PWRMGR_TELEMETRY_STATES];      // Times each state was reached
+    uint32_t transitions;
+    uint32_t savingMw;              // Nominal power of the components shed right now
+    uint64_t energySavedUj;
+    uint64_t lastLatencyUs;         // Request to published state
+    char stateNames[PWRMGR_TELEMETRY_STATES][PWRMGR_TELEMETRY_NAME_LEN];
+} PWRMGR_Telemetry;
+
+typedef struct
+{
+    int fd;
+    PWRMGR_Telemetry *shm;
+    char name[64];
+} PWRMGR_TelemetryWriter;
+
+int PwrMgr_Telemetry_Open(PWRMGR_TelemetryWriter *w, const char *name, const char *const *stateNames, int count);
+void PwrMgr_Telemetry_Update(PWRMGR_TelemetryWriter *w, int state, int target, uint32_t running, uint32_t savingMw, uint64_t nowMs);
+void PwrMgr_Telemetry_SetLatency(PWRMGR_TelemetryWriter *w, uint64_t latencyUs);
+void PwrMgr_Telemetry_Close(PWRMGR_TelemetryWriter *w);
+
+/**
+ *  @brief Map the daemon's segment read-only
+ *  @return the segment, NULL if the daemon has not created it
+ */
+static inline const PWRMGR_Telemetry *PwrMgr_Telemetry_Attach(const char *name)
+{
+    void *p;
+    int fd = shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+
+    if (fd < 0)
+        return NULL;
+    p = mmap(NULL, sizeof(PWRMGR_Telemetry), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    return (p == MAP_FAILED) ? NULL : (const PWRMGR_Telemetry *)p;
+}
+
+static inline void PwrMgr_Telemetry_Detach(const PWRMGR_Telemetry *shm)
+{
+    if (shm != NULL)
+        munmap((void *)shm, sizeof(PWRMGR_Telemetry));
+}
+
+/**
+ *  @brief Take a consistent copy of the segment, lock free
+ *  @return 0 on success, -1 if it is not a telemetry segment or kept changing
+ */
+static inline int PwrMgr_Telemetry_Read(const PWRMGR_Telemetry *shm, PWRMGR_Telemetry *out)
+{
+    int i;
+
+    for (i = 0; i < PWRMGR_TELEMETRY_RETRIES; i++) {
+        uint32_t before = __atomic_load_n(&shm->seq, __ATOMIC_ACQUIRE);
+
+        if (before & 1) {
+            // The daemon is half way through an update
+            sched_yield();
+            continue;
+        }
+        memcpy(out, (const void *)shm, sizeof(*out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&shm->seq, __ATOMIC_RELAXED) == before)
+            return (out->magic == PWRMGR_TELEMETRY_MAGIC) ? 0 : -1;
+    }
+    return -1;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,100 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+/**
+ *  @file pwrMgr_thermal.h
+ *  @brief RDKB Power Manger thermal monitor
+ *
+ *  Samples the thermal zones under /sys/class/thermal and requests power
+ *  states itself, rather than waiting for another process to set
+ *  rdkb-power-transition. The hottest zone is compared against trip points
+ *  in ascending order. A trip is entered at onMilliC and only left again
+ *  below offMilliC, so a temperature hovering on a threshold does not flap.
+ *  Heating up may skip levels, cooling down leaves one level per sample so
+ *  components are restored level by level.
+ *
+ *  Sampling is adaptive: every slowMs while well below the next trip, every
+ *  fastMs within marginMilliC of it or while any trip is active.
+ *
+ *  The monitor is driven by a timerfd. PwrMgr_Thermal_Fd is added to the
+ *  daemon's event loop and PwrMgr_Thermal_Dispatch called when it is
+ *  readable.
+ */
+
+#ifndef _RDKB_POWER_MGR_THERMAL_H_
+#define _RDKB_POWER_MGR_THERMAL_H_
+
+#include "pwrMgr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PWRMGR_THERMAL_ROOT "/sys/class/thermal"
+#define PWRMGR_THERMAL_MAX_ZONES 16
+#define PWRMGR_THERMAL_MAX_TRIPS 4
+
+typedef struct
+{
+    int onMilliC;               // Entered at or above this temperature
+    int offMilliC;              // Left below this temperature
+    PWRMGR_PwrState state;      // Requested when entered
+} PWRMGR_ThermalTrip;
+
+typedef struct
+{
+    char root[128];
+    PWRMGR_ThermalTrip trips[PWRMGR_THERMAL_MAX_TRIPS];  // Ascending
+    int tripCount;
+    PWRMGR_PwrState clearState; // Requested once every trip is left
+    int slowMs;
+    int fastMs;
+    int marginMilliC;
+} PWRMGR_ThermalConfig;
+
+// A different trip level was reached, state is the power state to request
+typedef void (*PWRMGR_ThermalFn)(void *ctx, PWRMGR_PwrState state, int milliC);
+
+typedef struct
+{
+    PWRMGR_ThermalConfig cfg;
+    PWRMGR_ThermalFn notify;
+    void *ctx;
+    int zoneFds[PWRMGR_THERMAL_MAX_ZONES];
+    int zoneCount;
+    int timerFd;
+    int level;                  // Trips currently active, 0 when clear
+    int lastMilliC;
+    int intervalMs;
+    unsigned long samples;
+} PWRMGR_ThermalMonitor;
+
+void PwrMgr_Thermal_DefaultConfig(PWRMGR_ThermalConfig *cfg);
+int PwrMgr_Thermal_Level(const PWRMGR_ThermalConfig *cfg, int level, int milliC);
+PWRMGR_PwrState PwrMgr_Thermal_LevelState(const PWRMGR_ThermalConfig *cfg, int level);
+int PwrMgr_Thermal_Open(PWRMGR_ThermalMonitor *mon, const PWRMGR_ThermalConfig *cfg, PWRMGR_ThermalFn notify, void *ctx);
+int PwrMgr_Thermal_Fd(PWRMGR_ThermalMonitor *mon);
+int PwrMgr_Thermal_Dispatch(PWRMGR_ThermalMonitor *mon);
+int PwrMgr_Thermal_Sample(PWRMGR_ThermalMonitor *mon);
+void PwrMgr_Thermal_Close(PWRMGR_ThermalMonitor *mon);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,115 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+/**
+ *  @file pwrMgr_unitctl.h
+ *  @brief RDKB Power Manger unit controller
+ *
+ *  The unit controller stops and starts the systemd units of the RDKB CCSP
+ *  components from inside the power manager. Jobs are submitted without
+ *  waiting, so every unit of a batch settles concurrently, and completions are
+ *  collected afterwards one at a time.
+ *
+ *  A run that gives up on jobs, because they timed out or were escalated,
+ *  tells the backend to forget them. Their late completions are then not
+ *  credited to whatever run reuses the job ids, and they do not hold on to
+ *  one of the PWRMGR_UNIT_MAX_JOBS slots.
+ *
+ *  A start job finishes once systemd has started the unit, which is not
+ *  necessarily when the component is serving. Backends that can tell also
+ *  report whether a unit is active, which the readiness check of
+ *  pwrMgr_compgraph.h asks once a component's ready file is there.
+ *
+ *  A stop that overruns its budget during an emergency is escalated: the
+ *  backend is asked to SIGKILL the unit and then to freeze it, see
+ *  PwrMgr_CompGraph_Shed. Backends that cannot do either leave them NULL.
+ *
+ *  The backend is pluggable. The daemon uses the systemd D-Bus backend when it
+ *  is built with systemd support and falls back to a systemctl child per
+ *  job, the unit tests plug in a mock bus.
+ */
+
+#ifndef _RDKB_POWER_MGR_UNITCTL_H_
+#define _RDKB_POWER_MGR_UNITCTL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Upper bound for a single batch, matches the systemd default stop timeout
+#define PWRMGR_UNIT_JOB_TIMEOUT_MS 90000
+#define PWRMGR_UNIT_MAX_JOBS 32
+#define PWRMGR_SYSTEMCTL "systemctl"
+
+typedef enum
+{
+    PWRMGR_UNIT_STOP = 0,
+    PWRMGR_UNIT_START
+} PWRMGR_UnitOp;
+
+typedef enum
+{
+    PWRMGR_UNIT_JOB_DONE = 0,
+    PWRMGR_UNIT_JOB_FAILED,
+    PWRMGR_UNIT_JOB_TIMEOUT
+} PWRMGR_UnitJobResult;
+
+typedef struct
+{
+    const char *name;  // Backend name used in logs
+    // Queue a stop/start job for unit. jobId is chosen by the caller and reported back by wait.
+    int  (*submit)(void *ctx, PWRMGR_UnitOp op, const char *unit, int jobId);
+    // Wait for the next job to finish. Returns 0 and fills jobId/result, 1 on timeout, -1 on error.
+    int  (*wait)(void *ctx, int timeoutMs, int *jobId, PWRMGR_UnitJobResult *result);
+    void (*close)(void *ctx);
+    // Whether unit is active: 1 if so, 0 if not yet, -1 if unknown. May be NULL.
+    int  (*active)(void *ctx, const char *unit);
+    // Send signal to every process of unit. Returns 0 on success, -1 on failure. May be NULL.
+    int  (*kill)(void *ctx, const char *unit, int signal);
+    // Freeze every process of unit. Returns 0 on success, -1 on failure. May be NULL.
+    int  (*freeze)(void *ctx, const char *unit);
+    // Drop a job nobody waits for any more, every pending job when jobId is -1. May be NULL.
+    void (*forget)(void *ctx, int jobId);
+} PWRMGR_UnitCtlOps;
+
+typedef struct
+{
+    const PWRMGR_UnitCtlOps *ops;
+    void *ctx;
+} PWRMGR_UnitCtl;
+
+int PwrMgr_UnitCtl_Submit(PWRMGR_UnitCtl *ctl, PWRMGR_UnitOp op, const char *unit, int jobId);
+int PwrMgr_UnitCtl_Wait(PWRMGR_UnitCtl *ctl, int timeoutMs, int *jobId, PWRMGR_UnitJobResult *result);
+int PwrMgr_UnitCtl_IsActive(PWRMGR_UnitCtl *ctl, const char *unit);
+int PwrMgr_UnitCtl_Kill(PWRMGR_UnitCtl *ctl, const char *unit, int signal);
+int PwrMgr_UnitCtl_Freeze(PWRMGR_UnitCtl *ctl, const char *unit);
+void PwrMgr_UnitCtl_Forget(PWRMGR_UnitCtl *ctl, int jobId);
+int PwrMgr_UnitCtl_RunBatch(PWRMGR_UnitCtl *ctl, PWRMGR_UnitOp op, const char **units, int count, int timeoutMs, PWRMGR_UnitJobResult *results);
+void PwrMgr_UnitCtl_Close(PWRMGR_UnitCtl *ctl);
+const char *PwrMgr_UnitCtl_OpStr(PWRMGR_UnitOp op);
+int PwrMgr_UnitCtl_OpenSystemctl(PWRMGR_UnitCtl *ctl, const char *path);
+
+#ifdef PWRMGR_SYSTEMD_SUPPORT
+int PwrMgr_UnitCtl_OpenSdBus(PWRMGR_UnitCtl *ctl);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,119 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ *  @file pwrMgr_wifi.h
+ *  @brief RDKB Power Manger Wi-Fi actuator
+ *
+ *  Degrades the radios per power state instead of stopping the Wi-Fi agent,
+ *  so recovering does not pay for a cold start and every client
+ *  reassociating. In order of cost to the customer a profile lowers the
+ *  transmit power, cuts the spatial streams and disables the radios of
+ *  whole bands, 6 GHz before 5 GHz; 2.4 GHz is never disabled.
+ *
+ *  The radios are reached through PWRMGR_WifiOps, backed by wifi_hal in
+ *  the daemon when built with --enable-wifihal. Like the CPU actuator, see
+ *  pwrMgr_cpu.h, anything a profile leaves unset goes back to the baseline,
+ *  the settings the first instance of the boot found, kept in a file.
+ *
+ *  The profiles of the supply and the thermal state are merged field by
+ *  field, the lower transmit power and stream cap and every band either
+ *  disables.
+ *
+ *  A restarted agent brings the radios up with its own configuration and a
+ *  thawed one may have missed writes, PwrMgr_Wifi_Reset makes the next
+ *  apply write every radio again.
+ */
+
+#ifndef _RDKB_POWER_MGR_WIFI_H_
+#define _RDKB_POWER_MGR_WIFI_H_
+
+#include <stdbool.h>
+#include "pwrMgr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PWRMGR_WIFI_BASELINE_FILE "/tmp/.rdkbPowerMgr.wifi"
+#define PWRMGR_WIFI_MAX_RADIOS 4
+
+typedef enum
+{
+    PWRMGR_WIFI_BAND_2G = 0,
+    PWRMGR_WIFI_BAND_5G,
+    PWRMGR_WIFI_BAND_6G,
+    PWRMGR_WIFI_BAND_TOTAL
+} PWRMGR_WifiBand;
+
+#define PWRMGR_WIFI_BAND_BIT(band) (1u << (band))
+
+typedef struct
+{
+    PWRMGR_WifiBand band;
+    bool enabled;
+    int txPowerPercent;
+    int streams;                // Transmit and receive chains in use
+} PWRMGR_WifiRadio;
+
+// Wi-Fi HAL, the radios are numbered from 0
+typedef struct
+{
+    int (*count)(void *ctx);
+    int (*read)(void *ctx, int radio, PWRMGR_WifiRadio *settings);
+    // Sets everything but the band, only called when something changes
+    int (*write)(void *ctx, int radio, const PWRMGR_WifiRadio *settings);
+} PWRMGR_WifiOps;
+
+typedef struct
+{
+    int txPowerPercent;         // Of the baseline, 0 keeps the baseline
+    int maxStreams;             // 0 keeps the baseline
+    unsigned bandsOff;          // PWRMGR_WIFI_BAND_BIT of the bands disabled, never 2.4 GHz
+} PWRMGR_WifiProfile;
+
+typedef struct
+{
+    const PWRMGR_WifiOps *ops;
+    void *ctx;
+    PWRMGR_WifiRadio baseline[PWRMGR_WIFI_MAX_RADIOS];
+    PWRMGR_WifiRadio current[PWRMGR_WIFI_MAX_RADIOS];  // As last read or written
+    int count;
+    PWRMGR_WifiProfile profiles[PWRMGR_STATE_TOTAL];
+    PWRMGR_WifiProfile last;    // Merged profile of the last apply
+    bool applied;               // Cleared until the first apply and by a reset
+    unsigned long writes;
+} PWRMGR_WifiActuator;
+
+void PwrMgr_Wifi_DefaultProfiles(PWRMGR_WifiProfile profiles[PWRMGR_STATE_TOTAL]);
+int PwrMgr_Wifi_ParseBands(const char *list, unsigned *bands);
+int PwrMgr_Wifi_Open(PWRMGR_WifiActuator *act, const PWRMGR_WifiOps *ops, void *ctx, const char *baselinePath);
+void PwrMgr_Wifi_SetProfile(PWRMGR_WifiActuator *act, PWRMGR_PwrState state, const PWRMGR_WifiProfile *profile);
+int PwrMgr_Wifi_Apply(PWRMGR_WifiActuator *act, PWRMGR_PwrState state);
+int PwrMgr_Wifi_ApplyStates(PWRMGR_WifiActuator *act, const PWRMGR_PwrState *states, int count);
+void PwrMgr_Wifi_Reset(PWRMGR_WifiActuator *act);
+#ifdef PWRMGR_WIFI_HAL_SUPPORT
+int PwrMgr_Wifi_OpenHal(PWRMGR_WifiActuator *act, const char *baselinePath);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -25,9 +25,11 @@
  *  @brief RDKB Power Manger
  *
  *  This file provides the implementation for the RDKB Power Manager. The
- *  processing here only handles the messaging to trigger power state transitions.
- *  There is an RDKB companion script which will perform the actual orderly
- *  shutdown and startup of the RDKB CCSP components.
+ *  processing here handles the messaging to trigger power state transitions and
+ *  stops/starts the RDKB CCSP components through the systemd unit controller.
+ *  Without sd-bus the same units are stopped and started with a systemctl
+ *  child per unit, so only the components a state sheds are touched either
+ *  way.
  *
  *  This code is listening for the following power system transition events:
  *  Transition from Battery to AC:
@@ -40,6 +42,41 @@
  *  rdkb-power-state AC
  *  rdkb-power-state BATTERY
  *
+ *  The supply and the thermal level are tracked separately, a thermal
+ *  request does not undo what the battery sheds and vice versa, see
+ *  pwrMgr_arbiter.h. With each state the daemon also publishes where both
+ *  axes are:
+ *  rdkb-power-supply AC|Battery
+ *  rdkb-power-thermal ThermalCooled|ThermalWarm|ThermalHot|ThermalCritical
+ *
+ *  Requests are coalesced: only the latest one is kept and it is acted on once
+ *  the per-state hysteresis and minimum dwell times have passed. The number of
+ *  requests that did not cause a transition is published as
+ *  rdkb-power-transition-suppressed.
+ *
+ *  Shedding for ThermalCritical, or any state the policy makes an emergency,
+ *  has to be done by a deadline. Components whose stop overran its budget
+ *  and had to be killed or frozen are published with the state as
+ *  rdkb-power-overrun-components.
+ *
+ *  Stopping the Wi-Fi agent is the last resort. In the milder states its
+ *  radios are degraded instead, lower transmit power, fewer streams and the
+ *  6 and 5 GHz bands off, see pwrMgr_wifi.h, so recovering needs no restart.
+ *
+ *  Clients can hold off transitions that would stop components, for the
+ *  length of a voice call or a firmware download, over the inhibitor socket,
+ *  see pwrMgr_inhibit.h. Critical levels are not held off. The number of
+ *  transitions held off and the time their components kept running are
+ *  published as rdkb-power-deferred and rdkb-power-deferred-ms.
+ *
+ *  An eco schedule sheds components by the time of day on top of whatever
+ *  the current state sheds, see pwrMgr_sched.h. The components shed by the
+ *  open windows are published as rdkb-power-eco-components.
+ *
+ *  The sysevent connection, the monitors' timers and the shutdown signals
+ *  share one epoll loop on the main thread. A dropped sysevent connection is
+ *  reopened with a backoff capped at one second.
+ *
  */
 
 /**************************************************************************/
@@ -53,26 +90,52 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/epoll.h>
 #include <sys/file.h>
 #include <sys/ioctl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/signalfd.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/un.h>
+#include <stddef.h>
 #include <unistd.h>
 #include <sysevent/sysevent.h>
 #include <syscfg/syscfg.h>
 #include <pthread.h>
 #include <stdarg.h>
+#include <time.h>
 #include "stdbool.h"
 #include "pwrMgr.h"
+#include "pwrMgr_unitctl.h"
+#include "pwrMgr_compgraph.h"
+#include "pwrMgr_arbiter.h"
+#include "pwrMgr_executor.h"
+#include "pwrMgr_fsm.h"
+#include "pwrMgr_stats.h"
+#include "pwrMgr_thermal.h"
+#include "pwrMgr_battery.h"
+#include "pwrMgr_loop.h"
+#include "pwrMgr_checkpoint.h"
+#include "pwrMgr_freezer.h"
+#include "pwrMgr_cpu.h"
+#include "pwrMgr_telemetry.h"
+#include "pwrMgr_policy.h"
+#include "pwrMgr_inhibit.h"
+#include "pwrMgr_wifi.h"
+#include "pwrMgr_sched.h"
 #include <pthread.h>
 #include "secure_wrapper.h"
+#ifdef PWRMGR_SYSTEMD_SUPPORT
+#include <systemd/sd-daemon.h>
+#endif
 /**************************************************************************/
 /*      LOCAL VARIABLES:                                                  */
 /**************************************************************************/
 static int sysevent_fd;
 static token_t sysevent_token;
-static pthread_t sysevent_tid;
 static int sysevent_fd_gs;
 static token_t sysevent_token_gs;
 
@@ -80,17 +143,11 @@ static token_t sysevent_token_gs;
 #include "breakpad_wrapper.h"
 #endif
 
-#define INFO  0
-#define WARNING  1
-#define ERROR 2
+#include "pwrMgr_log.h"
 
 #ifdef FEATURE_SUPPORT_RDKLOG
-#include "ccsp_trace.h"
 const char compName[25]="LOG.RDK.PWRMGR";
 #define DEBUG_INI_NAME  "/etc/debug.ini"
-#define PWRMGRLOG(x, ...) { if((x)==(INFO)){CcspTraceInfo((__VA_ARGS__));}else if((x)==(WARNING)){CcspTraceWarning((__VA_ARGS__));}else if((x)==(ERROR)){CcspTraceError((__VA_ARGS__));} }
-#else
-#define PWRMGRLOG(x, ...) {fprintf(stderr, "PowerMgrLog<%s:%d> ", __FUNCTION__, __LINE__);fprintf(stderr, __VA_ARGS__);}
 #endif
 
 #if defined (_XBB1_SUPPORTED_)
@@ -98,277 +155,1451 @@ const char compName[25]="LOG.RDK.PWRMGR";
 #include "mta_hal.h"
 #endif
 
-#define _DEBUG 1
-#define THREAD_NAME_LEN 16 //length is restricted to 16 characters, including the terminating null byte
-#define DATA_SIZE 1024
+#define _DEBUG 1
+#define DATA_SIZE 1024
+// sysevent connect retry backoff, replaces the old fixed 5 second sleeps
+#define SYSEVENT_RETRY_INITIAL_MS 100
+#define SYSEVENT_RETRY_MAX_MS 5000
+// Reconnecting at run time caps lower, events are lost while disconnected
+#define SYSEVENT_RECONNECT_MAX_MS 1000
+
+// Serialises sets from the executor thread with reconnects on the loop thread
+static pthread_mutex_t gSyseventLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Everything but the transitions runs on this loop, see PwrMgr_Run
+static PWRMGR_Loop gLoop;
+static int gSignalFd = -1;
+static int gReconnectFd = -1;
+static int gReconnectMs;
+static long gDisconnectedMs;
+#ifdef GTEST_ENABLE
+static volatile bool gSyseventHandling = false;
+#endif
+
+// Power states and the transitions between them, see pwrMgr_fsm.c
+static PWRMGR_Fsm gFsm;
+
+static PWRMGR_PwrState gCurPowerState;
+// Progress saved for a restart, and what PwrMgr_SetDefaults found in it
+static PWRMGR_Checkpoint gCheckpoint;
+static bool gResume = false;
+static PWRMGR_PwrState gResumeTarget;
+static PWRMGR_PowerVector gResumeWanted;
+static PWRMGR_CompMask gResumeRunning;
+// Components, their ordering and what each state sheds, see pwrMgr_policy.h.
+// Only the executor thread replaces gPolicy, under gPolicyLock and between transitions.
+static pthread_mutex_t gPolicyLock = PTHREAD_MUTEX_INITIALIZER;
+static const char *gPolicyPath = PWRMGR_POLICY_FILE;
+static PWRMGR_Policy gPolicyBoot;
+static PWRMGR_Policy *gPolicy = &gPolicyBoot;
+// Reloaded on the loop thread and waiting for the executor to adopt it
+static PWRMGR_Policy *gPolicyNext;
+static unsigned long gPolicyReloads;
+static int gPolicyFd = -1;
+static PWRMGR_UnitCtl gUnitCtl;
+static bool gUnitCtlReady = false;
+static const char *gSystemctl = PWRMGR_SYSTEMCTL;
+// Outcome of the transition in flight, published with the state it reaches
+static PWRMGR_CompMask gFailedComps;
+static PWRMGR_CompMask gOverrunComps;
+static long gRestoredMs = -1;
+// Sits in front of gUnitCtl and freezes the components that opted in
+static PWRMGR_Freezer gFreezer;
+static bool gFreezerReady = false;
+// Caps the clocks and parks cores in each power state
+static PWRMGR_CpuActuator gCpu;
+static bool gCpuReady = false;
+// Degrades the radios while the Wi-Fi agent, the component named gWifiComp, runs
+static PWRMGR_WifiActuator gWifi;
+static bool gWifiReady = false;
+static char gWifiComp[PWRMGR_COMP_NAME_LEN] = "wifi";
+#ifdef GTEST_ENABLE
+static const PWRMGR_WifiOps *gWifiTestOps = NULL;
+static void *gWifiTestCtx = NULL;
+#endif
+// Locks clients hold on transitions, see pwrMgr_inhibit.h
+static PWRMGR_Inhibitor gInhibit;
+static int gInhibitFd = -1;
+static int gInhibitClients;
+static char gInhibitPath[108];
+// Eco shedding is folded into every run mask, written under gPolicyLock
+static PWRMGR_Scheduler gSched;
+static bool gSchedReady = false;
+static PWRMGR_CompMask gEcoShed;
+
+// State and counters for other processes to read, see pwrMgr_telemetry.h
+static PWRMGR_TelemetryWriter gTelemetry;
+static long gInitStartMs;
+
+// Owns the transition thread and the set of running components
+static PWRMGR_Executor gExecutor;
+// Requests the thermal levels from the sysfs thermal zones
+static PWRMGR_ThermalMonitor gThermal;
+static bool gThermalReady = false;
+#if defined (_XBB1_SUPPORTED_)
+// Sheds components in tiers as the projected battery runtime drops
+static PWRMGR_BatteryMonitor gBattery;
+static bool gBatteryReady = false;
+static int gBatteryLevel = 0;
+#endif
+
+/**
+ *  @brief Monotonic clock in milliseconds
+ */
+static long PwrMgr_NowMs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ *  @brief Send a status such as READY=1 or STOPPING=1 to systemd
+ *
+ *  Speaks the sd_notify protocol directly when built without libsystemd so the
+ *  Type=notify unit works either way.
+ */
+static void PwrMgr_SdNotify(const char *status)
+{
+#ifdef PWRMGR_SYSTEMD_SUPPORT
+    sd_notify(0, status);
+#else
+    const char *sockPath = getenv("NOTIFY_SOCKET");
+    struct sockaddr_un addr;
+    int fd;
+
+    if (sockPath == NULL || (sockPath[0] != '/' && sockPath[0] != '@') || strlen(sockPath) >= sizeof(addr.sun_path))
+        return;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, sockPath);
+    if (addr.sun_path[0] == '@')
+        addr.sun_path[0] = '\0';
+
+    fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd >= 0) {
+        if (sendto(fd, status, strlen(status), 0, (struct sockaddr *)&addr, offsetof(struct sockaddr_un, sun_path) + strlen(sockPath)) < 0)
+            PWRMGRLOG(ERROR, "%s: sd_notify failed: %s\n",__FUNCTION__, strerror(errno));
+        close(fd);
+    }
+#endif
+}
+
+/**
+ *  @brief Set Power Manager system defaults
+ *  @return 0
+ */
+static void PwrMgr_SetDefaults()
+{
+    int i;
+
+    // Not sure what we should do here. Should we ask someone what the current state is? Basically if we
+    // boot up in battery mode are we going to get a later notification that there was a power state change?
+    // For now, we will call the mta hal to see what our current power state is.
+    gCurPowerState = PWRMGR_STATE_AC;
+#if defined (_XBB1_SUPPORTED_)
+    bool supplyKnown = false;
+    char status[DATA_SIZE] = {0};
+    ULONG len = sizeof(status);
+    int halStatus = RETURN_OK;
+
+    // Fetch the current battery status from mta - returns "AC", "Battery" or "Unknown"
+    halStatus = mta_hal_BatteryGetPowerStatus (status, &len);
+
+    if (halStatus == RETURN_OK && len > 0 && status[0] != 0) {
+        supplyKnown = true;
+        PWRMGRLOG(INFO, "%s: Power Manager mta_hal_BatteryGetPowerStatus returned %s\n",__FUNCTION__, status);
+
+        if (strcmp(status, PwrMgr_Fsm_StateStr(&gFsm, PWRMGR_STATE_BATT)) == 0) {
+            // The executor sheds the components as soon as it starts
+            gCurPowerState = PWRMGR_STATE_BATT;
+        }
+    } else {
+        PWRMGRLOG(ERROR, "%s: Power Manager mta_hal_BatteryGetPowerStatus call FAILED!\n",__FUNCTION__);
+    }
+#endif
+
+    // After a restart carry on from where the last instance got to
+    if (PwrMgr_Checkpoint_Load(PWRMGR_CHECKPOINT_FILE, &gCheckpoint) == 0 && gCheckpoint.compCount == gPolicy->graph.count) {
+        gResumeTarget = gCheckpoint.target;
+        gResumeRunning = gCheckpoint.running;
+        for (i = 0; i < PWRMGR_AXIS_TOTAL; i++)
+            gResumeWanted.axis[i] = gCheckpoint.axes[i];
+        // The supply may have changed while we were down, the HAL knows better
+#if defined (_XBB1_SUPPORTED_)
+        if (supplyKnown) {
+            gResumeWanted.axis[PWRMGR_AXIS_SUPPLY] = gCurPowerState;
+            if (PwrMgr_Arbiter_Axis(gResumeTarget) == PWRMGR_AXIS_SUPPLY)
+                gResumeTarget = gCurPowerState;
+        }
+#endif
+        gCurPowerState = gCheckpoint.state;
+        gResume = true;
+        PWRMGRLOG(INFO, "%s: resuming checkpoint %u, %s towards %s with components 0x%x running\n",__FUNCTION__, gCheckpoint.seq,
+                  PwrMgr_Fsm_StateStr(&gFsm, gCurPowerState), PwrMgr_Fsm_StateStr(&gFsm, gResumeTarget), gResumeRunning);
+    }
+
+    PWRMGRLOG(INFO, "%s: Power Manager initializing with %s\n",__FUNCTION__, PwrMgr_Fsm_StateStr(&gFsm, gCurPowerState));
+
+    // The notification is registered by now, so nobody can miss the initial state
+    PwrMgr_SyseventSetStr("rdkb-power-state", (unsigned char *)PwrMgr_Fsm_StateStr(&gFsm, gCurPowerState), 0);
+    PWRMGRLOG(INFO, "%s: initial power state published %ld ms after start\n",__FUNCTION__, PwrMgr_NowMs() - gInitStartMs);
+}
+
+/**
+ *  @brief Send sysevent string
+ *  @return 0
+ */
+int PwrMgr_SyseventSetStr(const char *name, unsigned char *value, int bufsz)
+{
+    int status;
+
+    pthread_mutex_lock(&gSyseventLock);
+    status = (sysevent_fd_gs >= 0) ? sysevent_set(sysevent_fd_gs, sysevent_token_gs, name, value, bufsz) : -1;
+    pthread_mutex_unlock(&gSyseventLock);
+    return status;
+}
+
+/**
+ *  @brief Open the in-process unit controller
+ *
+ *  Without sd-bus the units are driven through systemctl instead, still
+ *  exactly the components the executor asks for.
+ */
+static void PwrMgr_UnitCtlInit()
+{
+    if (gUnitCtlReady)
+        return;
+
+#ifdef PWRMGR_SYSTEMD_SUPPORT
+    if (PwrMgr_UnitCtl_OpenSdBus(&gUnitCtl) == 0) {
+        gUnitCtlReady = true;
+        return;
+    }
+#endif
+    if (PwrMgr_UnitCtl_OpenSystemctl(&gUnitCtl, gSystemctl) == 0) {
+        PWRMGRLOG(WARNING, "%s: systemd unreachable over D-Bus, using systemctl\n",__FUNCTION__);
+        gUnitCtlReady = true;
+        return;
+    }
+    PWRMGRLOG(ERROR, "%s: no unit controller, components cannot be stopped or started\n",__FUNCTION__);
+}
+
+#ifdef GTEST_ENABLE
+/**
+ *  @brief Test hook: drive components through ctl instead of systemd, call before PwrMgr_Init
+ */
+void PwrMgr_UseUnitCtl(const PWRMGR_UnitCtl *ctl)
+{
+    gUnitCtl = *ctl;
+    gUnitCtlReady = true;
+}
+
+/**
+ *  @brief Test hook: degrade the radios through ops instead of wifi_hal, call before PwrMgr_Init
+ */
+void PwrMgr_UseWifiOps(const PWRMGR_WifiOps *ops, void *ctx)
+{
+    gWifiTestOps = ops;
+    gWifiTestCtx = ctx;
+}
+
+/**
+ *  @brief Test hook: run path instead of PWRMGR_SYSTEMCTL when there is no sd-bus, call before PwrMgr_Init
+ */
+void PwrMgr_UseSystemctl(const char *path)
+{
+    gSystemctl = path;
+}
+
+/**
+ *  @brief Test hook: load and watch path instead of PWRMGR_POLICY_FILE, call before PwrMgr_Init
+ */
+void PwrMgr_UsePolicyFile(const char *path)
+{
+    gPolicyPath = path;
+}
+
+/**
+ *  @brief Test hook: wait until no notification is unread and no transition is pending or in flight
+ *  @return true when idle, false on timeout
+ */
+bool PwrMgr_WaitIdle(int timeoutMs)
+{
+    long deadline = PwrMgr_NowMs() + timeoutMs;
+
+    for (;;) {
+        struct pollfd pfd = { sysevent_fd, POLLIN, 0 };
+
+        if (!gSyseventHandling && (sysevent_fd < 0 || poll(&pfd, 1, 0) == 0))
+            break;
+        if (PwrMgr_NowMs() >= deadline)
+            return false;
+        usleep(1000);
+    }
+    return PwrMgr_Exec_WaitIdle(&gExecutor, deadline - PwrMgr_NowMs());
+}
+#endif
+
+/**
+ *  @brief Stop or start shed components on behalf of the executor
+ *  @return 0 on success
+ */
+static int PwrMgr_RunComponents(void *ctx, PWRMGR_PwrState target, PWRMGR_UnitOp op, PWRMGR_CompMask mask,
+                                PWRMGR_CancelFn cancelled, void *cancelArg, PWRMGR_CompMask *completed)
+{
+    PWRMGR_CompMask failed = 0;
+    long startMs = PwrMgr_NowMs();
+    int status = 0;
+
+    if (!gUnitCtlReady) {
+        *completed = 0;
+        gFailedComps |= mask;
+        return -1;
+    }
+
+    if (op == PWRMGR_UNIT_STOP && gPolicy->emergencyMs[target] > 0) {
+        PWRMGR_CompMask overrun = 0;
+
+        if (PwrMgr_CompGraph_Shed(&gPolicy->graph, &gUnitCtl, mask, (int)gPolicy->emergencyMs[target], cancelled, cancelArg, completed, &failed, &overrun) != 0) {
+            PWRMGRLOG(ERROR, "%s: components 0x%x could not be shed\n",__FUNCTION__, failed);
+            status = -1;
+        }
+        PWRMGRLOG(INFO, "%s: emergency shedding took %ld ms of %ld\n",__FUNCTION__, PwrMgr_NowMs() - startMs, gPolicy->emergencyMs[target]);
+        gOverrunComps |= overrun;
+    } else if (PwrMgr_CompGraph_Run(&gPolicy->graph, &gUnitCtl, op, mask, gPolicy->jobTimeoutMs, cancelled, cancelArg, completed, &failed) != 0) {
+        PWRMGRLOG(ERROR, "%s: components 0x%x did not %s\n",__FUNCTION__, failed, PwrMgr_UnitCtl_OpStr(op));
+        status = -1;
+    }
+    gFailedComps |= failed;
+    // Started components are only done once they are up, so this is when service is back
+    if (op == PWRMGR_UNIT_START && mask != 0)
+        gRestoredMs = PwrMgr_NowMs() - startMs;
+    return status;
+}
+
+/**
+ *  @brief Comma separated names of the components in mask
+ */
+static void PwrMgr_CompNames(PWRMGR_CompMask mask, char *buf, size_t size)
+{
+    size_t len = 0;
+    int i;
+
+    buf[0] = '\0';
+    for (i = 0; i < gPolicy->graph.count; i++) {
+        if (mask & PWRMGR_COMP_BIT(i))
+            len += snprintf(buf + len, size - len, "%s%s", len ? "," : "", gPolicy->graph.comps[i].name);
+    }
+}
+
+/**
+ *  @brief Publish how long restoring the components took, which of them failed and which overran
+ *
+ *  Runs before the new state is published, so whoever reacts to the state
+ *  sees the outcome of the transition that led to it.
+ */
+static void PwrMgr_PublishOutcome()
+{
+    char buf[PWRMGR_MAX_COMPONENTS * (PWRMGR_COMP_NAME_LEN + 1)];
+
+    PwrMgr_CompNames(gFailedComps, buf, sizeof(buf));
+    if (gFailedComps != 0)
+        PWRMGRLOG(ERROR, "%s: failed components: %s\n",__FUNCTION__, buf);
+    PwrMgr_SyseventSetStr("rdkb-power-failed-components", (unsigned char *)buf, 0);
+    gFailedComps = 0;
+
+    PwrMgr_CompNames(gOverrunComps, buf, sizeof(buf));
+    if (gOverrunComps != 0)
+        PWRMGRLOG(WARNING, "%s: components over their stop budget: %s\n",__FUNCTION__, buf);
+    PwrMgr_SyseventSetStr("rdkb-power-overrun-components", (unsigned char *)buf, 0);
+    gOverrunComps = 0;
+
+    if (gRestoredMs >= 0) {
+        PWRMGRLOG(INFO, "%s: service restored in %ld ms\n",__FUNCTION__, gRestoredMs);
+        snprintf(buf, sizeof(buf), "%ld", gRestoredMs);
+        PwrMgr_SyseventSetStr("rdkb-power-restored-ms", (unsigned char *)buf, 0);
+        gRestoredMs = -1;
+    }
+}
+
+/**
+ *  @brief Executor callback, every component matches the new state
+ */
+static void PwrMgr_StateReached(void *ctx, PWRMGR_PwrState from, PWRMGR_PwrState target, bool success)
+{
+    const PWRMGR_FsmTransition *trans = PwrMgr_Fsm_Lookup(&gFsm, from, target);
+    PWRMGR_PowerVector reached;
+
+    gCurPowerState = target;
+    if (success) {
+        PWRMGRLOG(INFO, "%s: Power transition from %s to %s Success\n",__FUNCTION__, PwrMgr_Fsm_TransStr(&gFsm, from), PwrMgr_Fsm_TransStr(&gFsm, target));
+    } else {
+        PWRMGRLOG(ERROR, "%s: Power transition from %s to %s FAILED for some components\n",__FUNCTION__, PwrMgr_Fsm_TransStr(&gFsm, from), PwrMgr_Fsm_TransStr(&gFsm, target));
+    }
+    PwrMgr_PublishOutcome();
+    // One transition can settle both axes, the state alone would only name the last request
+    PwrMgr_Exec_GetVectors(&gExecutor, &reached, NULL);
+    PwrMgr_SyseventSetStr("rdkb-power-supply", (unsigned char *)PwrMgr_Fsm_StateStr(&gFsm, reached.axis[PWRMGR_AXIS_SUPPLY]), 0);
+    PwrMgr_SyseventSetStr("rdkb-power-thermal", (unsigned char *)PwrMgr_Fsm_StateStr(&gFsm, reached.axis[PWRMGR_AXIS_THERMAL]), 0);
+    PwrMgr_SyseventSetStr("rdkb-power-state", (unsigned char *)PwrMgr_Fsm_StateStr(&gFsm, trans ? trans->publish : target), 0);
+}
+
+/**
+ *  @brief Executor callback, publish the number of suppressed requests
+ */
+static void PwrMgr_SuppressedChanged(void *ctx, unsigned long count)
+{
+    char buf[16];
+
+    snprintf(buf, sizeof(buf), "%lu", count);
+    PWRMGRLOG(INFO, "%s: %lu transition request(s) suppressed so far\n",__FUNCTION__, count);
+    PwrMgr_SyseventSetStr("rdkb-power-transition-suppressed", (unsigned char *)buf, 0);
+}
+
+/**
+ *  @brief Dump the latency histograms and publish the last transition latency
+ */
+static void PwrMgr_StatsUpdated(void *ctx, PWRMGR_PwrState from, PWRMGR_PwrState target, uint64_t totalUs)
+{
+    const char *stateNames[PWRMGR_STATE_TOTAL];
+    char buf[32];
+    int i;
+
+    for (i = 0; i < PWRMGR_STATE_TOTAL; i++)
+        stateNames[i] = PwrMgr_Fsm_StateStr(&gFsm, i);
+
+    PWRMGRLOG(INFO, "%s: %s to %s took %llu us\n",__FUNCTION__, stateNames[from], stateNames[target], (unsigned long long)totalUs);
+    PwrMgr_Stats_WriteFile(PWRMGR_STATS_FILE, stateNames, &gPolicy->graph);
+    if (totalUs != 0) {
+        PwrMgr_Telemetry_SetLatency(&gTelemetry, totalUs);
+        snprintf(buf, sizeof(buf), "%llu", (unsigned long long)(totalUs / 1000));
+        PwrMgr_SyseventSetStr("rdkb-power-transition-latency-ms", (unsigned char *)buf, 0);
+    }
+}
+
+/**
+ *  @brief Update the shared memory telemetry, the components not running count as saving power
+ */
+static void PwrMgr_TelemetryUpdate(PWRMGR_PwrState state, PWRMGR_PwrState target, PWRMGR_CompMask running)
+{
+    PWRMGR_CompMask shed = PwrMgr_CompGraph_AllMask(&gPolicy->graph) & ~running;
+
+    PwrMgr_Telemetry_Update(&gTelemetry, state, target, running, PwrMgr_CompGraph_PowerMw(&gPolicy->graph, shed), PwrMgr_NowMs());
+}
+
+/**
+ *  @brief Create the shared memory telemetry segment
+ */
+static void PwrMgr_TelemetryInit()
+{
+    const char *stateNames[PWRMGR_STATE_TOTAL];
+    int i;
+
+    for (i = 0; i < PWRMGR_STATE_TOTAL; i++)
+        stateNames[i] = PwrMgr_Fsm_StateStr(&gFsm, i);
+    if (PwrMgr_Telemetry_Open(&gTelemetry, PWRMGR_TELEMETRY_SHM, stateNames, PWRMGR_STATE_TOTAL) != 0)
+        PWRMGRLOG(WARNING, "%s: telemetry only available through sysevent\n",__FUNCTION__);
+}
+
+/**
+ *  @brief Apply the Wi-Fi profiles of the states the axes are heading for while the agent runs
+ *
+ *  A stopped or frozen agent cannot take them, they are applied in full
+ *  once the agent is back.
+ */
+static void PwrMgr_WifiUpdate(const PWRMGR_PowerVector *wanted, PWRMGR_CompMask running)
+{
+    int comp = PwrMgr_CompGraph_Find(&gPolicy->graph, gWifiComp);
+
+    if (comp >= 0 && !(running & PWRMGR_COMP_BIT(comp))) {
+        PwrMgr_Wifi_Reset(&gWifi);
+        return;
+    }
+    PwrMgr_Wifi_ApplyStates(&gWifi, wanted->axis, PWRMGR_AXIS_TOTAL);
+}
+
+/**
+ *  @brief Checkpoint transition progress so a restart can pick up from here
+ *
+ *  A transition starting is also when the CPU and Wi-Fi profiles of the
+ *  states the axes are heading for are applied, merged field by field.
+ */
+static void PwrMgr_Progress(void *ctx, PWRMGR_PwrState state, PWRMGR_PwrState target, PWRMGR_CompMask running)
+{
+    PWRMGR_PowerVector wanted;
+    int i;
+
+    PwrMgr_Exec_GetVectors(&gExecutor, NULL, &wanted);
+    // Clocks go down before any component is shed and back up before any is restarted
+    if (gCpuReady)
+        PwrMgr_Cpu_ApplyStates(&gCpu, wanted.axis, PWRMGR_AXIS_TOTAL);
+    if (gWifiReady)
+        PwrMgr_WifiUpdate(&wanted, running);
+    PwrMgr_TelemetryUpdate(state, target, running);
+
+    if (gCheckpoint.seq != 0 && gCheckpoint.state == state && gCheckpoint.target == target && gCheckpoint.running == running &&
+        memcmp(gCheckpoint.axes, wanted.axis, sizeof(gCheckpoint.axes)) == 0)
+        return;
+
+    gCheckpoint.seq++;
+    gCheckpoint.state = state;
+    gCheckpoint.target = target;
+    for (i = 0; i < PWRMGR_AXIS_TOTAL; i++)
+        gCheckpoint.axes[i] = wanted.axis[i];
+    gCheckpoint.running = running;
+    gCheckpoint.compCount = gPolicy->graph.count;
+    if (PwrMgr_Checkpoint_Save(PWRMGR_CHECKPOINT_FILE, &gCheckpoint) != 0)
+        PWRMGRLOG(WARNING, "%s: failed to write %s\n",__FUNCTION__, PWRMGR_CHECKPOINT_FILE);
+}
+
+/**
+ *  @brief Read a numeric syscfg value
+ *  @return the value, def if unset or not a number
+ */
+static long PwrMgr_SyscfgGetLong(const char *key, long def)
+{
+    char buf[16];
+    char *end;
+    long value;
+
+    if (syscfg_get(NULL, key, buf, sizeof(buf)) != 0 || buf[0] == '\0')
+        return def;
+    value = strtol(buf, &end, 10);
+    return (end != buf) ? value : def;
+}
+
+#if defined (_XBB1_SUPPORTED_)
+/**
+ *  @brief Components running on battery at a battery level, each tier sheds more
+ */
+static PWRMGR_CompMask PwrMgr_BatteryRunMask(const PWRMGR_Policy *policy, int level)
+{
+    return policy->runMask[PWRMGR_STATE_BATT] & ~PwrMgr_CompGraph_BattShedMask(&policy->graph, level > 0 ? level : 1);
+}
+#endif
+
+/**
+ *  @brief Components running in a state, less the battery tiers and the eco schedule shed
+ */
+static PWRMGR_CompMask PwrMgr_StateRunMask(const PWRMGR_Policy *policy, PWRMGR_PwrState state)
+{
+    PWRMGR_CompMask runMask = policy->runMask[state];
+
+#if defined (_XBB1_SUPPORTED_)
+    // The battery policy sheds more as the runtime drops, see PwrMgr_BatteryChanged
+    if (state == PWRMGR_STATE_BATT)
+        runMask = PwrMgr_BatteryRunMask(policy, gBatteryLevel);
+#endif
+    return runMask & ~gEcoShed;
+}
+
+/**
+ *  @brief Hand the run masks, the states that are on and the timing of a policy to the executor
+ *
+ *  PwrMgrHysteresisMs_<state> and PwrMgrMinDwellMs_<state> in syscfg still
+ *  override the policy's timing on a single box.
+ */
+static void PwrMgr_PolicyApply(const PWRMGR_Policy *policy)
+{
+    char key[64];
+    int i;
+
+    for (i = PWRMGR_STATE_UNKNOWN + 1; i < PWRMGR_STATE_TOTAL; i++) {
+        const char *state = PwrMgr_Fsm_StateStr(&gFsm, i);
+        PWRMGR_CompMask runMask = PwrMgr_StateRunMask(policy, i);
+        long hysteresisMs;
+        long minDwellMs;
+
+        snprintf(key, sizeof(key), "PwrMgrHysteresisMs_%s", state);
+        hysteresisMs = PwrMgr_SyscfgGetLong(key, policy->timing[i].hysteresisMs);
+        snprintf(key, sizeof(key), "PwrMgrMinDwellMs_%s", state);
+        minDwellMs = PwrMgr_SyscfgGetLong(key, policy->timing[i].minDwellMs);
+
+        PwrMgr_Exec_SetEnabled(&gExecutor, i, policy->enabled[i]);
+        PwrMgr_Exec_SetRunMask(&gExecutor, i, runMask);
+        PwrMgr_Exec_SetTiming(&gExecutor, i, hysteresisMs, minDwellMs);
+        PwrMgr_Exec_SetSeverity(&gExecutor, i, policy->timing[i].severity);
+        PWRMGRLOG(INFO, "%s: %s %s, components 0x%x running, hysteresis %ld ms, minimum dwell %ld ms\n",__FUNCTION__,
+                  state, policy->enabled[i] ? "on" : "off", runMask, hysteresisMs, minDwellMs);
+    }
+}
+
+/**
+ *  @brief Switch to a reloaded policy, runs on the executor thread between transitions
+ *
+ *  Nothing else on this thread is using the old policy, and the loop thread
+ *  only looks at it under gPolicyLock, so it can go straight away.
+ */
+static void PwrMgr_PolicyAdopt()
+{
+    PWRMGR_Policy *old = NULL;
+    char buf[16];
+
+    pthread_mutex_lock(&gPolicyLock);
+    if (gPolicyNext != NULL) {
+        old = gPolicy;
+        gPolicy = gPolicyNext;
+        gPolicyNext = NULL;
+        PwrMgr_PolicyApply(gPolicy);
+        gPolicyReloads++;
+    }
+    pthread_mutex_unlock(&gPolicyLock);
+
+    if (old == NULL)
+        return;
+    if (old != &gPolicyBoot)
+        free(old);
+    PWRMGRLOG(INFO, "%s: policy reload %lu applied\n",__FUNCTION__, gPolicyReloads);
+    snprintf(buf, sizeof(buf), "%lu", gPolicyReloads);
+    PwrMgr_SyseventSetStr("rdkb-power-policy-reloads", (unsigned char *)buf, 0);
+}
+
+/**
+ *  @brief Executor idle callback, adopt a reloaded policy and stop the components frozen for too long
+ *  @return ms until the next one is due, -1 when nothing is frozen
+ */
+static long PwrMgr_ExecIdle(void *ctx)
+{
+    PwrMgr_PolicyAdopt();
+    return gFreezerReady ? PwrMgr_Freezer_Expire(&gFreezer, PwrMgr_NowMs()) : -1;
+}
+
+/**
+ *  @brief Executor callback, hold off a teardown while a client holds a lock on its axis
+ *
+ *  Critical levels and whatever else the policy treats as an emergency go ahead regardless.
+ *  @return ms until the lock runs out, 0 to go ahead
+ */
+static long PwrMgr_Inhibited(void *ctx, PWRMGR_PwrState target, PWRMGR_CompMask stops)
+{
+    if (stops == 0 || target == PWRMGR_STATE_CRITICAL || gPolicy->emergencyMs[target] > 0)
+        return 0;
+    return PwrMgr_Inhibit_Check(&gInhibit, PwrMgr_Arbiter_Axis(target), PwrMgr_NowMs(), NULL, 0);
+}
+
+/**
+ *  @brief Executor callback, publish how many transitions were held off and for how long
+ */
+static void PwrMgr_DeferredChanged(void *ctx, unsigned long count, uint64_t totalMs)
+{
+    char buf[32];
+
+    PWRMGRLOG(INFO, "%s: %lu transition(s) held off for %llu ms in total\n",__FUNCTION__, count, (unsigned long long)totalMs);
+    snprintf(buf, sizeof(buf), "%lu", count);
+    PwrMgr_SyseventSetStr("rdkb-power-deferred", (unsigned char *)buf, 0);
+    snprintf(buf, sizeof(buf), "%llu", (unsigned long long)totalMs);
+    PwrMgr_SyseventSetStr("rdkb-power-deferred-ms", (unsigned char *)buf, 0);
+}
+
+static const PWRMGR_ExecOps pwrMgrExecOps = {
+    PwrMgr_RunComponents,
+    PwrMgr_StateReached,
+    PwrMgr_SuppressedChanged,
+    PwrMgr_StatsUpdated,
+    PwrMgr_Progress,
+    PwrMgr_ExecIdle,
+    PwrMgr_Inhibited,
+    PwrMgr_DeferredChanged
+};
+
+/**
+ *  @brief Freeze the components that opted in instead of stopping them
+ *
+ *  PwrMgrFreezeMode=false stops every component as before. The cgroups are
+ *  looked up under PwrMgrCgroupRoot, PWRMGR_CGROUP_ROOT by default. Without
+ *  cgroup v2 each freeze fails and the component is stopped instead.
+ */
+static void PwrMgr_FreezerInit(PWRMGR_CompMask running)
+{
+    const char *root = PWRMGR_CGROUP_ROOT;
+    char path[128];
+    char buf[16];
+    int i;
+
+    if (!gUnitCtlReady)
+        return;
+    if (syscfg_get(NULL, "PwrMgrFreezeMode", buf, sizeof(buf)) == 0 && strcmp(buf, "false") == 0) {
+        PWRMGRLOG(INFO, "%s: freeze mode disabled\n",__FUNCTION__);
+        return;
+    }
+    if (syscfg_get(NULL, "PwrMgrCgroupRoot", path, sizeof(path)) == 0 && path[0] != '\0')
+        root = path;
+
+    for (i = 0; i < gPolicy->graph.count; i++) {
+        const PWRMGR_Component *comp = &gPolicy->graph.comps[i];
+
+        if (comp->freezeDwellMs <= 0)
+            continue;
+        if (!gFreezerReady) {
+            if (PwrMgr_Freezer_Open(&gFreezer, root, &gUnitCtl, &gUnitCtl) != 0)
+                return;
+            gFreezerReady = true;
+        }
+        PwrMgr_Freezer_AddUnit(&gFreezer, comp->unit, comp->freezeDwellMs, !(running & PWRMGR_COMP_BIT(i)));
+        PWRMGRLOG(INFO, "%s: %s is frozen for up to %ld ms before it is stopped\n",__FUNCTION__, comp->name, comp->freezeDwellMs);
+    }
+}
+
+/**
+ *  @brief Set up the CPU actuator and apply the profiles of the initial states
+ *
+ *  PwrMgrCpuActuator=false leaves clocks and cores alone. The profiles can
+ *  be changed per state with PwrMgrCpuGovernor_<state>,
+ *  PwrMgrCpuMaxFreqPct_<state> and PwrMgrCpuOnline_<state>, where 0 or an
+ *  empty governor keeps the baseline.
+ */
+static void PwrMgr_CpuInit()
+{
+    const char *root = PWRMGR_CPU_ROOT;
+    PWRMGR_PowerVector wanted;
+    char path[128];
+    char key[64];
+    char buf[16];
+    int i;
+
+    if (syscfg_get(NULL, "PwrMgrCpuActuator", buf, sizeof(buf)) == 0 && strcmp(buf, "false") == 0) {
+        PWRMGRLOG(INFO, "%s: CPU actuator disabled\n",__FUNCTION__);
+        return;
+    }
+    if (syscfg_get(NULL, "PwrMgrCpuRoot", path, sizeof(path)) == 0 && path[0] != '\0')
+        root = path;
+    if (PwrMgr_Cpu_Open(&gCpu, root, PWRMGR_CPU_BASELINE_FILE) != 0)
+        return;
+
+    for (i = PWRMGR_STATE_UNKNOWN + 1; i < PWRMGR_STATE_TOTAL; i++) {
+        PWRMGR_CpuProfile profile = gCpu.profiles[i];
+        const char *state = PwrMgr_Fsm_StateStr(&gFsm, i);
+
+        snprintf(key, sizeof(key), "PwrMgrCpuGovernor_%s", state);
+        if (syscfg_get(NULL, key, buf, sizeof(buf)) == 0)
+            snprintf(profile.governor, sizeof(profile.governor), "%s", buf);
+        snprintf(key, sizeof(key), "PwrMgrCpuMaxFreqPct_%s", state);
+        profile.maxFreqPercent = (int)PwrMgr_SyscfgGetLong(key, profile.maxFreqPercent);
+        snprintf(key, sizeof(key), "PwrMgrCpuOnline_%s", state);
+        profile.onlineCpus = (int)PwrMgr_SyscfgGetLong(key, profile.onlineCpus);
+        PwrMgr_Cpu_SetProfile(&gCpu, i, &profile);
+    }
+
+    gCpuReady = true;
+    PwrMgr_Exec_GetVectors(&gExecutor, NULL, &wanted);
+    PwrMgr_Cpu_ApplyStates(&gCpu, wanted.axis, PWRMGR_AXIS_TOTAL);
+}
+
+/**
+ *  @brief Set up the Wi-Fi actuator and apply the profiles of the initial states
+ *
+ *  Needs a build with --enable-wifihal, PwrMgrWifiActuator=false leaves the
+ *  radios alone. PwrMgrWifiComponent names the component of the agent. The
+ *  profiles can be changed per state with PwrMgrWifiTxPowerPct_<state>,
+ *  PwrMgrWifiStreams_<state>, where 0 keeps the baseline, and
+ *  PwrMgrWifiBandsOff_<state>, a list such as "5GHz,6GHz" or "none".
+ */
+static void PwrMgr_WifiInit(PWRMGR_CompMask running)
+{
+    PWRMGR_PowerVector wanted;
+    char key[64];
+    char buf[32];
+    int status = -1;
+    int i;
+
+    if (syscfg_get(NULL, "PwrMgrWifiActuator", buf, sizeof(buf)) == 0 && strcmp(buf, "false") == 0) {
+        PWRMGRLOG(INFO, "%s: Wi-Fi actuator disabled\n",__FUNCTION__);
+        return;
+    }
+#ifdef GTEST_ENABLE
+    if (gWifiTestOps != NULL)
+        status = PwrMgr_Wifi_Open(&gWifi, gWifiTestOps, gWifiTestCtx, PWRMGR_WIFI_BASELINE_FILE);
+#elif defined (PWRMGR_WIFI_HAL_SUPPORT)
+    status = PwrMgr_Wifi_OpenHal(&gWifi, PWRMGR_WIFI_BASELINE_FILE);
+#endif
+    if (status != 0) {
+        PWRMGRLOG(INFO, "%s: no Wi-Fi actuator, the agent is only ever stopped\n",__FUNCTION__);
+        return;
+    }
+    if (syscfg_get(NULL, "PwrMgrWifiComponent", buf, sizeof(buf)) == 0 && buf[0] != '\0')
+        snprintf(gWifiComp, sizeof(gWifiComp), "%s", buf);
+
+    for (i = PWRMGR_STATE_UNKNOWN + 1; i < PWRMGR_STATE_TOTAL; i++) {
+        PWRMGR_WifiProfile profile = gWifi.profiles[i];
+        const char *state = PwrMgr_Fsm_StateStr(&gFsm, i);
+
+        snprintf(key, sizeof(key), "PwrMgrWifiTxPowerPct_%s", state);
+        profile.txPowerPercent = (int)PwrMgr_SyscfgGetLong(key, profile.txPowerPercent);
+        snprintf(key, sizeof(key), "PwrMgrWifiStreams_%s", state);
+        profile.maxStreams = (int)PwrMgr_SyscfgGetLong(key, profile.maxStreams);
+        snprintf(key, sizeof(key), "PwrMgrWifiBandsOff_%s", state);
+        if (syscfg_get(NULL, key, buf, sizeof(buf)) == 0 && PwrMgr_Wifi_ParseBands(buf, &profile.bandsOff) != 0) {
+            PWRMGRLOG(WARNING, "%s: ignoring %s=%s\n",__FUNCTION__, key, buf);
+            profile.bandsOff = gWifi.profiles[i].bandsOff;
+        }
+        PwrMgr_Wifi_SetProfile(&gWifi, i, &profile);
+    }
+
+    gWifiReady = true;
+    PwrMgr_Exec_GetVectors(&gExecutor, NULL, &wanted);
+    PwrMgr_WifiUpdate(&wanted, running);
+}
+
+/**
+ *  @brief Scheduler callback, an eco window opened or closed
+ *
+ *  Runs on the loop thread. Every state's run mask changes, the executor
+ *  reconciles the current one straight away.
+ */
+static void PwrMgr_EcoChanged(void *ctx, PWRMGR_CompMask shed)
+{
+    char buf[PWRMGR_MAX_COMPONENTS * (PWRMGR_COMP_NAME_LEN + 1)];
+    int i;
+
+    pthread_mutex_lock(&gPolicyLock);
+    gEcoShed = shed;
+    if (gSchedReady) {
+        for (i = PWRMGR_STATE_UNKNOWN + 1; i < PWRMGR_STATE_TOTAL; i++)
+            PwrMgr_Exec_SetRunMask(&gExecutor, i, PwrMgr_StateRunMask(gPolicy, i));
+    }
+    PwrMgr_CompNames(shed, buf, sizeof(buf));
+    pthread_mutex_unlock(&gPolicyLock);
+
+    PWRMGRLOG(INFO, "%s: eco schedule sheds 0x%x (%s)\n",__FUNCTION__, shed, buf);
+    PwrMgr_SyseventSetStr("rdkb-power-eco-components", (unsigned char *)buf, 0);
+}
+
+/**
+ *  @brief Loop callback, an eco window edge is due or the clock was set
+ */
+static void PwrMgr_SchedReadable(void *arg, int fd, uint32_t events)
+{
+    PwrMgr_Sched_Dispatch(&gSched);
+}
+
+/**
+ *  @brief The eco windows to run, PwrMgrEcoSchedule in syscfg overrides the policy's
+ *
+ *  "none" switches the schedule off on a single box. A value that does not
+ *  parse is ignored.
+ */
+static void PwrMgr_EcoWindows(const PWRMGR_Policy *policy, PWRMGR_EcoWindow *windows, int *count)
+{
+    char buf[256];
+
+    if (syscfg_get(NULL, "PwrMgrEcoSchedule", buf, sizeof(buf)) == 0 && buf[0] != '\0') {
+        if (PwrMgr_Policy_ParseEco(policy, buf, windows, count) == 0)
+            return;
+        PWRMGRLOG(ERROR, "%s: PwrMgrEcoSchedule \"%s\" is invalid, using the policy's\n",__FUNCTION__, buf);
+    }
+    memcpy(windows, policy->eco, sizeof(policy->eco));
+    *count = policy->ecoCount;
+}
+
+/**
+ *  @brief Start the eco schedule, runs before the executor gets its first run masks
+ */
+static void PwrMgr_SchedInit()
+{
+    PWRMGR_EcoWindow windows[PWRMGR_SCHED_MAX_WINDOWS];
+    int count;
+
+    if (PwrMgr_Sched_Open(&gSched, PwrMgr_EcoChanged, NULL) != 0)
+        return;
+    PwrMgr_EcoWindows(gPolicy, windows, &count);
+    if (PwrMgr_Sched_Set(&gSched, windows, count, time(NULL)) != 0 ||
+        PwrMgr_Loop_Add(&gLoop, PwrMgr_Sched_Fd(&gSched), PwrMgr_SchedReadable, NULL) != 0) {
+        PWRMGRLOG(ERROR, "%s: eco schedule not started\n",__FUNCTION__);
+        PwrMgr_Sched_Close(&gSched);
+        gEcoShed = 0;
+        return;
+    }
+    if (count > 0)
+        PWRMGRLOG(INFO, "%s: %d eco windows, shedding 0x%x now\n",__FUNCTION__, count, gEcoShed);
+    gSchedReady = true;
+}
+
+/**
+ *  @brief Set up and start the transition executor
+ *
+ *  Every shed component is assumed to be running at startup. When we boot
+ *  into a shedding state the executor stops them straight away. After a
+ *  restart the checkpoint says what is running and where each axis was
+ *  heading, so only the steps that had not finished are run.
+ *  @return 0 on success
+ */
+static int PwrMgr_ExecutorInit()
+{
+    PWRMGR_CompMask all = PwrMgr_CompGraph_AllMask(&gPolicy->graph);
+    PWRMGR_CompMask running = gResume ? gResumeRunning : all;
+    PWRMGR_PowerVector reached;
+    int i;
+
+    PwrMgr_Exec_Init(&gExecutor, &pwrMgrExecOps, NULL, gCurPowerState, running);
+    PwrMgr_TelemetryUpdate(gCurPowerState, gResume ? gResumeTarget : gCurPowerState, running);
+    PwrMgr_Exec_SetFsm(&gExecutor, &gFsm);
+
+    if (syscfg_init() != 0)
+        PWRMGRLOG(WARNING, "%s: syscfg_init failed, using the policy's transition timing\n",__FUNCTION__);
+    // Windows already open are in the first run masks, nothing is started just to be shed
+    PwrMgr_SchedInit();
+    PwrMgr_PolicyApply(gPolicy);
+
+    PwrMgr_FreezerInit(running);
+    PwrMgr_CpuInit();
+    PwrMgr_WifiInit(running);
+    if (gResume) {
+        // The axis of the target goes last, its state is the one published
+        PwrMgr_Exec_GetVectors(&gExecutor, &reached, NULL);
+        for (i = 0; i < PWRMGR_AXIS_TOTAL; i++) {
+            if (i != PwrMgr_Arbiter_Axis(gResumeTarget) && gResumeWanted.axis[i] != reached.axis[i])
+                PwrMgr_Exec_Resume(&gExecutor, gResumeWanted.axis[i]);
+        }
+        if (gResumeTarget != gCurPowerState)
+            PwrMgr_Exec_Resume(&gExecutor, gResumeTarget);
+    }
+
+    return PwrMgr_Exec_Start(&gExecutor);
+}
+
+/**
+ *  @brief Thermal monitor callback, a trip point was crossed
+ */
+static void PwrMgr_ThermalChanged(void *ctx, PWRMGR_PwrState state, int milliC)
+{
+    PWRMGRLOG(INFO, "%s: %d mC, requesting %s\n",__FUNCTION__, milliC, PwrMgr_Fsm_StateStr(&gFsm, state));
+    PwrMgr_Exec_Post(&gExecutor, state);
+}
+
+/**
+ *  @brief Loop callback, the next thermal sample is due
+ */
+static void PwrMgr_ThermalReadable(void *arg, int fd, uint32_t events)
+{
+    PwrMgr_Thermal_Dispatch(&gThermal);
+}
+
+/**
+ *  @brief Start the built-in thermal monitor unless disabled in syscfg
+ *
+ *  Trip points can be moved with PwrMgrThermalOnMilliC_<state> and
+ *  PwrMgrThermalOffMilliC_<state>, e.g. PwrMgrThermalOnMilliC_ThermalHot.
+ *
+ *  Without readable thermal zones the daemon keeps relying on
+ *  rdkb-power-transition requests from other processes.
+ */
+static void PwrMgr_ThermalInit()
+{
+    PWRMGR_ThermalConfig cfg;
+    char key[64];
+    char buf[16];
+    int i;
+
+    if (syscfg_get(NULL, "PwrMgrThermalMonitor", buf, sizeof(buf)) == 0 && strcmp(buf, "false") == 0) {
+        PWRMGRLOG(INFO, "%s: thermal monitor disabled\n",__FUNCTION__);
+        return;
+    }
+
+    PwrMgr_Thermal_DefaultConfig(&cfg);
+    for (i = 0; i < cfg.tripCount; i++) {
+        const char *state = PwrMgr_Fsm_StateStr(&gFsm, cfg.trips[i].state);
+
+        snprintf(key, sizeof(key), "PwrMgrThermalOnMilliC_%s", state);
+        cfg.trips[i].onMilliC = PwrMgr_SyscfgGetLong(key, cfg.trips[i].onMilliC);
+        snprintf(key, sizeof(key), "PwrMgrThermalOffMilliC_%s", state);
+        cfg.trips[i].offMilliC = PwrMgr_SyscfgGetLong(key, cfg.trips[i].offMilliC);
+    }
+    cfg.slowMs = PwrMgr_SyscfgGetLong("PwrMgrThermalSlowMs", cfg.slowMs);
+    cfg.fastMs = PwrMgr_SyscfgGetLong("PwrMgrThermalFastMs", cfg.fastMs);
+
+    if (PwrMgr_Thermal_Open(&gThermal, &cfg, PwrMgr_ThermalChanged, NULL) != 0)
+        return;
+    if (PwrMgr_Loop_Add(&gLoop, PwrMgr_Thermal_Fd(&gThermal), PwrMgr_ThermalReadable, NULL) != 0) {
+        PwrMgr_Thermal_Close(&gThermal);
+        return;
+    }
+    gThermalReady = true;
+}
 
-// Power Management state structure. This should have PWRMGR_STATE_TOTAL-1 entries
-PWRMGR_PwrStateItem powerStateArr[] = { {PWRMGR_STATE_UNKNOWN, "POWER_TRANS_UNKNOWN", "Unknown"},
-                                        {PWRMGR_STATE_AC,   "POWER_TRANS_AC", "AC"},
 #if defined (_XBB1_SUPPORTED_)
-                                        {PWRMGR_STATE_BATT, "POWER_TRANS_BATTERY", "Battery"},
-#endif
-                                        {PWRMGR_STATE_HOT, "POWER_TRANS_HOT", "ThermalHot"},
-                                        {PWRMGR_STATE_COOLED, "POWER_TRANS_COOLED", "ThermalCooled"} };
-
-static PWRMGR_PwrState gCurPowerState;
+/**
+ *  @brief Battery HAL read backed by the mta HAL
+ *  @return 0 on success, -1 if the power status is unavailable
+ */
+static int PwrMgr_BatteryRead(void *ctx, PWRMGR_BatteryReading *reading)
+{
+    char status[DATA_SIZE] = {0};
+    ULONG len = sizeof(status);
+    ULONG value = 0;
+
+    if (mta_hal_BatteryGetPowerStatus(status, &len) != RETURN_OK || status[0] == 0)
+        return -1;
+    reading->onBattery = (strcmp(status, PwrMgr_Fsm_StateStr(&gFsm, PWRMGR_STATE_BATT)) == 0);
+    reading->chargeMah = (mta_hal_BatteryGetRemainingCharge(&value) == RETURN_OK) ? (long)value : -1;
+    reading->capacityMah = (mta_hal_BatteryGetActualCapacity(&value) == RETURN_OK) ? (long)value : -1;
+    reading->minutes = (mta_hal_BatteryGetRemainingTime(&value) == RETURN_OK) ? (long)value : -1;
+    return 0;
+}
 
-static int PwrMgr_StateTranstion(char *cState);
+static const PWRMGR_BatteryOps pwrMgrBatteryOps = {
+    PwrMgr_BatteryRead
+};
 
 /**
- *  @brief Set Power Manager system defaults
- *  @return 0
+ *  @brief Battery policy callback, shed the next tier and publish the projected runtime
+ *
+ *  Only the battery run mask changes, AC and Battery themselves are still
+ *  requested through rdkb-power-transition.
  */
-static void PwrMgr_SetDefaults()
+static void PwrMgr_BatteryChanged(void *ctx, int level, long minutes, int percent)
 {
-    // Not sure what we should do here. Should we ask someone what the current state is? Basically if we
-    // boot up in battery mode are we going to get a later notification that there was a power state change?
-    // For now, we will call the mta hal to see what our current power state is.
-    gCurPowerState = PWRMGR_STATE_AC;
-#if defined (_XBB1_SUPPORTED_)
-    char status[DATA_SIZE] = {0};
-    int len = 0;
-    int halStatus = RETURN_OK;
+    char buf[16];
+
+    if (level != gBatteryLevel) {
+        PWRMGR_CompMask runMask;
+
+        // A reload adopted meanwhile must not be undone with the old policy's mask
+        pthread_mutex_lock(&gPolicyLock);
+        gBatteryLevel = level;
+        runMask = PwrMgr_StateRunMask(gPolicy, PWRMGR_STATE_BATT);
+        PwrMgr_Exec_SetRunMask(&gExecutor, PWRMGR_STATE_BATT, runMask);
+        pthread_mutex_unlock(&gPolicyLock);
+        PWRMGRLOG(INFO, "%s: battery level %d, %ld minutes left, running 0x%x on battery\n",__FUNCTION__, level, minutes, runMask);
+        snprintf(buf, sizeof(buf), "%d", level);
+        PwrMgr_SyseventSetStr("rdkb-power-battery-level", (unsigned char *)buf, 0);
+    }
 
-    // Fetch the current battery status from mta - returns "AC", "Battery" or "Unknown"
-    halStatus = mta_hal_BatteryGetPowerStatus (status, (ULONG *)&len);
+    snprintf(buf, sizeof(buf), "%ld", minutes);
+    PwrMgr_SyseventSetStr("rdkb-power-battery-runtime-min", (unsigned char *)buf, 0);
+    snprintf(buf, sizeof(buf), "%d", percent);
+    PwrMgr_SyseventSetStr("rdkb-power-battery-charge", (unsigned char *)buf, 0);
+}
 
-    if (halStatus == RETURN_OK && len > 0 && status[0] != 0) {
-        PWRMGRLOG(INFO, "%s: Power Manager mta_hal_BatteryGetPowerStatus returned %s\n",__FUNCTION__, status);
+/**
+ *  @brief Loop callback, the next battery sample is due
+ */
+static void PwrMgr_BatteryReadable(void *arg, int fd, uint32_t events)
+{
+    PwrMgr_Battery_Dispatch(&gBattery);
+}
 
-        if (strcmp(status, powerStateArr[PWRMGR_STATE_BATT].pwrStateStr) == 0) {
-            PwrMgr_StateTranstion(powerStateArr[PWRMGR_STATE_BATT].pwrTransStr);
-        }
-    } else {
-        PWRMGRLOG(ERROR, "%s: Power Manager mta_hal_BatteryGetPowerStatus call FAILED!\n",__FUNCTION__);
+/**
+ *  @brief Start the battery policy unless disabled in syscfg
+ *
+ *  Tier thresholds can be moved with PwrMgrBatteryTierMinutes_<level>,
+ *  e.g. PwrMgrBatteryTierMinutes_2 for the first tier below Battery.
+ */
+static void PwrMgr_BatteryInit()
+{
+    PWRMGR_BatteryConfig cfg;
+    char key[64];
+    char buf[16];
+    int i;
+
+    if (syscfg_get(NULL, "PwrMgrBatteryPolicy", buf, sizeof(buf)) == 0 && strcmp(buf, "false") == 0) {
+        PWRMGRLOG(INFO, "%s: battery policy disabled\n",__FUNCTION__);
+        return;
     }
-#endif
-
-    PWRMGRLOG(INFO, "%s: Power Manager initializing with %s\n",__FUNCTION__, powerStateArr[gCurPowerState].pwrStateStr);
 
+    PwrMgr_Battery_DefaultConfig(&cfg);
+    for (i = 0; i < cfg.tierCount; i++) {
+        snprintf(key, sizeof(key), "PwrMgrBatteryTierMinutes_%d", i + 2);
+        cfg.tierMinutes[i] = PwrMgr_SyscfgGetLong(key, cfg.tierMinutes[i]);
+    }
+    cfg.batteryMs = PwrMgr_SyscfgGetLong("PwrMgrBatteryPollMs", cfg.batteryMs);
 
-    // wait a couple seconds before sending the initial sysevent
-    sleep(5);
-    PwrMgr_SyseventSetStr("rdkb-power-state", powerStateArr[gCurPowerState].pwrStateStr, 0);
+    if (PwrMgr_Battery_Open(&gBattery, &cfg, &pwrMgrBatteryOps, NULL, PwrMgr_BatteryChanged, NULL) != 0)
+        return;
+    if (PwrMgr_Loop_Add(&gLoop, PwrMgr_Battery_Fd(&gBattery), PwrMgr_BatteryReadable, NULL) != 0) {
+        PwrMgr_Battery_Close(&gBattery);
+        return;
+    }
+    gBatteryReady = true;
 }
+#endif
 
 /**
- *  @brief Send sysevent string
- *  @return 0
+ *  @brief Loop callback, the policy file was written or replaced
+ *
+ *  The new file is compiled here and handed to the executor, which adopts it
+ *  between two transitions. A file that does not load, or that changes the
+ *  components themselves, leaves the current policy in place.
  */
-int PwrMgr_SyseventSetStr(const char *name, unsigned char *value, int bufsz)
+static void PwrMgr_PolicyReadable(void *arg, int fd, uint32_t events)
 {
-    return sysevent_set(sysevent_fd_gs, sysevent_token_gs, name, value, bufsz);
+    PWRMGR_Policy *policy;
+    PWRMGR_Policy *unused;
+
+    if (!PwrMgr_Policy_Changed(fd, gPolicyPath))
+        return;
+    policy = malloc(sizeof(*policy));
+    if (policy == NULL)
+        return;
+    if (PwrMgr_Policy_Load(policy, &gFsm, gPolicyPath) != 0) {
+        PWRMGRLOG(ERROR, "%s: %s does not load, keeping the current policy\n",__FUNCTION__, gPolicyPath);
+        free(policy);
+        return;
+    }
+
+    pthread_mutex_lock(&gPolicyLock);
+    if (!PwrMgr_Policy_SameComponents(policy, gPolicy)) {
+        pthread_mutex_unlock(&gPolicyLock);
+        PWRMGRLOG(WARNING, "%s: %s changes the components, it only applies after a restart\n",__FUNCTION__, gPolicyPath);
+        free(policy);
+        return;
+    }
+    // Two quick reloads, the executor never saw the first one
+    unused = gPolicyNext;
+    gPolicyNext = policy;
+    pthread_mutex_unlock(&gPolicyLock);
+    free(unused);
+
+    PWRMGRLOG(INFO, "%s: reloaded %s\n",__FUNCTION__, gPolicyPath);
+    if (gSchedReady) {
+        PWRMGR_EcoWindow windows[PWRMGR_SCHED_MAX_WINDOWS];
+        int count;
+
+        PwrMgr_EcoWindows(policy, windows, &count);
+        if (PwrMgr_Sched_Set(&gSched, windows, count, time(NULL)) != 0)
+            PWRMGRLOG(ERROR, "%s: keeping the current eco schedule\n",__FUNCTION__);
+    }
+    PwrMgr_Exec_Kick(&gExecutor);
 }
 
 /**
- *  @brief Transition power states
- *  @return 0
+ *  @brief Load the power policy and watch it for changes
+ *
+ *  Without a policy file the built-in one is used. A file installed later
+ *  is picked up as long as it declares the same components.
  */
-static int PwrMgr_StateTranstion(char *cState)
+static void PwrMgr_PolicyInit()
 {
-    bool transSuccess = false;
+    if (PwrMgr_Policy_Load(&gPolicyBoot, &gFsm, gPolicyPath) == 0) {
+        PWRMGRLOG(INFO, "%s: loaded %d components from %s\n",__FUNCTION__, gPolicyBoot.graph.count, gPolicyPath);
+    } else {
+        PWRMGRLOG(WARNING, "%s: using built-in policy\n",__FUNCTION__);
+        PwrMgr_Policy_LoadDefaults(&gPolicyBoot);
+    }
+    gPolicy = &gPolicyBoot;
 
-    PWRMGR_PwrState newState = PWRMGR_STATE_UNKNOWN;
-    PWRMGRLOG(INFO, "Entering into %s new state\n",__FUNCTION__);
+    gPolicyFd = PwrMgr_Policy_Watch(gPolicyPath);
+    if (gPolicyFd >= 0 && PwrMgr_Loop_Add(&gLoop, gPolicyFd, PwrMgr_PolicyReadable, NULL) != 0) {
+        close(gPolicyFd);
+        gPolicyFd = -1;
+    }
+    if (gPolicyFd < 0)
+        PWRMGRLOG(WARNING, "%s: changes to %s need a restart\n",__FUNCTION__, gPolicyPath);
+}
 
-    // Convert from sysevent string to power state
-    int i=0;
-    for (i=0;i<PWRMGR_STATE_TOTAL;i++) {
-        if (strcmp(powerStateArr[i].pwrTransStr,cState) == 0) {
-            newState = powerStateArr[i].pwrState;
-            break;
-        }
+/**
+ *  @brief Answer an inhibitor client, drop it once it hangs up
+ */
+static void PwrMgr_InhibitClientReadable(void *arg, int fd, uint32_t events)
+{
+    if (PwrMgr_Inhibit_Serve(&gInhibit, fd, PwrMgr_NowMs()) != 0) {
+        PwrMgr_Loop_Remove(&gLoop, fd);
+        close(fd);
+        gInhibitClients--;
     }
+    // A lock may be gone, a held off transition can go ahead
+    PwrMgr_Exec_Kick(&gExecutor);
+}
 
-    if (newState == gCurPowerState) {
-        PWRMGRLOG(WARNING, "%s: Power transition requested to current state %s ignored\n",__FUNCTION__, powerStateArr[gCurPowerState].pwrTransStr);
-    } else {
-        // Check the state we are transitioning to
-        switch (newState){
-        case PWRMGR_STATE_AC:
-            PWRMGRLOG(INFO, "%s: Power transition requested from %s to %s\n",__FUNCTION__, powerStateArr[gCurPowerState].pwrTransStr, powerStateArr[newState].pwrTransStr);
-            // We need to call an RDKB management script to tear down the CCSP components.
+/**
+ *  @brief Accept a connection on the inhibitor socket
+ *
+ *  Beyond PWRMGR_INHIBIT_MAX_CLIENTS the connection is closed again, so
+ *  clients cannot take the loop slot a sysevent reconnect needs.
+ */
+static void PwrMgr_InhibitAccept(void *arg, int fd, uint32_t events)
+{
+    int client = accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+    if (client < 0)
+        return;
+    if (gInhibitClients >= PWRMGR_INHIBIT_MAX_CLIENTS ||
+        PwrMgr_Loop_Add(&gLoop, client, PwrMgr_InhibitClientReadable, NULL) != 0) {
+        PWRMGRLOG(WARNING, "%s: too many inhibitor clients\n",__FUNCTION__);
+        close(client);
+        return;
+    }
+    gInhibitClients++;
+}
 
-            if (v_secure_system("/bin/sh /usr/ccsp/pwrMgr/rdkb_power_manager.sh POWER_TRANS_AC") == 0)
-            {
-                transSuccess = true;
-                gCurPowerState = newState;
-            }
-            else
-            {
-                /* Could not run command we can't transition to new state */
-                PWRMGRLOG(ERROR, "Error opening command pipe during power transition! \n");
-                return true;
-            }
+/**
+ *  @brief Serve the inhibitor socket
+ *
+ *  PwrMgrInhibitSocket moves it away from PWRMGR_INHIBIT_SOCKET.
+ */
+static void PwrMgr_InhibitInit()
+{
+    PwrMgr_Inhibit_Init(&gInhibit);
+    if (syscfg_get(NULL, "PwrMgrInhibitSocket", gInhibitPath, sizeof(gInhibitPath)) != 0 || gInhibitPath[0] == '\0')
+        snprintf(gInhibitPath, sizeof(gInhibitPath), "%s", PWRMGR_INHIBIT_SOCKET);
+
+    gInhibitFd = PwrMgr_Inhibit_Listen(gInhibitPath);
+    if (gInhibitFd >= 0 && PwrMgr_Loop_Add(&gLoop, gInhibitFd, PwrMgr_InhibitAccept, NULL) != 0) {
+        close(gInhibitFd);
+        gInhibitFd = -1;
+    }
+    if (gInhibitFd < 0)
+        PWRMGRLOG(WARNING, "%s: transitions cannot be inhibited\n",__FUNCTION__);
+}
 
-            break;
-#if defined (_XBB1_SUPPORTED_)
-        case PWRMGR_STATE_BATT:
-            PWRMGRLOG(INFO, "%s: Power transition requested from %s to %s\n",__FUNCTION__, powerStateArr[gCurPowerState].pwrTransStr, powerStateArr[newState].pwrTransStr);
-            // We need to call an RDKB management script to tear down the CCSP components.
+/**
+ *  @brief Close the inhibitor socket and every client connection
+ */
+static void PwrMgr_InhibitClose()
+{
+    int i;
 
-            if (v_secure_system("/bin/sh /usr/ccsp/pwrMgr/rdkb_power_manager.sh POWER_TRANS_BATTERY") == 0)
-            {
-                transSuccess = true;
-                gCurPowerState = newState;
-            }
-            else
-            {
-                /* Could not run command we can't transition to new state */
-                PWRMGRLOG(ERROR, "Error opening command pipe during power transition! \n");
-                return true;
-            }
+    for (i = gLoop.count - 1; i >= 0; i--) {
+        if (gLoop.sources[i].fn == PwrMgr_InhibitClientReadable) {
+            int fd = gLoop.sources[i].fd;
 
-            break;
-#endif
-        case PWRMGR_STATE_HOT:
-            PWRMGRLOG(INFO, "%s: Power transition requested from %s to %s\n",__FUNCTION__, powerStateArr[gCurPowerState].pwrTransStr, powerStateArr[newState].pwrTransStr);
-            // We need to call an RDKB management script to tear down the CCSP components.
+            PwrMgr_Loop_Remove(&gLoop, fd);
+            close(fd);
+        }
+    }
+    gInhibitClients = 0;
+    if (gInhibitFd >= 0) {
+        close(gInhibitFd);
+        unlink(gInhibitPath);
+    }
+    gInhibitFd = -1;
+    PwrMgr_Inhibit_Destroy(&gInhibit);
+}
 
-             if (v_secure_system("/bin/sh /usr/ccsp/pwrMgr/rdkb_power_manager.sh POWER_TRANS_HOT") == 0)
-            {
-                transSuccess = true;
-                gCurPowerState = newState;
-            }
-            else
-            {
-                /* Could not run command we can't transition to new state */
-                PWRMGRLOG(ERROR, "Error opening command pipe during power transition! \n");
-                return true;
-            }
+/**
+ *  @brief Hand a requested transition to the executor
+ *
+ *  Only the latest request is kept, older pending ones are coalesced away and
+ *  a transition in flight to another state is cancelled.
+ */
+static void PwrMgr_PostTransition(const char *cState)
+{
+    PWRMGR_PwrState newState = PwrMgr_Fsm_FromTransStr(&gFsm, cState);
 
-            break;
-        case PWRMGR_STATE_COOLED:
-            PWRMGRLOG(INFO, "%s: Power transition requested from %s to %s\n",__FUNCTION__, powerStateArr[gCurPowerState].pwrTransStr, powerStateArr[newState].pwrTransStr);
-            // We need to call an RDKB management script to tear down the CCSP components.
+    if (newState == PWRMGR_STATE_UNKNOWN) {
+        PWRMGRLOG(ERROR, "%s: Transition requested to unknown power state %s\n",__FUNCTION__, cState);
+        return;
+    }
 
-           if (v_secure_system("/bin/sh /usr/ccsp/pwrMgr/rdkb_power_manager.sh POWER_TRANS_COOLED") == 0)
-            {
-                transSuccess = true;
-                gCurPowerState = newState;
-            }
-            else
-            {
-                /* Could not run command we can't transition to new state */
-                PWRMGRLOG(ERROR, "Error opening command pipe during power transition! \n");
-                return true;
-            }
+    PwrMgr_Exec_Post(&gExecutor, newState);
+}
 
-            break;
-        default:
-            PWRMGRLOG(ERROR, "%s: Transition requested to unknown power state %s\n",__FUNCTION__, cState);
-            break;
-        }
+/**
+ *  @brief Handle one notification from the sysevent connection
+ */
+static void PwrMgr_SyseventHandle(const char *name, int vallen, const char *val)
+{
+    PWRMGRLOG(WARNING, "received notification event %s\n", name)
 
-        if (transSuccess) {
-            PWRMGRLOG(INFO, "%s: Power transition to %s Success\n",__FUNCTION__, powerStateArr[gCurPowerState].pwrTransStr);
-            PwrMgr_SyseventSetStr("rdkb-power-state", powerStateArr[gCurPowerState].pwrStateStr, 0);
-        } else {
-            PWRMGRLOG(ERROR, "%s: Power transition to %s FAILED\n",__FUNCTION__, powerStateArr[gCurPowerState].pwrTransStr);
+    if (strcmp(name, "rdkb-power-transition") == 0)
+    {
+        if (vallen > 0 && val[0] != '\0') {
+            PwrMgr_PostTransition(val);
         }
     }
-
-    PWRMGRLOG(INFO, "Exiting from %s\n",__FUNCTION__);
-    return 0;
+    else
+    {
+        PWRMGRLOG(WARNING, "undefined event %s \n",name)
+    }
 }
 
 /**
- *  @brief Power Manager Sysevent handler
- *  @return 0
+ *  @brief Open both sysevent connections and register for rdkb-power-transition
+ *
+ *  Connections that are already up are kept, a failed attempt can simply be
+ *  repeated.
+ *  @return true once registered
  */
-static void *PwrMgr_sysevent_handler(void *data)
+static bool PwrMgr_SyseventConnect()
 {
-    PWRMGRLOG(INFO, "Entering into %s\n",__FUNCTION__)
-
     /* Power transition event ids */
     async_id_t power_transition_asyncid;
+    bool status = false;
 
-    sysevent_setnotification(sysevent_fd, sysevent_token, "rdkb-power-transition",  &power_transition_asyncid);
-    sysevent_set_options(sysevent_fd_gs, sysevent_token, "rdkb-power-state", TUPLE_FLAG_EVENT);
+    if (sysevent_fd < 0)
+    {
+        sysevent_fd = sysevent_open("127.0.0.1", SE_SERVER_WELL_KNOWN_PORT, SE_VERSION, "rdkb_power_manger", &sysevent_token);
+        if (sysevent_fd < 0)
+            PWRMGRLOG(ERROR, "rdkb_power_manager failed to register with sysevent daemon\n")
+        else
+            PWRMGRLOG(INFO, "rdkb_power_manager registered with sysevent daemon successfully\n")
+    }
+
+    //Make another connection for gets/sets
+    pthread_mutex_lock(&gSyseventLock);
+    if (sysevent_fd_gs < 0)
+    {
+        sysevent_fd_gs = sysevent_open("127.0.0.1", SE_SERVER_WELL_KNOWN_PORT, SE_VERSION, "rdkb_power_manager-gs", &sysevent_token_gs);
+        if (sysevent_fd_gs < 0)
+            PWRMGRLOG(ERROR, "rdkb_power_manager-gs failed to register with sysevent daemon\n")
+        else
+            PWRMGRLOG(INFO, "rdkb_power_manager-gs registered with sysevent daemon successfully\n")
+    }
 
-    for (;;)
+    // The connection is only usable once the notification is accepted
+    if (sysevent_fd >= 0 && sysevent_fd_gs >= 0 &&
+        sysevent_setnotification(sysevent_fd, sysevent_token, "rdkb-power-transition", &power_transition_asyncid) == 0)
     {
-        unsigned char name[25], val[42];
-        int namelen = sizeof(name);
-        int vallen  = sizeof(val);
-        int err;
-        async_id_t getnotification_asyncid;
+        sysevent_set_options(sysevent_fd_gs, sysevent_token_gs, "rdkb-power-state", TUPLE_FLAG_EVENT);
+        status = true;
+    }
+    pthread_mutex_unlock(&gSyseventLock);
 
+    return status;
+}
+
+/**
+ *  @brief Close both sysevent connections
+ */
+static void PwrMgr_SyseventDisconnect()
+{
+    if (sysevent_fd >= 0)
+    {
+        PwrMgr_Loop_Remove(&gLoop, sysevent_fd);
+        sysevent_close(sysevent_fd, sysevent_token);
+        sysevent_fd = -1;
+    }
+    pthread_mutex_lock(&gSyseventLock);
+    if (sysevent_fd_gs >= 0)
+    {
+        sysevent_close(sysevent_fd_gs, sysevent_token_gs);
+        sysevent_fd_gs = -1;
+    }
+    pthread_mutex_unlock(&gSyseventLock);
+}
 
+/**
+ *  @brief Loop callback, a notification arrived or the connection dropped
+ *
+ *  Only called when the socket is readable, so sysevent_getnotification
+ *  never blocks the loop. A failure drops both connections and starts the
+ *  reconnect backoff instead of waiting for syseventd to come back.
+ */
+static void PwrMgr_SyseventReadable(void *arg, int fd, uint32_t events)
+{
+    unsigned char name[25], val[42];
+    int namelen = sizeof(name);
+    int vallen  = sizeof(val);
+    int err = -1;
+    async_id_t getnotification_asyncid;
+
+#ifdef GTEST_ENABLE
+    gSyseventHandling = true;
+#endif
+    if (!(events & (EPOLLERR | EPOLLHUP)) || (events & EPOLLIN))
         err = sysevent_getnotification(sysevent_fd, sysevent_token, name, &namelen,  val, &vallen, &getnotification_asyncid);
 
-        if (err)
-        {
-            PWRMGRLOG(ERROR, "sysevent_getnotification failed with error: %d\n", err)
-            if ( 0 != v_secure_system("pidof syseventd")) {
+    if (err)
+    {
+        PWRMGRLOG(ERROR, "sysevent_getnotification failed with error: %d, reconnecting\n", err)
+        PwrMgr_SyseventDisconnect();
+        gDisconnectedMs = PwrMgr_NowMs();
+        gReconnectMs = SYSEVENT_RETRY_INITIAL_MS;
+        PwrMgr_Loop_Arm(gReconnectFd, 0);
+    }
+    else
+    {
+        PwrMgr_SyseventHandle(name, vallen, val);
+    }
+#ifdef GTEST_ENABLE
+    gSyseventHandling = false;
+#endif
+}
 
-                CcspTraceWarning(("%s syseventd not running  \n",__FUNCTION__));
-           	sleep(600);
-	    } 
-        }
-        else
-        {
-            PWRMGRLOG(WARNING, "received notification event %s\n", name)
+/**
+ *  @brief Loop callback, time for the next reconnect attempt
+ */
+static void PwrMgr_ReconnectTimer(void *arg, int fd, uint32_t events)
+{
+    uint64_t expirations;
+    PWRMGR_PwrState state;
 
-            if (strcmp(name, "rdkb-power-transition") == 0)
-            {
-                if (vallen > 0 && val[0] != '\0') {
-                    PwrMgr_StateTranstion(val);
-                }
-            }
-            else
-            {
-                PWRMGRLOG(WARNING, "undefined event %s \n",name)
-            }			
-        }
+    if (read(fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+        return;
+
+    if (!PwrMgr_SyseventConnect() || PwrMgr_Loop_Add(&gLoop, sysevent_fd, PwrMgr_SyseventReadable, NULL) != 0)
+    {
+        PWRMGRLOG(WARNING, "%s: sysevent still down, retrying in %d ms\n",__FUNCTION__, gReconnectMs);
+        PwrMgr_Loop_Arm(gReconnectFd, gReconnectMs);
+        gReconnectMs = (gReconnectMs * 2 > SYSEVENT_RECONNECT_MAX_MS) ? SYSEVENT_RECONNECT_MAX_MS : gReconnectMs * 2;
+        return;
     }
 
-    PWRMGRLOG(INFO, "Exiting from %s\n",__FUNCTION__)
-    return 0;
+    PWRMGRLOG(INFO, "%s: sysevent reconnected after %ld ms\n",__FUNCTION__, PwrMgr_NowMs() - gDisconnectedMs);
+    // A restarted syseventd lost the tuple, publish the state again for new listeners.
+    // The executor thread owns the reached state, ask it rather than reading gCurPowerState
+    PwrMgr_Exec_GetStatus(&gExecutor, &state, NULL, NULL, NULL);
+    PwrMgr_SyseventSetStr("rdkb-power-state", (unsigned char *)PwrMgr_Fsm_StateStr(&gFsm, state), 0);
+}
+
+/**
+ *  @brief Loop callback, SIGHUP from the unit's ExecStop, SIGTERM or SIGINT
+ */
+static void PwrMgr_SignalReadable(void *arg, int fd, uint32_t events)
+{
+    struct signalfd_siginfo info;
+
+    if (read(fd, &info, sizeof(info)) != sizeof(info))
+        return;
+    PWRMGRLOG(INFO, "%s: received signal %u, shutting down\n",__FUNCTION__, info.ssi_signo);
+    PwrMgr_SdNotify("STOPPING=1");
+    PwrMgr_Loop_Quit(&gLoop);
+}
+
+/**
+ *  @brief Block the shutdown signals and route them to a signalfd
+ *
+ *  Runs before any thread is created so every thread inherits the mask and
+ *  the signals can only be picked up by the loop.
+ *  @return 0 on success
+ */
+static int PwrMgr_SignalInit()
+{
+    sigset_t mask;
+
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGHUP);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGINT);
+    if (pthread_sigmask(SIG_BLOCK, &mask, NULL) != 0)
+        return -1;
+    gSignalFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (gSignalFd < 0) {
+        PWRMGRLOG(ERROR, "%s: signalfd failed, %s\n",__FUNCTION__, strerror(errno));
+        return -1;
+    }
+    return PwrMgr_Loop_Add(&gLoop, gSignalFd, PwrMgr_SignalReadable, NULL);
 }
 
 /**
  *  @brief Power Manager register for system events
- *  @return 0
+ *
+ *  Retries with a short exponential backoff until both sysevent connections
+ *  are up and the rdkb-power-transition notification is registered, then
+ *  publishes the initial power state.
+ *  @return true once registered
  */
 static bool PwrMgr_Register_sysevent()
 {
     bool status = false;
-    const int max_retries = 6;
+    const int max_retries = 10;
     int retry = 0;
+    int backoff_ms = SYSEVENT_RETRY_INITIAL_MS;
     PWRMGRLOG(INFO, "Entering into %s\n",__FUNCTION__)
 
+    sysevent_fd = -1;
+    sysevent_fd_gs = -1;
+
     do
     {
-        sysevent_fd = sysevent_open("127.0.0.1", SE_SERVER_WELL_KNOWN_PORT, SE_VERSION, "rdkb_power_manger", &sysevent_token);
-        if (sysevent_fd < 0)
-        {
-            PWRMGRLOG(ERROR, "rdkb_power_manager failed to register with sysevent daemon\n");
-            status = false;
-        }
-        else
-        {  
-            PWRMGRLOG(INFO, "rdkb_power_manager registered with sysevent daemon successfully\n");
-            status = true;
-        }
-
-        //Make another connection for gets/sets
-        sysevent_fd_gs = sysevent_open("127.0.0.1", SE_SERVER_WELL_KNOWN_PORT, SE_VERSION, "rdkb_power_manager-gs", &sysevent_token_gs);
-        if (sysevent_fd_gs < 0)
-        {
-            PWRMGRLOG(ERROR, "rdkb_power_manager-gs failed to register with sysevent daemon\n");
-            status = false;
-        }
-        else
-        {
-            PWRMGRLOG(INFO, "rdkb_power_manager-gs registered with sysevent daemon successfully\n");
-            status = true;
-        }
+        status = PwrMgr_SyseventConnect();
 
         if(status == false) {
-        	v_secure_system("/usr/bin/syseventd");
-                sleep(5);
+            if (retry == 0)
+                v_secure_system("/usr/bin/syseventd");
+            usleep(backoff_ms * 1000);
+            backoff_ms = (backoff_ms * 2 > SYSEVENT_RETRY_MAX_MS) ? SYSEVENT_RETRY_MAX_MS : backoff_ms * 2;
         }
     }while((status == false) && (retry++ < max_retries));
 
@@ -381,15 +1612,30 @@ static bool PwrMgr_Register_sysevent()
 
 /**
  *  @brief Power Manager initialize code
+ *
+ *  Sets everything up and starts the transition thread, PwrMgr_Run then
+ *  runs the event loop.
  *  @return 0
  */
-static int PwrMgr_Init()
+int PwrMgr_Init()
 {
     int status = 0;
-    int thread_status = 0;
-    char thread_name[THREAD_NAME_LEN];
     PWRMGRLOG(INFO, "Entering into %s\n",__FUNCTION__)
 
+    gInitStartMs = PwrMgr_NowMs();
+
+    if (PwrMgr_Fsm_InitDefault(&gFsm) != 0)
+        return -1;
+    PwrMgr_TelemetryInit();
+    if (PwrMgr_Loop_Init(&gLoop) != 0 || PwrMgr_SignalInit() != 0)
+        return -1;
+    gReconnectFd = PwrMgr_Loop_TimerFd();
+    if (PwrMgr_Loop_Add(&gLoop, gReconnectFd, PwrMgr_ReconnectTimer, NULL) != 0)
+        return -1;
+    PwrMgr_PolicyInit();
+    PwrMgr_InhibitInit();
+    PwrMgr_UnitCtlInit();
+
     if (PwrMgr_Register_sysevent() == false)
     {
         PWRMGRLOG(ERROR, "PwrMgr_Register_sysevent failed\n")
@@ -398,25 +1644,23 @@ static int PwrMgr_Init()
     else 
     {
         PWRMGRLOG(INFO, "PwrMgr_Register_sysevent Successful\n")
-    
-        thread_status = pthread_create(&sysevent_tid, NULL, PwrMgr_sysevent_handler, NULL);
-        if (thread_status == 0)
-        {
-            PWRMGRLOG(INFO, "PwrMgr_sysevent_handler thread created successfully\n");
 
-            memset( thread_name, '\0', sizeof(char) * THREAD_NAME_LEN );
-            strcpy( thread_name, "pwrMgr_sysevent");
-
-            if (pthread_setname_np(sysevent_tid, thread_name) == 0)
-                PWRMGRLOG(INFO, "PwrMgr_sysevent_handler thread name %s set successfully\n", thread_name)
-            else
-                PWRMGRLOG(ERROR, "%s error occurred while setting PwrMgr_sysevent_handler thread name\n", strerror(errno))
-                
-            sleep(5);
+        status = PwrMgr_ExecutorInit();
+        if (status == 0)
+        {
+            PwrMgr_ThermalInit();
+#if defined (_XBB1_SUPPORTED_)
+            PwrMgr_BatteryInit();
+#endif
+            status = PwrMgr_Loop_Add(&gLoop, sysevent_fd, PwrMgr_SyseventReadable, NULL);
+        }
+        if (status == 0)
+        {
+            PwrMgr_SdNotify("READY=1");
         }
         else
         {
-            PWRMGRLOG(ERROR, "%s error occured while creating PwrMgr_sysevent_handler thread\n", strerror(errno))
+            PWRMGRLOG(ERROR, "error occured while starting the power manager\n")
             status = -1;
         }
     }
@@ -424,6 +1668,58 @@ static int PwrMgr_Init()
     return status;
 }
 
+/**
+ *  @brief Run the event loop until a shutdown signal
+ *  @return 0 after a clean shutdown
+ */
+int PwrMgr_Run()
+{
+    return PwrMgr_Loop_Run(&gLoop);
+}
+
+/**
+ *  @brief Stop the monitors and the transition thread and close the connections
+ */
+void PwrMgr_Term()
+{
+    if (gThermalReady)
+        PwrMgr_Thermal_Close(&gThermal);
+#if defined (_XBB1_SUPPORTED_)
+    if (gBatteryReady)
+        PwrMgr_Battery_Close(&gBattery);
+#endif
+    PwrMgr_Exec_Stop(&gExecutor);
+    PwrMgr_InhibitClose();
+    if (gSchedReady)
+        PwrMgr_Sched_Close(&gSched);
+    gSchedReady = false;
+    gEcoShed = 0;
+    if (gPolicyFd >= 0)
+        close(gPolicyFd);
+    gPolicyFd = -1;
+    free(gPolicyNext);
+    if (gPolicy != &gPolicyBoot)
+        free(gPolicy);
+    gPolicyNext = NULL;
+    gPolicy = &gPolicyBoot;
+    PwrMgr_UnitCtl_Close(&gUnitCtl);
+    gFreezerReady = false;
+    gCpuReady = false;
+    gWifiReady = false;
+    PwrMgr_Telemetry_Close(&gTelemetry);
+    PwrMgr_SyseventDisconnect();
+    if (gReconnectFd >= 0)
+        close(gReconnectFd);
+    if (gSignalFd >= 0)
+        close(gSignalFd);
+    gReconnectFd = gSignalFd = -1;
+    PwrMgr_Loop_Close(&gLoop);
+}
+
+#ifndef GTEST_ENABLE
+// Holds the flock on PWRMGR_PID_FILE for the life of the process
+static int gPidLockFd = -1;
+
 /**
  *  @brief Power Manager check to see if we are already running
  *  @return 0
@@ -431,28 +1727,14 @@ static int PwrMgr_Init()
 static bool checkIfAlreadyRunning(const char* name)
 {
     PWRMGRLOG(INFO, "Entering into %s\n",__FUNCTION__)
-    bool status = true;
-	
-    FILE *fp = fopen("/tmp/.rdkbPowerMgr.pid", "r");
-    if (fp == NULL) 
-    {
-        PWRMGRLOG(ERROR, "File /tmp/.rdkbPowerMgr.pid doesn't exist\n")
-        FILE *pfp = fopen("/tmp/.rdkbPowerMgr.pid", "w");
-        if (pfp == NULL) 
-        {
-            PWRMGRLOG(ERROR, "Error in creating file /tmp/.rdkbPowerMgr.pid\n")
-        }
-        else
-        {
-            pid_t pid = getpid();
-            fprintf(pfp, "%d", pid);
-            fclose(pfp);
-        }
-        status = false;
-    }
-    else
+    bool status = false;
+
+    // The lock goes away with the process, however it exits
+    gPidLockFd = PwrMgr_Checkpoint_Lock(PWRMGR_PID_FILE);
+    if (gPidLockFd < 0)
     {
-        fclose(fp);
+        PWRMGRLOG(ERROR, "%s is locked by another instance\n", PWRMGR_PID_FILE)
+        status = true;
     }
     PWRMGRLOG(INFO, "Exiting from %s\n",__FUNCTION__)
     return status;
@@ -532,7 +1814,14 @@ int main(int argc, char *argv[])
 
     PWRMGRLOG(INFO, "Started power manager\n")
 
-    daemonize();
+    // Under Type=notify systemd tracks the main process, so stay in the foreground
+    if (getenv("NOTIFY_SOCKET") == NULL)
+        daemonize();
+
+#ifndef FEATURE_SUPPORT_RDKLOG
+    // After daemonize, the flusher thread would not survive the fork
+    PwrMgr_Log_Start(STDERR_FILENO);
+#endif
 
     if (checkIfAlreadyRunning(argv[0]) == true)
     {
@@ -551,10 +1840,11 @@ int main(int argc, char *argv[])
             else
             {
                 PWRMGRLOG(INFO, "Power Manager initialization completed\n")
-                //wait for sysevent_tid thread to terminate
-                pthread_join(sysevent_tid, NULL);
-                
-                PWRMGRLOG(INFO,"sysevent_tid thread terminated\n")
+                if (PwrMgr_Run() != 0)
+                    status = 1;
+
+                PWRMGRLOG(INFO,"event loop terminated\n")
+                PwrMgr_Term();
             }
         }
         else
@@ -564,6 +1854,10 @@ int main(int argc, char *argv[])
         }
 	PWRMGRLOG(INFO, "power manager app terminated\n")
     }
+#ifndef FEATURE_SUPPORT_RDKLOG
+    PwrMgr_Log_Stop();
+#endif
     return status;
 }
+#endif /* GTEST_ENABLE */
 #endif
@@ -0,0 +1,94 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ *  @file pwrMgr_arbiter.c
+ *  @brief RDKB Power Manger power state arbitration
+ */
+
+#include "pwrMgr_arbiter.h"
+
+// State of each axis before anything is requested on it
+static const PWRMGR_PwrState arbiterDefaults[PWRMGR_AXIS_TOTAL] = {
+    [PWRMGR_AXIS_SUPPLY]  = PWRMGR_STATE_AC,
+    [PWRMGR_AXIS_THERMAL] = PWRMGR_STATE_COOLED,
+};
+
+/**
+ *  @brief Axis a power state belongs to
+ */
+PWRMGR_Axis PwrMgr_Arbiter_Axis(PWRMGR_PwrState state)
+{
+    switch (state) {
+    case PWRMGR_STATE_AC:
+#if defined (_XBB1_SUPPORTED_)
+    case PWRMGR_STATE_BATT:
+#endif
+        return PWRMGR_AXIS_SUPPLY;
+    default:
+        return PWRMGR_AXIS_THERMAL;
+    }
+}
+
+/**
+ *  @brief Put state on its axis and every other axis in its unconstrained state
+ */
+void PwrMgr_Arbiter_Init(PWRMGR_PowerVector *vec, PWRMGR_PwrState state)
+{
+    int i;
+
+    for (i = 0; i < PWRMGR_AXIS_TOTAL; i++)
+        vec->axis[i] = arbiterDefaults[i];
+    if (state > PWRMGR_STATE_UNKNOWN && state < PWRMGR_STATE_TOTAL)
+        vec->axis[PwrMgr_Arbiter_Axis(state)] = state;
+}
+
+/**
+ *  @brief Move the axis of state to state
+ *  @return the state the axis was in
+ */
+PWRMGR_PwrState PwrMgr_Arbiter_Set(PWRMGR_PowerVector *vec, PWRMGR_PwrState state)
+{
+    PWRMGR_Axis axis = PwrMgr_Arbiter_Axis(state);
+    PWRMGR_PwrState old = vec->axis[axis];
+
+    vec->axis[axis] = state;
+    return old;
+}
+
+/**
+ *  @brief State of the axis state belongs to
+ */
+PWRMGR_PwrState PwrMgr_Arbiter_Get(const PWRMGR_PowerVector *vec, PWRMGR_PwrState state)
+{
+    return vec->axis[PwrMgr_Arbiter_Axis(state)];
+}
+
+/**
+ *  @brief Components that run under every axis, runMask is indexed by state
+ */
+PWRMGR_CompMask PwrMgr_Arbiter_RunMask(const PWRMGR_PowerVector *vec, const PWRMGR_CompMask runMask[PWRMGR_STATE_TOTAL])
+{
+    PWRMGR_CompMask mask = runMask[vec->axis[0]];
+    int i;
+
+    for (i = 1; i < PWRMGR_AXIS_TOTAL; i++)
+        mask &= runMask[vec->axis[i]];
+    return mask;
+}
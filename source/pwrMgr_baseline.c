@@ -0,0 +1,74 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+/**
+ *  @file pwrMgr_baseline.c
+ *  @brief RDKB Power Manger actuator baseline file
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include "pwrMgr_baseline.h"
+
+/**
+ *  @brief Load the baseline an earlier instance of this boot saved
+ *  @return 0 if every one of the count entries is covered
+ */
+int PwrMgr_Baseline_Load(const char *path, int count, PWRMGR_BaselineParseFn parse, void *ctx)
+{
+    char line[PWRMGR_BASELINE_LINE_LEN];
+    int seen = 0;
+    FILE *fp = fopen(path, "r");
+
+    if (fp == NULL)
+        return -1;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        int index = parse(ctx, line);
+
+        if (index >= 0 && index < count)
+            seen |= 1 << index;
+    }
+    fclose(fp);
+    return (seen == (1 << count) - 1) ? 0 : -1;
+}
+
+/**
+ *  @brief Save count entries, replacing the file only once it is complete
+ *  @return 0 on success
+ */
+int PwrMgr_Baseline_Save(const char *path, int count, PWRMGR_BaselineFormatFn format, const void *ctx)
+{
+    char tmpPath[128];
+    char line[PWRMGR_BASELINE_LINE_LEN];
+    FILE *fp;
+    int i;
+
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+    fp = fopen(tmpPath, "w");
+    if (fp == NULL)
+        return -1;
+    for (i = 0; i < count; i++) {
+        format(ctx, i, line, sizeof(line));
+        fputs(line, fp);
+    }
+    if (fclose(fp) != 0) {
+        unlink(tmpPath);
+        return -1;
+    }
+    return rename(tmpPath, path);
+}
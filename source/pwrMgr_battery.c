@@ -0,0 +1,200 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ *  @file pwrMgr_battery.c
+ *  @brief RDKB Power Manger battery policy
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "pwrMgr_log.h"
+#include "pwrMgr_loop.h"
+#include "pwrMgr_battery.h"
+
+// Weight of the newest drain measurement in the moving average
+#define PWRMGR_BATTERY_DRAIN_WEIGHT 0.25
+
+/**
+ *  @brief Defaults: Wi-Fi tier at 120 minutes, last tier at 45 minutes
+ */
+void PwrMgr_Battery_DefaultConfig(PWRMGR_BatteryConfig *cfg)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->tierMinutes[0] = 120;
+    cfg->tierMinutes[1] = 45;
+    cfg->tierCount = 2;
+    cfg->acMs = 60000;
+    cfg->batteryMs = 30000;
+    cfg->fastMs = 5000;
+    cfg->marginMinutes = 10;
+}
+
+static long PwrMgr_Battery_NowMs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ *  @brief Set up the policy, the first sample is taken straight away
+ *  @return 0 on success
+ */
+int PwrMgr_Battery_Open(PWRMGR_BatteryMonitor *mon, const PWRMGR_BatteryConfig *cfg, const PWRMGR_BatteryOps *ops,
+                        void *opsCtx, PWRMGR_BatteryFn notify, void *ctx)
+{
+    memset(mon, 0, sizeof(*mon));
+    mon->cfg = *cfg;
+    if (mon->cfg.tierCount > PWRMGR_BATTERY_MAX_TIERS)
+        mon->cfg.tierCount = PWRMGR_BATTERY_MAX_TIERS;
+    mon->ops = ops;
+    mon->opsCtx = opsCtx;
+    mon->notify = notify;
+    mon->ctx = ctx;
+    mon->minutes = -1;
+    mon->percent = -1;
+    mon->lastChargeMah = -1;
+
+    mon->timerFd = PwrMgr_Loop_TimerFd();
+    if (mon->timerFd < 0) {
+        PWRMGRLOG(ERROR, "%s: timerfd_create failed, %s\n", __FUNCTION__, strerror(errno));
+        return -1;
+    }
+    mon->intervalMs = cfg->acMs;
+    PwrMgr_Loop_Arm(mon->timerFd, 0);
+    return 0;
+}
+
+/**
+ *  @brief Timer descriptor, readable when the next sample is due
+ */
+int PwrMgr_Battery_Fd(PWRMGR_BatteryMonitor *mon)
+{
+    return mon->timerFd;
+}
+
+/**
+ *  @brief Fold a new charge reading into the drain average
+ */
+static void PwrMgr_Battery_UpdateDrain(PWRMGR_BatteryMonitor *mon, long chargeMah, long nowMs)
+{
+    if (mon->lastChargeMah >= 0 && chargeMah <= mon->lastChargeMah && nowMs > mon->lastSampleMs) {
+        double rate = (double)(mon->lastChargeMah - chargeMah) * 60000.0 / (double)(nowMs - mon->lastSampleMs);
+
+        if (mon->drainMahPerMin <= 0)
+            mon->drainMahPerMin = rate;
+        else
+            mon->drainMahPerMin += PWRMGR_BATTERY_DRAIN_WEIGHT * (rate - mon->drainMahPerMin);
+    }
+    mon->lastChargeMah = chargeMah;
+    mon->lastSampleMs = nowMs;
+}
+
+/**
+ *  @brief Take one sample, notify when the level or the projection changed
+ *  @return milliseconds until the next sample
+ */
+int PwrMgr_Battery_Sample(PWRMGR_BatteryMonitor *mon, long nowMs)
+{
+    const PWRMGR_BatteryConfig *cfg = &mon->cfg;
+    PWRMGR_BatteryReading reading;
+    int level = mon->level;
+    long minutes = -1;
+    int percent = -1;
+
+    memset(&reading, 0, sizeof(reading));
+    if (mon->ops->read(mon->opsCtx, &reading) != 0) {
+        PWRMGRLOG(WARNING, "%s: battery status not readable\n", __FUNCTION__);
+        mon->intervalMs = mon->level > 0 ? cfg->batteryMs : cfg->acMs;
+        return mon->intervalMs;
+    }
+    mon->samples++;
+
+    if (reading.chargeMah >= 0 && reading.capacityMah > 0)
+        percent = (int)(reading.chargeMah * 100 / reading.capacityMah);
+
+    if (!reading.onBattery) {
+        // Charging, the next discharge starts a fresh average
+        level = 0;
+        mon->drainMahPerMin = 0;
+        mon->lastChargeMah = -1;
+    } else {
+        if (reading.chargeMah >= 0)
+            PwrMgr_Battery_UpdateDrain(mon, reading.chargeMah, nowMs);
+        minutes = reading.minutes;
+        if (reading.chargeMah >= 0 && mon->drainMahPerMin > 0) {
+            long projected = (long)(reading.chargeMah / mon->drainMahPerMin);
+            if (minutes < 0 || projected < minutes)
+                minutes = projected;
+        }
+
+        if (level == 0)
+            level = 1;
+        while (level - 1 < cfg->tierCount && minutes >= 0 && minutes <= cfg->tierMinutes[level - 1])
+            level++;
+    }
+
+    if (level != mon->level || minutes != mon->minutes || percent != mon->percent) {
+        if (level != mon->level)
+            PWRMGRLOG(INFO, "%s: %ld minutes left, battery level %d -> %d\n", __FUNCTION__, minutes, mon->level, level);
+        mon->level = level;
+        mon->minutes = minutes;
+        mon->percent = percent;
+        if (mon->notify)
+            mon->notify(mon->ctx, level, minutes, percent);
+    }
+
+    if (level == 0)
+        mon->intervalMs = cfg->acMs;
+    else if (level - 1 < cfg->tierCount && minutes >= 0 && minutes <= cfg->tierMinutes[level - 1] + cfg->marginMinutes)
+        mon->intervalMs = cfg->fastMs;
+    else
+        mon->intervalMs = cfg->batteryMs;
+    return mon->intervalMs;
+}
+
+/**
+ *  @brief Handle the timer descriptor becoming readable
+ *  @return 0
+ */
+int PwrMgr_Battery_Dispatch(PWRMGR_BatteryMonitor *mon)
+{
+    uint64_t expirations;
+
+    if (read(mon->timerFd, &expirations, sizeof(expirations)) != sizeof(expirations))
+        return 0;
+    PwrMgr_Loop_Arm(mon->timerFd, PwrMgr_Battery_Sample(mon, PwrMgr_Battery_NowMs()));
+    return 0;
+}
+
+/**
+ *  @brief Close every descriptor of the policy
+ */
+void PwrMgr_Battery_Close(PWRMGR_BatteryMonitor *mon)
+{
+    if (mon->timerFd >= 0)
+        close(mon->timerFd);
+    mon->timerFd = -1;
+}
@@ -0,0 +1,151 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ *  @file pwrMgr_checkpoint.c
+ *  @brief RDKB Power Manger state checkpoint
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/file.h>
+#include <unistd.h>
+#include "pwrMgr_log.h"
+#include "pwrMgr_checkpoint.h"
+
+#define PWRMGR_CHECKPOINT_MAGIC   0x50574d43    // "PWMC"
+#define PWRMGR_CHECKPOINT_VERSION 2
+
+/**
+ *  @brief FNV-1a over everything but the checksum field
+ */
+static uint32_t PwrMgr_Checkpoint_Sum(const PWRMGR_Checkpoint *cp)
+{
+    const unsigned char *p = (const unsigned char *)cp;
+    uint32_t hash = 2166136261u;
+    size_t i;
+
+    for (i = 0; i < offsetof(PWRMGR_Checkpoint, checksum); i++) {
+        hash ^= p[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ *  @brief Replace the checkpoint at path, the header and checksum are filled in
+ *
+ *  The file lives on tmpfs, so there is no fsync: the rename alone makes the
+ *  update atomic against a crash of the daemon.
+ *  @return 0 on success
+ */
+int PwrMgr_Checkpoint_Save(const char *path, PWRMGR_Checkpoint *cp)
+{
+    char tmpPath[128];
+    int fd;
+    ssize_t written;
+
+    cp->magic = PWRMGR_CHECKPOINT_MAGIC;
+    cp->version = PWRMGR_CHECKPOINT_VERSION;
+    cp->checksum = PwrMgr_Checkpoint_Sum(cp);
+
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+    fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        PWRMGRLOG(ERROR, "%s: cannot write %s, %s\n", __FUNCTION__, tmpPath, strerror(errno));
+        return -1;
+    }
+    written = write(fd, cp, sizeof(*cp));
+    close(fd);
+    if (written != (ssize_t)sizeof(*cp)) {
+        unlink(tmpPath);
+        return -1;
+    }
+    return rename(tmpPath, path);
+}
+
+/**
+ *  @brief Read the checkpoint at path
+ *  @return 0 if it is complete and intact, -1 otherwise
+ */
+int PwrMgr_Checkpoint_Load(const char *path, PWRMGR_Checkpoint *cp)
+{
+    PWRMGR_Checkpoint tmp;
+    ssize_t len;
+    int fd;
+    int i;
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+    len = read(fd, &tmp, sizeof(tmp));
+    close(fd);
+
+    if (len != (ssize_t)sizeof(tmp) || tmp.magic != PWRMGR_CHECKPOINT_MAGIC ||
+        tmp.version != PWRMGR_CHECKPOINT_VERSION || tmp.checksum != PwrMgr_Checkpoint_Sum(&tmp)) {
+        PWRMGRLOG(WARNING, "%s: ignoring invalid checkpoint %s\n", __FUNCTION__, path);
+        return -1;
+    }
+    if (tmp.state <= PWRMGR_STATE_UNKNOWN || tmp.state >= PWRMGR_STATE_TOTAL ||
+        tmp.target <= PWRMGR_STATE_UNKNOWN || tmp.target >= PWRMGR_STATE_TOTAL) {
+        PWRMGRLOG(WARNING, "%s: checkpoint %s names an unknown state\n", __FUNCTION__, path);
+        return -1;
+    }
+    for (i = 0; i < PWRMGR_AXIS_TOTAL; i++) {
+        if (tmp.axes[i] <= PWRMGR_STATE_UNKNOWN || tmp.axes[i] >= PWRMGR_STATE_TOTAL ||
+            PwrMgr_Arbiter_Axis(tmp.axes[i]) != i) {
+            PWRMGRLOG(WARNING, "%s: checkpoint %s puts a state on the wrong axis\n", __FUNCTION__, path);
+            return -1;
+        }
+    }
+    *cp = tmp;
+    return 0;
+}
+
+/**
+ *  @brief Take the single instance lock and write our pid to path
+ *
+ *  The lock goes away with the process, however it exits.
+ *  @return the locked descriptor, keep it open; -1 if another instance holds it
+ */
+int PwrMgr_Checkpoint_Lock(const char *path)
+{
+    char pid[16];
+    int fd;
+    int len;
+
+    fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        PWRMGRLOG(ERROR, "%s: cannot open %s, %s\n", __FUNCTION__, path, strerror(errno));
+        return -1;
+    }
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    len = snprintf(pid, sizeof(pid), "%d", (int)getpid());
+    if (ftruncate(fd, 0) != 0 || pwrite(fd, pid, len, 0) != len)
+        PWRMGRLOG(WARNING, "%s: cannot write the pid to %s\n", __FUNCTION__, path);
+    return fd;
+}
@@ -0,0 +1,173 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ *  @file pwrMgr_coalesce.c
+ *  @brief RDKB Power Manger transition coalescing
+ */
+
+#include <string.h>
+#include "pwrMgr_coalesce.h"
+
+// Default hysteresis and minimum dwell per state in ms, the daemon takes
+// overrides from syscfg PwrMgrHysteresisMs_<state> and PwrMgrMinDwellMs_<state>.
+// Heat is shed at once but the box stays shed for a while before cooling
+// restores it. A more severe state is entered without waiting for the minimum
+// dwell.
+static const PWRMGR_StateTiming pwrStateTimingDefaults[PWRMGR_STATE_TOTAL] = {
+    [PWRMGR_STATE_AC]       = { 2000, 0, 0 },
+#if defined (_XBB1_SUPPORTED_)
+    [PWRMGR_STATE_BATT]     = { 2000, 0, 3 },
+#endif
+    [PWRMGR_STATE_COOLED]   = { 5000, 0, 0 },
+    [PWRMGR_STATE_WARM]     = { 2000, 10000, 1 },
+    [PWRMGR_STATE_HOT]      = { 0, 30000, 2 },
+    [PWRMGR_STATE_CRITICAL] = { 0, 30000, 3 },
+};
+
+/**
+ *  @brief Default timing of every state
+ */
+void PwrMgr_Coalesce_DefaultTiming(PWRMGR_StateTiming timing[PWRMGR_STATE_TOTAL])
+{
+    memcpy(timing, pwrStateTimingDefaults, sizeof(pwrStateTimingDefaults));
+}
+
+/**
+ *  @brief Start with no pending request and zero timing for every state
+ */
+void PwrMgr_Coalesce_Init(PWRMGR_Coalescer *co, PWRMGR_PwrState current, long nowMs)
+{
+    memset(co, 0, sizeof(*co));
+    co->current = current;
+    co->enteredMs = nowMs;
+    co->pending = PWRMGR_STATE_UNKNOWN;
+}
+
+/**
+ *  @brief Set the hysteresis and minimum dwell time of a state
+ */
+void PwrMgr_Coalesce_SetTiming(PWRMGR_Coalescer *co, PWRMGR_PwrState state, long hysteresisMs, long minDwellMs)
+{
+    if (state <= PWRMGR_STATE_UNKNOWN || state >= PWRMGR_STATE_TOTAL)
+        return;
+    co->timing[state].hysteresisMs = hysteresisMs;
+    co->timing[state].minDwellMs = minDwellMs;
+}
+
+/**
+ *  @brief Set how severe a state is, escalating skips the minimum dwell
+ */
+void PwrMgr_Coalesce_SetSeverity(PWRMGR_Coalescer *co, PWRMGR_PwrState state, int severity)
+{
+    if (state <= PWRMGR_STATE_UNKNOWN || state >= PWRMGR_STATE_TOTAL)
+        return;
+    co->timing[state].severity = severity;
+}
+
+/**
+ *  @brief Record a requested transition, replacing any older pending one
+ */
+void PwrMgr_Coalesce_Post(PWRMGR_Coalescer *co, PWRMGR_PwrState target, long nowMs)
+{
+    if (target <= PWRMGR_STATE_UNKNOWN || target >= PWRMGR_STATE_TOTAL)
+        return;
+
+    co->stats.received++;
+
+    if (target == co->pending) {
+        // Repeated request, keep the original hysteresis start
+        co->stats.coalesced++;
+    } else if (target == co->current) {
+        if (co->pending != PWRMGR_STATE_UNKNOWN) {
+            co->stats.flapped++;
+            co->pending = PWRMGR_STATE_UNKNOWN;
+        } else {
+            co->stats.sameState++;
+        }
+    } else {
+        if (co->pending != PWRMGR_STATE_UNKNOWN)
+            co->stats.coalesced++;
+        co->pending = target;
+        co->requestedMs = nowMs;
+    }
+}
+
+/**
+ *  @brief Check whether the pending request may be executed now
+ *  @return 0 with target set when it is due, the milliseconds left until it is
+ *          due, or -1 when nothing is pending
+ */
+long PwrMgr_Coalesce_Next(PWRMGR_Coalescer *co, long nowMs, PWRMGR_PwrState *target)
+{
+    long dueMs;
+    long dwellMs;
+
+    if (co->pending == PWRMGR_STATE_UNKNOWN)
+        return -1;
+
+    dueMs = co->requestedMs + co->timing[co->pending].hysteresisMs;
+    dwellMs = co->enteredMs + co->timing[co->current].minDwellMs;
+    if (co->timing[co->pending].severity <= co->timing[co->current].severity && dwellMs > dueMs)
+        dueMs = dwellMs;
+
+    if (dueMs > nowMs)
+        return dueMs - nowMs;
+
+    *target = co->pending;
+    co->pending = PWRMGR_STATE_UNKNOWN;
+    co->stats.executed++;
+    return 0;
+}
+
+/**
+ *  @brief Put back a request Next handed out that may not run yet
+ *
+ *  It stays due, a newer request posted meanwhile replaces it as usual.
+ */
+void PwrMgr_Coalesce_Hold(PWRMGR_Coalescer *co, PWRMGR_PwrState target)
+{
+    if (co->pending != PWRMGR_STATE_UNKNOWN)
+        return;
+    co->pending = target;
+    co->stats.executed--;
+}
+
+/**
+ *  @brief Record the state reached by an executed transition
+ */
+void PwrMgr_Coalesce_Done(PWRMGR_Coalescer *co, PWRMGR_PwrState reached, long nowMs)
+{
+    if (reached != co->current) {
+        co->current = reached;
+        co->enteredMs = nowMs;
+    }
+    if (co->pending == reached) {
+        co->pending = PWRMGR_STATE_UNKNOWN;
+        co->stats.sameState++;
+    }
+}
+
+/**
+ *  @brief Number of requests that did not lead to a transition
+ */
+unsigned long PwrMgr_Coalesce_Suppressed(const PWRMGR_Coalescer *co)
+{
+    return co->stats.coalesced + co->stats.sameState + co->stats.flapped;
+}
@@ -0,0 +1,757 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ *  @file pwrMgr_compgraph.c
+ *  @brief RDKB Power Manger component graph
+ *
+ *  Loads the component graph and schedules stop/start jobs over it. A
+ *  transition takes as long as the critical path through the graph instead of
+ *  the sum of every unit's stop or start time.
+ */
+
+#include <limits.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "pwrMgr_log.h"
+#include "pwrMgr_compgraph.h"
+#include "pwrMgr_stats.h"
+
+static long PwrMgr_CompGraph_NowMs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ *  @brief Reset a graph to no components
+ */
+void PwrMgr_CompGraph_Init(PWRMGR_CompGraph *graph)
+{
+    memset(graph, 0, sizeof(*graph));
+}
+
+/**
+ *  @brief Look up a component by name
+ *  @return component index, -1 if unknown
+ */
+int PwrMgr_CompGraph_Find(const PWRMGR_CompGraph *graph, const char *name)
+{
+    int i;
+    for (i = 0; i < graph->count; i++) {
+        if (strcmp(graph->comps[i].name, name) == 0)
+            return i;
+    }
+    return -1;
+}
+
+/**
+ *  @brief Add a component node
+ *  @return component index, -1 on failure
+ */
+int PwrMgr_CompGraph_AddComponent(PWRMGR_CompGraph *graph, const char *name, const char *unit)
+{
+    PWRMGR_Component *comp;
+
+    if (PwrMgr_CompGraph_Find(graph, name) >= 0) {
+        PWRMGRLOG(ERROR, "%s: duplicate component %s\n", __FUNCTION__, name);
+        return -1;
+    }
+    if (graph->count >= PWRMGR_MAX_COMPONENTS || strlen(name) >= PWRMGR_COMP_NAME_LEN || strlen(unit) >= PWRMGR_UNIT_NAME_LEN) {
+        PWRMGRLOG(ERROR, "%s: cannot add component %s\n", __FUNCTION__, name);
+        return -1;
+    }
+
+    comp = &graph->comps[graph->count];
+    memset(comp, 0, sizeof(*comp));
+    strcpy(comp->name, name);
+    strcpy(comp->unit, unit);
+    comp->shedLevel = PWRMGR_SHED_HOT;
+    comp->battShedTier = 1;
+    return graph->count++;
+}
+
+/**
+ *  @brief Require first to be stopped before then is stopped
+ *  @return 0 on success, -1 if a component is unknown
+ */
+int PwrMgr_CompGraph_AddStopBefore(PWRMGR_CompGraph *graph, const char *first, const char *then)
+{
+    int a = PwrMgr_CompGraph_Find(graph, first);
+    int b = PwrMgr_CompGraph_Find(graph, then);
+
+    if (a < 0 || b < 0 || a == b)
+        return -1;
+    graph->comps[b].stopPrereq |= PWRMGR_COMP_BIT(a);
+    return 0;
+}
+
+/**
+ *  @brief Require later to be started only once first is running
+ *  @return 0 on success, -1 if a component is unknown
+ */
+int PwrMgr_CompGraph_AddStartAfter(PWRMGR_CompGraph *graph, const char *later, const char *first)
+{
+    int a = PwrMgr_CompGraph_Find(graph, later);
+    int b = PwrMgr_CompGraph_Find(graph, first);
+
+    if (a < 0 || b < 0 || a == b)
+        return -1;
+    graph->comps[a].startPrereq |= PWRMGR_COMP_BIT(b);
+    return 0;
+}
+
+/**
+ *  @brief Set the lowest thermal level that sheds a component
+ *  @return 0 on success, -1 if the component is unknown
+ */
+int PwrMgr_CompGraph_SetShedLevel(PWRMGR_CompGraph *graph, const char *name, PWRMGR_ShedLevel level)
+{
+    int i = PwrMgr_CompGraph_Find(graph, name);
+
+    if (i < 0 || level < PWRMGR_SHED_WARM || level > PWRMGR_SHED_CRITICAL)
+        return -1;
+    graph->comps[i].shedLevel = level;
+    return 0;
+}
+
+/**
+ *  @brief Set the battery tier that sheds a component
+ *  @return 0 on success, -1 if the component is unknown
+ */
+int PwrMgr_CompGraph_SetBattShedTier(PWRMGR_CompGraph *graph, const char *name, int tier)
+{
+    int i = PwrMgr_CompGraph_Find(graph, name);
+
+    if (i < 0 || tier < 1 || tier > PWRMGR_BATT_SHED_MAX)
+        return -1;
+    graph->comps[i].battShedTier = tier;
+    return 0;
+}
+
+/**
+ *  @brief Set the nominal power a component draws, for the energy saved estimate
+ *  @return 0 on success, -1 if the component is unknown
+ */
+int PwrMgr_CompGraph_SetPower(PWRMGR_CompGraph *graph, const char *name, int powerMw)
+{
+    int i = PwrMgr_CompGraph_Find(graph, name);
+
+    if (i < 0 || powerMw < 0)
+        return -1;
+    graph->comps[i].powerMw = powerMw;
+    return 0;
+}
+
+/**
+ *  @brief Set how long a component may take to come up and the file it creates once it has
+ *  @return 0 on success, -1 if the component is unknown or the file name too long
+ */
+int PwrMgr_CompGraph_SetReady(PWRMGR_CompGraph *graph, const char *name, long deadlineMs, const char *file)
+{
+    int i = PwrMgr_CompGraph_Find(graph, name);
+
+    if (i < 0 || deadlineMs < 0 || (file != NULL && strlen(file) >= PWRMGR_READY_FILE_LEN))
+        return -1;
+    graph->comps[i].readyDeadlineMs = deadlineMs;
+    snprintf(graph->comps[i].readyFile, PWRMGR_READY_FILE_LEN, "%s", file ? file : "");
+    return 0;
+}
+
+/**
+ *  @brief Shed a component by freezing its cgroup, it is only stopped once frozen for dwellMs
+ *  @return 0 on success, -1 if the component is unknown
+ */
+int PwrMgr_CompGraph_SetFreeze(PWRMGR_CompGraph *graph, const char *name, long dwellMs)
+{
+    int i = PwrMgr_CompGraph_Find(graph, name);
+
+    if (i < 0 || dwellMs <= 0)
+        return -1;
+    graph->comps[i].freezeDwellMs = dwellMs;
+    return 0;
+}
+
+/**
+ *  @brief Set how long a component's stop may take in an emergency before it is escalated
+ *  @return 0 on success, -1 if the component is unknown
+ */
+int PwrMgr_CompGraph_SetStopBudget(PWRMGR_CompGraph *graph, const char *name, long budgetMs)
+{
+    int i = PwrMgr_CompGraph_Find(graph, name);
+
+    if (i < 0 || budgetMs < 0)
+        return -1;
+    graph->comps[i].stopBudgetMs = budgetMs;
+    return 0;
+}
+
+/**
+ *  @brief Parse one line of the components file
+ *  @return 0 on success or for blank/comment lines, -1 on a malformed line
+ */
+int PwrMgr_CompGraph_ParseLine(PWRMGR_CompGraph *graph, char *line)
+{
+    char *save = NULL;
+    char *key = strtok_r(line, " \t\r\n", &save);
+    char *arg1;
+    char *arg2;
+
+    if (key == NULL || key[0] == '#')
+        return 0;
+
+    arg1 = strtok_r(NULL, " \t\r\n", &save);
+    arg2 = strtok_r(NULL, " \t\r\n", &save);
+    if (arg1 == NULL || arg2 == NULL)
+        return -1;
+
+    if (strcmp(key, "component") == 0)
+        return (PwrMgr_CompGraph_AddComponent(graph, arg1, arg2) >= 0) ? 0 : -1;
+    if (strcmp(key, "stop_before") == 0)
+        return PwrMgr_CompGraph_AddStopBefore(graph, arg1, arg2);
+    if (strcmp(key, "start_after") == 0)
+        return PwrMgr_CompGraph_AddStartAfter(graph, arg1, arg2);
+    if (strcmp(key, "thermal_shed") == 0) {
+        if (strcmp(arg2, "warm") == 0)
+            return PwrMgr_CompGraph_SetShedLevel(graph, arg1, PWRMGR_SHED_WARM);
+        if (strcmp(arg2, "hot") == 0)
+            return PwrMgr_CompGraph_SetShedLevel(graph, arg1, PWRMGR_SHED_HOT);
+        if (strcmp(arg2, "critical") == 0)
+            return PwrMgr_CompGraph_SetShedLevel(graph, arg1, PWRMGR_SHED_CRITICAL);
+    }
+    if (strcmp(key, "battery_shed") == 0) {
+        char *end;
+        long tier = strtol(arg2, &end, 10);
+
+        if (end != arg2 && *end == '\0')
+            return PwrMgr_CompGraph_SetBattShedTier(graph, arg1, (int)tier);
+    }
+    if (strcmp(key, "freeze") == 0) {
+        char *end;
+        long dwellMs = strtol(arg2, &end, 10);
+
+        if (end != arg2 && *end == '\0')
+            return PwrMgr_CompGraph_SetFreeze(graph, arg1, dwellMs);
+    }
+    if (strcmp(key, "power") == 0) {
+        char *end;
+        long powerMw = strtol(arg2, &end, 10);
+
+        if (end != arg2 && *end == '\0')
+            return PwrMgr_CompGraph_SetPower(graph, arg1, (int)powerMw);
+    }
+    if (strcmp(key, "ready") == 0) {
+        char *end;
+        long deadlineMs = strtol(arg2, &end, 10);
+
+        if (end != arg2 && *end == '\0')
+            return PwrMgr_CompGraph_SetReady(graph, arg1, deadlineMs, strtok_r(NULL, " \t\r\n", &save));
+    }
+    if (strcmp(key, "stop_budget") == 0) {
+        char *end;
+        long budgetMs = strtol(arg2, &end, 10);
+
+        if (end != arg2 && *end == '\0')
+            return PwrMgr_CompGraph_SetStopBudget(graph, arg1, budgetMs);
+    }
+
+    return -1;
+}
+
+/**
+ *  @brief Built-in graph, used when no components file is installed
+ */
+void PwrMgr_CompGraph_LoadDefaults(PWRMGR_CompGraph *graph)
+{
+    PwrMgr_CompGraph_Init(graph);
+    PwrMgr_CompGraph_AddComponent(graph, "harvester", "harvester.service");
+    PwrMgr_CompGraph_AddComponent(graph, "lmlite", "CcspLMLite.service");
+    PwrMgr_CompGraph_AddComponent(graph, "wifi", "ccspwifiagent.service");
+    PwrMgr_CompGraph_AddComponent(graph, "moca", "CcspMoca.service");
+    // harvester and LMLite collect their data from the Wi-Fi agent
+    PwrMgr_CompGraph_AddStopBefore(graph, "harvester", "wifi");
+    PwrMgr_CompGraph_AddStopBefore(graph, "lmlite", "wifi");
+    PwrMgr_CompGraph_AddStartAfter(graph, "harvester", "wifi");
+    PwrMgr_CompGraph_AddStartAfter(graph, "lmlite", "wifi");
+    // Telemetry goes first, customer facing Wi-Fi last
+    PwrMgr_CompGraph_SetShedLevel(graph, "harvester", PWRMGR_SHED_WARM);
+    PwrMgr_CompGraph_SetShedLevel(graph, "lmlite", PWRMGR_SHED_WARM);
+    PwrMgr_CompGraph_SetShedLevel(graph, "wifi", PWRMGR_SHED_CRITICAL);
+    // On battery Wi-Fi is kept until the runtime gets short
+    PwrMgr_CompGraph_SetBattShedTier(graph, "moca", 2);
+    PwrMgr_CompGraph_SetBattShedTier(graph, "wifi", 3);
+    // Short excursions should not cost a radio restart and re-association
+    PwrMgr_CompGraph_SetFreeze(graph, "wifi", PWRMGR_FREEZE_DWELL_MS);
+    PwrMgr_CompGraph_SetFreeze(graph, "moca", PWRMGR_FREEZE_DWELL_MS);
+    // Rough figures, the Wi-Fi agent stands for its radios
+    PwrMgr_CompGraph_SetPower(graph, "harvester", 100);
+    PwrMgr_CompGraph_SetPower(graph, "lmlite", 100);
+    PwrMgr_CompGraph_SetPower(graph, "wifi", 2500);
+    PwrMgr_CompGraph_SetPower(graph, "moca", 1200);
+}
+
+static int PwrMgr_CompGraph_IsAcyclic(const PWRMGR_CompGraph *graph, bool startEdges)
+{
+    PWRMGR_CompMask all = PwrMgr_CompGraph_AllMask(graph);
+    PWRMGR_CompMask done = 0;
+    bool progress = true;
+    int i;
+
+    while (done != all && progress) {
+        progress = false;
+        for (i = 0; i < graph->count; i++) {
+            PWRMGR_CompMask prereq = startEdges ? graph->comps[i].startPrereq : graph->comps[i].stopPrereq;
+            if (!(done & PWRMGR_COMP_BIT(i)) && (prereq & ~done) == 0) {
+                done |= PWRMGR_COMP_BIT(i);
+                progress = true;
+            }
+        }
+    }
+    return done == all;
+}
+
+/**
+ *  @brief Check that neither the stop nor the start edges form a cycle
+ *  @return 0 if the graph can be scheduled, -1 otherwise
+ */
+int PwrMgr_CompGraph_Validate(const PWRMGR_CompGraph *graph)
+{
+    if (!PwrMgr_CompGraph_IsAcyclic(graph, false) || !PwrMgr_CompGraph_IsAcyclic(graph, true)) {
+        PWRMGRLOG(ERROR, "%s: component graph has a dependency cycle\n", __FUNCTION__);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ *  @brief Mask with every component of the graph
+ */
+PWRMGR_CompMask PwrMgr_CompGraph_AllMask(const PWRMGR_CompGraph *graph)
+{
+    if (graph->count >= 32)
+        return ~(PWRMGR_CompMask)0;
+    return PWRMGR_COMP_BIT(graph->count) - 1;
+}
+
+/**
+ *  @brief Whether a started component is up: its ready file exists and its unit is active
+ *
+ *  The file is cheap to check, the unit is only asked once it is there. A
+ *  backend that cannot tell whether the unit is active trusts the file.
+ */
+static bool PwrMgr_CompGraph_IsUp(PWRMGR_UnitCtl *ctl, const PWRMGR_Component *comp)
+{
+    if (access(comp->readyFile, F_OK) != 0)
+        return false;
+    return PwrMgr_UnitCtl_IsActive(ctl, comp->unit) != 0;
+}
+
+/**
+ *  @brief Stop or start the components in mask, honouring the graph edges
+ *
+ *  Edges to components outside of mask are ignored, those components are
+ *  already in the requested state. A component that fails still releases its
+ *  dependents so one broken unit does not block the rest of the transition.
+ *  A started component with a ready file is polled, backing off from
+ *  PWRMGR_READY_POLL_MS, until it is up or its ready deadline passes, and
+ *  only then releases its dependents. A start job still running at the
+ *  ready deadline fails the same way.
+ *  Once cancelled returns true no more jobs are submitted, the ones in flight
+ *  are waited for and the run returns. completed reports the components that
+ *  reached the requested state.
+ *
+ *  @return 0 if no component failed, -1 otherwise
+ */
+int PwrMgr_CompGraph_Run(const PWRMGR_CompGraph *graph, PWRMGR_UnitCtl *ctl, PWRMGR_UnitOp op,
+                         PWRMGR_CompMask mask, int timeoutMs, PWRMGR_CancelFn cancelled, void *cancelArg,
+                         PWRMGR_CompMask *completed, PWRMGR_CompMask *failed)
+{
+    PWRMGR_CompMask done = 0;
+    PWRMGR_CompMask inflight = 0;
+    PWRMGR_CompMask verifying = 0;  // Started, not up yet
+    PWRMGR_CompMask failedMask = 0;
+    uint64_t submittedUs[PWRMGR_MAX_COMPONENTS];
+    long readyDueMs[PWRMGR_MAX_COMPONENTS];
+    long nextCheckMs[PWRMGR_MAX_COMPONENTS];
+    int pollMs[PWRMGR_MAX_COMPONENTS];
+    long deadline = PwrMgr_CompGraph_NowMs() + timeoutMs;
+    bool stopping = false;
+    int i;
+
+    mask &= PwrMgr_CompGraph_AllMask(graph);
+
+    while (done != mask) {
+        bool progress = false;
+        int jobId = -1;
+        PWRMGR_UnitJobResult result = PWRMGR_UNIT_JOB_FAILED;
+        long remaining;
+        long nextMs;
+        long now;
+        int waitMs;
+        int rc;
+
+        if (!stopping && cancelled != NULL && cancelled(cancelArg)) {
+            PWRMGRLOG(WARNING, "%s: %s cancelled with 0x%x left\n", __FUNCTION__, PwrMgr_UnitCtl_OpStr(op), mask & ~done & ~inflight);
+            stopping = true;
+        }
+
+        now = PwrMgr_CompGraph_NowMs();
+        for (i = 0; i < graph->count && verifying != 0; i++) {
+            PWRMGR_CompMask bit = PWRMGR_COMP_BIT(i);
+
+            if (!(verifying & bit) || (!stopping && now < nextCheckMs[i] && now < readyDueMs[i]))
+                continue;
+            if (PwrMgr_CompGraph_IsUp(ctl, &graph->comps[i])) {
+                PwrMgr_Stats_RecordComponent(i, op, PwrMgr_Stats_NowUs() - submittedUs[i]);
+            } else if (now >= readyDueMs[i]) {
+                PWRMGRLOG(ERROR, "%s: %s started but is not up\n", __FUNCTION__, graph->comps[i].name);
+                failedMask |= bit;
+            } else if (!stopping) {
+                pollMs[i] = (pollMs[i] * 2 < PWRMGR_READY_POLL_MAX_MS) ? pollMs[i] * 2 : PWRMGR_READY_POLL_MAX_MS;
+                nextCheckMs[i] = now + pollMs[i];
+                continue;
+            }
+            // Cancelled: it is started, whatever runs next takes it from there
+            verifying &= ~bit;
+            done |= bit;
+            progress = true;
+        }
+
+        for (i = 0; i < graph->count && op == PWRMGR_UNIT_START; i++) {
+            PWRMGR_CompMask bit = PWRMGR_COMP_BIT(i);
+
+            if (!(inflight & bit) || graph->comps[i].readyDeadlineMs <= 0 || now < readyDueMs[i])
+                continue;
+            PWRMGRLOG(ERROR, "%s: %s is not started by its ready deadline\n", __FUNCTION__, graph->comps[i].name);
+            PwrMgr_UnitCtl_Forget(ctl, i);
+            inflight &= ~bit;
+            done |= bit;
+            failedMask |= bit;
+            progress = true;
+        }
+
+        for (i = 0; i < graph->count && !stopping; i++) {
+            PWRMGR_CompMask bit = PWRMGR_COMP_BIT(i);
+            PWRMGR_CompMask prereq = (op == PWRMGR_UNIT_START) ? graph->comps[i].startPrereq : graph->comps[i].stopPrereq;
+
+            if (!(mask & bit) || (done & bit) || (inflight & bit) || (verifying & bit) || (prereq & mask & ~done))
+                continue;
+
+            submittedUs[i] = PwrMgr_Stats_NowUs();
+            readyDueMs[i] = graph->comps[i].readyDeadlineMs > 0 ? PwrMgr_CompGraph_NowMs() + graph->comps[i].readyDeadlineMs : deadline;
+            if (readyDueMs[i] > deadline)
+                readyDueMs[i] = deadline;
+            if (PwrMgr_UnitCtl_Submit(ctl, op, graph->comps[i].unit, i) == 0) {
+                inflight |= bit;
+            } else {
+                PWRMGRLOG(ERROR, "%s: failed to %s %s\n", __FUNCTION__, PwrMgr_UnitCtl_OpStr(op), graph->comps[i].unit);
+                done |= bit;
+                failedMask |= bit;
+                progress = true;
+            }
+        }
+
+        if (inflight == 0 && verifying == 0) {
+            if (progress)
+                continue;
+            // Nothing runnable left: cancelled, or a cyclic graph
+            if (!stopping)
+                failedMask |= mask & ~done;
+            break;
+        }
+        if (progress)
+            continue;
+
+        // Wake up for the next readiness check or ready deadline
+        nextMs = deadline;
+        for (i = 0; i < graph->count; i++) {
+            PWRMGR_CompMask bit = PWRMGR_COMP_BIT(i);
+
+            if ((verifying & bit) && nextCheckMs[i] < nextMs)
+                nextMs = nextCheckMs[i];
+            if (((verifying | inflight) & bit) && op == PWRMGR_UNIT_START && graph->comps[i].readyDeadlineMs > 0 && readyDueMs[i] < nextMs)
+                nextMs = readyDueMs[i];
+        }
+        now = PwrMgr_CompGraph_NowMs();
+        remaining = deadline - now;
+        waitMs = nextMs > now ? (int)(nextMs - now) : 0;
+        if (inflight == 0) {
+            // Only waiting for components to come up, their deadlines end the run
+            usleep(waitMs * 1000);
+            continue;
+        }
+
+        rc = PwrMgr_UnitCtl_Wait(ctl, waitMs, &jobId, &result);
+        if (rc == 1 && waitMs < remaining)
+            continue;
+        if (rc != 0) {
+            PWRMGRLOG(ERROR, "%s: %s did not finish in time\n", __FUNCTION__, PwrMgr_UnitCtl_OpStr(op));
+            failedMask |= stopping ? inflight : (mask & ~done);
+            PwrMgr_UnitCtl_Forget(ctl, -1);
+            break;
+        }
+        if (jobId < 0 || jobId >= graph->count || !(inflight & PWRMGR_COMP_BIT(jobId)))
+            continue;
+
+        inflight &= ~PWRMGR_COMP_BIT(jobId);
+        if (op == PWRMGR_UNIT_START && result == PWRMGR_UNIT_JOB_DONE && graph->comps[jobId].readyFile[0] != '\0') {
+            // systemd has started the unit, that does not mean it is serving yet
+            verifying |= PWRMGR_COMP_BIT(jobId);
+            pollMs[jobId] = PWRMGR_READY_POLL_MS;
+            nextCheckMs[jobId] = PwrMgr_CompGraph_NowMs();
+            continue;
+        }
+        done |= PWRMGR_COMP_BIT(jobId);
+        PwrMgr_Stats_RecordComponent(jobId, op, PwrMgr_Stats_NowUs() - submittedUs[jobId]);
+        if (result != PWRMGR_UNIT_JOB_DONE) {
+            PWRMGRLOG(ERROR, "%s: %s %s failed\n", __FUNCTION__, PwrMgr_UnitCtl_OpStr(op), graph->comps[jobId].unit);
+            failedMask |= PWRMGR_COMP_BIT(jobId);
+        }
+    }
+
+    if (completed)
+        *completed = done & ~failedMask;
+    if (failed)
+        *failed = failedMask;
+    return (failedMask == 0) ? 0 : -1;
+}
+
+/**
+ *  @brief Stop the components in mask by a deadline, escalating the ones that overrun
+ *
+ *  Works like a stop run, except that every stop job only has the
+ *  component's stop budget, or what is left of deadlineMs. A component that
+ *  overruns it is sent SIGKILL and gets PWRMGR_KILL_GRACE_MS more, after
+ *  that its cgroup is frozen and it counts as shed. Once deadlineMs has
+ *  passed the edges no longer hold up anything: whatever is still running
+ *  is killed and frozen straight away, and whatever was waiting for it is
+ *  stopped with PWRMGR_KILL_GRACE_MS to go before the same happens to it.
+ *  overrun reports the components that had to be escalated, one that could
+ *  not be frozen either has failed.
+ *
+ *  @return 0 if no component failed, -1 otherwise
+ */
+int PwrMgr_CompGraph_Shed(const PWRMGR_CompGraph *graph, PWRMGR_UnitCtl *ctl, PWRMGR_CompMask mask,
+                          int deadlineMs, PWRMGR_CancelFn cancelled, void *cancelArg,
+                          PWRMGR_CompMask *completed, PWRMGR_CompMask *failed, PWRMGR_CompMask *overrun)
+{
+    PWRMGR_CompMask done = 0;
+    PWRMGR_CompMask inflight = 0;
+    PWRMGR_CompMask killed = 0;
+    PWRMGR_CompMask failedMask = 0;
+    PWRMGR_CompMask overrunMask = 0;
+    uint64_t submittedUs[PWRMGR_MAX_COMPONENTS];
+    long dueMs[PWRMGR_MAX_COMPONENTS];  // End of the stop budget, or of the grace after SIGKILL
+    long deadline = PwrMgr_CompGraph_NowMs() + deadlineMs;
+    bool stopping = false;
+    int i;
+
+    mask &= PwrMgr_CompGraph_AllMask(graph);
+
+    while (done != mask) {
+        long now = PwrMgr_CompGraph_NowMs();
+        bool late = now >= deadline;
+        bool progress = false;
+        long nextMs = LONG_MAX;
+        int jobId = -1;
+        PWRMGR_UnitJobResult result = PWRMGR_UNIT_JOB_FAILED;
+        int rc;
+
+        if (!stopping && cancelled != NULL && cancelled(cancelArg)) {
+            PWRMGRLOG(WARNING, "%s: shedding cancelled with 0x%x left\n", __FUNCTION__, mask & ~done & ~inflight);
+            stopping = true;
+        }
+
+        for (i = 0; i < graph->count && inflight != 0; i++) {
+            PWRMGR_CompMask bit = PWRMGR_COMP_BIT(i);
+            const PWRMGR_Component *comp = &graph->comps[i];
+
+            if (!(inflight & bit) || now < dueMs[i])
+                continue;
+            overrunMask |= bit;
+            if (!(killed & bit)) {
+                PWRMGRLOG(WARNING, "%s: %s still running after %ld ms, killing it\n", __FUNCTION__, comp->name,
+                          (long)((PwrMgr_Stats_NowUs() - submittedUs[i]) / 1000));
+                if (PwrMgr_UnitCtl_Kill(ctl, comp->unit, SIGKILL) != 0)
+                    PWRMGRLOG(ERROR, "%s: cannot kill %s\n", __FUNCTION__, comp->unit);
+                killed |= bit;
+                if (!late) {
+                    dueMs[i] = (now + PWRMGR_KILL_GRACE_MS < deadline) ? now + PWRMGR_KILL_GRACE_MS : deadline;
+                    continue;
+                }
+            }
+            // Most likely stuck in the kernel, at least it no longer gets to run
+            inflight &= ~bit;
+            done |= bit;
+            progress = true;
+            // Nobody waits for its stop job any more
+            PwrMgr_UnitCtl_Forget(ctl, i);
+            if (PwrMgr_UnitCtl_Freeze(ctl, comp->unit) == 0) {
+                PWRMGRLOG(WARNING, "%s: %s did not stop, froze it\n", __FUNCTION__, comp->name);
+            } else {
+                PWRMGRLOG(ERROR, "%s: %s did not stop and cannot be frozen\n", __FUNCTION__, comp->name);
+                failedMask |= bit;
+            }
+        }
+
+        for (i = 0; i < graph->count && !stopping; i++) {
+            PWRMGR_CompMask bit = PWRMGR_COMP_BIT(i);
+            long budgetMs = graph->comps[i].stopBudgetMs;
+
+            if (!(mask & bit) || (done & bit) || (inflight & bit) || (!late && (graph->comps[i].stopPrereq & mask & ~done)))
+                continue;
+
+            submittedUs[i] = PwrMgr_Stats_NowUs();
+            if (late)
+                dueMs[i] = now + PWRMGR_KILL_GRACE_MS;
+            else
+                dueMs[i] = (budgetMs > 0 && now + budgetMs < deadline) ? now + budgetMs : deadline;
+            if (PwrMgr_UnitCtl_Submit(ctl, PWRMGR_UNIT_STOP, graph->comps[i].unit, i) == 0) {
+                inflight |= bit;
+            } else {
+                PWRMGRLOG(ERROR, "%s: failed to stop %s\n", __FUNCTION__, graph->comps[i].unit);
+                done |= bit;
+                failedMask |= bit;
+                progress = true;
+            }
+        }
+
+        if (inflight == 0) {
+            if (progress)
+                continue;
+            // Nothing runnable left: cancelled, or a cyclic graph
+            if (!stopping)
+                failedMask |= mask & ~done;
+            break;
+        }
+        if (progress)
+            continue;
+
+        for (i = 0; i < graph->count; i++) {
+            if ((inflight & PWRMGR_COMP_BIT(i)) && dueMs[i] < nextMs)
+                nextMs = dueMs[i];
+        }
+        now = PwrMgr_CompGraph_NowMs();
+        rc = PwrMgr_UnitCtl_Wait(ctl, nextMs > now ? (int)(nextMs - now) : 0, &jobId, &result);
+        if (rc == 1)
+            continue;
+        if (rc != 0) {
+            PWRMGRLOG(ERROR, "%s: lost track of the stop jobs\n", __FUNCTION__);
+            failedMask |= stopping ? inflight : (mask & ~done);
+            PwrMgr_UnitCtl_Forget(ctl, -1);
+            break;
+        }
+        if (jobId < 0 || jobId >= graph->count || !(inflight & PWRMGR_COMP_BIT(jobId)))
+            continue;
+
+        inflight &= ~PWRMGR_COMP_BIT(jobId);
+        done |= PWRMGR_COMP_BIT(jobId);
+        PwrMgr_Stats_RecordComponent(jobId, PWRMGR_UNIT_STOP, PwrMgr_Stats_NowUs() - submittedUs[jobId]);
+        if (result != PWRMGR_UNIT_JOB_DONE) {
+            PWRMGRLOG(ERROR, "%s: stop %s failed\n", __FUNCTION__, graph->comps[jobId].unit);
+            failedMask |= PWRMGR_COMP_BIT(jobId);
+        }
+    }
+
+    if (completed)
+        *completed = done & ~failedMask;
+    if (failed)
+        *failed = failedMask;
+    if (overrun)
+        *overrun = overrunMask;
+    return (failedMask == 0) ? 0 : -1;
+}
+
+/**
+ *  @brief Mask of the components shed at a thermal level
+ */
+PWRMGR_CompMask PwrMgr_CompGraph_ShedMask(const PWRMGR_CompGraph *graph, PWRMGR_ShedLevel level)
+{
+    PWRMGR_CompMask mask = 0;
+    int i;
+
+    for (i = 0; i < graph->count; i++) {
+        if (graph->comps[i].shedLevel <= level)
+            mask |= PWRMGR_COMP_BIT(i);
+    }
+    return mask;
+}
+
+/**
+ *  @brief Mask of the components shed at a battery tier, 0 while on AC
+ */
+PWRMGR_CompMask PwrMgr_CompGraph_BattShedMask(const PWRMGR_CompGraph *graph, int tier)
+{
+    PWRMGR_CompMask mask = 0;
+    int i;
+
+    for (i = 0; i < graph->count; i++) {
+        if (graph->comps[i].battShedTier <= tier)
+            mask |= PWRMGR_COMP_BIT(i);
+    }
+    return mask;
+}
+
+/**
+ *  @brief Mask of the components running in a power state
+ *
+ *  AC and ThermalCooled run everything, each thermal level sheds its own
+ *  components and those of the levels below, Battery sheds the first tier.
+ */
+PWRMGR_CompMask PwrMgr_CompGraph_StateMask(const PWRMGR_CompGraph *graph, PWRMGR_PwrState state)
+{
+    PWRMGR_CompMask all = PwrMgr_CompGraph_AllMask(graph);
+
+    switch (state) {
+#if defined (_XBB1_SUPPORTED_)
+    case PWRMGR_STATE_BATT:
+        return all & ~PwrMgr_CompGraph_BattShedMask(graph, 1);
+#endif
+    case PWRMGR_STATE_WARM:
+        return all & ~PwrMgr_CompGraph_ShedMask(graph, PWRMGR_SHED_WARM);
+    case PWRMGR_STATE_HOT:
+        return all & ~PwrMgr_CompGraph_ShedMask(graph, PWRMGR_SHED_HOT);
+    case PWRMGR_STATE_CRITICAL:
+        return all & ~PwrMgr_CompGraph_ShedMask(graph, PWRMGR_SHED_CRITICAL);
+    default:
+        return all;
+    }
+}
+
+/**
+ *  @brief Nominal power of the components in mask
+ *  @return mW
+ */
+int PwrMgr_CompGraph_PowerMw(const PWRMGR_CompGraph *graph, PWRMGR_CompMask mask)
+{
+    int powerMw = 0;
+    int i;
+
+    for (i = 0; i < graph->count; i++) {
+        if (mask & PWRMGR_COMP_BIT(i))
+            powerMw += graph->comps[i].powerMw;
+    }
+    return powerMw;
+}
@@ -0,0 +1,305 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+/**
+ *  @file pwrMgr_cpu.c
+ *  @brief RDKB Power Manger CPU actuator
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "pwrMgr_log.h"
+#include "pwrMgr_baseline.h"
+#include "pwrMgr_cpu.h"
+
+/**
+ *  @brief Read a sysfs attribute of a core, trailing newline removed
+ *  @return 0 on success, -1 if it cannot be read
+ */
+static int PwrMgr_Cpu_Read(const PWRMGR_CpuActuator *act, int cpu, const char *name, char *buf, int len)
+{
+    char path[256];
+    ssize_t n;
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/cpu%d/%s", act->root, cpu, name);
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+    n = read(fd, buf, len - 1);
+    close(fd);
+    if (n <= 0)
+        return -1;
+    buf[n] = '\0';
+    buf[strcspn(buf, "\n")] = '\0';
+    return 0;
+}
+
+static long PwrMgr_Cpu_ReadLong(const PWRMGR_CpuActuator *act, int cpu, const char *name)
+{
+    char buf[32];
+
+    return (PwrMgr_Cpu_Read(act, cpu, name, buf, sizeof(buf)) == 0) ? atol(buf) : -1;
+}
+
+/**
+ *  @brief Write a sysfs attribute of a core
+ *  @return 0 on success or when the core has no such attribute, -1 on failure
+ */
+static int PwrMgr_Cpu_Write(const PWRMGR_CpuActuator *act, int cpu, const char *name, const char *value)
+{
+    char path[256];
+    ssize_t len = strlen(value);
+    ssize_t n;
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/cpu%d/%s", act->root, cpu, name);
+    // Like a shell redirect, sysfs ignores the truncate
+    fd = open(path, O_WRONLY | O_TRUNC | O_CLOEXEC);
+    if (fd < 0) {
+        if (errno == ENOENT)
+            return 0;
+        PWRMGRLOG(ERROR, "%s: cannot open %s, %s\n", __FUNCTION__, path, strerror(errno));
+        return -1;
+    }
+    n = write(fd, value, len);
+    close(fd);
+    if (n != len) {
+        PWRMGRLOG(ERROR, "%s: cannot write %s to %s\n", __FUNCTION__, value, path);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ *  @brief One line of the baseline file: cpu<n> <online> <max kHz> [governor]
+ *  @return the core it covers, -1 to skip it
+ */
+static int PwrMgr_Cpu_ParseBaseline(void *ctx, const char *line)
+{
+    PWRMGR_CpuActuator *act = ctx;
+    char governor[PWRMGR_CPU_GOV_LEN] = "";
+    int cpu, online;
+    long maxKHz;
+
+    if (sscanf(line, "cpu%d %d %ld %31s", &cpu, &online, &maxKHz, governor) < 3 || cpu < 0 || cpu >= act->count)
+        return -1;
+    act->cpus[cpu].online = (online != 0);
+    act->cpus[cpu].maxKHz = maxKHz;
+    strcpy(act->cpus[cpu].governor, governor);
+    return cpu;
+}
+
+static void PwrMgr_Cpu_FormatBaseline(const void *ctx, int cpu, char *buf, int len)
+{
+    const PWRMGR_CpuActuator *act = ctx;
+
+    snprintf(buf, len, "cpu%d %d %ld %s\n", cpu, act->cpus[cpu].online, act->cpus[cpu].maxKHz, act->cpus[cpu].governor);
+}
+
+/**
+ *  @brief Default profiles: clock first, then cores, nothing on AC and cooled
+ */
+void PwrMgr_Cpu_DefaultProfiles(PWRMGR_CpuProfile profiles[PWRMGR_STATE_TOTAL])
+{
+    memset(profiles, 0, sizeof(PWRMGR_CpuProfile) * PWRMGR_STATE_TOTAL);
+    profiles[PWRMGR_STATE_WARM].maxFreqPercent = 80;
+    profiles[PWRMGR_STATE_HOT].maxFreqPercent = 60;
+    profiles[PWRMGR_STATE_HOT].onlineCpus = 2;
+    strcpy(profiles[PWRMGR_STATE_CRITICAL].governor, "powersave");
+    profiles[PWRMGR_STATE_CRITICAL].onlineCpus = 1;
+#if defined (_XBB1_SUPPORTED_)
+    profiles[PWRMGR_STATE_BATT].maxFreqPercent = 60;
+    profiles[PWRMGR_STATE_BATT].onlineCpus = 2;
+#endif
+}
+
+/**
+ *  @brief Find the cores under root and establish their baseline
+ *  @return 0 on success, -1 without any core
+ */
+int PwrMgr_Cpu_Open(PWRMGR_CpuActuator *act, const char *root, const char *baselinePath)
+{
+    char path[256];
+    int i;
+
+    memset(act, 0, sizeof(*act));
+    if (strlen(root) >= sizeof(act->root))
+        return -1;
+    strcpy(act->root, root);
+    PwrMgr_Cpu_DefaultProfiles(act->profiles);
+
+    for (i = 0; i < PWRMGR_CPU_MAX; i++) {
+        snprintf(path, sizeof(path), "%s/cpu%d", root, i);
+        if (access(path, F_OK) != 0)
+            break;
+        snprintf(path, sizeof(path), "%s/cpu%d/online", root, i);
+        act->cpus[i].hotplug = (access(path, F_OK) == 0);
+    }
+    act->count = i;
+    if (act->count == 0) {
+        PWRMGRLOG(WARNING, "%s: no cores under %s\n", __FUNCTION__, root);
+        return -1;
+    }
+
+    if (PwrMgr_Baseline_Load(baselinePath, act->count, PwrMgr_Cpu_ParseBaseline, act) != 0) {
+        for (i = 0; i < act->count; i++) {
+            PWRMGR_Cpu *cpu = &act->cpus[i];
+
+            cpu->online = !cpu->hotplug || PwrMgr_Cpu_ReadLong(act, i, "online") == 1;
+            if (PwrMgr_Cpu_Read(act, i, "cpufreq/scaling_governor", cpu->governor, sizeof(cpu->governor)) != 0)
+                cpu->governor[0] = '\0';
+            cpu->maxKHz = PwrMgr_Cpu_ReadLong(act, i, "cpufreq/scaling_max_freq");
+        }
+        if (PwrMgr_Baseline_Save(baselinePath, act->count, PwrMgr_Cpu_FormatBaseline, act) != 0)
+            PWRMGRLOG(WARNING, "%s: cannot save %s\n", __FUNCTION__, baselinePath);
+    }
+    return 0;
+}
+
+/**
+ *  @brief Replace the profile of a state, takes effect on the next apply
+ */
+void PwrMgr_Cpu_SetProfile(PWRMGR_CpuActuator *act, PWRMGR_PwrState state, const PWRMGR_CpuProfile *profile)
+{
+    if (state > PWRMGR_STATE_UNKNOWN && state < PWRMGR_STATE_TOTAL)
+        act->profiles[state] = *profile;
+}
+
+/**
+ *  @brief Set the governor and clock cap of an online core
+ *  @return 0 on success
+ */
+static int PwrMgr_Cpu_ApplyFreq(PWRMGR_CpuActuator *act, int i, const PWRMGR_CpuProfile *p)
+{
+    PWRMGR_Cpu *cpu = &act->cpus[i];
+    const char *governor = p->governor[0] ? p->governor : cpu->governor;
+    long maxKHz = cpu->maxKHz;
+    char buf[16];
+    int status = 0;
+
+    if (governor[0] != '\0' && PwrMgr_Cpu_Write(act, i, "cpufreq/scaling_governor", governor) != 0)
+        status = -1;
+
+    if (p->maxFreqPercent > 0) {
+        // A parked core has no cpufreq directory, learn the limits once it is up
+        if (cpu->hwMaxKHz <= 0) {
+            cpu->hwMaxKHz = PwrMgr_Cpu_ReadLong(act, i, "cpufreq/cpuinfo_max_freq");
+            cpu->hwMinKHz = PwrMgr_Cpu_ReadLong(act, i, "cpufreq/cpuinfo_min_freq");
+        }
+        if (cpu->hwMaxKHz <= 0)
+            return status;
+        maxKHz = cpu->hwMaxKHz * p->maxFreqPercent / 100;
+        if (maxKHz < cpu->hwMinKHz)
+            maxKHz = cpu->hwMinKHz;
+    }
+    if (maxKHz > 0) {
+        snprintf(buf, sizeof(buf), "%ld", maxKHz);
+        if (PwrMgr_Cpu_Write(act, i, "cpufreq/scaling_max_freq", buf) != 0)
+            status = -1;
+    }
+    return status;
+}
+
+/**
+ *  @brief Bring the cores in line with the profile of state
+ *  @return 0 on success, -1 if some setting could not be written
+ */
+int PwrMgr_Cpu_Apply(PWRMGR_CpuActuator *act, PWRMGR_PwrState state)
+{
+    return PwrMgr_Cpu_ApplyStates(act, &state, 1);
+}
+
+/**
+ *  @brief Merge the profiles of states, the most restrictive setting of each field wins
+ */
+static void PwrMgr_Cpu_Merge(const PWRMGR_CpuActuator *act, const PWRMGR_PwrState *states, int count, PWRMGR_CpuProfile *merged)
+{
+    int i;
+
+    memset(merged, 0, sizeof(*merged));
+    for (i = 0; i < count; i++) {
+        const PWRMGR_CpuProfile *p = &act->profiles[states[i]];
+
+        if (p->governor[0] != '\0' && (merged->governor[0] == '\0' || strcmp(p->governor, "powersave") == 0))
+            strcpy(merged->governor, p->governor);
+        if (p->maxFreqPercent > 0 && (merged->maxFreqPercent == 0 || p->maxFreqPercent < merged->maxFreqPercent))
+            merged->maxFreqPercent = p->maxFreqPercent;
+        if (p->onlineCpus > 0 && (merged->onlineCpus == 0 || p->onlineCpus < merged->onlineCpus))
+            merged->onlineCpus = p->onlineCpus;
+    }
+}
+
+/**
+ *  @brief Bring the cores in line with the merged profiles of states, one per axis
+ *
+ *  Cores coming back are onlined before their clocks are set, cores being
+ *  parked are capped first and parked last. Nothing is written when the
+ *  merged profile is the one already applied.
+ *  @return 0 on success, -1 if some setting could not be written
+ */
+int PwrMgr_Cpu_ApplyStates(PWRMGR_CpuActuator *act, const PWRMGR_PwrState *states, int count)
+{
+    PWRMGR_CpuProfile merged;
+    const PWRMGR_CpuProfile *p = &merged;
+    bool want[PWRMGR_CPU_MAX];
+    int online = 0;
+    int status = 0;
+    int i;
+
+    if (count <= 0)
+        return -1;
+    for (i = 0; i < count; i++) {
+        if (states[i] <= PWRMGR_STATE_UNKNOWN || states[i] >= PWRMGR_STATE_TOTAL)
+            return -1;
+    }
+    PwrMgr_Cpu_Merge(act, states, count, &merged);
+    if (act->applied && memcmp(&merged, &act->last, sizeof(merged)) == 0)
+        return 0;
+
+    for (i = 0; i < act->count; i++) {
+        const PWRMGR_Cpu *cpu = &act->cpus[i];
+
+        want[i] = cpu->online && (!cpu->hotplug || p->onlineCpus <= 0 || online < p->onlineCpus);
+        online += want[i];
+    }
+
+    for (i = 0; i < act->count; i++) {
+        if (want[i] && act->cpus[i].hotplug && PwrMgr_Cpu_Write(act, i, "online", "1") != 0)
+            status = -1;
+    }
+    for (i = 0; i < act->count; i++) {
+        if (want[i] && PwrMgr_Cpu_ApplyFreq(act, i, p) != 0)
+            status = -1;
+    }
+    for (i = 0; i < act->count; i++) {
+        if (!want[i] && act->cpus[i].online && PwrMgr_Cpu_Write(act, i, "online", "0") != 0)
+            status = -1;
+    }
+
+    act->last = merged;
+    act->applied = true;
+    PWRMGRLOG(INFO, "%s: %d of %d cores online, clock %d%%, governor %s\n", __FUNCTION__, online, act->count,
+              p->maxFreqPercent ? p->maxFreqPercent : 100, p->governor[0] ? p->governor : "unchanged");
+    return status;
+}
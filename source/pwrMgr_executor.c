@@ -0,0 +1,600 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ *  @file pwrMgr_executor.c
+ *  @brief RDKB Power Manger transition executor
+ */
+
+#define _GNU_SOURCE
+#include <limits.h>
+#include <string.h>
+#include <time.h>
+#include "pwrMgr_log.h"
+#include "pwrMgr_executor.h"
+#include "pwrMgr_stats.h"
+
+static long PwrMgr_Exec_NowMs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void PwrMgr_Exec_TimedWait(PWRMGR_Executor *ex, long waitMs)
+{
+    struct timespec ts;
+
+    if (waitMs < 0) {
+        pthread_cond_wait(&ex->cond, &ex->lock);
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += waitMs / 1000;
+    ts.tv_nsec += (waitMs % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+    pthread_cond_timedwait(&ex->cond, &ex->lock, &ts);
+}
+
+/**
+ *  @brief Check whether a request is pending on any axis, call with the lock held
+ *
+ *  A request the inhibited callback holds back does not count.
+ */
+static bool PwrMgr_Exec_Pending(PWRMGR_Executor *ex)
+{
+    int axis;
+
+    for (axis = 0; axis < PWRMGR_AXIS_TOTAL; axis++) {
+        if (ex->co[axis].pending != PWRMGR_STATE_UNKNOWN && ex->deferredSinceMs[axis] < 0)
+            return true;
+    }
+    return false;
+}
+
+/**
+ *  @brief Cancellation check handed to the component runner
+ *  @return true once a newer request is pending or the executor is stopping
+ */
+static bool PwrMgr_Exec_Cancelled(void *arg)
+{
+    PWRMGR_Executor *ex = (PWRMGR_Executor *)arg;
+    bool cancelled;
+
+    pthread_mutex_lock(&ex->lock);
+    cancelled = ex->stop || PwrMgr_Exec_Pending(ex);
+    pthread_mutex_unlock(&ex->lock);
+    return cancelled;
+}
+
+/**
+ *  @brief Name of a state for logging
+ */
+static const char *PwrMgr_Exec_StateStr(PWRMGR_Executor *ex, PWRMGR_PwrState state)
+{
+    return ex->fsm ? PwrMgr_Fsm_StateStr(ex->fsm, state) : "state";
+}
+
+/**
+ *  @brief The request of an axis is no longer held back, call with the lock held
+ */
+static void PwrMgr_Exec_EndDeferral(PWRMGR_Executor *ex, int axis, long now)
+{
+    if (ex->deferredSinceMs[axis] < 0)
+        return;
+    ex->stats.deferredMs += now - ex->deferredSinceMs[axis];
+    ex->deferredSinceMs[axis] = -1;
+}
+
+/**
+ *  @brief Ask the inhibited callback whether a due request has to wait, call with the lock held
+ *  @return ms to hold it back, 0 to go ahead
+ */
+static long PwrMgr_Exec_Inhibited(PWRMGR_Executor *ex, int axis, PWRMGR_PwrState next, long now)
+{
+    PWRMGR_PowerVector wanted = ex->wanted;
+    PWRMGR_CompMask stops;
+    long holdMs;
+
+    if (ex->ops->inhibited == NULL)
+        return 0;
+    PwrMgr_Arbiter_Set(&wanted, next);
+    stops = ex->running & ~PwrMgr_Arbiter_RunMask(&wanted, ex->runMask);
+    holdMs = ex->ops->inhibited(ex->ctx, next, stops);
+    if (holdMs <= 0) {
+        PwrMgr_Exec_EndDeferral(ex, axis, now);
+        return 0;
+    }
+    if (ex->deferredSinceMs[axis] < 0) {
+        PWRMGRLOG(INFO, "%s: transition to %s (%d) held back\n",__FUNCTION__, PwrMgr_Exec_StateStr(ex, next), next);
+        ex->deferredSinceMs[axis] = now;
+        ex->stats.deferred++;
+    }
+    PwrMgr_Coalesce_Hold(&ex->co[axis], next);
+    return holdMs;
+}
+
+/**
+ *  @brief Report the running set to the progress callback
+ */
+static void PwrMgr_Exec_Progress(PWRMGR_Executor *ex, PWRMGR_PwrState state, PWRMGR_PwrState target)
+{
+    PWRMGR_CompMask running;
+
+    if (ex->ops->progress == NULL)
+        return;
+    pthread_mutex_lock(&ex->lock);
+    running = ex->running;
+    pthread_mutex_unlock(&ex->lock);
+    ex->ops->progress(ex->ctx, state, target, running);
+}
+
+/**
+ *  @brief Move the components in the stop or start delta towards target
+ *  @return 0 when done, 1 when cancelled, -1 when a component failed
+ */
+static int PwrMgr_Exec_RunOp(PWRMGR_Executor *ex, PWRMGR_PwrState from, PWRMGR_PwrState target, PWRMGR_UnitOp op)
+{
+    PWRMGR_CompMask completed = 0;
+    PWRMGR_CompMask desired;
+    PWRMGR_CompMask delta;
+    int status = 0;
+
+    pthread_mutex_lock(&ex->lock);
+    desired = PwrMgr_Arbiter_RunMask(&ex->wanted, ex->runMask);
+    delta = (op == PWRMGR_UNIT_STOP) ? (ex->running & ~desired) : (desired & ~ex->running);
+    pthread_mutex_unlock(&ex->lock);
+    if (delta == 0)
+        return 0;
+
+    if (ex->ops->run(ex->ctx, target, op, delta, PwrMgr_Exec_Cancelled, ex, &completed) != 0)
+        status = -1;
+    pthread_mutex_lock(&ex->lock);
+    if (op == PWRMGR_UNIT_STOP)
+        ex->running &= ~completed;
+    else
+        ex->running |= completed;
+    pthread_mutex_unlock(&ex->lock);
+    PwrMgr_Exec_Progress(ex, from, target);
+
+    return PwrMgr_Exec_Cancelled(ex) ? 1 : status;
+}
+
+/**
+ *  @brief Stop and start what differs between the running set and target
+ *
+ *  The transition table entry from the state target's axis was in orders
+ *  the stop and start steps, see PwrMgr_Fsm_Steps.
+ *
+ *  @return 0 when done, 1 when cancelled, -1 when a component failed
+ */
+static int PwrMgr_Exec_Reconcile(PWRMGR_Executor *ex, PWRMGR_PwrState from, PWRMGR_PwrState target)
+{
+    PWRMGR_FsmAction steps[2];
+    int count = PwrMgr_Fsm_Steps(ex->fsm, PwrMgr_Arbiter_Get(&ex->reached, target), target, steps);
+    int status = 0;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        int rc = PwrMgr_Exec_RunOp(ex, from, target, (steps[i] == PWRMGR_FSM_ACT_STOP) ? PWRMGR_UNIT_STOP : PWRMGR_UNIT_START);
+        if (rc == 1)
+            return 1;
+        if (rc != 0)
+            status = -1;
+    }
+
+    return status;
+}
+
+/**
+ *  @brief Transition thread
+ *  @return 0
+ */
+static void *PwrMgr_Exec_Thread(void *arg)
+{
+    PWRMGR_Executor *ex = (PWRMGR_Executor *)arg;
+    PWRMGRLOG(INFO, "Entering into %s\n",__FUNCTION__)
+
+    pthread_mutex_lock(&ex->lock);
+    while (!ex->stop)
+    {
+        PWRMGR_PwrState next = PWRMGR_STATE_UNKNOWN;
+        long now = PwrMgr_Exec_NowMs();
+        long waitMs = -1;
+        unsigned long suppressed = 0;
+        int axis;
+
+        for (axis = 0; axis < PWRMGR_AXIS_TOTAL; axis++)
+        {
+            long axisMs = PwrMgr_Coalesce_Next(&ex->co[axis], now, &next);
+
+            if (axisMs == 0)
+                axisMs = PwrMgr_Exec_Inhibited(ex, axis, next, now);
+            else
+                PwrMgr_Exec_EndDeferral(ex, axis, now);
+            if (axisMs == 0)
+                break;
+            if (axisMs > 0 && (waitMs < 0 || axisMs < waitMs))
+                waitMs = axisMs;
+        }
+
+        if (axis < PWRMGR_AXIS_TOTAL)
+        {
+            // Committed: requests for the previous state now count as a real change
+            PWRMGR_PwrState prev = PwrMgr_Arbiter_Set(&ex->wanted, next);
+
+            PWRMGRLOG(INFO, "%s: transition requested from %s (%d) to %s (%d)\n",__FUNCTION__,
+                      PwrMgr_Exec_StateStr(ex, prev), prev, PwrMgr_Exec_StateStr(ex, next), next);
+            ex->target = next;
+            ex->dirty = true;
+            ex->receivedUs = ex->postedUs[axis];
+            PwrMgr_Coalesce_Done(&ex->co[axis], next, now);
+            PwrMgr_Stats_RecordPhase(PWRMGR_PHASE_QUEUE, PwrMgr_Stats_NowUs() - ex->receivedUs);
+            continue;
+        }
+
+        // A pending request inside its hysteresis window, on either axis, holds the executor still
+        if (ex->dirty && !PwrMgr_Exec_Pending(ex))
+        {
+            PWRMGR_PwrState from = ex->state;
+            PWRMGR_PwrState target = ex->target;
+            uint64_t receivedUs = ex->receivedUs;
+            uint64_t startUs, doneUs, publishedUs;
+            int rc;
+
+            ex->busy = true;
+            pthread_mutex_unlock(&ex->lock);
+            startUs = PwrMgr_Stats_NowUs();
+            PwrMgr_Exec_Progress(ex, from, target);
+            rc = PwrMgr_Exec_Reconcile(ex, from, target);
+            doneUs = PwrMgr_Stats_NowUs();
+            pthread_mutex_lock(&ex->lock);
+
+            if (rc == 1)
+            {
+                ex->busy = false;
+                ex->stats.preempted++;
+                PWRMGRLOG(WARNING, "%s: transition to %s (%d) preempted\n",__FUNCTION__, PwrMgr_Exec_StateStr(ex, target), target);
+                continue;
+            }
+
+            ex->dirty = false;
+            ex->state = target;
+            ex->reached = ex->wanted;
+            ex->stats.transitions++;
+            pthread_mutex_unlock(&ex->lock);
+            PwrMgr_Exec_Progress(ex, target, target);
+            ex->ops->reached(ex->ctx, from, target, rc == 0);
+            publishedUs = PwrMgr_Stats_NowUs();
+
+            // A run mask change reconciles without a request, it only counts as execute time
+            PwrMgr_Stats_RecordPhase(PWRMGR_PHASE_EXECUTE, doneUs - startUs);
+            PwrMgr_Stats_RecordPhase(PWRMGR_PHASE_PUBLISH, publishedUs - doneUs);
+            if (receivedUs != 0) {
+                PwrMgr_Stats_RecordPhase(PWRMGR_PHASE_TOTAL, publishedUs - receivedUs);
+                PwrMgr_Stats_RecordEdge(from, target, publishedUs - receivedUs);
+            }
+            if (ex->ops->stats)
+                ex->ops->stats(ex->ctx, from, target, receivedUs ? publishedUs - receivedUs : 0);
+            pthread_mutex_lock(&ex->lock);
+            // Only idle once the new state is published
+            ex->busy = false;
+            ex->receivedUs = 0;
+            ex->idleDueMs = 0;
+            pthread_cond_broadcast(&ex->cond);
+            continue;
+        }
+
+        for (axis = 0; axis < PWRMGR_AXIS_TOTAL; axis++)
+            suppressed += PwrMgr_Coalesce_Suppressed(&ex->co[axis]);
+        if (suppressed != ex->published && ex->ops->suppressed)
+        {
+            ex->published = suppressed;
+            pthread_mutex_unlock(&ex->lock);
+            ex->ops->suppressed(ex->ctx, suppressed);
+            pthread_mutex_lock(&ex->lock);
+            continue;
+        }
+
+        if ((ex->stats.deferred != ex->publishedDeferred || ex->stats.deferredMs != ex->publishedDeferredMs) && ex->ops->deferred)
+        {
+            ex->publishedDeferred = ex->stats.deferred;
+            ex->publishedDeferredMs = ex->stats.deferredMs;
+            pthread_mutex_unlock(&ex->lock);
+            ex->ops->deferred(ex->ctx, ex->publishedDeferred, ex->publishedDeferredMs);
+            pthread_mutex_lock(&ex->lock);
+            continue;
+        }
+
+        if (ex->ops->idle)
+        {
+            long idleMs;
+
+            if (now >= ex->idleDueMs)
+            {
+                pthread_mutex_unlock(&ex->lock);
+                idleMs = ex->ops->idle(ex->ctx);
+                pthread_mutex_lock(&ex->lock);
+                ex->idleDueMs = (idleMs < 0) ? LONG_MAX : PwrMgr_Exec_NowMs() + idleMs;
+                continue;
+            }
+            if (ex->idleDueMs != LONG_MAX && (waitMs < 0 || ex->idleDueMs - now < waitMs))
+                waitMs = ex->idleDueMs - now;
+        }
+
+        // Idle: wake up anyone in PwrMgr_Exec_WaitIdle
+        pthread_cond_broadcast(&ex->cond);
+        PwrMgr_Exec_TimedWait(ex, waitMs);
+    }
+    pthread_mutex_unlock(&ex->lock);
+
+    PWRMGRLOG(INFO, "Exiting from %s\n",__FUNCTION__)
+    return 0;
+}
+
+/**
+ *  @brief Set up an executor, running holds the components currently up
+ *
+ *  The axes other than the one of state start unconstrained. If running
+ *  does not match what they run the executor reconciles it as soon as it is
+ *  started.
+ */
+void PwrMgr_Exec_Init(PWRMGR_Executor *ex, const PWRMGR_ExecOps *ops, void *ctx,
+                      PWRMGR_PwrState state, PWRMGR_CompMask running)
+{
+    pthread_condattr_t attr;
+    int axis;
+
+    memset(ex, 0, sizeof(*ex));
+    ex->ops = ops;
+    ex->ctx = ctx;
+    ex->state = state;
+    ex->target = state;
+    ex->running = running;
+    PwrMgr_Arbiter_Init(&ex->reached, state);
+    ex->wanted = ex->reached;
+    for (axis = 0; axis < PWRMGR_AXIS_TOTAL; axis++) {
+        PwrMgr_Coalesce_Init(&ex->co[axis], ex->reached.axis[axis], PwrMgr_Exec_NowMs());
+        ex->deferredSinceMs[axis] = -1;
+    }
+
+    pthread_mutex_init(&ex->lock, NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&ex->cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+/**
+ *  @brief Carry on with a transition to target that was in flight, call before starting
+ *
+ *  Unlike a posted request it is not subject to hysteresis and does not
+ *  count towards the latency statistics. Each axis can be resumed, the last
+ *  call sets the state that is published.
+ */
+void PwrMgr_Exec_Resume(PWRMGR_Executor *ex, PWRMGR_PwrState target)
+{
+    if (target <= PWRMGR_STATE_UNKNOWN || target >= PWRMGR_STATE_TOTAL)
+        return;
+    pthread_mutex_lock(&ex->lock);
+    ex->target = target;
+    PwrMgr_Arbiter_Set(&ex->wanted, target);
+    ex->dirty = true;
+    PwrMgr_Coalesce_Done(&ex->co[PwrMgr_Arbiter_Axis(target)], target, PwrMgr_Exec_NowMs());
+    pthread_mutex_unlock(&ex->lock);
+}
+
+/**
+ *  @brief Set the components that should be running in a state, may change at run time
+ */
+void PwrMgr_Exec_SetRunMask(PWRMGR_Executor *ex, PWRMGR_PwrState state, PWRMGR_CompMask mask)
+{
+    if (state <= PWRMGR_STATE_UNKNOWN || state >= PWRMGR_STATE_TOTAL)
+        return;
+    pthread_mutex_lock(&ex->lock);
+    ex->runMask[state] = mask;
+    ex->dirty = (ex->running != PwrMgr_Arbiter_RunMask(&ex->wanted, ex->runMask));
+    // A change to the current state reconciles without waiting for a request
+    pthread_cond_broadcast(&ex->cond);
+    pthread_mutex_unlock(&ex->lock);
+}
+
+/**
+ *  @brief Switch a state on or off, requests for a state that is off are rejected
+ */
+void PwrMgr_Exec_SetEnabled(PWRMGR_Executor *ex, PWRMGR_PwrState state, bool enabled)
+{
+    if (state <= PWRMGR_STATE_UNKNOWN || state >= PWRMGR_STATE_TOTAL)
+        return;
+    pthread_mutex_lock(&ex->lock);
+    ex->disabled[state] = !enabled;
+    pthread_mutex_unlock(&ex->lock);
+}
+
+/**
+ *  @brief Use a transition table to order steps and reject requests, NULL accepts everything
+ */
+void PwrMgr_Exec_SetFsm(PWRMGR_Executor *ex, const PWRMGR_Fsm *fsm)
+{
+    pthread_mutex_lock(&ex->lock);
+    ex->fsm = fsm;
+    pthread_mutex_unlock(&ex->lock);
+}
+
+/**
+ *  @brief Set the hysteresis and minimum dwell time of a state
+ */
+void PwrMgr_Exec_SetTiming(PWRMGR_Executor *ex, PWRMGR_PwrState state, long hysteresisMs, long minDwellMs)
+{
+    pthread_mutex_lock(&ex->lock);
+    PwrMgr_Coalesce_SetTiming(&ex->co[PwrMgr_Arbiter_Axis(state)], state, hysteresisMs, minDwellMs);
+    pthread_mutex_unlock(&ex->lock);
+}
+
+/**
+ *  @brief Set how severe a state is, escalating skips the minimum dwell
+ */
+void PwrMgr_Exec_SetSeverity(PWRMGR_Executor *ex, PWRMGR_PwrState state, int severity)
+{
+    pthread_mutex_lock(&ex->lock);
+    PwrMgr_Coalesce_SetSeverity(&ex->co[PwrMgr_Arbiter_Axis(state)], state, severity);
+    pthread_mutex_unlock(&ex->lock);
+}
+
+/**
+ *  @brief Start the transition thread
+ *  @return 0 on success
+ */
+int PwrMgr_Exec_Start(PWRMGR_Executor *ex)
+{
+    int status = pthread_create(&ex->tid, NULL, PwrMgr_Exec_Thread, ex);
+
+    if (status != 0) {
+        PWRMGRLOG(ERROR, "%s error occured while creating PwrMgr_Exec_Thread thread\n", strerror(status))
+        return -1;
+    }
+    ex->started = true;
+    if (pthread_setname_np(ex->tid, "pwrMgr_trans") != 0)
+        PWRMGRLOG(ERROR, "%s: failed to set the transition thread name\n",__FUNCTION__);
+    return 0;
+}
+
+/**
+ *  @brief Request a transition, a transition in flight to another state is cancelled
+ *  @return 0 if accepted, -1 if the state is off or the transition table rejects it
+ */
+int PwrMgr_Exec_Post(PWRMGR_Executor *ex, PWRMGR_PwrState target)
+{
+    PWRMGR_Axis axis = PwrMgr_Arbiter_Axis(target);
+    PWRMGR_Coalescer *co = &ex->co[axis];
+    PWRMGR_PwrState pending;
+    PWRMGR_PwrState current;
+
+    pthread_mutex_lock(&ex->lock);
+    current = PwrMgr_Arbiter_Get(&ex->wanted, target);
+    if (target <= PWRMGR_STATE_UNKNOWN || target >= PWRMGR_STATE_TOTAL || ex->disabled[target] ||
+        (ex->fsm && target != current && !PwrMgr_Fsm_Allowed(ex->fsm, current, target))) {
+        ex->stats.rejected++;
+        pthread_mutex_unlock(&ex->lock);
+        PWRMGRLOG(WARNING, "%s: transition from %s to %s rejected\n",__FUNCTION__,
+                  PwrMgr_Exec_StateStr(ex, current), PwrMgr_Exec_StateStr(ex, target));
+        return -1;
+    }
+    pending = co->pending;
+    PwrMgr_Coalesce_Post(co, target, PwrMgr_Exec_NowMs());
+    // Latency is measured from the first request for the state that wins
+    if (co->pending != pending)
+        ex->postedUs[axis] = PwrMgr_Stats_NowUs();
+    pthread_cond_broadcast(&ex->cond);
+    pthread_mutex_unlock(&ex->lock);
+    return 0;
+}
+
+/**
+ *  @brief Run the idle callback once the transition in flight, if any, is done
+ */
+void PwrMgr_Exec_Kick(PWRMGR_Executor *ex)
+{
+    pthread_mutex_lock(&ex->lock);
+    ex->idleDueMs = 0;
+    pthread_cond_broadcast(&ex->cond);
+    pthread_mutex_unlock(&ex->lock);
+}
+
+/**
+ *  @brief Wait until nothing is pending and every component matches the target
+ *  @return true when idle, false on timeout
+ */
+bool PwrMgr_Exec_WaitIdle(PWRMGR_Executor *ex, int timeoutMs)
+{
+    long deadline = PwrMgr_Exec_NowMs() + timeoutMs;
+    bool idle;
+
+    pthread_mutex_lock(&ex->lock);
+    for (;;) {
+        long remaining = deadline - PwrMgr_Exec_NowMs();
+        idle = !ex->busy && !ex->dirty && !PwrMgr_Exec_Pending(ex);
+        if (idle || remaining <= 0)
+            break;
+        PwrMgr_Exec_TimedWait(ex, remaining);
+    }
+    pthread_mutex_unlock(&ex->lock);
+    return idle;
+}
+
+/**
+ *  @brief Snapshot of the executor state, the coalescing stats add up every axis, any output may be NULL
+ */
+void PwrMgr_Exec_GetStatus(PWRMGR_Executor *ex, PWRMGR_PwrState *state, PWRMGR_CompMask *running,
+                           PWRMGR_ExecStats *stats, PWRMGR_CoalesceStats *coStats)
+{
+    int axis;
+
+    pthread_mutex_lock(&ex->lock);
+    if (state)
+        *state = ex->state;
+    if (running)
+        *running = ex->running;
+    if (stats)
+        *stats = ex->stats;
+    if (coStats) {
+        memset(coStats, 0, sizeof(*coStats));
+        for (axis = 0; axis < PWRMGR_AXIS_TOTAL; axis++) {
+            coStats->received += ex->co[axis].stats.received;
+            coStats->executed += ex->co[axis].stats.executed;
+            coStats->coalesced += ex->co[axis].stats.coalesced;
+            coStats->sameState += ex->co[axis].stats.sameState;
+            coStats->flapped += ex->co[axis].stats.flapped;
+        }
+    }
+    pthread_mutex_unlock(&ex->lock);
+}
+
+/**
+ *  @brief State of each axis last reached and being worked towards, either may be NULL
+ */
+void PwrMgr_Exec_GetVectors(PWRMGR_Executor *ex, PWRMGR_PowerVector *reached, PWRMGR_PowerVector *wanted)
+{
+    pthread_mutex_lock(&ex->lock);
+    if (reached)
+        *reached = ex->reached;
+    if (wanted)
+        *wanted = ex->wanted;
+    pthread_mutex_unlock(&ex->lock);
+}
+
+/**
+ *  @brief Stop the transition thread, a transition in flight is cancelled
+ */
+void PwrMgr_Exec_Stop(PWRMGR_Executor *ex)
+{
+    if (!ex->started)
+        return;
+
+    pthread_mutex_lock(&ex->lock);
+    ex->stop = true;
+    pthread_cond_broadcast(&ex->cond);
+    pthread_mutex_unlock(&ex->lock);
+    pthread_join(ex->tid, NULL);
+    ex->started = false;
+}
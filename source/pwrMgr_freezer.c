@@ -0,0 +1,366 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+/**
+ *  @file pwrMgr_freezer.c
+ *  @brief RDKB Power Manger cgroup freezer
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "pwrMgr_log.h"
+#include "pwrMgr_freezer.h"
+
+static uint64_t PwrMgr_Freezer_NowUs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static PWRMGR_FreezerUnit *PwrMgr_Freezer_Find(const PWRMGR_Freezer *fz, const char *unit)
+{
+    int i;
+
+    for (i = 0; i < fz->count; i++) {
+        if (strcmp(fz->units[i].unit, unit) == 0)
+            return (PWRMGR_FreezerUnit *)&fz->units[i];
+    }
+    return NULL;
+}
+
+/**
+ *  @brief Read the freeze state of a unit's cgroup
+ *  @return 1 when frozen, 0 when thawed, -1 without a freezable cgroup
+ */
+static int PwrMgr_Freezer_Read(const PWRMGR_Freezer *fz, const char *unit)
+{
+    char path[256];
+    char buf[4] = {0};
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/%s/cgroup.freeze", fz->root, unit);
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+    if (read(fd, buf, sizeof(buf) - 1) <= 0)
+        buf[0] = '\0';
+    close(fd);
+    return (buf[0] == '1') ? 1 : (buf[0] == '0') ? 0 : -1;
+}
+
+/**
+ *  @brief Wait for cgroup.events to report the frozen state we asked for
+ *
+ *  The kernel raises POLLPRI on cgroup.events whenever it changes. A cgroup
+ *  without the file, like a fake one in the tests, is taken at its word.
+ */
+static void PwrMgr_Freezer_Settle(const PWRMGR_Freezer *fz, const char *unit, bool frozen)
+{
+    const char *want = frozen ? "frozen 1" : "frozen 0";
+    uint64_t deadlineUs = PwrMgr_Freezer_NowUs() + (uint64_t)fz->settleMs * 1000;
+    char path[256];
+    char buf[256];
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/%s/cgroup.events", fz->root, unit);
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return;
+
+    for (;;) {
+        struct pollfd pfd = { fd, POLLPRI, 0 };
+        uint64_t now;
+        ssize_t len = pread(fd, buf, sizeof(buf) - 1, 0);
+
+        buf[len > 0 ? len : 0] = '\0';
+        if (strstr(buf, want) != NULL)
+            break;
+        now = PwrMgr_Freezer_NowUs();
+        if (now >= deadlineUs || poll(&pfd, 1, (int)((deadlineUs - now + 999) / 1000)) <= 0) {
+            // Tasks in uninterruptible sleep hold a freeze up, the kernel still completes it
+            PWRMGRLOG(WARNING, "%s: %s not %s after %d ms\n", __FUNCTION__, unit, frozen ? "frozen" : "thawed", fz->settleMs);
+            break;
+        }
+    }
+    close(fd);
+}
+
+/**
+ *  @brief Freeze or thaw the cgroup of a unit
+ *  @return 0 on success, -1 if the cgroup cannot be written
+ */
+static int PwrMgr_Freezer_Set(PWRMGR_Freezer *fz, PWRMGR_FreezerUnit *u, bool frozen)
+{
+    uint64_t startUs = PwrMgr_Freezer_NowUs();
+    char path[256];
+    ssize_t written;
+    int fd;
+
+    snprintf(path, sizeof(path), "%s/%s/cgroup.freeze", fz->root, u->unit);
+    fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        PWRMGRLOG(WARNING, "%s: cannot open %s, %s\n", __FUNCTION__, path, strerror(errno));
+        return -1;
+    }
+    written = write(fd, frozen ? "1" : "0", 1);
+    close(fd);
+    if (written != 1) {
+        PWRMGRLOG(WARNING, "%s: cannot write %s\n", __FUNCTION__, path);
+        return -1;
+    }
+    PwrMgr_Freezer_Settle(fz, u->unit, frozen);
+
+    u->frozen = frozen;
+    if (frozen) {
+        u->frozenAtMs = (long)(PwrMgr_Freezer_NowUs() / 1000);
+        fz->stats.freezes++;
+        fz->stats.lastFreezeUs = PwrMgr_Freezer_NowUs() - startUs;
+    } else {
+        fz->stats.thaws++;
+        fz->stats.lastThawUs = PwrMgr_Freezer_NowUs() - startUs;
+    }
+    return 0;
+}
+
+static void PwrMgr_Freezer_Done(PWRMGR_Freezer *fz, int jobId, PWRMGR_UnitJobResult result)
+{
+    if (fz->doneCount < PWRMGR_UNIT_MAX_JOBS) {
+        fz->doneIds[fz->doneCount] = jobId;
+        fz->doneResults[fz->doneCount] = result;
+        fz->doneCount++;
+    }
+}
+
+static int PwrMgr_Freezer_Submit(void *ctx, PWRMGR_UnitOp op, const char *unit, int jobId)
+{
+    PWRMGR_Freezer *fz = (PWRMGR_Freezer *)ctx;
+    PWRMGR_FreezerUnit *u = PwrMgr_Freezer_Find(fz, unit);
+
+    if (u != NULL && op == PWRMGR_UNIT_STOP && !u->frozen && !u->emergency) {
+        if (PwrMgr_Freezer_Set(fz, u, true) == 0) {
+            PwrMgr_Freezer_Done(fz, jobId, PWRMGR_UNIT_JOB_DONE);
+            return 0;
+        }
+        PWRMGRLOG(WARNING, "%s: %s cannot be frozen, stopping it\n", __FUNCTION__, unit);
+        fz->stats.fallbacks++;
+    } else if (u != NULL && op == PWRMGR_UNIT_START && u->frozen && u->emergency) {
+        // Its stop was cut short, thawing alone does not leave it running
+        if (PwrMgr_Freezer_Set(fz, u, false) != 0)
+            return -1;
+    } else if (u != NULL && op == PWRMGR_UNIT_START && u->frozen) {
+        PwrMgr_Freezer_Done(fz, jobId, PwrMgr_Freezer_Set(fz, u, false) == 0 ? PWRMGR_UNIT_JOB_DONE : PWRMGR_UNIT_JOB_FAILED);
+        return 0;
+    }
+    return PwrMgr_UnitCtl_Submit(&fz->inner, op, unit, jobId);
+}
+
+static int PwrMgr_Freezer_Wait(void *ctx, int timeoutMs, int *jobId, PWRMGR_UnitJobResult *result)
+{
+    PWRMGR_Freezer *fz = (PWRMGR_Freezer *)ctx;
+
+    if (fz->doneCount > 0) {
+        *jobId = fz->doneIds[0];
+        *result = fz->doneResults[0];
+        fz->doneCount--;
+        memmove(fz->doneIds, fz->doneIds + 1, fz->doneCount * sizeof(fz->doneIds[0]));
+        memmove(fz->doneResults, fz->doneResults + 1, fz->doneCount * sizeof(fz->doneResults[0]));
+        return 0;
+    }
+    return PwrMgr_UnitCtl_Wait(&fz->inner, timeoutMs, jobId, result);
+}
+
+static int PwrMgr_Freezer_Active(void *ctx, const char *unit)
+{
+    PWRMGR_Freezer *fz = (PWRMGR_Freezer *)ctx;
+    PWRMGR_FreezerUnit *u = PwrMgr_Freezer_Find(fz, unit);
+
+    // systemd still reports a frozen unit as active
+    if (u != NULL && u->frozen)
+        return 0;
+    return PwrMgr_UnitCtl_IsActive(&fz->inner, unit);
+}
+
+static int PwrMgr_Freezer_Kill(void *ctx, const char *unit, int signal)
+{
+    PWRMGR_Freezer *fz = (PWRMGR_Freezer *)ctx;
+
+    return PwrMgr_UnitCtl_Kill(&fz->inner, unit, signal);
+}
+
+static int PwrMgr_Freezer_Freeze(void *ctx, const char *unit)
+{
+    PWRMGR_Freezer *fz = (PWRMGR_Freezer *)ctx;
+    PWRMGR_FreezerUnit *u = PwrMgr_Freezer_Find(fz, unit);
+
+    if (u != NULL && u->frozen)
+        return 0;
+    if (u == NULL && fz->count < PWRMGR_UNIT_MAX_JOBS && strlen(unit) < PWRMGR_FREEZER_UNIT_LEN) {
+        u = &fz->units[fz->count++];
+        memset(u, 0, sizeof(*u));
+        strcpy(u->unit, unit);
+        u->dwellMs = PWRMGR_FREEZER_EMERGENCY_DWELL_MS;
+        u->emergency = true;
+    }
+    if (u != NULL && PwrMgr_Freezer_Set(fz, u, true) == 0)
+        return 0;
+    return PwrMgr_UnitCtl_Freeze(&fz->inner, unit);
+}
+
+static void PwrMgr_Freezer_Forget(void *ctx, int jobId)
+{
+    PWRMGR_Freezer *fz = (PWRMGR_Freezer *)ctx;
+    int i = 0;
+    int j;
+
+    // Freezes and thaws complete right away, only their queued results can be left
+    for (j = 0; j < fz->doneCount; j++) {
+        if (jobId >= 0 && fz->doneIds[j] != jobId) {
+            fz->doneIds[i] = fz->doneIds[j];
+            fz->doneResults[i] = fz->doneResults[j];
+            i++;
+        }
+    }
+    fz->doneCount = i;
+    PwrMgr_UnitCtl_Forget(&fz->inner, jobId);
+}
+
+static void PwrMgr_Freezer_Close(void *ctx)
+{
+    PWRMGR_Freezer *fz = (PWRMGR_Freezer *)ctx;
+
+    // Frozen units stay frozen, the next instance adopts them
+    PwrMgr_UnitCtl_Close(&fz->inner);
+}
+
+static const PWRMGR_UnitCtlOps freezerOps = {
+    "freezer",
+    PwrMgr_Freezer_Submit,
+    PwrMgr_Freezer_Wait,
+    PwrMgr_Freezer_Close,
+    PwrMgr_Freezer_Active,
+    PwrMgr_Freezer_Kill,
+    PwrMgr_Freezer_Freeze,
+    PwrMgr_Freezer_Forget
+};
+
+/**
+ *  @brief Put the freezer in front of inner, ctl then drives the freezer
+ *
+ *  The freezer takes over inner and closes it with ctl. ctl may be inner itself.
+ *  @return 0 on success
+ */
+int PwrMgr_Freezer_Open(PWRMGR_Freezer *fz, const char *root, const PWRMGR_UnitCtl *inner, PWRMGR_UnitCtl *ctl)
+{
+    if (inner == NULL || inner->ops == NULL || strlen(root) >= sizeof(fz->root))
+        return -1;
+
+    memset(fz, 0, sizeof(*fz));
+    fz->inner = *inner;
+    strcpy(fz->root, root);
+    fz->settleMs = PWRMGR_FREEZER_SETTLE_MS;
+    ctl->ops = &freezerOps;
+    ctl->ctx = fz;
+    return 0;
+}
+
+/**
+ *  @brief Let a unit be frozen rather than stopped, it is stopped once frozen for dwellMs
+ *
+ *  shed tells whether the caller considers the unit stopped. A cgroup left
+ *  frozen by an earlier instance is adopted then, and thawed otherwise.
+ *  @return 0 on success
+ */
+int PwrMgr_Freezer_AddUnit(PWRMGR_Freezer *fz, const char *unit, long dwellMs, bool shed)
+{
+    PWRMGR_FreezerUnit *u;
+
+    if (fz->count >= PWRMGR_UNIT_MAX_JOBS || strlen(unit) >= PWRMGR_FREEZER_UNIT_LEN || dwellMs <= 0 ||
+        PwrMgr_Freezer_Find(fz, unit) != NULL)
+        return -1;
+
+    u = &fz->units[fz->count++];
+    strcpy(u->unit, unit);
+    u->dwellMs = dwellMs;
+    if (PwrMgr_Freezer_Read(fz, unit) == 1) {
+        if (shed) {
+            // The dwell time starts over
+            u->frozen = true;
+            u->frozenAtMs = (long)(PwrMgr_Freezer_NowUs() / 1000);
+            PWRMGRLOG(INFO, "%s: %s is still frozen\n", __FUNCTION__, unit);
+        } else if (PwrMgr_Freezer_Set(fz, u, false) == 0) {
+            PWRMGRLOG(INFO, "%s: thawed %s\n", __FUNCTION__, unit);
+        }
+    }
+    return 0;
+}
+
+/**
+ *  @brief Whether a unit is frozen right now
+ */
+bool PwrMgr_Freezer_IsFrozen(const PWRMGR_Freezer *fz, const char *unit)
+{
+    PWRMGR_FreezerUnit *u = PwrMgr_Freezer_Find(fz, unit);
+
+    return u != NULL && u->frozen;
+}
+
+/**
+ *  @brief Stop the units frozen for longer than their dwell time
+ *
+ *  They are thawed first so they see the SIGTERM and shut down cleanly.
+ *  @return milliseconds until the next unit is due, -1 when none is frozen
+ */
+long PwrMgr_Freezer_Expire(PWRMGR_Freezer *fz, long nowMs)
+{
+    const char *units[PWRMGR_UNIT_MAX_JOBS];
+    PWRMGR_UnitJobResult results[PWRMGR_UNIT_MAX_JOBS];
+    long nextMs = -1;
+    int count = 0;
+    int i;
+
+    for (i = 0; i < fz->count; i++) {
+        PWRMGR_FreezerUnit *u = &fz->units[i];
+        long leftMs = u->frozenAtMs + u->dwellMs - nowMs;
+
+        if (!u->frozen)
+            continue;
+        if (leftMs > 0) {
+            if (nextMs < 0 || leftMs < nextMs)
+                nextMs = leftMs;
+            continue;
+        }
+        PWRMGRLOG(INFO, "%s: %s frozen for %ld ms, stopping it\n", __FUNCTION__, u->unit, nowMs - u->frozenAtMs);
+        if (PwrMgr_Freezer_Set(fz, u, false) != 0) {
+            // Stopping still gets rid of it, systemd falls back to SIGKILL
+            u->frozen = false;
+        }
+        units[count++] = u->unit;
+        fz->stats.expired++;
+    }
+
+    if (count > 0 && PwrMgr_UnitCtl_RunBatch(&fz->inner, PWRMGR_UNIT_STOP, units, count, PWRMGR_UNIT_JOB_TIMEOUT_MS, results) != 0)
+        PWRMGRLOG(ERROR, "%s: some expired units did not stop\n", __FUNCTION__);
+    return nextMs;
+}
@@ -0,0 +1,231 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ *  @file pwrMgr_fsm.c
+ *  @brief RDKB Power Manger state machine tables
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "pwrMgr_log.h"
+#include "pwrMgr_fsm.h"
+
+// Seeds tried before giving up on a collision-free hash
+#define PWRMGR_FSM_MAX_SEEDS 4096
+
+// Power states, indexed by state so platform specific entries cannot shift the others
+static const PWRMGR_PwrStateItem fsmStates[PWRMGR_STATE_TOTAL] = {
+    [PWRMGR_STATE_UNKNOWN]  = { PWRMGR_STATE_UNKNOWN, "POWER_TRANS_UNKNOWN", "Unknown" },
+    [PWRMGR_STATE_AC]       = { PWRMGR_STATE_AC, "POWER_TRANS_AC", "AC" },
+#if defined (_XBB1_SUPPORTED_)
+    [PWRMGR_STATE_BATT]     = { PWRMGR_STATE_BATT, "POWER_TRANS_BATTERY", "Battery" },
+#endif
+    [PWRMGR_STATE_HOT]      = { PWRMGR_STATE_HOT, "POWER_TRANS_HOT", "ThermalHot" },
+    [PWRMGR_STATE_COOLED]   = { PWRMGR_STATE_COOLED, "POWER_TRANS_COOLED", "ThermalCooled" },
+    [PWRMGR_STATE_WARM]     = { PWRMGR_STATE_WARM, "POWER_TRANS_WARM", "ThermalWarm" },
+    [PWRMGR_STATE_CRITICAL] = { PWRMGR_STATE_CRITICAL, "POWER_TRANS_CRITICAL", "ThermalCritical" },
+};
+
+// Shedding stops first so the freed budget is not spent on starts, restoring starts first
+#define PWRMGR_FSM_SHED(from, to)     [from][to] = { NULL, { PWRMGR_FSM_ACT_STOP, PWRMGR_FSM_ACT_START }, to }
+#define PWRMGR_FSM_RESTORE(from, to)  [from][to] = { NULL, { PWRMGR_FSM_ACT_START, PWRMGR_FSM_ACT_STOP }, to }
+
+static PWRMGR_FsmTable fsmTable = {
+    // AC and ThermalCooled run everything
+    PWRMGR_FSM_RESTORE(PWRMGR_STATE_AC, PWRMGR_STATE_COOLED),
+    PWRMGR_FSM_RESTORE(PWRMGR_STATE_COOLED, PWRMGR_STATE_AC),
+
+    // Heating up sheds, levels may be skipped
+    PWRMGR_FSM_SHED(PWRMGR_STATE_AC, PWRMGR_STATE_WARM),
+    PWRMGR_FSM_SHED(PWRMGR_STATE_AC, PWRMGR_STATE_HOT),
+    PWRMGR_FSM_SHED(PWRMGR_STATE_AC, PWRMGR_STATE_CRITICAL),
+    PWRMGR_FSM_SHED(PWRMGR_STATE_COOLED, PWRMGR_STATE_WARM),
+    PWRMGR_FSM_SHED(PWRMGR_STATE_COOLED, PWRMGR_STATE_HOT),
+    PWRMGR_FSM_SHED(PWRMGR_STATE_COOLED, PWRMGR_STATE_CRITICAL),
+    PWRMGR_FSM_SHED(PWRMGR_STATE_WARM, PWRMGR_STATE_HOT),
+    PWRMGR_FSM_SHED(PWRMGR_STATE_WARM, PWRMGR_STATE_CRITICAL),
+    PWRMGR_FSM_SHED(PWRMGR_STATE_HOT, PWRMGR_STATE_CRITICAL),
+
+    // Cooling down restores
+    PWRMGR_FSM_RESTORE(PWRMGR_STATE_CRITICAL, PWRMGR_STATE_HOT),
+    PWRMGR_FSM_RESTORE(PWRMGR_STATE_CRITICAL, PWRMGR_STATE_WARM),
+    PWRMGR_FSM_RESTORE(PWRMGR_STATE_HOT, PWRMGR_STATE_WARM),
+    PWRMGR_FSM_RESTORE(PWRMGR_STATE_WARM, PWRMGR_STATE_COOLED),
+    PWRMGR_FSM_RESTORE(PWRMGR_STATE_HOT, PWRMGR_STATE_COOLED),
+    PWRMGR_FSM_RESTORE(PWRMGR_STATE_CRITICAL, PWRMGR_STATE_COOLED),
+    PWRMGR_FSM_RESTORE(PWRMGR_STATE_WARM, PWRMGR_STATE_AC),
+    PWRMGR_FSM_RESTORE(PWRMGR_STATE_HOT, PWRMGR_STATE_AC),
+    PWRMGR_FSM_RESTORE(PWRMGR_STATE_CRITICAL, PWRMGR_STATE_AC),
+
+#if defined (_XBB1_SUPPORTED_)
+    // Battery runs nothing that can be shed
+    PWRMGR_FSM_SHED(PWRMGR_STATE_AC, PWRMGR_STATE_BATT),
+    PWRMGR_FSM_SHED(PWRMGR_STATE_COOLED, PWRMGR_STATE_BATT),
+    PWRMGR_FSM_SHED(PWRMGR_STATE_WARM, PWRMGR_STATE_BATT),
+    PWRMGR_FSM_SHED(PWRMGR_STATE_HOT, PWRMGR_STATE_BATT),
+    PWRMGR_FSM_SHED(PWRMGR_STATE_CRITICAL, PWRMGR_STATE_BATT),
+    PWRMGR_FSM_RESTORE(PWRMGR_STATE_BATT, PWRMGR_STATE_AC),
+    PWRMGR_FSM_RESTORE(PWRMGR_STATE_BATT, PWRMGR_STATE_COOLED),
+    PWRMGR_FSM_RESTORE(PWRMGR_STATE_BATT, PWRMGR_STATE_WARM),
+    PWRMGR_FSM_RESTORE(PWRMGR_STATE_BATT, PWRMGR_STATE_HOT),
+    PWRMGR_FSM_RESTORE(PWRMGR_STATE_BATT, PWRMGR_STATE_CRITICAL),
+#endif
+};
+
+static uint32_t PwrMgr_Fsm_Hash(uint32_t seed, const char *str)
+{
+    uint32_t hash = 2166136261u ^ seed;
+
+    while (*str) {
+        hash ^= (uint8_t)*str++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ *  @brief Load state and transition tables, searching for a collision-free hash seed
+ *  @return 0 on success, -1 if no seed maps every request string to its own slot
+ */
+int PwrMgr_Fsm_Init(PWRMGR_Fsm *fsm, const PWRMGR_PwrStateItem *states, PWRMGR_FsmTable *table)
+{
+    uint32_t seed;
+    int i;
+
+    fsm->states = states;
+    fsm->table = table;
+
+    for (seed = 0; seed < PWRMGR_FSM_MAX_SEEDS; seed++) {
+        bool collision = false;
+
+        memset(fsm->hash, -1, sizeof(fsm->hash));
+        for (i = PWRMGR_STATE_UNKNOWN + 1; i < PWRMGR_STATE_TOTAL && !collision; i++) {
+            uint32_t slot = PwrMgr_Fsm_Hash(seed, states[i].pwrTransStr) & (PWRMGR_FSM_HASH_SIZE - 1);
+
+            if (fsm->hash[slot] >= 0)
+                collision = true;
+            else
+                fsm->hash[slot] = (int8_t)i;
+        }
+        if (!collision) {
+            fsm->seed = seed;
+            return 0;
+        }
+    }
+
+    PWRMGRLOG(ERROR, "%s: no perfect hash seed found for %d states\n", __FUNCTION__, PWRMGR_STATE_TOTAL - 1);
+    return -1;
+}
+
+/**
+ *  @brief Load the built-in power states and transitions
+ *  @return 0 on success
+ */
+int PwrMgr_Fsm_InitDefault(PWRMGR_Fsm *fsm)
+{
+    return PwrMgr_Fsm_Init(fsm, fsmStates, &fsmTable);
+}
+
+/**
+ *  @brief Convert an rdkb-power-transition value to a power state
+ *  @return power state, PWRMGR_STATE_UNKNOWN if not recognised
+ */
+PWRMGR_PwrState PwrMgr_Fsm_FromTransStr(const PWRMGR_Fsm *fsm, const char *transStr)
+{
+    int state = fsm->hash[PwrMgr_Fsm_Hash(fsm->seed, transStr) & (PWRMGR_FSM_HASH_SIZE - 1)];
+
+    if (state < 0 || strcmp(fsm->states[state].pwrTransStr, transStr) != 0)
+        return PWRMGR_STATE_UNKNOWN;
+    return (PWRMGR_PwrState)state;
+}
+
+/**
+ *  @brief Table entry for a transition
+ *  @return entry, NULL if the pair has none
+ */
+const PWRMGR_FsmTransition *PwrMgr_Fsm_Lookup(const PWRMGR_Fsm *fsm, PWRMGR_PwrState from, PWRMGR_PwrState to)
+{
+    const PWRMGR_FsmTransition *trans;
+
+    if (from < 0 || from >= PWRMGR_STATE_TOTAL || to < 0 || to >= PWRMGR_STATE_TOTAL)
+        return NULL;
+    trans = &(*fsm->table)[from][to];
+    return (trans->publish != PWRMGR_STATE_UNKNOWN) ? trans : NULL;
+}
+
+/**
+ *  @brief Check whether a request for to is accepted while heading for from
+ *  @return true if the table has the transition and its guard passes
+ */
+bool PwrMgr_Fsm_Allowed(const PWRMGR_Fsm *fsm, PWRMGR_PwrState from, PWRMGR_PwrState to)
+{
+    const PWRMGR_FsmTransition *trans = PwrMgr_Fsm_Lookup(fsm, from, to);
+
+    return trans != NULL && (trans->guard == NULL || trans->guard(from, to));
+}
+
+/**
+ *  @brief Order of the stop and start steps of a transition, fsm may be NULL
+ *
+ *  The table entry orders the steps. A step it leaves out still runs
+ *  afterwards, a preempted transition can leave components in either
+ *  direction. Without an entry components are stopped first.
+ *
+ *  @return the number of steps, always 2
+ */
+int PwrMgr_Fsm_Steps(const PWRMGR_Fsm *fsm, PWRMGR_PwrState from, PWRMGR_PwrState to, PWRMGR_FsmAction steps[2])
+{
+    const PWRMGR_FsmTransition *trans = fsm ? PwrMgr_Fsm_Lookup(fsm, from, to) : NULL;
+    bool queued[PWRMGR_FSM_ACT_START + 1] = { false, false, false };
+    int count = 0;
+    int i;
+
+    for (i = 0; trans != NULL && i < PWRMGR_FSM_MAX_ACTIONS && trans->actions[i] != PWRMGR_FSM_ACT_NONE; i++) {
+        if (!queued[trans->actions[i]]) {
+            queued[trans->actions[i]] = true;
+            steps[count++] = trans->actions[i];
+        }
+    }
+    if (!queued[PWRMGR_FSM_ACT_STOP])
+        steps[count++] = PWRMGR_FSM_ACT_STOP;
+    if (!queued[PWRMGR_FSM_ACT_START])
+        steps[count++] = PWRMGR_FSM_ACT_START;
+    return count;
+}
+
+/**
+ *  @brief rdkb-power-state value of a state
+ */
+const char *PwrMgr_Fsm_StateStr(const PWRMGR_Fsm *fsm, PWRMGR_PwrState state)
+{
+    if (state < 0 || state >= PWRMGR_STATE_TOTAL)
+        state = PWRMGR_STATE_UNKNOWN;
+    return fsm->states[state].pwrStateStr;
+}
+
+/**
+ *  @brief rdkb-power-transition value of a state
+ */
+const char *PwrMgr_Fsm_TransStr(const PWRMGR_Fsm *fsm, PWRMGR_PwrState state)
+{
+    if (state < 0 || state >= PWRMGR_STATE_TOTAL)
+        state = PWRMGR_STATE_UNKNOWN;
+    return fsm->states[state].pwrTransStr;
+}
@@ -0,0 +1,338 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ *  @file pwrMgr_inhibit.c
+ *  @brief RDKB Power Manger transition inhibitor
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "pwrMgr_log.h"
+#include "pwrMgr_inhibit.h"
+
+static const char *inhibitClassNames[PWRMGR_AXIS_TOTAL] = {
+    [PWRMGR_AXIS_SUPPLY]  = "supply",
+    [PWRMGR_AXIS_THERMAL] = "thermal",
+};
+
+static const char *PwrMgr_Inhibit_ClassStr(unsigned classes)
+{
+    int axis;
+
+    if (classes == PWRMGR_INHIBIT_ALL)
+        return "all";
+    for (axis = 0; axis < PWRMGR_AXIS_TOTAL; axis++) {
+        if (classes == PWRMGR_INHIBIT_CLASS(axis))
+            return inhibitClassNames[axis];
+    }
+    return "none";
+}
+
+static unsigned PwrMgr_Inhibit_Class(const char *name)
+{
+    int axis;
+
+    if (strcmp(name, "all") == 0)
+        return PWRMGR_INHIBIT_ALL;
+    for (axis = 0; axis < PWRMGR_AXIS_TOTAL; axis++) {
+        if (strcmp(name, inhibitClassNames[axis]) == 0)
+            return PWRMGR_INHIBIT_CLASS(axis);
+    }
+    return 0;
+}
+
+/**
+ *  @brief Drop the locks whose time is up, call with the lock held
+ */
+static void PwrMgr_Inhibit_Expire(PWRMGR_Inhibitor *inh, long nowMs)
+{
+    int i;
+
+    for (i = 0; i < PWRMGR_INHIBIT_MAX_LOCKS; i++) {
+        PWRMGR_InhibitLock *l = &inh->locks[i];
+
+        if (l->id != 0 && nowMs >= l->expiresMs) {
+            PWRMGRLOG(WARNING, "%s: %s (%d) ran out of time\n", __FUNCTION__, l->name, l->id);
+            l->id = 0;
+            inh->stats.expired++;
+        }
+    }
+}
+
+/**
+ *  @brief Start with no locks
+ */
+void PwrMgr_Inhibit_Init(PWRMGR_Inhibitor *inh)
+{
+    memset(inh, 0, sizeof(*inh));
+    pthread_mutex_init(&inh->lock, NULL);
+    inh->nextId = 1;
+}
+
+/**
+ *  @brief Take a lock holding off the transitions of classes for durationMs
+ *  @return lock id, -1 if the request is malformed or the table is full
+ */
+int PwrMgr_Inhibit_Take(PWRMGR_Inhibitor *inh, int owner, const char *name, unsigned classes, long durationMs, long nowMs)
+{
+    PWRMGR_InhibitLock *l = NULL;
+    int id = -1;
+    int i;
+
+    if (name == NULL || name[0] == '\0' || strlen(name) >= PWRMGR_INHIBIT_NAME_LEN ||
+        classes == 0 || (classes & ~PWRMGR_INHIBIT_ALL) || durationMs <= 0)
+        return -1;
+    if (durationMs > PWRMGR_INHIBIT_MAX_MS)
+        durationMs = PWRMGR_INHIBIT_MAX_MS;
+
+    pthread_mutex_lock(&inh->lock);
+    PwrMgr_Inhibit_Expire(inh, nowMs);
+    for (i = 0; i < PWRMGR_INHIBIT_MAX_LOCKS && l == NULL; i++) {
+        if (inh->locks[i].id == 0)
+            l = &inh->locks[i];
+    }
+    if (l != NULL) {
+        l->id = id = inh->nextId++;
+        l->owner = owner;
+        l->classes = classes;
+        strcpy(l->name, name);
+        l->expiresMs = nowMs + durationMs;
+        inh->stats.taken++;
+    }
+    pthread_mutex_unlock(&inh->lock);
+
+    if (id < 0) {
+        PWRMGRLOG(ERROR, "%s: no room for %s\n", __FUNCTION__, name);
+    } else {
+        PWRMGRLOG(INFO, "%s: %s (%d) holds off %s transitions for %ld ms\n", __FUNCTION__, name, id, PwrMgr_Inhibit_ClassStr(classes), durationMs);
+    }
+    return id;
+}
+
+/**
+ *  @brief Drop a lock, only its owner may
+ *  @return 0 on success, -1 if owner holds no such lock
+ */
+int PwrMgr_Inhibit_Release(PWRMGR_Inhibitor *inh, int owner, int id)
+{
+    int status = -1;
+    int i;
+
+    pthread_mutex_lock(&inh->lock);
+    for (i = 0; i < PWRMGR_INHIBIT_MAX_LOCKS; i++) {
+        PWRMGR_InhibitLock *l = &inh->locks[i];
+
+        if (id > 0 && l->id == id && l->owner == owner) {
+            PWRMGRLOG(INFO, "%s: %s (%d) released\n", __FUNCTION__, l->name, id);
+            l->id = 0;
+            inh->stats.released++;
+            status = 0;
+        }
+    }
+    pthread_mutex_unlock(&inh->lock);
+    return status;
+}
+
+/**
+ *  @brief Drop every lock of a client that went away
+ */
+void PwrMgr_Inhibit_ReleaseOwner(PWRMGR_Inhibitor *inh, int owner)
+{
+    int i;
+
+    pthread_mutex_lock(&inh->lock);
+    for (i = 0; i < PWRMGR_INHIBIT_MAX_LOCKS; i++) {
+        PWRMGR_InhibitLock *l = &inh->locks[i];
+
+        if (l->id != 0 && l->owner == owner) {
+            PWRMGRLOG(WARNING, "%s: %s (%d) dropped, its client went away\n", __FUNCTION__, l->name, l->id);
+            l->id = 0;
+            inh->stats.expired++;
+        }
+    }
+    pthread_mutex_unlock(&inh->lock);
+}
+
+/**
+ *  @brief Whether the transitions of an axis are held off
+ *
+ *  who gets the name of the lock that runs out first.
+ *  @return ms until that lock runs out, 0 if nothing holds the axis
+ */
+long PwrMgr_Inhibit_Check(PWRMGR_Inhibitor *inh, PWRMGR_Axis axis, long nowMs, char *who, size_t size)
+{
+    long leftMs = 0;
+    int i;
+
+    pthread_mutex_lock(&inh->lock);
+    PwrMgr_Inhibit_Expire(inh, nowMs);
+    for (i = 0; i < PWRMGR_INHIBIT_MAX_LOCKS; i++) {
+        PWRMGR_InhibitLock *l = &inh->locks[i];
+
+        if (l->id == 0 || !(l->classes & PWRMGR_INHIBIT_CLASS(axis)))
+            continue;
+        if (leftMs == 0 || l->expiresMs - nowMs < leftMs) {
+            leftMs = l->expiresMs - nowMs;
+            if (who != NULL)
+                snprintf(who, size, "%s", l->name);
+        }
+    }
+    pthread_mutex_unlock(&inh->lock);
+    return leftMs;
+}
+
+/**
+ *  @brief Run one command of a client and put the answer in reply
+ *  @return 0 if it succeeded, -1 if reply holds an error
+ */
+int PwrMgr_Inhibit_Command(PWRMGR_Inhibitor *inh, int owner, const char *cmd, long nowMs, char *reply, size_t size)
+{
+    char buf[PWRMGR_INHIBIT_MSG_LEN];
+    char *save = NULL;
+    char *key;
+    char *arg[3];
+    char *end;
+    long number;
+    int i;
+
+    snprintf(buf, sizeof(buf), "%s", cmd);
+    key = strtok_r(buf, " \t\r\n", &save);
+    for (i = 0; i < 3; i++)
+        arg[i] = strtok_r(NULL, " \t\r\n", &save);
+
+    if (key != NULL && strcmp(key, "inhibit") == 0 && arg[2] != NULL) {
+        unsigned classes = PwrMgr_Inhibit_Class(arg[0]);
+        int id;
+
+        number = strtol(arg[2], &end, 10);
+        if (classes == 0 || end == arg[2] || *end != '\0') {
+            snprintf(reply, size, "error usage: inhibit <supply|thermal|all> <name> <ms>\n");
+            return -1;
+        }
+        if ((id = PwrMgr_Inhibit_Take(inh, owner, arg[1], classes, number, nowMs)) < 0) {
+            snprintf(reply, size, "error lock refused\n");
+            return -1;
+        }
+        snprintf(reply, size, "ok %d\n", id);
+        return 0;
+    }
+
+    if (key != NULL && strcmp(key, "release") == 0 && arg[0] != NULL) {
+        number = strtol(arg[0], &end, 10);
+        if (end == arg[0] || *end != '\0' || PwrMgr_Inhibit_Release(inh, owner, (int)number) != 0) {
+            snprintf(reply, size, "error no such lock\n");
+            return -1;
+        }
+        snprintf(reply, size, "ok\n");
+        return 0;
+    }
+
+    if (key != NULL && strcmp(key, "list") == 0) {
+        size_t len;
+        int count = 0;
+
+        pthread_mutex_lock(&inh->lock);
+        PwrMgr_Inhibit_Expire(inh, nowMs);
+        for (i = 0; i < PWRMGR_INHIBIT_MAX_LOCKS; i++)
+            count += (inh->locks[i].id != 0);
+        len = snprintf(reply, size, "ok %d\n", count);
+        for (i = 0; i < PWRMGR_INHIBIT_MAX_LOCKS && len < size; i++) {
+            const PWRMGR_InhibitLock *l = &inh->locks[i];
+
+            if (l->id != 0)
+                len += snprintf(reply + len, size - len, "%d %s %s %ld\n", l->id, PwrMgr_Inhibit_ClassStr(l->classes), l->name, l->expiresMs - nowMs);
+        }
+        pthread_mutex_unlock(&inh->lock);
+        return 0;
+    }
+
+    snprintf(reply, size, "error unknown command\n");
+    return -1;
+}
+
+/**
+ *  @brief Create the listening socket, replacing one a previous instance left behind
+ *  @return non-blocking listening descriptor, -1 on failure
+ */
+int PwrMgr_Inhibit_Listen(const char *path)
+{
+    struct sockaddr_un addr;
+    int fd;
+
+    if (strlen(path) >= sizeof(addr.sun_path))
+        return -1;
+    fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        PWRMGRLOG(ERROR, "%s: socket failed, %s\n", __FUNCTION__, strerror(errno));
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 4) != 0) {
+        PWRMGRLOG(ERROR, "%s: cannot listen on %s, %s\n", __FUNCTION__, path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    // Clients run as root or in the daemon's group
+    chmod(path, 0660);
+    return fd;
+}
+
+/**
+ *  @brief Answer the next command waiting on a client connection
+ *
+ *  A client that hung up loses its locks, the caller then closes fd.
+ *  @return 0 while the client is connected, -1 once it is gone
+ */
+int PwrMgr_Inhibit_Serve(PWRMGR_Inhibitor *inh, int fd, long nowMs)
+{
+    char cmd[PWRMGR_INHIBIT_MSG_LEN];
+    char reply[PWRMGR_INHIBIT_MSG_LEN];
+    ssize_t len = recv(fd, cmd, sizeof(cmd) - 1, MSG_DONTWAIT);
+
+    if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        return 0;
+    if (len <= 0) {
+        PwrMgr_Inhibit_ReleaseOwner(inh, fd);
+        return -1;
+    }
+    cmd[len] = '\0';
+    PwrMgr_Inhibit_Command(inh, fd, cmd, nowMs, reply, sizeof(reply));
+    if (send(fd, reply, strlen(reply), MSG_NOSIGNAL | MSG_DONTWAIT) < 0)
+        PWRMGRLOG(WARNING, "%s: cannot answer client %d, %s\n", __FUNCTION__, fd, strerror(errno));
+    return 0;
+}
+
+/**
+ *  @brief Release the table
+ */
+void PwrMgr_Inhibit_Destroy(PWRMGR_Inhibitor *inh)
+{
+    pthread_mutex_destroy(&inh->lock);
+}
@@ -0,0 +1,323 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+/**
+ *  @file pwrMgr_log.c
+ *  @brief RDKB Power Manger asynchronous logger
+ *
+ *  Each ring has a single producer, the thread that claimed it, and a single
+ *  consumer, the flusher, so head and tail only need acquire/release
+ *  ordering. A producer only makes a system call to wake the flusher when
+ *  it was idle; messages logged while a flush is under way are picked up by
+ *  the same flush.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "pwrMgr_log.h"
+
+#define PWRMGR_LOG_PREFIX "PowerMgrLog"
+#define PWRMGR_LOG_NICE 10
+#define PWRMGR_LOG_LINGER_MS 5   // Flush delay after the first message, lets a burst go out in one write
+
+typedef struct
+{
+    uint32_t head;              // Written by the producer
+    uint32_t tailSeen;          // Producer's copy of tail, refreshed when the ring looks full
+    int claimed;                // 1 while a thread owns it
+    int released;               // Set by the owner on thread exit, freed once drained
+    uint32_t tail __attribute__((aligned(64)));     // Written by the flusher, own cache line
+    char lines[PWRMGR_LOG_RING_SLOTS][PWRMGR_LOG_LINE_LEN];
+    uint16_t lens[PWRMGR_LOG_RING_SLOTS];
+} PWRMGR_LogRing;
+
+static PWRMGR_LogRing gLogRings[PWRMGR_LOG_MAX_THREADS];
+static __thread PWRMGR_LogRing *tLogRing;
+static pthread_key_t gLogKey;
+static pthread_once_t gLogOnce = PTHREAD_ONCE_INIT;
+static pthread_t gLogThread;
+static int gLogFd = -1;
+static int gLogWakeFd = -1;
+static int gLogRunning = 0;
+static int gLogPending = 0;     // The flusher has been woken and not yet gone back to sleep
+static unsigned long gLogDropped = 0;
+
+static void PwrMgr_Log_WriteAll(int fd, const char *buf, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return;
+        buf += n;
+        len -= n;
+    }
+}
+
+/**
+ *  @brief Format a line with the usual prefix, newline kept when truncated
+ *  @return its length
+ */
+static int PwrMgr_Log_Format(char *buf, int size, const char *func, int line, const char *fmt, va_list ap)
+{
+    int len = snprintf(buf, size, PWRMGR_LOG_PREFIX "<%s:%d> ", func, line);
+
+    if (len < size)
+        len += vsnprintf(buf + len, size - len, fmt, ap);
+    if (len >= size) {
+        len = size - 1;
+        buf[len - 1] = '\n';
+    }
+    return len;
+}
+
+static int PwrMgr_Log_Wake(void)
+{
+    uint64_t one = 1;
+
+    return write(gLogWakeFd, &one, sizeof(one)) == sizeof(one) ? 0 : -1;
+}
+
+static void PwrMgr_Log_Release(void *arg)
+{
+    PWRMGR_LogRing *ring = (PWRMGR_LogRing *)arg;
+
+    __atomic_store_n(&ring->released, 1, __ATOMIC_RELEASE);
+}
+
+static void PwrMgr_Log_CreateKey(void)
+{
+    pthread_key_create(&gLogKey, PwrMgr_Log_Release);
+}
+
+/**
+ *  @brief The calling thread's ring, claimed on first use
+ *  @return NULL when every ring is taken
+ */
+static PWRMGR_LogRing *PwrMgr_Log_Ring(void)
+{
+    int i;
+
+    if (tLogRing != NULL)
+        return tLogRing;
+
+    pthread_once(&gLogOnce, PwrMgr_Log_CreateKey);
+    for (i = 0; i < PWRMGR_LOG_MAX_THREADS; i++) {
+        int expected = 0;
+
+        if (__atomic_compare_exchange_n(&gLogRings[i].claimed, &expected, 1, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            tLogRing = &gLogRings[i];
+            pthread_setspecific(gLogKey, tLogRing);
+            return tLogRing;
+        }
+    }
+    return NULL;
+}
+
+/**
+ *  @brief Log a message, called through PWRMGRLOG
+ */
+void PwrMgr_Log_Write(const char *func, int line, const char *fmt, ...)
+{
+    PWRMGR_LogRing *ring = NULL;
+    va_list ap;
+
+    if (__atomic_load_n(&gLogRunning, __ATOMIC_ACQUIRE))
+        ring = PwrMgr_Log_Ring();
+
+    va_start(ap, fmt);
+    if (ring == NULL) {
+        char buf[PWRMGR_LOG_LINE_LEN];
+        int len = PwrMgr_Log_Format(buf, sizeof(buf), func, line, fmt, ap);
+
+        PwrMgr_Log_WriteAll(gLogFd >= 0 ? gLogFd : STDERR_FILENO, buf, len);
+    } else {
+        uint32_t head = ring->head;
+
+        if (head - ring->tailSeen >= PWRMGR_LOG_RING_SLOTS)
+            ring->tailSeen = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        if (head - ring->tailSeen >= PWRMGR_LOG_RING_SLOTS) {
+            __atomic_add_fetch(&gLogDropped, 1, __ATOMIC_RELAXED);
+        } else {
+            uint32_t slot = head % PWRMGR_LOG_RING_SLOTS;
+
+            ring->lens[slot] = (uint16_t)PwrMgr_Log_Format(ring->lines[slot], PWRMGR_LOG_LINE_LEN, func, line, fmt, ap);
+            __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+            // Pairs with the flusher's fence, either it sees the line or we see pending cleared
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            if (__atomic_load_n(&gLogPending, __ATOMIC_SEQ_CST) == 0 &&
+                __atomic_exchange_n(&gLogPending, 1, __ATOMIC_SEQ_CST) == 0) {
+                if (PwrMgr_Log_Wake() != 0)
+                    __atomic_store_n(&gLogPending, 0, __ATOMIC_SEQ_CST);
+            } else if ((head + 1) % (PWRMGR_LOG_RING_SLOTS / 2) == 0) {
+                // Every half ring, cut the flusher's linger short
+                PwrMgr_Log_Wake();
+            }
+        }
+    }
+    va_end(ap);
+}
+
+/**
+ *  @brief Write out everything queued so far, in batches
+ *  @return the number of lines written
+ */
+static int PwrMgr_Log_Drain(void)
+{
+    static unsigned long reported = 0;
+    char batch[4096];
+    size_t used = 0;
+    unsigned long dropped;
+    int lines = 0;
+    int i;
+
+    for (i = 0; i < PWRMGR_LOG_MAX_THREADS; i++) {
+        PWRMGR_LogRing *ring = &gLogRings[i];
+        uint32_t tail = ring->tail;
+        uint32_t head;
+        int released;
+
+        if (!__atomic_load_n(&ring->claimed, __ATOMIC_ACQUIRE))
+            continue;
+        // Read released first: a ring released after this has nothing left to add
+        released = __atomic_load_n(&ring->released, __ATOMIC_ACQUIRE);
+        head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        for (; tail != head; tail++) {
+            uint32_t slot = tail % PWRMGR_LOG_RING_SLOTS;
+
+            if (used + ring->lens[slot] > sizeof(batch)) {
+                __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+                PwrMgr_Log_WriteAll(gLogFd, batch, used);
+                used = 0;
+            }
+            memcpy(batch + used, ring->lines[slot], ring->lens[slot]);
+            used += ring->lens[slot];
+            lines++;
+        }
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+        if (released) {
+            ring->head = ring->tailSeen = ring->tail = 0;
+            ring->released = 0;
+            __atomic_store_n(&ring->claimed, 0, __ATOMIC_RELEASE);
+        }
+    }
+    if (used > 0)
+        PwrMgr_Log_WriteAll(gLogFd, batch, used);
+
+    dropped = __atomic_load_n(&gLogDropped, __ATOMIC_RELAXED);
+    if (dropped != reported) {
+        char buf[96];
+        int len = snprintf(buf, sizeof(buf), PWRMGR_LOG_PREFIX "<%s> %lu message(s) dropped\n", __FUNCTION__, dropped - reported);
+
+        PwrMgr_Log_WriteAll(gLogFd, buf, len);
+        reported = dropped;
+    }
+    return lines;
+}
+
+static void *PwrMgr_Log_Thread(void *arg)
+{
+    uint64_t count;
+
+    // Run below the daemon threads, waking up should not preempt the thread that logged
+    setpriority(PRIO_PROCESS, syscall(SYS_gettid), PWRMGR_LOG_NICE);
+    while (__atomic_load_n(&gLogRunning, __ATOMIC_ACQUIRE)) {
+        int lines;
+
+        struct pollfd pfd = { gLogWakeFd, POLLIN, 0 };
+
+        if (read(gLogWakeFd, &count, sizeof(count)) < 0 && errno != EINTR)
+            break;
+        if (poll(&pfd, 1, PWRMGR_LOG_LINGER_MS) > 0 && read(gLogWakeFd, &count, sizeof(count)) < 0)
+            break;
+        // Producers skip the wake-up while pending is set, so only clear it
+        // once the rings are found empty, then look once more before blocking
+        do {
+            lines = PwrMgr_Log_Drain();
+            if (lines == 0) {
+                __atomic_store_n(&gLogPending, 0, __ATOMIC_SEQ_CST);
+                __atomic_thread_fence(__ATOMIC_SEQ_CST);
+                lines = PwrMgr_Log_Drain();
+            }
+        } while (lines > 0);
+    }
+    return NULL;
+}
+
+/**
+ *  @brief Start the flusher, messages go to fd from then on
+ *
+ *  Call it after daemonizing, the flusher thread would not survive the fork.
+ *  @return 0 on success, -1 if logging stays synchronous
+ */
+int PwrMgr_Log_Start(int fd)
+{
+    if (gLogRunning)
+        return 0;
+    gLogFd = fd;
+    gLogWakeFd = eventfd(0, EFD_CLOEXEC);
+    if (gLogWakeFd < 0)
+        return -1;
+    __atomic_store_n(&gLogRunning, 1, __ATOMIC_RELEASE);
+    if (pthread_create(&gLogThread, NULL, PwrMgr_Log_Thread, NULL) != 0) {
+        __atomic_store_n(&gLogRunning, 0, __ATOMIC_RELEASE);
+        close(gLogWakeFd);
+        gLogWakeFd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ *  @brief Flush what is queued and go back to synchronous logging
+ *
+ *  Only call it once the other threads have stopped logging.
+ */
+void PwrMgr_Log_Stop(void)
+{
+    if (!gLogRunning)
+        return;
+    __atomic_store_n(&gLogRunning, 0, __ATOMIC_RELEASE);
+    if (PwrMgr_Log_Wake() == 0)
+        pthread_join(gLogThread, NULL);
+    else
+        pthread_detach(gLogThread);
+    PwrMgr_Log_Drain();
+    close(gLogWakeFd);
+    gLogWakeFd = -1;
+}
+
+/**
+ *  @brief Messages dropped on full rings since the process started
+ */
+unsigned long PwrMgr_Log_Dropped(void)
+{
+    return __atomic_load_n(&gLogDropped, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,183 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ *  @file pwrMgr_loop.c
+ *  @brief RDKB Power Manger event loop
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include "pwrMgr_log.h"
+#include "pwrMgr_loop.h"
+
+/**
+ *  @brief Create the epoll instance and the quit eventfd
+ *  @return 0 on success
+ */
+int PwrMgr_Loop_Init(PWRMGR_Loop *loop)
+{
+    struct epoll_event ev;
+
+    memset(loop, 0, sizeof(*loop));
+    loop->epollFd = epoll_create1(EPOLL_CLOEXEC);
+    loop->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (loop->epollFd < 0 || loop->wakeFd < 0) {
+        PWRMGRLOG(ERROR, "%s: cannot create the event loop, %s\n", __FUNCTION__, strerror(errno));
+        PwrMgr_Loop_Close(loop);
+        return -1;
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = loop->wakeFd;
+    epoll_ctl(loop->epollFd, EPOLL_CTL_ADD, loop->wakeFd, &ev);
+    return 0;
+}
+
+/**
+ *  @brief Call fn whenever fd is readable
+ *  @return 0 on success, -1 if the loop is full or fd cannot be watched
+ */
+int PwrMgr_Loop_Add(PWRMGR_Loop *loop, int fd, PWRMGR_LoopFn fn, void *arg)
+{
+    struct epoll_event ev;
+
+    if (fd < 0 || loop->count >= PWRMGR_LOOP_MAX_SOURCES)
+        return -1;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(loop->epollFd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        PWRMGRLOG(ERROR, "%s: cannot watch fd %d, %s\n", __FUNCTION__, fd, strerror(errno));
+        return -1;
+    }
+    loop->sources[loop->count].fd = fd;
+    loop->sources[loop->count].fn = fn;
+    loop->sources[loop->count].arg = arg;
+    loop->count++;
+    return 0;
+}
+
+/**
+ *  @brief Stop watching fd, call before closing it
+ */
+void PwrMgr_Loop_Remove(PWRMGR_Loop *loop, int fd)
+{
+    int i;
+
+    for (i = 0; i < loop->count; i++) {
+        if (loop->sources[i].fd == fd) {
+            epoll_ctl(loop->epollFd, EPOLL_CTL_DEL, fd, NULL);
+            loop->sources[i] = loop->sources[--loop->count];
+            return;
+        }
+    }
+}
+
+/**
+ *  @brief Dispatch events until PwrMgr_Loop_Quit
+ *  @return 0 after a quit, -1 if epoll failed
+ */
+int PwrMgr_Loop_Run(PWRMGR_Loop *loop)
+{
+    struct epoll_event events[PWRMGR_LOOP_MAX_SOURCES + 1];
+
+    PWRMGRLOG(INFO, "Entering into %s\n",__FUNCTION__)
+    while (!loop->quit) {
+        int count = epoll_wait(loop->epollFd, events, PWRMGR_LOOP_MAX_SOURCES + 1, -1);
+        int i, j;
+
+        if (count < 0) {
+            if (errno == EINTR)
+                continue;
+            PWRMGRLOG(ERROR, "%s: epoll_wait failed, %s\n", __FUNCTION__, strerror(errno));
+            return -1;
+        }
+        loop->wakeups++;
+        for (i = 0; i < count && !loop->quit; i++) {
+            // A callback may have removed a source that is later in this batch
+            for (j = 0; j < loop->count; j++) {
+                if (loop->sources[j].fd == events[i].data.fd) {
+                    loop->sources[j].fn(loop->sources[j].arg, events[i].data.fd, events[i].events);
+                    break;
+                }
+            }
+        }
+    }
+    PWRMGRLOG(INFO, "Exiting from %s\n",__FUNCTION__)
+    return 0;
+}
+
+/**
+ *  @brief Make PwrMgr_Loop_Run return, safe from any thread
+ */
+void PwrMgr_Loop_Quit(PWRMGR_Loop *loop)
+{
+    uint64_t one = 1;
+
+    loop->quit = true;
+    if (write(loop->wakeFd, &one, sizeof(one)) != sizeof(one))
+        PWRMGRLOG(ERROR, "%s: cannot wake the event loop\n",__FUNCTION__);
+}
+
+/**
+ *  @brief Close the loop, the sources stay open
+ */
+void PwrMgr_Loop_Close(PWRMGR_Loop *loop)
+{
+    if (loop->epollFd >= 0)
+        close(loop->epollFd);
+    if (loop->wakeFd >= 0)
+        close(loop->wakeFd);
+    loop->epollFd = loop->wakeFd = -1;
+    loop->count = 0;
+}
+
+/**
+ *  @brief Create a disarmed monotonic timer for the loop
+ *  @return the timerfd, -1 on failure
+ */
+int PwrMgr_Loop_TimerFd()
+{
+    return timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+}
+
+/**
+ *  @brief Fire timerFd once after ms, a negative ms disarms it
+ */
+void PwrMgr_Loop_Arm(int timerFd, int ms)
+{
+    struct itimerspec its;
+
+    memset(&its, 0, sizeof(its));
+    if (ms >= 0) {
+        its.it_value.tv_sec = ms / 1000;
+        its.it_value.tv_nsec = (long)(ms % 1000) * 1000000;
+        if (ms == 0)
+            its.it_value.tv_nsec = 1;    // Zero would disarm
+    }
+    timerfd_settime(timerFd, 0, &its, NULL);
+}
@@ -0,0 +1,384 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ *  @file pwrMgr_policy.c
+ *  @brief RDKB Power Manger power policy
+ *
+ *  Parses the policy file and compiles it into per-state run masks, and
+ *  watches the file for the daemon to reload it.
+ */
+
+#include <errno.h>
+#include <libgen.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#include "pwrMgr_log.h"
+#include "pwrMgr_policy.h"
+#include "pwrMgr_unitctl.h"
+
+#define LINE_SIZE 256
+
+/**
+ *  @brief Every state on, the built-in timing and job timeout and no components
+ *
+ *  ThermalCritical is the only emergency.
+ */
+void PwrMgr_Policy_Init(PWRMGR_Policy *policy)
+{
+    int i;
+
+    memset(policy, 0, sizeof(*policy));
+    PwrMgr_CompGraph_Init(&policy->graph);
+    for (i = 0; i < PWRMGR_STATE_TOTAL; i++)
+        policy->enabled[i] = (i != PWRMGR_STATE_UNKNOWN);
+    PwrMgr_Coalesce_DefaultTiming(policy->timing);
+    policy->jobTimeoutMs = PWRMGR_UNIT_JOB_TIMEOUT_MS;
+    policy->emergencyMs[PWRMGR_STATE_CRITICAL] = PWRMGR_EMERGENCY_DEADLINE_MS;
+}
+
+/**
+ *  @brief State from its rdkb-power-state value
+ *  @return state, PWRMGR_STATE_UNKNOWN if this build does not have it
+ */
+static PWRMGR_PwrState PwrMgr_Policy_State(const PWRMGR_Fsm *fsm, const char *name)
+{
+    int i;
+
+    for (i = PWRMGR_STATE_UNKNOWN + 1; i < PWRMGR_STATE_TOTAL; i++) {
+        if (strcmp(PwrMgr_Fsm_StateStr(fsm, i), name) == 0)
+            return (PWRMGR_PwrState)i;
+    }
+    return PWRMGR_STATE_UNKNOWN;
+}
+
+/**
+ *  @brief Parse a non-negative number that has to make up the whole token
+ *  @return 0 on success
+ */
+static int PwrMgr_Policy_Number(const char *str, long *value)
+{
+    char *end;
+
+    if (str == NULL)
+        return -1;
+    *value = strtol(str, &end, 10);
+    return (end != str && *end == '\0' && *value >= 0) ? 0 : -1;
+}
+
+/**
+ *  @brief Parse a local time of day, "HH:MM", 24:00 being midnight
+ *  @return the minute of the day, -1 if malformed
+ */
+static int PwrMgr_Policy_Minute(const char *str)
+{
+    int hour, minute, len = 0;
+
+    if (sscanf(str, "%2d:%2d%n", &hour, &minute, &len) != 2 || str[len] != '\0')
+        return -1;
+    if (hour < 0 || minute < 0 || minute > 59 || hour > 24 || (hour == 24 && minute != 0))
+        return -1;
+    return (hour * 60 + minute) % PWRMGR_SCHED_DAY_MIN;
+}
+
+/**
+ *  @brief Parse an eco window, the "<HH:MM>-<HH:MM>" range and the components it sheds
+ *  @return 0 on success, -1 if malformed or a component is unknown
+ */
+static int PwrMgr_Policy_EcoWindow(const PWRMGR_Policy *policy, char *range, char **save, PWRMGR_EcoWindow *window)
+{
+    char *dash;
+    char *arg;
+    int comp;
+
+    if (range == NULL || (dash = strchr(range, '-')) == NULL)
+        return -1;
+    *dash = '\0';
+    if ((window->startMin = PwrMgr_Policy_Minute(range)) < 0 || (window->endMin = PwrMgr_Policy_Minute(dash + 1)) < 0)
+        return -1;
+
+    window->shed = 0;
+    while ((arg = strtok_r(NULL, " \t\r\n", save)) != NULL) {
+        if ((comp = PwrMgr_CompGraph_Find(&policy->graph, arg)) < 0)
+            return -1;
+        window->shed |= PWRMGR_COMP_BIT(comp);
+    }
+    return 0;
+}
+
+/**
+ *  @brief Parse an eco schedule given outside the policy file
+ *
+ *  Windows are separated by ';', "01:00-05:00 harvester lmlite; 13:00-14:00 moca",
+ *  and "none" is an empty schedule. The components come from the policy.
+ *  @return 0 on success, -1 if malformed or there are too many windows
+ */
+int PwrMgr_Policy_ParseEco(const PWRMGR_Policy *policy, const char *spec, PWRMGR_EcoWindow *windows, int *count)
+{
+    char buf[LINE_SIZE];
+    char *outer = NULL;
+    char *save;
+    char *part;
+    char *range;
+
+    *count = 0;
+    snprintf(buf, sizeof(buf), "%s", spec);
+    for (part = strtok_r(buf, ";", &outer); part != NULL; part = strtok_r(NULL, ";", &outer)) {
+        save = NULL;
+        if ((range = strtok_r(part, " \t\r\n", &save)) == NULL)
+            continue;
+        if (strcmp(range, "none") == 0 && *count == 0 && strtok_r(NULL, " \t\r\n", &save) == NULL)
+            continue;
+        if (*count >= PWRMGR_SCHED_MAX_WINDOWS)
+            return -1;
+        if (PwrMgr_Policy_EcoWindow(policy, range, &save, &windows[*count]) != 0)
+            return -1;
+        (*count)++;
+    }
+    return 0;
+}
+
+/**
+ *  @brief Parse one line of a policy file, comments and blank lines are ignored
+ *
+ *  Anything that is not a policy keyword goes to the component graph.
+ *  @return 0 on success, -1 if the line is malformed
+ */
+int PwrMgr_Policy_ParseLine(PWRMGR_Policy *policy, const PWRMGR_Fsm *fsm, char *line)
+{
+    char buf[LINE_SIZE];
+    char *save = NULL;
+    char *key;
+    char *arg;
+    PWRMGR_PwrState state;
+    long number;
+
+    snprintf(buf, sizeof(buf), "%s", line);
+    key = strtok_r(buf, " \t\r\n", &save);
+    if (key == NULL || key[0] == '#')
+        return 0;
+
+    if (strcmp(key, "timeout") == 0) {
+        if (PwrMgr_Policy_Number(strtok_r(NULL, " \t\r\n", &save), &number) != 0 || number == 0)
+            return -1;
+        policy->jobTimeoutMs = (int)number;
+        return 0;
+    }
+    if (strcmp(key, "eco") == 0) {
+        if (policy->ecoCount >= PWRMGR_SCHED_MAX_WINDOWS)
+            return -1;
+        if (PwrMgr_Policy_EcoWindow(policy, strtok_r(NULL, " \t\r\n", &save), &save, &policy->eco[policy->ecoCount]) != 0)
+            return -1;
+        policy->ecoCount++;
+        return 0;
+    }
+    if (strcmp(key, "state") != 0 && strcmp(key, "shed") != 0 && strcmp(key, "timing") != 0 && strcmp(key, "emergency") != 0)
+        return PwrMgr_CompGraph_ParseLine(&policy->graph, line);
+
+    if ((arg = strtok_r(NULL, " \t\r\n", &save)) == NULL)
+        return -1;
+    state = PwrMgr_Policy_State(fsm, arg);
+    if (state == PWRMGR_STATE_UNKNOWN) {
+        PWRMGRLOG(WARNING, "%s: no %s state in this build, skipping %s\n",__FUNCTION__, arg, key);
+        return 0;
+    }
+
+    if (strcmp(key, "state") == 0) {
+        arg = strtok_r(NULL, " \t\r\n", &save);
+        if (arg == NULL || (strcmp(arg, "on") != 0 && strcmp(arg, "off") != 0))
+            return -1;
+        policy->enabled[state] = (strcmp(arg, "on") == 0);
+        return 0;
+    }
+
+    if (strcmp(key, "shed") == 0) {
+        PWRMGR_CompMask shed = 0;
+        int comp;
+
+        while ((arg = strtok_r(NULL, " \t\r\n", &save)) != NULL) {
+            if ((comp = PwrMgr_CompGraph_Find(&policy->graph, arg)) < 0)
+                return -1;
+            shed |= PWRMGR_COMP_BIT(comp);
+        }
+        policy->shed[state] = shed;
+        policy->shedSet[state] = true;
+        return 0;
+    }
+
+    if (strcmp(key, "emergency") == 0) {
+        if (PwrMgr_Policy_Number(strtok_r(NULL, " \t\r\n", &save), &number) != 0)
+            return -1;
+        policy->emergencyMs[state] = number;
+        return 0;
+    }
+
+    // timing
+    if (PwrMgr_Policy_Number(strtok_r(NULL, " \t\r\n", &save), &number) != 0)
+        return -1;
+    policy->timing[state].hysteresisMs = number;
+    if (PwrMgr_Policy_Number(strtok_r(NULL, " \t\r\n", &save), &number) != 0)
+        return -1;
+    policy->timing[state].minDwellMs = number;
+    return 0;
+}
+
+/**
+ *  @brief Check the policy and build the run mask table, call again after changing it
+ *  @return 0 on success, -1 if the graph is cyclic or AC is switched off
+ */
+int PwrMgr_Policy_Compile(PWRMGR_Policy *policy)
+{
+    PWRMGR_CompMask all = PwrMgr_CompGraph_AllMask(&policy->graph);
+    int i;
+
+    if (PwrMgr_CompGraph_Validate(&policy->graph) != 0)
+        return -1;
+    // Where the daemon starts when nothing else is known
+    if (!policy->enabled[PWRMGR_STATE_AC]) {
+        PWRMGRLOG(ERROR, "%s: AC cannot be switched off\n",__FUNCTION__);
+        return -1;
+    }
+
+    policy->runMask[PWRMGR_STATE_UNKNOWN] = all;
+    for (i = PWRMGR_STATE_UNKNOWN + 1; i < PWRMGR_STATE_TOTAL; i++) {
+        if (policy->shedSet[i])
+            policy->runMask[i] = all & ~policy->shed[i];
+        else
+            policy->runMask[i] = PwrMgr_CompGraph_StateMask(&policy->graph, i);
+    }
+    return 0;
+}
+
+/**
+ *  @brief Load and compile a policy file
+ *  @return 0 on success, -1 if the file is missing, malformed or does not compile
+ */
+int PwrMgr_Policy_Load(PWRMGR_Policy *policy, const PWRMGR_Fsm *fsm, const char *path)
+{
+    char line[LINE_SIZE];
+    int lineNo = 0;
+    int status = 0;
+    FILE *fp = fopen(path, "r");
+
+    if (fp == NULL)
+        return -1;
+
+    PwrMgr_Policy_Init(policy);
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        lineNo++;
+        if (PwrMgr_Policy_ParseLine(policy, fsm, line) != 0) {
+            PWRMGRLOG(ERROR, "%s: %s:%d is invalid\n",__FUNCTION__, path, lineNo);
+            status = -1;
+            break;
+        }
+    }
+    fclose(fp);
+
+    if (status == 0)
+        status = PwrMgr_Policy_Compile(policy);
+    return status;
+}
+
+/**
+ *  @brief Built-in policy, used when no policy file is installed
+ */
+void PwrMgr_Policy_LoadDefaults(PWRMGR_Policy *policy)
+{
+    PwrMgr_Policy_Init(policy);
+    PwrMgr_CompGraph_LoadDefaults(&policy->graph);
+    PwrMgr_Policy_Compile(policy);
+}
+
+/**
+ *  @brief Whether two policies declare the same components in the same order
+ *
+ *  Compares what the running daemon has indexed: names, units and freeze
+ *  dwell. Edges, shed sets, power and timing may differ.
+ */
+bool PwrMgr_Policy_SameComponents(const PWRMGR_Policy *a, const PWRMGR_Policy *b)
+{
+    int i;
+
+    if (a->graph.count != b->graph.count)
+        return false;
+    for (i = 0; i < a->graph.count; i++) {
+        const PWRMGR_Component *ca = &a->graph.comps[i];
+        const PWRMGR_Component *cb = &b->graph.comps[i];
+
+        if (strcmp(ca->name, cb->name) != 0 || strcmp(ca->unit, cb->unit) != 0 || ca->freezeDwellMs != cb->freezeDwellMs)
+            return false;
+    }
+    return true;
+}
+
+/**
+ *  @brief Watch the directory of a policy file
+ *
+ *  The directory is watched rather than the file so an update that renames
+ *  a new file over the old one is seen too.
+ *  @return non-blocking inotify descriptor for PwrMgr_Policy_Changed, -1 on failure
+ */
+int PwrMgr_Policy_Watch(const char *path)
+{
+    char dir[PATH_MAX];
+    int fd;
+
+    snprintf(dir, sizeof(dir), "%s", path);
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) {
+        PWRMGRLOG(ERROR, "%s: inotify_init1 failed, %s\n",__FUNCTION__, strerror(errno));
+        return -1;
+    }
+    if (inotify_add_watch(fd, dirname(dir), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        PWRMGRLOG(WARNING, "%s: cannot watch %s, %s\n",__FUNCTION__, path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ *  @brief Drain the watch descriptor
+ *  @return true if the policy file was written or replaced
+ */
+bool PwrMgr_Policy_Changed(int fd, const char *path)
+{
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    const char *base = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+    bool changed = false;
+    ssize_t len;
+
+    while ((len = read(fd, buf, sizeof(buf))) > 0) {
+        char *ptr = buf;
+
+        while (ptr < buf + len) {
+            const struct inotify_event *ev = (const struct inotify_event *)ptr;
+
+            // Events were lost, the file may be among them
+            if ((ev->mask & IN_Q_OVERFLOW) || (ev->len > 0 && strcmp(ev->name, base) == 0))
+                changed = true;
+            ptr += sizeof(struct inotify_event) + ev->len;
+        }
+    }
+    return changed;
+}
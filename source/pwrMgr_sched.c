@@ -0,0 +1,271 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ *  @file pwrMgr_sched.c
+ *  @brief RDKB Power Manger eco schedule
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include "pwrMgr_log.h"
+#include "pwrMgr_sched.h"
+
+#ifndef TFD_TIMER_CANCEL_ON_SET
+#define TFD_TIMER_CANCEL_ON_SET (1 << 1)
+#endif
+
+/**
+ *  @brief Minutes after local midnight at t
+ */
+static int PwrMgr_Sched_MinuteOfDay(time_t t)
+{
+    struct tm tm;
+
+    localtime_r(&t, &tm);
+    return tm.tm_hour * 60 + tm.tm_min;
+}
+
+/**
+ *  @brief Whether a window is open at t
+ */
+bool PwrMgr_Sched_WindowOpen(const PWRMGR_EcoWindow *window, time_t t)
+{
+    int minute = PwrMgr_Sched_MinuteOfDay(t);
+
+    if (window->startMin == window->endMin)
+        return true;
+    if (window->startMin < window->endMin)
+        return minute >= window->startMin && minute < window->endMin;
+    return minute >= window->startMin || minute < window->endMin;
+}
+
+/**
+ *  @brief Components the windows open at t shed
+ */
+PWRMGR_CompMask PwrMgr_Sched_ShedAt(const PWRMGR_EcoWindow *windows, int count, time_t t)
+{
+    PWRMGR_CompMask shed = 0;
+    int i;
+
+    for (i = 0; i < count; i++) {
+        if (PwrMgr_Sched_WindowOpen(&windows[i], t))
+            shed |= windows[i].shed;
+    }
+    return shed;
+}
+
+/**
+ *  @brief First time after now the local clock reads minute
+ */
+static time_t PwrMgr_Sched_Next(int minute, time_t now)
+{
+    struct tm tm;
+    int day;
+    time_t t = now;
+
+    // mktime normalises the day past the end of the month and across DST
+    for (day = 0; day <= 1 && t <= now; day++) {
+        localtime_r(&now, &tm);
+        tm.tm_mday += day;
+        tm.tm_hour = minute / 60;
+        tm.tm_min = minute % 60;
+        tm.tm_sec = 0;
+        tm.tm_isdst = -1;
+        t = mktime(&tm);
+    }
+    return t;
+}
+
+static void PwrMgr_Sched_Swap(PWRMGR_Scheduler *sched, int a, int b)
+{
+    PWRMGR_SchedTimer tmp = sched->heap[a];
+
+    sched->heap[a] = sched->heap[b];
+    sched->heap[b] = tmp;
+}
+
+static void PwrMgr_Sched_Push(PWRMGR_Scheduler *sched, int window, bool opens, time_t now)
+{
+    const PWRMGR_EcoWindow *w = &sched->windows[window];
+    int i = sched->heapSize++;
+
+    sched->heap[i].dueSec = PwrMgr_Sched_Next(opens ? w->startMin : w->endMin, now);
+    sched->heap[i].window = window;
+    sched->heap[i].opens = opens;
+    while (i > 0 && sched->heap[(i - 1) / 2].dueSec > sched->heap[i].dueSec) {
+        PwrMgr_Sched_Swap(sched, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+static PWRMGR_SchedTimer PwrMgr_Sched_Pop(PWRMGR_Scheduler *sched)
+{
+    PWRMGR_SchedTimer top = sched->heap[0];
+    int i = 0;
+
+    sched->heap[0] = sched->heap[--sched->heapSize];
+    for (;;) {
+        int left = 2 * i + 1;
+        int right = left + 1;
+        int least = i;
+
+        if (left < sched->heapSize && sched->heap[left].dueSec < sched->heap[least].dueSec)
+            least = left;
+        if (right < sched->heapSize && sched->heap[right].dueSec < sched->heap[least].dueSec)
+            least = right;
+        if (least == i)
+            break;
+        PwrMgr_Sched_Swap(sched, i, least);
+        i = least;
+    }
+    return top;
+}
+
+/**
+ *  @brief Arm the timer for the earliest edge, disarm it without any
+ */
+static void PwrMgr_Sched_Arm(PWRMGR_Scheduler *sched)
+{
+    struct itimerspec its;
+
+    if (sched->timerFd < 0)
+        return;
+    memset(&its, 0, sizeof(its));
+    if (sched->heapSize > 0)
+        its.it_value.tv_sec = sched->heap[0].dueSec;
+    if (timerfd_settime(sched->timerFd, TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET, &its, NULL) != 0)
+        PWRMGRLOG(ERROR, "%s: timerfd_settime failed, %s\n", __FUNCTION__, strerror(errno));
+}
+
+/**
+ *  @brief Create the timer, the schedule starts out empty
+ *  @return 0 on success, -1 without a timer
+ */
+int PwrMgr_Sched_Open(PWRMGR_Scheduler *sched, PWRMGR_SchedFn notify, void *ctx)
+{
+    memset(sched, 0, sizeof(*sched));
+    sched->notify = notify;
+    sched->ctx = ctx;
+    sched->timerFd = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (sched->timerFd < 0) {
+        PWRMGRLOG(ERROR, "%s: timerfd_create failed, %s\n", __FUNCTION__, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ *  @brief Replace the windows, the components they shed change right away
+ *  @return 0 on success, -1 if there are too many windows or one is out of range
+ */
+int PwrMgr_Sched_Set(PWRMGR_Scheduler *sched, const PWRMGR_EcoWindow *windows, int count, time_t now)
+{
+    int i;
+
+    if (count < 0 || count > PWRMGR_SCHED_MAX_WINDOWS)
+        return -1;
+    for (i = 0; i < count; i++) {
+        if (windows[i].startMin < 0 || windows[i].startMin >= PWRMGR_SCHED_DAY_MIN || windows[i].endMin < 0 || windows[i].endMin >= PWRMGR_SCHED_DAY_MIN)
+            return -1;
+    }
+
+    memmove(sched->windows, windows, count * sizeof(*windows));
+    sched->count = count;
+    sched->heapSize = 0;
+    for (i = 0; i < count; i++) {
+        // Open all day, nothing to wake up for
+        if (windows[i].startMin == windows[i].endMin)
+            continue;
+        PwrMgr_Sched_Push(sched, i, true, now);
+        PwrMgr_Sched_Push(sched, i, false, now);
+    }
+    PWRMGRLOG(INFO, "%s: %d eco window(s)\n", __FUNCTION__, count);
+    PwrMgr_Sched_Run(sched, now);
+    return 0;
+}
+
+/**
+ *  @brief Take the edges that are due and report a change in what is shed
+ *  @return seconds until the next edge, -1 without any
+ */
+long PwrMgr_Sched_Run(PWRMGR_Scheduler *sched, time_t now)
+{
+    PWRMGR_CompMask shed;
+
+    while (sched->heapSize > 0 && sched->heap[0].dueSec <= now) {
+        PWRMGR_SchedTimer due = PwrMgr_Sched_Pop(sched);
+
+        sched->fired++;
+        PwrMgr_Sched_Push(sched, due.window, due.opens, now);
+    }
+
+    // Worked out from the clock, a late or missed edge cannot leave a window open
+    shed = PwrMgr_Sched_ShedAt(sched->windows, sched->count, now);
+    if (shed != sched->shed) {
+        PWRMGRLOG(INFO, "%s: eco shedding 0x%x, was 0x%x\n", __FUNCTION__, shed, sched->shed);
+        sched->shed = shed;
+        if (sched->notify)
+            sched->notify(sched->ctx, shed);
+    }
+
+    PwrMgr_Sched_Arm(sched);
+    return (sched->heapSize > 0) ? (long)(sched->heap[0].dueSec - now) : -1;
+}
+
+/**
+ *  @brief Timer descriptor, readable when the next window opens or closes
+ */
+int PwrMgr_Sched_Fd(PWRMGR_Scheduler *sched)
+{
+    return sched->timerFd;
+}
+
+/**
+ *  @brief Handle the timer descriptor becoming readable
+ *  @return 0
+ */
+int PwrMgr_Sched_Dispatch(PWRMGR_Scheduler *sched)
+{
+    uint64_t expirations;
+    time_t now = time(NULL);
+
+    if (read(sched->timerFd, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+        PwrMgr_Sched_Run(sched, now);
+    } else if (errno == ECANCELED) {
+        // The clock was set, every edge is computed again for the new time
+        PWRMGRLOG(INFO, "%s: clock changed, rescheduling\n", __FUNCTION__);
+        PwrMgr_Sched_Set(sched, sched->windows, sched->count, now);
+    }
+    return 0;
+}
+
+/**
+ *  @brief Close the timer
+ */
+void PwrMgr_Sched_Close(PWRMGR_Scheduler *sched)
+{
+    if (sched->timerFd >= 0)
+        close(sched->timerFd);
+    sched->timerFd = -1;
+    sched->heapSize = 0;
+}
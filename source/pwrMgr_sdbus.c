@@ -0,0 +1,313 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ *  @file pwrMgr_sdbus.c
+ *  @brief RDKB Power Manger systemd D-Bus unit controller
+ *
+ *  Issues StopUnit/StartUnit calls on org.freedesktop.systemd1.Manager and
+ *  tracks the returned job objects until systemd reports them through the
+ *  JobRemoved signal. systemd queues the job and replies straight away, so a
+ *  batch of units runs in parallel inside systemd.
+ *
+ *  Escalation uses KillUnit and FreezeUnit, which act on the unit's cgroup
+ *  right away and leave a pending stop job alone.
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <systemd/sd-bus.h>
+#include "pwrMgr_log.h"
+#include "pwrMgr_unitctl.h"
+
+#define SD_BUS_DEST       "org.freedesktop.systemd1"
+#define SD_BUS_PATH       "/org/freedesktop/systemd1"
+#define SD_BUS_MANAGER    "org.freedesktop.systemd1.Manager"
+#define SD_BUS_UNIT       "org.freedesktop.systemd1.Unit"
+#define SD_BUS_UNIT_PATH  "/org/freedesktop/systemd1/unit"
+
+typedef struct
+{
+    int jobId;
+    char *jobPath;
+    bool done;
+    PWRMGR_UnitJobResult result;
+} PWRMGR_SdBusJob;
+
+typedef struct
+{
+    sd_bus *bus;
+    sd_bus_slot *jobRemovedSlot;
+    PWRMGR_SdBusJob jobs[PWRMGR_UNIT_MAX_JOBS];
+    int jobCount;
+} PWRMGR_SdBusCtx;
+
+static long PwrMgr_SdBus_NowMs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int PwrMgr_SdBus_JobRemoved(sd_bus_message *m, void *userdata, sd_bus_error *ret_error)
+{
+    PWRMGR_SdBusCtx *ctx = (PWRMGR_SdBusCtx *)userdata;
+    uint32_t id = 0;
+    const char *path = NULL;
+    const char *unit = NULL;
+    const char *result = NULL;
+    int i;
+
+    (void)ret_error;
+
+    if (sd_bus_message_read(m, "uoss", &id, &path, &unit, &result) < 0)
+        return 0;
+
+    for (i = 0; i < ctx->jobCount; i++)
+    {
+        if (!ctx->jobs[i].done && strcmp(ctx->jobs[i].jobPath, path) == 0)
+        {
+            ctx->jobs[i].done = true;
+            ctx->jobs[i].result = (strcmp(result, "done") == 0) ? PWRMGR_UNIT_JOB_DONE : PWRMGR_UNIT_JOB_FAILED;
+            PWRMGRLOG(INFO, "%s: job %u for %s finished with %s\n", __FUNCTION__, id, unit, result);
+            break;
+        }
+    }
+    return 0;
+}
+
+static int PwrMgr_SdBus_Submit(void *data, PWRMGR_UnitOp op, const char *unit, int jobId)
+{
+    PWRMGR_SdBusCtx *ctx = (PWRMGR_SdBusCtx *)data;
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    sd_bus_message *reply = NULL;
+    const char *jobPath = NULL;
+    int rc;
+
+    if (ctx->jobCount >= PWRMGR_UNIT_MAX_JOBS)
+        return -1;
+
+    rc = sd_bus_call_method(ctx->bus, SD_BUS_DEST, SD_BUS_PATH, SD_BUS_MANAGER,
+                            (op == PWRMGR_UNIT_START) ? "StartUnit" : "StopUnit",
+                            &error, &reply, "ss", unit, "replace");
+    if (rc < 0)
+    {
+        PWRMGRLOG(ERROR, "%s: %s %s failed: %s\n", __FUNCTION__, PwrMgr_UnitCtl_OpStr(op), unit, error.message ? error.message : strerror(-rc));
+        sd_bus_error_free(&error);
+        return -1;
+    }
+
+    rc = sd_bus_message_read(reply, "o", &jobPath);
+    if (rc >= 0)
+    {
+        PWRMGR_SdBusJob *job = &ctx->jobs[ctx->jobCount++];
+        job->jobId = jobId;
+        job->jobPath = strdup(jobPath);
+        job->done = false;
+        job->result = PWRMGR_UNIT_JOB_FAILED;
+    }
+    sd_bus_message_unref(reply);
+    sd_bus_error_free(&error);
+    return (rc >= 0) ? 0 : -1;
+}
+
+static void PwrMgr_SdBus_Reap(PWRMGR_SdBusCtx *ctx, int index)
+{
+    free(ctx->jobs[index].jobPath);
+    ctx->jobs[index] = ctx->jobs[--ctx->jobCount];
+}
+
+static int PwrMgr_SdBus_Wait(void *data, int timeoutMs, int *jobId, PWRMGR_UnitJobResult *result)
+{
+    PWRMGR_SdBusCtx *ctx = (PWRMGR_SdBusCtx *)data;
+    long deadline = PwrMgr_SdBus_NowMs() + timeoutMs;
+    int i;
+
+    for (;;)
+    {
+        long remaining;
+        int rc;
+
+        for (i = 0; i < ctx->jobCount; i++)
+        {
+            if (ctx->jobs[i].done)
+            {
+                *jobId = ctx->jobs[i].jobId;
+                *result = ctx->jobs[i].result;
+                PwrMgr_SdBus_Reap(ctx, i);
+                return 0;
+            }
+        }
+
+        if (ctx->jobCount == 0)
+            return -1;
+
+        // Dispatch everything already queued on the bus before sleeping
+        rc = sd_bus_process(ctx->bus, NULL);
+        if (rc < 0)
+        {
+            PWRMGRLOG(ERROR, "%s: sd_bus_process failed: %s\n", __FUNCTION__, strerror(-rc));
+            return -1;
+        }
+        if (rc > 0)
+            continue;
+
+        remaining = deadline - PwrMgr_SdBus_NowMs();
+        if (remaining <= 0)
+            return 1;
+
+        rc = sd_bus_wait(ctx->bus, (uint64_t)remaining * 1000);
+        if (rc < 0)
+        {
+            PWRMGRLOG(ERROR, "%s: sd_bus_wait failed: %s\n", __FUNCTION__, strerror(-rc));
+            return -1;
+        }
+    }
+}
+
+static int PwrMgr_SdBus_Active(void *data, const char *unit)
+{
+    PWRMGR_SdBusCtx *ctx = (PWRMGR_SdBusCtx *)data;
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    char *path = NULL;
+    char *state = NULL;
+    int active = -1;
+
+    // The object path is derived from the name, no GetUnit round trip needed
+    if (sd_bus_path_encode(SD_BUS_UNIT_PATH, unit, &path) < 0)
+        return -1;
+    if (sd_bus_get_property_string(ctx->bus, SD_BUS_DEST, path, SD_BUS_UNIT, "ActiveState", &error, &state) >= 0)
+        active = (strcmp(state, "active") == 0) ? 1 : 0;
+    else
+        PWRMGRLOG(WARNING, "%s: ActiveState of %s unavailable: %s\n", __FUNCTION__, unit, error.message ? error.message : "unknown error");
+    free(state);
+    free(path);
+    sd_bus_error_free(&error);
+    return active;
+}
+
+static int PwrMgr_SdBus_Kill(void *data, const char *unit, int signal)
+{
+    PWRMGR_SdBusCtx *ctx = (PWRMGR_SdBusCtx *)data;
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    int rc;
+
+    rc = sd_bus_call_method(ctx->bus, SD_BUS_DEST, SD_BUS_PATH, SD_BUS_MANAGER, "KillUnit",
+                            &error, NULL, "ssi", unit, "all", signal);
+    if (rc < 0)
+        PWRMGRLOG(ERROR, "%s: kill %s failed: %s\n", __FUNCTION__, unit, error.message ? error.message : strerror(-rc));
+    sd_bus_error_free(&error);
+    return (rc >= 0) ? 0 : -1;
+}
+
+static int PwrMgr_SdBus_Freeze(void *data, const char *unit)
+{
+    PWRMGR_SdBusCtx *ctx = (PWRMGR_SdBusCtx *)data;
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    int rc;
+
+    rc = sd_bus_call_method(ctx->bus, SD_BUS_DEST, SD_BUS_PATH, SD_BUS_MANAGER, "FreezeUnit",
+                            &error, NULL, "s", unit);
+    if (rc < 0)
+        PWRMGRLOG(ERROR, "%s: freeze %s failed: %s\n", __FUNCTION__, unit, error.message ? error.message : strerror(-rc));
+    sd_bus_error_free(&error);
+    return (rc >= 0) ? 0 : -1;
+}
+
+static void PwrMgr_SdBus_Forget(void *data, int jobId)
+{
+    PWRMGR_SdBusCtx *ctx = (PWRMGR_SdBusCtx *)data;
+    int i;
+
+    // A JobRemoved for a forgotten job no longer matches anything
+    for (i = ctx->jobCount - 1; i >= 0; i--)
+    {
+        if (jobId < 0 || ctx->jobs[i].jobId == jobId)
+            PwrMgr_SdBus_Reap(ctx, i);
+    }
+}
+
+static void PwrMgr_SdBus_Close(void *data)
+{
+    PWRMGR_SdBusCtx *ctx = (PWRMGR_SdBusCtx *)data;
+
+    while (ctx->jobCount > 0)
+        PwrMgr_SdBus_Reap(ctx, 0);
+    sd_bus_slot_unref(ctx->jobRemovedSlot);
+    sd_bus_flush_close_unref(ctx->bus);
+    free(ctx);
+}
+
+static const PWRMGR_UnitCtlOps sdBusOps = {
+    "sd-bus",
+    PwrMgr_SdBus_Submit,
+    PwrMgr_SdBus_Wait,
+    PwrMgr_SdBus_Close,
+    PwrMgr_SdBus_Active,
+    PwrMgr_SdBus_Kill,
+    PwrMgr_SdBus_Freeze,
+    PwrMgr_SdBus_Forget
+};
+
+/**
+ *  @brief Connect the unit controller to the systemd manager on the system bus
+ *  @return 0 on success, -1 on failure
+ */
+int PwrMgr_UnitCtl_OpenSdBus(PWRMGR_UnitCtl *ctl)
+{
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    PWRMGR_SdBusCtx *ctx;
+    int rc;
+
+    ctx = (PWRMGR_SdBusCtx *)calloc(1, sizeof(*ctx));
+    if (ctx == NULL)
+        return -1;
+
+    rc = sd_bus_open_system(&ctx->bus);
+    if (rc < 0)
+    {
+        PWRMGRLOG(ERROR, "%s: sd_bus_open_system failed: %s\n", __FUNCTION__, strerror(-rc));
+        free(ctx);
+        return -1;
+    }
+
+    rc = sd_bus_match_signal(ctx->bus, &ctx->jobRemovedSlot, SD_BUS_DEST, SD_BUS_PATH, SD_BUS_MANAGER,
+                             "JobRemoved", PwrMgr_SdBus_JobRemoved, ctx);
+    if (rc >= 0)
+    {
+        // systemd only emits job signals while at least one client is subscribed
+        rc = sd_bus_call_method(ctx->bus, SD_BUS_DEST, SD_BUS_PATH, SD_BUS_MANAGER, "Subscribe", &error, NULL, "");
+    }
+    if (rc < 0)
+    {
+        PWRMGRLOG(ERROR, "%s: JobRemoved subscription failed: %s\n", __FUNCTION__, error.message ? error.message : strerror(-rc));
+        sd_bus_error_free(&error);
+        sd_bus_slot_unref(ctx->jobRemovedSlot);
+        sd_bus_flush_close_unref(ctx->bus);
+        free(ctx);
+        return -1;
+    }
+
+    ctl->ops = &sdBusOps;
+    ctl->ctx = ctx;
+    PWRMGRLOG(INFO, "%s: connected to systemd over D-Bus\n", __FUNCTION__);
+    return 0;
+}
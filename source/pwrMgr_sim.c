@@ -0,0 +1,579 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+/**
+ *  @file pwrMgr_sim.c
+ *  @brief RDKB Power Manger trace replay simulator
+ *
+ *  Follows PwrMgr_Exec_Thread step by step, with the waits on the unit
+ *  controller and the coalescer replaced by jumps of the virtual clock.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "pwrMgr_log.h"
+#include "pwrMgr_sim.h"
+
+#define LINE_SIZE 256
+
+/**
+ *  @brief The daemon's defaults: built-in policy, transition table and trip points
+ */
+void PwrMgr_Sim_DefaultPolicy(PWRMGR_SimPolicy *policy)
+{
+    int i;
+
+    memset(policy, 0, sizeof(*policy));
+    PwrMgr_Policy_LoadDefaults(&policy->power);
+    PwrMgr_Fsm_InitDefault(&policy->fsm);
+    PwrMgr_Thermal_DefaultConfig(&policy->thermal);
+    for (i = 0; i < PWRMGR_MAX_COMPONENTS; i++) {
+        policy->cost[i].stopMs = PWRMGR_SIM_STOP_MS;
+        policy->cost[i].startMs = PWRMGR_SIM_START_MS;
+    }
+    policy->freeze = true;
+    policy->freezeMs = PWRMGR_SIM_FREEZE_MS;
+}
+
+/**
+ *  @brief State from its rdkb-power-state value
+ *  @return state, PWRMGR_STATE_UNKNOWN if not recognised
+ */
+static PWRMGR_PwrState PwrMgr_Sim_StateByName(const PWRMGR_SimPolicy *policy, const char *name)
+{
+    int i;
+
+    for (i = PWRMGR_STATE_UNKNOWN + 1; i < PWRMGR_STATE_TOTAL; i++) {
+        if (strcmp(PwrMgr_Fsm_StateStr(&policy->fsm, i), name) == 0)
+            return (PWRMGR_PwrState)i;
+    }
+    return PWRMGR_STATE_UNKNOWN;
+}
+
+/**
+ *  @brief Apply one policy setting, the keys are the daemon's syscfg keys
+ *
+ *  PwrMgrHysteresisMs_<state>, PwrMgrMinDwellMs_<state>,
+ *  PwrMgrThermalOnMilliC_<state>, PwrMgrThermalOffMilliC_<state> and
+ *  PwrMgrFreezeMode as in the daemon. The modelled costs are set with
+ *  PwrMgrSimStopMs, PwrMgrSimStartMs and PwrMgrSimFreezeMs, the first two
+ *  apply to one component with a _<component> suffix.
+ *
+ *  @return 0 on success, -1 for an unknown key or a bad value
+ */
+int PwrMgr_Sim_SetOption(PWRMGR_SimPolicy *policy, const char *key, const char *value)
+{
+    static const char *stateKeys[] = {
+        "PwrMgrHysteresisMs_", "PwrMgrMinDwellMs_", "PwrMgrThermalOnMilliC_", "PwrMgrThermalOffMilliC_"
+    };
+    char *end;
+    long number;
+    size_t len;
+    int i;
+
+    if (strcmp(key, "PwrMgrFreezeMode") == 0) {
+        policy->freeze = (strcmp(value, "false") != 0);
+        return 0;
+    }
+
+    number = strtol(value, &end, 10);
+    if (end == value || *end != '\0' || number < 0)
+        return -1;
+
+    for (i = 0; i < (int)(sizeof(stateKeys) / sizeof(stateKeys[0])); i++) {
+        PWRMGR_PwrState state;
+        int t;
+
+        len = strlen(stateKeys[i]);
+        if (strncmp(key, stateKeys[i], len) != 0)
+            continue;
+        state = PwrMgr_Sim_StateByName(policy, key + len);
+        if (state == PWRMGR_STATE_UNKNOWN)
+            return -1;
+        if (i == 0) {
+            policy->power.timing[state].hysteresisMs = number;
+            return 0;
+        }
+        if (i == 1) {
+            policy->power.timing[state].minDwellMs = number;
+            return 0;
+        }
+        for (t = 0; t < policy->thermal.tripCount; t++) {
+            if (policy->thermal.trips[t].state != state)
+                continue;
+            if (i == 2)
+                policy->thermal.trips[t].onMilliC = (int)number;
+            else
+                policy->thermal.trips[t].offMilliC = (int)number;
+            return 0;
+        }
+        return -1;
+    }
+
+    if (strcmp(key, "PwrMgrSimFreezeMs") == 0) {
+        policy->freezeMs = number;
+        return 0;
+    }
+    for (i = 0; i < 2; i++) {
+        const char *prefix = (i == 0) ? "PwrMgrSimStopMs" : "PwrMgrSimStartMs";
+        int comp;
+
+        len = strlen(prefix);
+        if (strncmp(key, prefix, len) != 0)
+            continue;
+        if (key[len] == '\0') {
+            for (comp = 0; comp < PWRMGR_MAX_COMPONENTS; comp++) {
+                if (i == 0)
+                    policy->cost[comp].stopMs = number;
+                else
+                    policy->cost[comp].startMs = number;
+            }
+            return 0;
+        }
+        if (key[len] != '_' || (comp = PwrMgr_CompGraph_Find(&policy->power.graph, key + len + 1)) < 0)
+            return -1;
+        if (i == 0)
+            policy->cost[comp].stopMs = number;
+        else
+            policy->cost[comp].startMs = number;
+        return 0;
+    }
+    return -1;
+}
+
+/**
+ *  @brief Put the clock at startMs with target reached and nothing pending
+ */
+static void PwrMgr_Sim_Start(PWRMGR_Sim *sim, long startMs)
+{
+    const PWRMGR_SimPolicy *policy = sim->policy;
+    int i;
+
+    for (i = 0; i < PWRMGR_AXIS_TOTAL; i++)
+        PwrMgr_Coalesce_Init(&sim->co[i], sim->reached.axis[i], startMs);
+    for (i = PWRMGR_STATE_UNKNOWN + 1; i < PWRMGR_STATE_TOTAL; i++) {
+        PWRMGR_Coalescer *co = &sim->co[PwrMgr_Arbiter_Axis(i)];
+
+        PwrMgr_Coalesce_SetTiming(co, i, policy->power.timing[i].hysteresisMs, policy->power.timing[i].minDwellMs);
+        PwrMgr_Coalesce_SetSeverity(co, i, policy->power.timing[i].severity);
+    }
+    sim->startMs = startMs;
+    sim->nowMs = startMs;
+    sim->lastEventMs = startMs;
+    sim->stateSinceMs = startMs;
+}
+
+/**
+ *  @brief Set up a replay starting in state, startMs -1 starts at the first event
+ */
+void PwrMgr_Sim_Init(PWRMGR_Sim *sim, const PWRMGR_SimPolicy *policy, PWRMGR_PwrState state, long startMs)
+{
+    int i;
+
+    memset(sim, 0, sizeof(*sim));
+    sim->policy = policy;
+    for (i = PWRMGR_STATE_UNKNOWN + 1; i < PWRMGR_STATE_TOTAL; i++)
+        sim->runMask[i] = policy->power.runMask[i];
+    sim->state = state;
+    sim->target = state;
+    PwrMgr_Arbiter_Init(&sim->reached, state);
+    sim->wanted = sim->reached;
+    sim->running = PwrMgr_Arbiter_RunMask(&sim->reached, sim->runMask);
+    sim->op = PWRMGR_FSM_ACT_NONE;
+    for (i = 0; i < PWRMGR_MAX_COMPONENTS; i++) {
+        sim->downSinceMs[i] = -1;
+        sim->frozenSinceMs[i] = -1;
+    }
+    sim->startMs = -1;
+    if (startMs >= 0)
+        PwrMgr_Sim_Start(sim, startMs);
+}
+
+/**
+ *  @brief Modelled time of a job on component i submitted at atMs
+ */
+static long PwrMgr_Sim_JobMs(PWRMGR_Sim *sim, int i, PWRMGR_FsmAction op, long atMs)
+{
+    const PWRMGR_SimPolicy *policy = sim->policy;
+    long dwellMs = policy->freeze ? policy->power.graph.comps[i].freezeDwellMs : 0;
+
+    if (op == PWRMGR_FSM_ACT_STOP)
+        return (dwellMs > 0) ? policy->freezeMs : policy->cost[i].stopMs;
+    if (sim->frozenSinceMs[i] >= 0 && atMs - sim->frozenSinceMs[i] < dwellMs)
+        return policy->freezeMs;
+    return policy->cost[i].startMs;
+}
+
+/**
+ *  @brief Schedule the stop or start delta towards target over the graph edges
+ *
+ *  A component is submitted once its prerequisites in the delta are done and
+ *  takes its modelled cost, the step ends when the last one is done.
+ */
+static void PwrMgr_Sim_ScheduleOp(PWRMGR_Sim *sim, PWRMGR_FsmAction op)
+{
+    const PWRMGR_CompGraph *graph = &sim->policy->power.graph;
+    PWRMGR_CompMask desired = PwrMgr_Arbiter_RunMask(&sim->wanted, sim->runMask);
+    PWRMGR_CompMask delta = (op == PWRMGR_FSM_ACT_STOP) ? (sim->running & ~desired) : (desired & ~sim->running);
+    PWRMGR_CompMask left = delta;
+    bool progress = true;
+    int i;
+
+    sim->op = op;
+    sim->opStartMs = sim->nowMs;
+    sim->opEndMs = sim->nowMs;
+    while (left != 0 && progress) {
+        progress = false;
+        for (i = 0; i < graph->count; i++) {
+            PWRMGR_CompMask bit = PWRMGR_COMP_BIT(i);
+            PWRMGR_CompMask prereq = (op == PWRMGR_FSM_ACT_START) ? graph->comps[i].startPrereq : graph->comps[i].stopPrereq;
+            long readyMs = sim->nowMs;
+            int p;
+
+            prereq &= delta;
+            if (!(left & bit) || (prereq & left))
+                continue;
+            for (p = 0; p < graph->count; p++) {
+                if ((prereq & PWRMGR_COMP_BIT(p)) && sim->doneMs[p] > readyMs)
+                    readyMs = sim->doneMs[p];
+            }
+            sim->readyMs[i] = readyMs;
+            sim->doneMs[i] = readyMs + PwrMgr_Sim_JobMs(sim, i, op, readyMs);
+            if (sim->doneMs[i] > sim->opEndMs)
+                sim->opEndMs = sim->doneMs[i];
+            left &= ~bit;
+            progress = true;
+        }
+    }
+    // A cycle leaves components that are never submitted, like a failed run
+    sim->opMask = delta & ~left;
+}
+
+/**
+ *  @brief A newer request at atMs, nothing is submitted after it
+ */
+static void PwrMgr_Sim_Cancel(PWRMGR_Sim *sim, long atMs)
+{
+    int i;
+
+    sim->cancelled = true;
+    if (sim->op == PWRMGR_FSM_ACT_NONE)
+        return;
+    sim->opEndMs = sim->opStartMs;
+    for (i = 0; i < sim->policy->power.graph.count; i++) {
+        PWRMGR_CompMask bit = PWRMGR_COMP_BIT(i);
+
+        if (!(sim->opMask & bit))
+            continue;
+        if (sim->readyMs[i] >= atMs && sim->readyMs[i] != sim->opStartMs) {
+            sim->opMask &= ~bit;
+            continue;
+        }
+        if (sim->doneMs[i] > sim->opEndMs)
+            sim->opEndMs = sim->doneMs[i];
+    }
+}
+
+/**
+ *  @brief Account the time since the last state change
+ */
+static void PwrMgr_Sim_AccountState(PWRMGR_Sim *sim, long nowMs)
+{
+    long spentMs = nowMs - sim->stateSinceMs;
+
+    sim->report.timeInStateMs[sim->state] += spentMs;
+    if (PwrMgr_Arbiter_RunMask(&sim->reached, sim->runMask) != PwrMgr_CompGraph_AllMask(&sim->policy->power.graph))
+        sim->report.degradedMs += spentMs;
+    sim->stateSinceMs = nowMs;
+}
+
+/**
+ *  @brief The step in flight is done, update the running set
+ */
+static void PwrMgr_Sim_FinishOp(PWRMGR_Sim *sim)
+{
+    const PWRMGR_SimPolicy *policy = sim->policy;
+    int i;
+
+    for (i = 0; i < policy->power.graph.count; i++) {
+        PWRMGR_CompMask bit = PWRMGR_COMP_BIT(i);
+
+        if (!(sim->opMask & bit))
+            continue;
+        if (sim->op == PWRMGR_FSM_ACT_STOP) {
+            sim->running &= ~bit;
+            sim->downSinceMs[i] = sim->readyMs[i];
+            if (policy->freeze && policy->power.graph.comps[i].freezeDwellMs > 0)
+                sim->frozenSinceMs[i] = sim->doneMs[i];
+        } else {
+            sim->running |= bit;
+            if (sim->downSinceMs[i] >= 0)
+                sim->report.downtimeMs[i] += sim->doneMs[i] - sim->downSinceMs[i];
+            sim->downSinceMs[i] = -1;
+            sim->frozenSinceMs[i] = -1;
+        }
+    }
+    sim->op = PWRMGR_FSM_ACT_NONE;
+    sim->opMask = 0;
+}
+
+/**
+ *  @brief Check whether a request is pending on any axis
+ */
+static bool PwrMgr_Sim_Pending(PWRMGR_Sim *sim)
+{
+    int i;
+
+    for (i = 0; i < PWRMGR_AXIS_TOTAL; i++) {
+        if (sim->co[i].pending != PWRMGR_STATE_UNKNOWN)
+            return true;
+    }
+    return false;
+}
+
+/**
+ *  @brief Run the executor at the current virtual time until it has to wait
+ *  @return virtual time it waits for, -1 when idle
+ */
+static long PwrMgr_Sim_Step(PWRMGR_Sim *sim)
+{
+    for (;;) {
+        PWRMGR_PwrState next = PWRMGR_STATE_UNKNOWN;
+        long waitMs = -1;
+        int axis;
+
+        if (sim->busy) {
+            if (sim->nowMs < sim->opEndMs)
+                return sim->opEndMs;
+            PwrMgr_Sim_FinishOp(sim);
+            if (sim->cancelled) {
+                sim->busy = false;
+                sim->report.preempted++;
+                sim->report.transitionMs += sim->nowMs - sim->busySinceMs;
+            } else if (++sim->step < sim->stepCount) {
+                PwrMgr_Sim_ScheduleOp(sim, sim->steps[sim->step]);
+            } else {
+                PwrMgr_Sim_AccountState(sim, sim->nowMs);
+                sim->state = sim->target;
+                sim->reached = sim->wanted;
+                sim->dirty = false;
+                sim->busy = false;
+                sim->report.transitions++;
+                sim->report.transitionMs += sim->nowMs - sim->busySinceMs;
+            }
+            continue;
+        }
+
+        for (axis = 0; axis < PWRMGR_AXIS_TOTAL; axis++) {
+            long axisMs = PwrMgr_Coalesce_Next(&sim->co[axis], sim->nowMs, &next);
+
+            if (axisMs == 0)
+                break;
+            if (axisMs > 0 && (waitMs < 0 || axisMs < waitMs))
+                waitMs = axisMs;
+        }
+        if (axis < PWRMGR_AXIS_TOTAL) {
+            sim->target = next;
+            PwrMgr_Arbiter_Set(&sim->wanted, next);
+            sim->dirty = true;
+            PwrMgr_Coalesce_Done(&sim->co[axis], next, sim->nowMs);
+            continue;
+        }
+        if (sim->dirty && !PwrMgr_Sim_Pending(sim)) {
+            sim->busy = true;
+            sim->cancelled = false;
+            sim->busySinceMs = sim->nowMs;
+            sim->stepCount = PwrMgr_Fsm_Steps(&sim->policy->fsm, PwrMgr_Arbiter_Get(&sim->reached, sim->target),
+                                              sim->target, sim->steps);
+            sim->step = 0;
+            PwrMgr_Sim_ScheduleOp(sim, sim->steps[0]);
+            continue;
+        }
+        return (waitMs < 0) ? -1 : sim->nowMs + waitMs;
+    }
+}
+
+/**
+ *  @brief Move the virtual clock to untilMs, running whatever falls due on the way
+ */
+static void PwrMgr_Sim_Advance(PWRMGR_Sim *sim, long untilMs)
+{
+    long dueMs;
+
+    while ((dueMs = PwrMgr_Sim_Step(sim)) >= 0 && dueMs <= untilMs)
+        sim->nowMs = dueMs;
+    if (untilMs > sim->nowMs)
+        sim->nowMs = untilMs;
+}
+
+/**
+ *  @brief Check the timestamp of an event and bring the clock up to it
+ *  @return 0 on success, -1 if it goes backwards
+ */
+static int PwrMgr_Sim_At(PWRMGR_Sim *sim, long atMs)
+{
+    if (sim->startMs < 0)
+        PwrMgr_Sim_Start(sim, atMs);
+    if (atMs < sim->lastEventMs)
+        return -1;
+    PwrMgr_Sim_Advance(sim, atMs);
+    sim->lastEventMs = atMs;
+    return 0;
+}
+
+/**
+ *  @brief A power state requested at atMs, as by rdkb-power-transition
+ *  @return 0 if accepted, 1 if the state is off or the transition table rejects it, -1 if atMs goes backwards
+ */
+int PwrMgr_Sim_Request(PWRMGR_Sim *sim, long atMs, PWRMGR_PwrState target)
+{
+    PWRMGR_PwrState current;
+
+    if (PwrMgr_Sim_At(sim, atMs) != 0)
+        return -1;
+
+    sim->report.requests++;
+    current = PwrMgr_Arbiter_Get(&sim->wanted, target);
+    if (!sim->policy->power.enabled[target] ||
+        (target != current && !PwrMgr_Fsm_Allowed(&sim->policy->fsm, current, target))) {
+        sim->report.rejected++;
+        return 1;
+    }
+    PwrMgr_Coalesce_Post(&sim->co[PwrMgr_Arbiter_Axis(target)], target, atMs);
+    if (sim->busy && !sim->cancelled && PwrMgr_Sim_Pending(sim))
+        PwrMgr_Sim_Cancel(sim, atMs);
+    return 0;
+}
+
+/**
+ *  @brief A thermal sample at atMs, requests a state when a trip level changes
+ *  @return 0 on success, -1 if atMs goes backwards
+ */
+int PwrMgr_Sim_Temperature(PWRMGR_Sim *sim, long atMs, int milliC)
+{
+    int level;
+
+    if (PwrMgr_Sim_At(sim, atMs) != 0)
+        return -1;
+
+    level = PwrMgr_Thermal_Level(&sim->policy->thermal, sim->thermalLevel, milliC);
+    if (level == sim->thermalLevel)
+        return 0;
+    sim->thermalLevel = level;
+    return (PwrMgr_Sim_Request(sim, atMs, PwrMgr_Thermal_LevelState(&sim->policy->thermal, level)) < 0) ? -1 : 0;
+}
+
+/**
+ *  @brief Replay one line of a trace, see pwrMgr_sim.h
+ *  @return 0 for an event, 1 for a blank or comment line, -1 if malformed
+ */
+int PwrMgr_Sim_ReplayLine(PWRMGR_Sim *sim, char *line)
+{
+    char *saveptr = NULL;
+    char *hash = strchr(line, '#');
+    char *token[3];
+    char *end;
+    long atMs;
+    int count = 0;
+    int rc;
+
+    if (hash != NULL)
+        *hash = '\0';
+    for (token[0] = strtok_r(line, " \t\r\n", &saveptr); token[count] != NULL; ) {
+        if (++count == 3)
+            break;
+        token[count] = strtok_r(NULL, " \t\r\n", &saveptr);
+    }
+    if (count == 0)
+        return 1;
+    if (count != 3 || strtok_r(NULL, " \t\r\n", &saveptr) != NULL)
+        return -1;
+
+    atMs = strtol(token[0], &end, 10);
+    if (end == token[0] || *end != '\0' || atMs < 0)
+        return -1;
+
+    if (strcmp(token[1], "trans") == 0) {
+        PWRMGR_PwrState state = PwrMgr_Fsm_FromTransStr(&sim->policy->fsm, token[2]);
+
+        if (state == PWRMGR_STATE_UNKNOWN)
+            return -1;
+        rc = PwrMgr_Sim_Request(sim, atMs, state);
+    } else if (strcmp(token[1], "temp") == 0) {
+        long milliC = strtol(token[2], &end, 10);
+
+        if (end == token[2] || *end != '\0')
+            return -1;
+        rc = PwrMgr_Sim_Temperature(sim, atMs, (int)milliC);
+    } else {
+        return -1;
+    }
+    if (rc < 0)
+        return -1;
+    sim->report.events++;
+    return 0;
+}
+
+/**
+ *  @brief Replay a whole trace
+ *  @return 0 on success, -1 on the first malformed line, its number in lineNo
+ */
+int PwrMgr_Sim_Replay(PWRMGR_Sim *sim, FILE *fp, int *lineNo)
+{
+    char line[LINE_SIZE];
+    int n = 0;
+
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        n++;
+        if (PwrMgr_Sim_ReplayLine(sim, line) < 0) {
+            if (lineNo)
+                *lineNo = n;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ *  @brief Let whatever is pending settle and report, call once at the end of the trace
+ */
+void PwrMgr_Sim_Finish(PWRMGR_Sim *sim, PWRMGR_SimReport *report)
+{
+    long dueMs;
+    int i;
+
+    if (sim->startMs < 0)
+        PwrMgr_Sim_Start(sim, 0);
+    while ((dueMs = PwrMgr_Sim_Step(sim)) >= 0)
+        sim->nowMs = dueMs;
+
+    PwrMgr_Sim_AccountState(sim, sim->nowMs);
+    sim->report.durationMs = sim->nowMs - sim->startMs;
+    sim->report.suppressed = 0;
+    for (i = 0; i < PWRMGR_AXIS_TOTAL; i++)
+        sim->report.suppressed += PwrMgr_Coalesce_Suppressed(&sim->co[i]);
+    sim->report.totalDowntimeMs = 0;
+    for (i = 0; i < sim->policy->power.graph.count; i++) {
+        if (sim->downSinceMs[i] >= 0) {
+            sim->report.downtimeMs[i] += sim->nowMs - sim->downSinceMs[i];
+            sim->downSinceMs[i] = sim->nowMs;
+        }
+        sim->report.totalDowntimeMs += sim->report.downtimeMs[i];
+    }
+    *report = sim->report;
+}
@@ -0,0 +1,171 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+/**
+ *  @file pwrMgr_simtool.c
+ *  @brief RDKB Power Manger trace replay tool
+ *
+ *  rdkbPowerMgrSim [-c pwrMgr_components.conf] [-p policy.conf] [-s key=value]... <trace|->
+ *
+ *  Replays a trace, see pwrMgr_sim.h, and prints what the policy cost in
+ *  key=value lines. The policy starts from the daemon's defaults, -c loads
+ *  another power policy file, -p reads key=value lines and -s sets one key,
+ *  the keys are listed with PwrMgr_Sim_SetOption. Run it once per policy
+ *  on the same trace to compare them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "pwrMgr_log.h"
+#include "pwrMgr_sim.h"
+
+#define LINE_SIZE 256
+
+static void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-c pwrMgr_components.conf] [-p policy.conf] [-s key=value]... <trace|->\n", name);
+}
+
+/**
+ *  @brief Apply a key=value setting
+ *  @return 0 on success
+ */
+static int setOption(PWRMGR_SimPolicy *policy, char *setting)
+{
+    char *value = strchr(setting, '=');
+    char *end = value;
+
+    if (value == NULL)
+        return -1;
+    while (end > setting && (end[-1] == ' ' || end[-1] == '\t'))
+        end--;
+    *end = '\0';
+    value++;
+    while (*value == ' ' || *value == '\t')
+        value++;
+    return PwrMgr_Sim_SetOption(policy, setting, value);
+}
+
+/**
+ *  @brief Apply a file of key=value lines, # starts a comment
+ *  @return 0 on success
+ */
+static int loadPolicy(PWRMGR_SimPolicy *policy, const char *path)
+{
+    char line[LINE_SIZE];
+    int lineNo = 0;
+    int status = 0;
+    FILE *fp = fopen(path, "r");
+
+    if (fp == NULL)
+        return -1;
+    while (status == 0 && fgets(line, sizeof(line), fp) != NULL) {
+        char *start = line;
+        char *end = strchr(line, '#');
+
+        lineNo++;
+        if (end == NULL)
+            end = line + strlen(line);
+        while (end > start && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r' || end[-1] == '\n'))
+            end--;
+        *end = '\0';
+        while (*start == ' ' || *start == '\t')
+            start++;
+        if (*start != '\0' && setOption(policy, start) != 0) {
+            fprintf(stderr, "%s:%d: invalid setting\n", path, lineNo);
+            status = -1;
+        }
+    }
+    fclose(fp);
+    return status;
+}
+
+static double nowMs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+int main(int argc, char *argv[])
+{
+    static PWRMGR_SimPolicy policy;
+    static PWRMGR_Sim sim;
+    PWRMGR_SimReport report;
+    double startMs;
+    FILE *fp;
+    int lineNo = 0;
+    int opt;
+    int i;
+
+    PwrMgr_Sim_DefaultPolicy(&policy);
+    // The power policy first, per component costs refer to its graph
+    while ((opt = getopt(argc, argv, "c:p:s:")) != -1) {
+        if (opt == 'c' && PwrMgr_Policy_Load(&policy.power, &policy.fsm, optarg) != 0) {
+            fprintf(stderr, "%s: cannot load %s\n", argv[0], optarg);
+            return 2;
+        }
+        if (opt == '?') {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    optind = 1;
+    while ((opt = getopt(argc, argv, "c:p:s:")) != -1) {
+        if ((opt == 'p' && loadPolicy(&policy, optarg) != 0) || (opt == 's' && setOption(&policy, optarg) != 0)) {
+            fprintf(stderr, "%s: invalid policy %s\n", argv[0], optarg);
+            return 2;
+        }
+    }
+    if (optind != argc - 1) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    fp = (strcmp(argv[optind], "-") == 0) ? stdin : fopen(argv[optind], "r");
+    if (fp == NULL) {
+        fprintf(stderr, "%s: cannot open %s\n", argv[0], argv[optind]);
+        return 2;
+    }
+    startMs = nowMs();
+    PwrMgr_Sim_Init(&sim, &policy, PWRMGR_STATE_AC, -1);
+    if (PwrMgr_Sim_Replay(&sim, fp, &lineNo) != 0) {
+        fprintf(stderr, "%s:%d: invalid event\n", argv[optind], lineNo);
+        return 1;
+    }
+    PwrMgr_Sim_Finish(&sim, &report);
+    if (fp != stdin)
+        fclose(fp);
+
+    printf("duration_h=%.2f events=%lu requests=%lu transitions=%lu preempted=%lu rejected=%lu suppressed=%lu\n",
+           report.durationMs / 3600000.0, report.events, report.requests, report.transitions, report.preempted,
+           report.rejected, report.suppressed);
+    printf("transition_s=%.1f degraded_s=%.1f downtime_s=%.1f\n", report.transitionMs / 1000.0,
+           report.degradedMs / 1000.0, report.totalDowntimeMs / 1000.0);
+    for (i = PWRMGR_STATE_UNKNOWN + 1; i < PWRMGR_STATE_TOTAL; i++) {
+        if (report.timeInStateMs[i] > 0)
+            printf("state=%s time_s=%.1f\n", PwrMgr_Fsm_StateStr(&policy.fsm, i), report.timeInStateMs[i] / 1000.0);
+    }
+    for (i = 0; i < policy.power.graph.count; i++)
+        printf("component=%s downtime_s=%.1f\n", policy.power.graph.comps[i].name, report.downtimeMs[i] / 1000.0);
+    printf("replay_ms=%.1f\n", nowMs() - startMs);
+    return 0;
+}
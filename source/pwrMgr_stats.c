@@ -0,0 +1,225 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ *  @file pwrMgr_stats.c
+ *  @brief RDKB Power Manger transition latency statistics
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "pwrMgr_log.h"
+#include "pwrMgr_stats.h"
+
+// Bucket upper bounds in ms, the last bucket takes everything above
+static const uint32_t histLimitsMs[PWRMGR_HIST_BUCKETS - 1] = {
+    1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 60000
+};
+
+static const char *phaseNames[PWRMGR_PHASE_COUNT] = { "queue", "execute", "publish", "total" };
+
+static pthread_mutex_t gStatsLock = PTHREAD_MUTEX_INITIALIZER;
+static PWRMGR_Stats gStats;
+
+/**
+ *  @brief Monotonic clock in microseconds
+ */
+uint64_t PwrMgr_Stats_NowUs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ *  @brief Upper bound of a bucket in us, UINT64_MAX for the overflow bucket
+ */
+uint64_t PwrMgr_Hist_BucketLimitUs(int bucket)
+{
+    if (bucket < 0 || bucket >= PWRMGR_HIST_BUCKETS - 1)
+        return UINT64_MAX;
+    return (uint64_t)histLimitsMs[bucket] * 1000;
+}
+
+/**
+ *  @brief Add one sample to a histogram
+ */
+void PwrMgr_Hist_Record(PWRMGR_Histogram *hist, uint64_t us)
+{
+    int bucket = 0;
+
+    while (bucket < PWRMGR_HIST_BUCKETS - 1 && us > PwrMgr_Hist_BucketLimitUs(bucket))
+        bucket++;
+
+    hist->buckets[bucket]++;
+    hist->count++;
+    hist->sumUs += us;
+    if (us > hist->maxUs)
+        hist->maxUs = us;
+}
+
+/**
+ *  @brief Estimate a percentile as the upper bound of the bucket it falls in
+ *  @return latency in us, capped at the largest sample, 0 for an empty histogram
+ */
+uint64_t PwrMgr_Hist_Percentile(const PWRMGR_Histogram *hist, int percent)
+{
+    uint64_t rank;
+    uint64_t seen = 0;
+    int i;
+
+    if (hist->count == 0)
+        return 0;
+
+    rank = ((uint64_t)hist->count * percent + 99) / 100;
+    if (rank == 0)
+        rank = 1;
+
+    for (i = 0; i < PWRMGR_HIST_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank) {
+            uint64_t limit = PwrMgr_Hist_BucketLimitUs(i);
+            return (limit < hist->maxUs) ? limit : hist->maxUs;
+        }
+    }
+    return hist->maxUs;
+}
+
+/**
+ *  @brief Clear every histogram
+ */
+void PwrMgr_Stats_Reset()
+{
+    pthread_mutex_lock(&gStatsLock);
+    memset(&gStats, 0, sizeof(gStats));
+    pthread_mutex_unlock(&gStatsLock);
+}
+
+/**
+ *  @brief Record the latency of a transition phase
+ */
+void PwrMgr_Stats_RecordPhase(PWRMGR_Phase phase, uint64_t us)
+{
+    if (phase < 0 || phase >= PWRMGR_PHASE_COUNT)
+        return;
+    pthread_mutex_lock(&gStatsLock);
+    PwrMgr_Hist_Record(&gStats.phase[phase], us);
+    if (phase == PWRMGR_PHASE_TOTAL)
+        gStats.lastTotalUs = us;
+    pthread_mutex_unlock(&gStatsLock);
+}
+
+/**
+ *  @brief Record the end to end latency of a transition between two states
+ */
+void PwrMgr_Stats_RecordEdge(PWRMGR_PwrState from, PWRMGR_PwrState to, uint64_t us)
+{
+    if (from < 0 || from >= PWRMGR_STATE_TOTAL || to < 0 || to >= PWRMGR_STATE_TOTAL)
+        return;
+    pthread_mutex_lock(&gStatsLock);
+    PwrMgr_Hist_Record(&gStats.edge[from][to], us);
+    pthread_mutex_unlock(&gStatsLock);
+}
+
+/**
+ *  @brief Record how long a component took to stop or start
+ */
+void PwrMgr_Stats_RecordComponent(int comp, PWRMGR_UnitOp op, uint64_t us)
+{
+    if (comp < 0 || comp >= PWRMGR_MAX_COMPONENTS || (op != PWRMGR_UNIT_STOP && op != PWRMGR_UNIT_START))
+        return;
+    pthread_mutex_lock(&gStatsLock);
+    PwrMgr_Hist_Record(&gStats.component[comp][op], us);
+    pthread_mutex_unlock(&gStatsLock);
+}
+
+/**
+ *  @brief Copy the current statistics
+ */
+void PwrMgr_Stats_Get(PWRMGR_Stats *out)
+{
+    pthread_mutex_lock(&gStatsLock);
+    *out = gStats;
+    pthread_mutex_unlock(&gStatsLock);
+}
+
+static void PwrMgr_Stats_WriteHist(FILE *fp, const char *kind, const char *name, const PWRMGR_Histogram *hist)
+{
+    int i;
+
+    fprintf(fp, "%s %s count=%u sum_us=%llu max_us=%llu p50_us=%llu p99_us=%llu buckets=", kind, name, hist->count,
+            (unsigned long long)hist->sumUs, (unsigned long long)hist->maxUs,
+            (unsigned long long)PwrMgr_Hist_Percentile(hist, 50), (unsigned long long)PwrMgr_Hist_Percentile(hist, 99));
+    for (i = 0; i < PWRMGR_HIST_BUCKETS; i++)
+        fprintf(fp, "%s%u", i ? "," : "", hist->buckets[i]);
+    fprintf(fp, "\n");
+}
+
+/**
+ *  @brief Write every non-empty histogram to path, replacing it atomically
+ *  @return 0 on success, -1 on failure
+ */
+int PwrMgr_Stats_WriteFile(const char *path, const char *const *stateNames, const PWRMGR_CompGraph *graph)
+{
+    char tmpPath[128];
+    char name[2 * PWRMGR_COMP_NAME_LEN + 8];
+    PWRMGR_Stats stats;
+    FILE *fp;
+    int i, j;
+
+    PwrMgr_Stats_Get(&stats);
+
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+    fp = fopen(tmpPath, "w");
+    if (fp == NULL) {
+        PWRMGRLOG(ERROR, "%s: cannot write %s\n", __FUNCTION__, tmpPath);
+        return -1;
+    }
+
+    fprintf(fp, "# bucket upper bounds in ms:");
+    for (i = 0; i < PWRMGR_HIST_BUCKETS - 1; i++)
+        fprintf(fp, " %u", histLimitsMs[i]);
+    fprintf(fp, " inf\n");
+
+    for (i = 0; i < PWRMGR_PHASE_COUNT; i++)
+        PwrMgr_Stats_WriteHist(fp, "phase", phaseNames[i], &stats.phase[i]);
+
+    for (i = 0; i < PWRMGR_STATE_TOTAL; i++) {
+        for (j = 0; j < PWRMGR_STATE_TOTAL; j++) {
+            if (stats.edge[i][j].count == 0)
+                continue;
+            snprintf(name, sizeof(name), "%s->%s", stateNames[i], stateNames[j]);
+            PwrMgr_Stats_WriteHist(fp, "edge", name, &stats.edge[i][j]);
+        }
+    }
+
+    for (i = 0; graph != NULL && i < graph->count; i++) {
+        for (j = PWRMGR_UNIT_STOP; j <= PWRMGR_UNIT_START; j++) {
+            if (stats.component[i][j].count == 0)
+                continue;
+            snprintf(name, sizeof(name), "%s:%s", graph->comps[i].name, PwrMgr_UnitCtl_OpStr(j));
+            PwrMgr_Stats_WriteHist(fp, "component", name, &stats.component[i][j]);
+        }
+    }
+
+    fclose(fp);
+    return rename(tmpPath, path);
+}
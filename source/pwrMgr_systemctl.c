@@ -0,0 +1,247 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ *  @file pwrMgr_systemctl.c
+ *  @brief RDKB Power Manger systemctl unit controller
+ *
+ *  Fallback for builds without sd-bus, or when the system bus cannot be
+ *  reached. Every job runs "systemctl stop|start <unit>" for exactly the unit
+ *  the executor asked for, so the running set stays what it is told.
+ *
+ *  A submit spawns systemctl and returns without waiting for it, so the
+ *  units of a batch settle concurrently like they do over D-Bus. The child
+ *  exits once its job is done and wait reaps it, its exit status is the
+ *  result. Forgetting a job kills its child; systemd still finishes the job,
+ *  nobody waits for it any more.
+ */
+
+#include <errno.h>
+#include <signal.h>
+#include <spawn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "pwrMgr_log.h"
+#include "pwrMgr_unitctl.h"
+
+// How often wait checks on the children
+#define PWRMGR_SYSTEMCTL_POLL_MS 10
+
+extern char **environ;
+
+typedef struct
+{
+    char path[128];
+    pid_t pids[PWRMGR_UNIT_MAX_JOBS];
+    int jobIds[PWRMGR_UNIT_MAX_JOBS];
+    int count;
+} PWRMGR_SystemctlCtx;
+
+static long PwrMgr_Systemctl_NowMs()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+/**
+ *  @brief Start systemctl with args, without waiting for it
+ *  @return the pid of the child, -1 on failure
+ */
+static pid_t PwrMgr_Systemctl_Spawn(PWRMGR_SystemctlCtx *ctx, const char *arg1, const char *arg2, const char *arg3)
+{
+    char *argv[] = { ctx->path, (char *)arg1, (char *)arg2, (char *)arg3, NULL };
+    posix_spawnattr_t attr;
+    sigset_t none;
+    pid_t pid;
+    int rc;
+
+    // The daemon blocks the signals its signalfd reads, the child must not inherit that
+    sigemptyset(&none);
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setsigmask(&attr, &none);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+    rc = posix_spawnp(&pid, ctx->path, NULL, &attr, argv, environ);
+    posix_spawnattr_destroy(&attr);
+    if (rc != 0) {
+        PWRMGRLOG(ERROR, "%s: cannot run %s %s, %s\n", __FUNCTION__, ctx->path, arg1, strerror(rc));
+        return -1;
+    }
+    return pid;
+}
+
+/**
+ *  @brief Run systemctl with args and wait for it
+ *  @return its exit status, -1 if it could not be run or was killed
+ */
+static int PwrMgr_Systemctl_Run(PWRMGR_SystemctlCtx *ctx, const char *arg1, const char *arg2, const char *arg3)
+{
+    pid_t pid = PwrMgr_Systemctl_Spawn(ctx, arg1, arg2, arg3);
+    int status;
+
+    if (pid < 0)
+        return -1;
+    while (waitpid(pid, &status, 0) < 0)
+    {
+        if (errno != EINTR)
+            return -1;
+    }
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static void PwrMgr_Systemctl_Remove(PWRMGR_SystemctlCtx *ctx, int i)
+{
+    ctx->count--;
+    for (; i < ctx->count; i++)
+    {
+        ctx->pids[i] = ctx->pids[i + 1];
+        ctx->jobIds[i] = ctx->jobIds[i + 1];
+    }
+}
+
+static int PwrMgr_Systemctl_Submit(void *data, PWRMGR_UnitOp op, const char *unit, int jobId)
+{
+    PWRMGR_SystemctlCtx *ctx = (PWRMGR_SystemctlCtx *)data;
+    pid_t pid;
+
+    if (ctx->count >= PWRMGR_UNIT_MAX_JOBS)
+        return -1;
+
+    pid = PwrMgr_Systemctl_Spawn(ctx, PwrMgr_UnitCtl_OpStr(op), unit, NULL);
+    if (pid < 0)
+        return -1;
+    ctx->pids[ctx->count] = pid;
+    ctx->jobIds[ctx->count] = jobId;
+    ctx->count++;
+    return 0;
+}
+
+static int PwrMgr_Systemctl_Wait(void *data, int timeoutMs, int *jobId, PWRMGR_UnitJobResult *result)
+{
+    PWRMGR_SystemctlCtx *ctx = (PWRMGR_SystemctlCtx *)data;
+    long deadline = PwrMgr_Systemctl_NowMs() + timeoutMs;
+
+    if (ctx->count == 0)
+        return -1;
+
+    for (;;)
+    {
+        long remaining;
+        int i;
+
+        for (i = 0; i < ctx->count; i++)
+        {
+            int status = 0;
+            pid_t rc = waitpid(ctx->pids[i], &status, WNOHANG);
+
+            if (rc == 0 || (rc < 0 && errno == EINTR))
+                continue;
+            *jobId = ctx->jobIds[i];
+            *result = (rc > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0) ? PWRMGR_UNIT_JOB_DONE : PWRMGR_UNIT_JOB_FAILED;
+            if (*result != PWRMGR_UNIT_JOB_DONE)
+                PWRMGRLOG(ERROR, "%s: job %d of %s failed, status %d\n", __FUNCTION__, *jobId, ctx->path, status);
+            PwrMgr_Systemctl_Remove(ctx, i);
+            return 0;
+        }
+
+        remaining = deadline - PwrMgr_Systemctl_NowMs();
+        if (remaining <= 0)
+            return 1;
+        usleep((remaining < PWRMGR_SYSTEMCTL_POLL_MS ? remaining : PWRMGR_SYSTEMCTL_POLL_MS) * 1000);
+    }
+}
+
+static int PwrMgr_Systemctl_Active(void *data, const char *unit)
+{
+    int rc = PwrMgr_Systemctl_Run((PWRMGR_SystemctlCtx *)data, "is-active", "--quiet", unit);
+
+    if (rc < 0)
+        return -1;
+    return (rc == 0) ? 1 : 0;
+}
+
+static int PwrMgr_Systemctl_Kill(void *data, const char *unit, int signal)
+{
+    char arg[32];
+
+    snprintf(arg, sizeof(arg), "--signal=%d", signal);
+    return (PwrMgr_Systemctl_Run((PWRMGR_SystemctlCtx *)data, "kill", arg, unit) == 0) ? 0 : -1;
+}
+
+static int PwrMgr_Systemctl_Freeze(void *data, const char *unit)
+{
+    return (PwrMgr_Systemctl_Run((PWRMGR_SystemctlCtx *)data, "freeze", unit, NULL) == 0) ? 0 : -1;
+}
+
+static void PwrMgr_Systemctl_Forget(void *data, int jobId)
+{
+    PWRMGR_SystemctlCtx *ctx = (PWRMGR_SystemctlCtx *)data;
+    int i = 0;
+
+    while (i < ctx->count)
+    {
+        if (jobId >= 0 && ctx->jobIds[i] != jobId)
+        {
+            i++;
+            continue;
+        }
+        kill(ctx->pids[i], SIGKILL);
+        while (waitpid(ctx->pids[i], NULL, 0) < 0 && errno == EINTR)
+            ;
+        PwrMgr_Systemctl_Remove(ctx, i);
+    }
+}
+
+static void PwrMgr_Systemctl_Close(void *data)
+{
+    PwrMgr_Systemctl_Forget(data, -1);
+    free(data);
+}
+
+static const PWRMGR_UnitCtlOps systemctlOps = {
+    "systemctl",
+    PwrMgr_Systemctl_Submit,
+    PwrMgr_Systemctl_Wait,
+    PwrMgr_Systemctl_Close,
+    PwrMgr_Systemctl_Active,
+    PwrMgr_Systemctl_Kill,
+    PwrMgr_Systemctl_Freeze,
+    PwrMgr_Systemctl_Forget
+};
+
+/**
+ *  @brief Drive the units through the systemctl command, PWRMGR_SYSTEMCTL unless path is given
+ *  @return 0 on success, -1 on failure
+ */
+int PwrMgr_UnitCtl_OpenSystemctl(PWRMGR_UnitCtl *ctl, const char *path)
+{
+    PWRMGR_SystemctlCtx *ctx = (PWRMGR_SystemctlCtx *)calloc(1, sizeof(PWRMGR_SystemctlCtx));
+
+    if (ctx == NULL)
+        return -1;
+    snprintf(ctx->path, sizeof(ctx->path), "%s", path ? path : PWRMGR_SYSTEMCTL);
+    ctl->ops = &systemctlOps;
+    ctl->ctx = ctx;
+    return 0;
+}
@@ -0,0 +1,143 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+/**
+ *  @file pwrMgr_telemetry.c
+ *  @brief RDKB Power Manger shared memory telemetry, writer side
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include "pwrMgr_log.h"
+#include "pwrMgr_telemetry.h"
+
+static void PwrMgr_Telemetry_Begin(PWRMGR_TelemetryWriter *w)
+{
+    __atomic_store_n(&w->shm->seq, w->shm->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void PwrMgr_Telemetry_End(PWRMGR_TelemetryWriter *w)
+{
+    __atomic_store_n(&w->shm->seq, w->shm->seq + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ *  @brief Create the segment, readers see it once it is filled in
+ *
+ *  A segment left by an earlier instance is replaced, readers still holding
+ *  it keep the old copy until they attach again.
+ *  @return 0 on success
+ */
+int PwrMgr_Telemetry_Open(PWRMGR_TelemetryWriter *w, const char *name, const char *const *stateNames, int count)
+{
+    PWRMGR_Telemetry *shm;
+    void *p;
+    int i;
+
+    memset(w, 0, sizeof(*w));
+    w->fd = -1;
+    if (strlen(name) >= sizeof(w->name))
+        return -1;
+    strcpy(w->name, name);
+
+    shm_unlink(name);
+    w->fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (w->fd < 0 || ftruncate(w->fd, sizeof(PWRMGR_Telemetry)) != 0) {
+        PWRMGRLOG(ERROR, "%s: cannot create %s, %s\n", __FUNCTION__, name, strerror(errno));
+        PwrMgr_Telemetry_Close(w);
+        return -1;
+    }
+    p = mmap(NULL, sizeof(PWRMGR_Telemetry), PROT_READ | PROT_WRITE, MAP_SHARED, w->fd, 0);
+    if (p == MAP_FAILED) {
+        PwrMgr_Telemetry_Close(w);
+        return -1;
+    }
+    shm = (PWRMGR_Telemetry *)p;
+
+    // ftruncate zero filled it, so seq starts out even
+    shm->version = PWRMGR_TELEMETRY_VERSION;
+    shm->size = sizeof(PWRMGR_Telemetry);
+    shm->pid = (uint32_t)getpid();
+    shm->state = shm->target = -1;
+    for (i = 0; i < count && i < PWRMGR_TELEMETRY_STATES; i++)
+        snprintf(shm->stateNames[i], sizeof(shm->stateNames[i]), "%s", stateNames[i] ? stateNames[i] : "");
+    // The magic last: a reader that sees it sees the rest
+    __atomic_store_n(&shm->magic, PWRMGR_TELEMETRY_MAGIC, __ATOMIC_RELEASE);
+    w->shm = shm;
+    return 0;
+}
+
+/**
+ *  @brief Account the time since the last update and record the new state
+ */
+void PwrMgr_Telemetry_Update(PWRMGR_TelemetryWriter *w, int state, int target, uint32_t running, uint32_t savingMw, uint64_t nowMs)
+{
+    PWRMGR_Telemetry *shm = w->shm;
+    uint64_t elapsedMs;
+
+    if (shm == NULL || state < 0 || state >= PWRMGR_TELEMETRY_STATES)
+        return;
+
+    PwrMgr_Telemetry_Begin(w);
+    if (shm->state >= 0) {
+        elapsedMs = nowMs - shm->updatedMs;
+        shm->timeInStateMs[shm->state] += elapsedMs;
+        // mW times ms is uJ
+        shm->energySavedUj += (uint64_t)shm->savingMw * elapsedMs;
+    }
+    if (state != shm->state) {
+        if (shm->state >= 0)
+            shm->transitions++;
+        shm->entries[state]++;
+        shm->stateSinceMs = nowMs;
+    }
+    shm->state = state;
+    shm->target = target;
+    shm->running = running;
+    shm->savingMw = savingMw;
+    shm->updatedMs = nowMs;
+    PwrMgr_Telemetry_End(w);
+}
+
+/**
+ *  @brief Record the latency of the transition just published
+ */
+void PwrMgr_Telemetry_SetLatency(PWRMGR_TelemetryWriter *w, uint64_t latencyUs)
+{
+    if (w->shm == NULL)
+        return;
+    PwrMgr_Telemetry_Begin(w);
+    w->shm->lastLatencyUs = latencyUs;
+    PwrMgr_Telemetry_End(w);
+}
+
+/**
+ *  @brief Unmap the segment, it stays in place for the readers
+ */
+void PwrMgr_Telemetry_Close(PWRMGR_TelemetryWriter *w)
+{
+    if (w->shm != NULL)
+        munmap(w->shm, sizeof(PWRMGR_Telemetry));
+    if (w->fd >= 0)
+        close(w->fd);
+    w->shm = NULL;
+    w->fd = -1;
+}
@@ -0,0 +1,234 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ *  @file pwrMgr_thermal.c
+ *  @brief RDKB Power Manger thermal monitor
+ */
+
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "pwrMgr_log.h"
+#include "pwrMgr_loop.h"
+#include "pwrMgr_thermal.h"
+
+/**
+ *  @brief Defaults: ThermalWarm at 85C, ThermalHot at 95C, ThermalCritical at 105C
+ */
+void PwrMgr_Thermal_DefaultConfig(PWRMGR_ThermalConfig *cfg)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    snprintf(cfg->root, sizeof(cfg->root), "%s", PWRMGR_THERMAL_ROOT);
+    cfg->trips[0].onMilliC = 85000;
+    cfg->trips[0].offMilliC = 80000;
+    cfg->trips[0].state = PWRMGR_STATE_WARM;
+    cfg->trips[1].onMilliC = 95000;
+    cfg->trips[1].offMilliC = 88000;
+    cfg->trips[1].state = PWRMGR_STATE_HOT;
+    cfg->trips[2].onMilliC = 105000;
+    cfg->trips[2].offMilliC = 98000;
+    cfg->trips[2].state = PWRMGR_STATE_CRITICAL;
+    cfg->tripCount = 3;
+    cfg->clearState = PWRMGR_STATE_COOLED;
+    cfg->slowMs = 10000;
+    cfg->fastMs = 1000;
+    cfg->marginMilliC = 5000;
+}
+
+/**
+ *  @brief Trip level after a sample, from the level before it
+ *  @return number of trips active, 0 when clear
+ */
+int PwrMgr_Thermal_Level(const PWRMGR_ThermalConfig *cfg, int level, int milliC)
+{
+    int next = level;
+
+    while (next < cfg->tripCount && milliC >= cfg->trips[next].onMilliC)
+        next++;
+    if (next == level && level > 0 && milliC < cfg->trips[level - 1].offMilliC)
+        next--;
+    return next;
+}
+
+/**
+ *  @brief Power state requested at a trip level
+ */
+PWRMGR_PwrState PwrMgr_Thermal_LevelState(const PWRMGR_ThermalConfig *cfg, int level)
+{
+    return (level > 0) ? cfg->trips[level - 1].state : cfg->clearState;
+}
+
+/**
+ *  @brief Open the temp file of every thermal zone under the configured root
+ *  @return 0 on success, -1 if there is no readable zone
+ */
+int PwrMgr_Thermal_Open(PWRMGR_ThermalMonitor *mon, const PWRMGR_ThermalConfig *cfg, PWRMGR_ThermalFn notify, void *ctx)
+{
+    char path[256];
+    struct dirent *entry;
+    DIR *dir;
+
+    memset(mon, 0, sizeof(*mon));
+    mon->cfg = *cfg;
+    mon->notify = notify;
+    mon->ctx = ctx;
+    mon->timerFd = -1;
+
+    dir = opendir(cfg->root);
+    if (dir == NULL) {
+        PWRMGRLOG(WARNING, "%s: cannot open %s\n", __FUNCTION__, cfg->root);
+        return -1;
+    }
+    while ((entry = readdir(dir)) != NULL && mon->zoneCount < PWRMGR_THERMAL_MAX_ZONES) {
+        int fd;
+
+        if (strncmp(entry->d_name, "thermal_zone", 12) != 0)
+            continue;
+        snprintf(path, sizeof(path), "%s/%s/temp", cfg->root, entry->d_name);
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd >= 0)
+            mon->zoneFds[mon->zoneCount++] = fd;
+    }
+    closedir(dir);
+
+    if (mon->zoneCount == 0) {
+        PWRMGRLOG(WARNING, "%s: no thermal zones under %s\n", __FUNCTION__, cfg->root);
+        return -1;
+    }
+
+    mon->timerFd = PwrMgr_Loop_TimerFd();
+    if (mon->timerFd < 0) {
+        PWRMGRLOG(ERROR, "%s: timerfd_create failed, %s\n", __FUNCTION__, strerror(errno));
+        PwrMgr_Thermal_Close(mon);
+        return -1;
+    }
+    mon->intervalMs = cfg->slowMs;
+    PwrMgr_Loop_Arm(mon->timerFd, 0);
+
+    PWRMGRLOG(INFO, "%s: monitoring %d thermal zone(s) under %s\n", __FUNCTION__, mon->zoneCount, cfg->root);
+    return 0;
+}
+
+/**
+ *  @brief Timer descriptor, readable when the next sample is due
+ */
+int PwrMgr_Thermal_Fd(PWRMGR_ThermalMonitor *mon)
+{
+    return mon->timerFd;
+}
+
+/**
+ *  @brief Hottest zone in millidegrees C
+ *  @return 0 on success, -1 if no zone could be read
+ */
+static int PwrMgr_Thermal_Read(PWRMGR_ThermalMonitor *mon, int *milliC)
+{
+    char buf[32];
+    bool found = false;
+    int i;
+
+    for (i = 0; i < mon->zoneCount; i++) {
+        ssize_t len = pread(mon->zoneFds[i], buf, sizeof(buf) - 1, 0);
+        char *end;
+        long value;
+
+        if (len <= 0)
+            continue;
+        buf[len] = '\0';
+        value = strtol(buf, &end, 10);
+        if (end == buf)
+            continue;
+        if (!found || value > *milliC)
+            *milliC = (int)value;
+        found = true;
+    }
+    return found ? 0 : -1;
+}
+
+/**
+ *  @brief Take one sample, notify on a trip level change
+ *  @return milliseconds until the next sample
+ */
+int PwrMgr_Thermal_Sample(PWRMGR_ThermalMonitor *mon)
+{
+    const PWRMGR_ThermalConfig *cfg = &mon->cfg;
+    int milliC = 0;
+    int level;
+
+    if (PwrMgr_Thermal_Read(mon, &milliC) != 0) {
+        PWRMGRLOG(WARNING, "%s: no thermal zone readable\n", __FUNCTION__);
+        mon->intervalMs = cfg->slowMs;
+        return mon->intervalMs;
+    }
+    mon->samples++;
+    mon->lastMilliC = milliC;
+
+    level = PwrMgr_Thermal_Level(cfg, mon->level, milliC);
+    if (level != mon->level) {
+        PWRMGR_PwrState state = PwrMgr_Thermal_LevelState(cfg, level);
+
+        PWRMGRLOG(INFO, "%s: %d mC, thermal level %d -> %d\n", __FUNCTION__, milliC, mon->level, level);
+        mon->level = level;
+        if (mon->notify)
+            mon->notify(mon->ctx, state, milliC);
+    }
+
+    if (level > 0 || (level < cfg->tripCount && milliC >= cfg->trips[level].onMilliC - cfg->marginMilliC))
+        mon->intervalMs = cfg->fastMs;
+    else
+        mon->intervalMs = cfg->slowMs;
+    return mon->intervalMs;
+}
+
+/**
+ *  @brief Handle the timer descriptor becoming readable
+ *  @return 0
+ */
+int PwrMgr_Thermal_Dispatch(PWRMGR_ThermalMonitor *mon)
+{
+    uint64_t expirations;
+
+    if (read(mon->timerFd, &expirations, sizeof(expirations)) != sizeof(expirations))
+        return 0;
+    PwrMgr_Loop_Arm(mon->timerFd, PwrMgr_Thermal_Sample(mon));
+    return 0;
+}
+
+/**
+ *  @brief Close every descriptor of the monitor
+ */
+void PwrMgr_Thermal_Close(PWRMGR_ThermalMonitor *mon)
+{
+    int i;
+
+    for (i = 0; i < mon->zoneCount; i++)
+        close(mon->zoneFds[i]);
+    mon->zoneCount = 0;
+    if (mon->timerFd >= 0)
+        close(mon->timerFd);
+    mon->timerFd = -1;
+}
@@ -0,0 +1,195 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ *  @file pwrMgr_unitctl.c
+ *  @brief RDKB Power Manger unit controller
+ *
+ *  Backend independent part of the unit controller. A batch submits every job
+ *  first and only then waits, so the time spent is the slowest unit rather
+ *  than the sum of all of them.
+ */
+
+#include <string.h>
+#include <time.h>
+#include "pwrMgr_log.h"
+#include "pwrMgr_unitctl.h"
+
+static long PwrMgr_UnitCtl_NowMs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ *  @brief Name of a unit operation
+ *  @return "stop" or "start"
+ */
+const char *PwrMgr_UnitCtl_OpStr(PWRMGR_UnitOp op)
+{
+    return (op == PWRMGR_UNIT_START) ? "start" : "stop";
+}
+
+/**
+ *  @brief Queue a single unit job without waiting for it
+ *  @return 0 on success, -1 on failure
+ */
+int PwrMgr_UnitCtl_Submit(PWRMGR_UnitCtl *ctl, PWRMGR_UnitOp op, const char *unit, int jobId)
+{
+    if (ctl == NULL || ctl->ops == NULL || unit == NULL)
+        return -1;
+
+    return ctl->ops->submit(ctl->ctx, op, unit, jobId);
+}
+
+/**
+ *  @brief Wait for the next submitted job to finish
+ *  @return 0 on completion, 1 on timeout, -1 on error
+ */
+int PwrMgr_UnitCtl_Wait(PWRMGR_UnitCtl *ctl, int timeoutMs, int *jobId, PWRMGR_UnitJobResult *result)
+{
+    if (ctl == NULL || ctl->ops == NULL)
+        return -1;
+
+    return ctl->ops->wait(ctl->ctx, timeoutMs, jobId, result);
+}
+
+/**
+ *  @brief Ask the backend whether a unit is active
+ *  @return 1 if active, 0 if not yet, -1 if the backend cannot tell
+ */
+int PwrMgr_UnitCtl_IsActive(PWRMGR_UnitCtl *ctl, const char *unit)
+{
+    if (ctl == NULL || ctl->ops == NULL || ctl->ops->active == NULL || unit == NULL)
+        return -1;
+
+    return ctl->ops->active(ctl->ctx, unit);
+}
+
+/**
+ *  @brief Send a signal to every process of a unit
+ *  @return 0 on success, -1 on failure or if the backend cannot
+ */
+int PwrMgr_UnitCtl_Kill(PWRMGR_UnitCtl *ctl, const char *unit, int signal)
+{
+    if (ctl == NULL || ctl->ops == NULL || ctl->ops->kill == NULL || unit == NULL)
+        return -1;
+
+    return ctl->ops->kill(ctl->ctx, unit, signal);
+}
+
+/**
+ *  @brief Freeze every process of a unit where it stands
+ *  @return 0 on success, -1 on failure or if the backend cannot
+ */
+int PwrMgr_UnitCtl_Freeze(PWRMGR_UnitCtl *ctl, const char *unit)
+{
+    if (ctl == NULL || ctl->ops == NULL || ctl->ops->freeze == NULL || unit == NULL)
+        return -1;
+
+    return ctl->ops->freeze(ctl->ctx, unit);
+}
+
+/**
+ *  @brief Drop a job that will not be waited for, -1 drops every pending job
+ */
+void PwrMgr_UnitCtl_Forget(PWRMGR_UnitCtl *ctl, int jobId)
+{
+    if (ctl != NULL && ctl->ops != NULL && ctl->ops->forget != NULL)
+        ctl->ops->forget(ctl->ctx, jobId);
+}
+
+/**
+ *  @brief Stop or start a set of units concurrently and wait for all of them
+ *  @return 0 if every job finished successfully, -1 otherwise
+ */
+int PwrMgr_UnitCtl_RunBatch(PWRMGR_UnitCtl *ctl, PWRMGR_UnitOp op, const char **units, int count, int timeoutMs, PWRMGR_UnitJobResult *results)
+{
+    int pending = 0;
+    int status = 0;
+    int i;
+    long deadline;
+
+    if (ctl == NULL || ctl->ops == NULL || count < 0 || count > PWRMGR_UNIT_MAX_JOBS)
+        return -1;
+
+    for (i = 0; i < count; i++)
+    {
+        results[i] = PWRMGR_UNIT_JOB_TIMEOUT;
+        if (PwrMgr_UnitCtl_Submit(ctl, op, units[i], i) == 0)
+        {
+            pending++;
+        }
+        else
+        {
+            PWRMGRLOG(ERROR, "%s: %s failed to %s %s\n", __FUNCTION__, ctl->ops->name, PwrMgr_UnitCtl_OpStr(op), units[i]);
+            results[i] = PWRMGR_UNIT_JOB_FAILED;
+            status = -1;
+        }
+    }
+
+    deadline = PwrMgr_UnitCtl_NowMs() + timeoutMs;
+    while (pending > 0)
+    {
+        int jobId = -1;
+        PWRMGR_UnitJobResult result = PWRMGR_UNIT_JOB_FAILED;
+        long remaining = deadline - PwrMgr_UnitCtl_NowMs();
+        int rc;
+
+        if (remaining < 0)
+            remaining = 0;
+
+        rc = PwrMgr_UnitCtl_Wait(ctl, (int)remaining, &jobId, &result);
+        if (rc != 0)
+        {
+            PWRMGRLOG(ERROR, "%s: %s %d job(s) did not finish (%s)\n", __FUNCTION__, ctl->ops->name, pending, rc > 0 ? "timeout" : "error");
+            PwrMgr_UnitCtl_Forget(ctl, -1);
+            status = -1;
+            break;
+        }
+
+        if (jobId < 0 || jobId >= count)
+            continue;
+
+        results[jobId] = result;
+        pending--;
+        if (result != PWRMGR_UNIT_JOB_DONE)
+        {
+            PWRMGRLOG(ERROR, "%s: %s %s failed\n", __FUNCTION__, PwrMgr_UnitCtl_OpStr(op), units[jobId]);
+            status = -1;
+        }
+    }
+
+    return status;
+}
+
+/**
+ *  @brief Release the backend
+ */
+void PwrMgr_UnitCtl_Close(PWRMGR_UnitCtl *ctl)
+{
+    if (ctl != NULL && ctl->ops != NULL)
+    {
+        if (ctl->ops->close)
+            ctl->ops->close(ctl->ctx);
+        ctl->ops = NULL;
+        ctl->ctx = NULL;
+    }
+}
@@ -0,0 +1,275 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ *  @file pwrMgr_wifi.c
+ *  @brief RDKB Power Manger Wi-Fi actuator
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "pwrMgr_log.h"
+#include "pwrMgr_baseline.h"
+#include "pwrMgr_wifi.h"
+
+static const char *wifiBandNames[PWRMGR_WIFI_BAND_TOTAL] = {
+    [PWRMGR_WIFI_BAND_2G] = "2.4GHz",
+    [PWRMGR_WIFI_BAND_5G] = "5GHz",
+    [PWRMGR_WIFI_BAND_6G] = "6GHz",
+};
+
+/**
+ *  @brief One line of the baseline file: radio<n> <band> <enabled> <tx power %> <streams>
+ *  @return the radio it covers, -1 to skip it
+ */
+static int PwrMgr_Wifi_ParseBaseline(void *ctx, const char *line)
+{
+    PWRMGR_WifiActuator *act = ctx;
+    int radio, band, enabled, txPowerPercent, streams;
+
+    if (sscanf(line, "radio%d %d %d %d %d", &radio, &band, &enabled, &txPowerPercent, &streams) != 5 ||
+        radio < 0 || radio >= act->count || band < 0 || band >= PWRMGR_WIFI_BAND_TOTAL)
+        return -1;
+    act->baseline[radio].band = band;
+    act->baseline[radio].enabled = (enabled != 0);
+    act->baseline[radio].txPowerPercent = txPowerPercent;
+    act->baseline[radio].streams = streams;
+    return radio;
+}
+
+static void PwrMgr_Wifi_FormatBaseline(const void *ctx, int radio, char *buf, int len)
+{
+    const PWRMGR_WifiRadio *r = &((const PWRMGR_WifiActuator *)ctx)->baseline[radio];
+
+    snprintf(buf, len, "radio%d %d %d %d %d\n", radio, r->band, r->enabled, r->txPowerPercent, r->streams);
+}
+
+/**
+ *  @brief Default profiles: transmit power first, then streams, then bands
+ */
+void PwrMgr_Wifi_DefaultProfiles(PWRMGR_WifiProfile profiles[PWRMGR_STATE_TOTAL])
+{
+    memset(profiles, 0, sizeof(PWRMGR_WifiProfile) * PWRMGR_STATE_TOTAL);
+    profiles[PWRMGR_STATE_WARM].txPowerPercent = 75;
+    profiles[PWRMGR_STATE_HOT].txPowerPercent = 50;
+    profiles[PWRMGR_STATE_HOT].maxStreams = 2;
+    profiles[PWRMGR_STATE_HOT].bandsOff = PWRMGR_WIFI_BAND_BIT(PWRMGR_WIFI_BAND_6G);
+    profiles[PWRMGR_STATE_CRITICAL].txPowerPercent = 25;
+    profiles[PWRMGR_STATE_CRITICAL].maxStreams = 1;
+    profiles[PWRMGR_STATE_CRITICAL].bandsOff = PWRMGR_WIFI_BAND_BIT(PWRMGR_WIFI_BAND_5G) | PWRMGR_WIFI_BAND_BIT(PWRMGR_WIFI_BAND_6G);
+#if defined (_XBB1_SUPPORTED_)
+    profiles[PWRMGR_STATE_BATT].txPowerPercent = 50;
+    profiles[PWRMGR_STATE_BATT].maxStreams = 2;
+    profiles[PWRMGR_STATE_BATT].bandsOff = PWRMGR_WIFI_BAND_BIT(PWRMGR_WIFI_BAND_6G);
+#endif
+}
+
+/**
+ *  @brief Parse a list of bands to disable such as "5GHz,6GHz", "" or "none" for none
+ *  @return 0 on success, -1 for an unknown band or 2.4 GHz
+ */
+int PwrMgr_Wifi_ParseBands(const char *list, unsigned *bands)
+{
+    char buf[64];
+    char *save = NULL;
+    char *tok;
+
+    *bands = 0;
+    snprintf(buf, sizeof(buf), "%s", list);
+    for (tok = strtok_r(buf, ", \t", &save); tok != NULL; tok = strtok_r(NULL, ", \t", &save)) {
+        if (strcasecmp(tok, "none") == 0)
+            continue;
+        if (strcasecmp(tok, "5") == 0 || strcasecmp(tok, "5G") == 0 || strcasecmp(tok, "5GHz") == 0)
+            *bands |= PWRMGR_WIFI_BAND_BIT(PWRMGR_WIFI_BAND_5G);
+        else if (strcasecmp(tok, "6") == 0 || strcasecmp(tok, "6G") == 0 || strcasecmp(tok, "6GHz") == 0)
+            *bands |= PWRMGR_WIFI_BAND_BIT(PWRMGR_WIFI_BAND_6G);
+        else
+            return -1;
+    }
+    return 0;
+}
+
+/**
+ *  @brief Find the radios behind ops and establish their baseline
+ *  @return 0 on success, -1 without any radio
+ */
+int PwrMgr_Wifi_Open(PWRMGR_WifiActuator *act, const PWRMGR_WifiOps *ops, void *ctx, const char *baselinePath)
+{
+    int i;
+
+    memset(act, 0, sizeof(*act));
+    act->ops = ops;
+    act->ctx = ctx;
+    PwrMgr_Wifi_DefaultProfiles(act->profiles);
+
+    act->count = ops->count(ctx);
+    if (act->count > PWRMGR_WIFI_MAX_RADIOS)
+        act->count = PWRMGR_WIFI_MAX_RADIOS;
+    if (act->count <= 0) {
+        PWRMGRLOG(WARNING, "%s: no radios\n", __FUNCTION__);
+        act->count = 0;
+        return -1;
+    }
+    for (i = 0; i < act->count; i++) {
+        if (ops->read(ctx, i, &act->current[i]) != 0) {
+            PWRMGRLOG(WARNING, "%s: cannot read radio %d\n", __FUNCTION__, i);
+            return -1;
+        }
+    }
+
+    // Settings an earlier instance left degraded are not the baseline
+    if (PwrMgr_Baseline_Load(baselinePath, act->count, PwrMgr_Wifi_ParseBaseline, act) != 0) {
+        memcpy(act->baseline, act->current, sizeof(act->baseline));
+        if (PwrMgr_Baseline_Save(baselinePath, act->count, PwrMgr_Wifi_FormatBaseline, act) != 0)
+            PWRMGRLOG(WARNING, "%s: cannot save %s\n", __FUNCTION__, baselinePath);
+    }
+    return 0;
+}
+
+/**
+ *  @brief Replace the profile of a state, takes effect on the next apply
+ */
+void PwrMgr_Wifi_SetProfile(PWRMGR_WifiActuator *act, PWRMGR_PwrState state, const PWRMGR_WifiProfile *profile)
+{
+    if (state > PWRMGR_STATE_UNKNOWN && state < PWRMGR_STATE_TOTAL)
+        act->profiles[state] = *profile;
+}
+
+/**
+ *  @brief Write the settings of a radio if they differ from what it has
+ *
+ *  Until the first apply, and after a reset, what it has is not known.
+ *  @return 0 on success
+ */
+static int PwrMgr_Wifi_Write(PWRMGR_WifiActuator *act, int i, const PWRMGR_WifiRadio *want)
+{
+    PWRMGR_WifiRadio *cur = &act->current[i];
+
+    if (act->applied && cur->enabled == want->enabled &&
+        cur->txPowerPercent == want->txPowerPercent && cur->streams == want->streams)
+        return 0;
+    act->writes++;
+    if (act->ops->write(act->ctx, i, want) != 0) {
+        PWRMGRLOG(ERROR, "%s: cannot set up the %s radio %d\n", __FUNCTION__, wifiBandNames[cur->band], i);
+        return -1;
+    }
+    *cur = *want;
+    return 0;
+}
+
+/**
+ *  @brief Bring the radios in line with the profile of state
+ *  @return 0 on success, -1 if some radio could not be set up
+ */
+int PwrMgr_Wifi_Apply(PWRMGR_WifiActuator *act, PWRMGR_PwrState state)
+{
+    return PwrMgr_Wifi_ApplyStates(act, &state, 1);
+}
+
+/**
+ *  @brief Merge the profiles of states, the most restrictive setting of each field wins
+ */
+static void PwrMgr_Wifi_Merge(const PWRMGR_WifiActuator *act, const PWRMGR_PwrState *states, int count, PWRMGR_WifiProfile *merged)
+{
+    int i;
+
+    memset(merged, 0, sizeof(*merged));
+    for (i = 0; i < count; i++) {
+        const PWRMGR_WifiProfile *p = &act->profiles[states[i]];
+
+        if (p->txPowerPercent > 0 && (merged->txPowerPercent == 0 || p->txPowerPercent < merged->txPowerPercent))
+            merged->txPowerPercent = p->txPowerPercent;
+        if (p->maxStreams > 0 && (merged->maxStreams == 0 || p->maxStreams < merged->maxStreams))
+            merged->maxStreams = p->maxStreams;
+        merged->bandsOff |= p->bandsOff;
+    }
+}
+
+/**
+ *  @brief Bring the radios in line with the merged profiles of states, one per axis
+ *
+ *  Radios coming back are enabled and set up first, radios being disabled
+ *  go last so their clients can move to the bands that stay. Nothing is
+ *  written when the merged profile is the one already applied.
+ *  @return 0 on success, -1 if some radio could not be set up
+ */
+int PwrMgr_Wifi_ApplyStates(PWRMGR_WifiActuator *act, const PWRMGR_PwrState *states, int count)
+{
+    PWRMGR_WifiRadio want[PWRMGR_WIFI_MAX_RADIOS];
+    PWRMGR_WifiProfile merged;
+    const PWRMGR_WifiProfile *p = &merged;
+    int enabled = 0;
+    int status = 0;
+    int i;
+
+    if (count <= 0)
+        return -1;
+    for (i = 0; i < count; i++) {
+        if (states[i] <= PWRMGR_STATE_UNKNOWN || states[i] >= PWRMGR_STATE_TOTAL)
+            return -1;
+    }
+    PwrMgr_Wifi_Merge(act, states, count, &merged);
+    if (act->applied && memcmp(&merged, &act->last, sizeof(merged)) == 0)
+        return 0;
+
+    for (i = 0; i < act->count; i++) {
+        const PWRMGR_WifiRadio *base = &act->baseline[i];
+
+        want[i] = *base;
+        if (base->band != PWRMGR_WIFI_BAND_2G && (p->bandsOff & PWRMGR_WIFI_BAND_BIT(base->band))) {
+            // Left as they are, a disabled radio does not transmit
+            want[i] = act->current[i];
+            want[i].enabled = false;
+            continue;
+        }
+        if (p->txPowerPercent > 0) {
+            want[i].txPowerPercent = base->txPowerPercent * p->txPowerPercent / 100;
+            if (want[i].txPowerPercent < 1)
+                want[i].txPowerPercent = 1;
+        }
+        if (p->maxStreams > 0 && base->streams > p->maxStreams)
+            want[i].streams = p->maxStreams;
+        enabled += want[i].enabled;
+    }
+
+    for (i = 0; i < act->count; i++) {
+        if (want[i].enabled && PwrMgr_Wifi_Write(act, i, &want[i]) != 0)
+            status = -1;
+    }
+    for (i = 0; i < act->count; i++) {
+        if (!want[i].enabled && PwrMgr_Wifi_Write(act, i, &want[i]) != 0)
+            status = -1;
+    }
+
+    act->last = merged;
+    act->applied = true;
+    PWRMGRLOG(INFO, "%s: %d of %d radios enabled, transmit power %d%%, streams %s\n", __FUNCTION__, enabled, act->count,
+              p->txPowerPercent ? p->txPowerPercent : 100, p->maxStreams ? "capped" : "unchanged");
+    return status;
+}
+
+/**
+ *  @brief The Wi-Fi agent went away, the next apply writes every radio again
+ */
+void PwrMgr_Wifi_Reset(PWRMGR_WifiActuator *act)
+{
+    act->applied = false;
+}
@@ -0,0 +1,102 @@
+/*
+ * If not stated otherwise in this file or this component's Licenses.txt file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2016 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ *  @file pwrMgr_wifihal.c
+ *  @brief RDKB Power Manger wifi_hal backend of the Wi-Fi actuator
+ *
+ *  Uses the radio calls of wifi_hal the TR-181 Device.WiFi.Radio objects
+ *  map to: TransmitPower is a percentage, the chain masks are set as a
+ *  number of streams. The Wi-Fi agent keeps its own configuration, so the
+ *  radios come back with it whenever the agent restarts.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "wifi_hal.h"
+#include "pwrMgr_log.h"
+#include "pwrMgr_wifi.h"
+
+static int PwrMgr_WifiHal_Count(void *ctx)
+{
+    ULONG count = 0;
+
+    (void)ctx;
+    if (wifi_getRadioNumberOfEntries(&count) != RETURN_OK)
+        return -1;
+    return (int)count;
+}
+
+static int PwrMgr_WifiHal_Read(void *ctx, int radio, PWRMGR_WifiRadio *settings)
+{
+    CHAR band[64] = "";
+    BOOL enabled = 0;
+    ULONG txPower = 0;
+    INT streams = 0;
+
+    (void)ctx;
+    if (wifi_getRadioOperatingFrequencyBand(radio, band) != RETURN_OK ||
+        wifi_getRadioEnable(radio, &enabled) != RETURN_OK ||
+        wifi_getRadioPercentageTransmitPower(radio, &txPower) != RETURN_OK ||
+        wifi_getRadioTxChainMask(radio, &streams) != RETURN_OK) {
+        PWRMGRLOG(ERROR, "%s: cannot read radio %d\n", __FUNCTION__, radio);
+        return -1;
+    }
+
+    // "2.4GHz", "5GHz" or "6GHz"
+    if (strchr(band, '6') != NULL)
+        settings->band = PWRMGR_WIFI_BAND_6G;
+    else if (strchr(band, '5') != NULL)
+        settings->band = PWRMGR_WIFI_BAND_5G;
+    else
+        settings->band = PWRMGR_WIFI_BAND_2G;
+    settings->enabled = enabled;
+    settings->txPowerPercent = (int)txPower;
+    settings->streams = streams;
+    return 0;
+}
+
+static int PwrMgr_WifiHal_Write(void *ctx, int radio, const PWRMGR_WifiRadio *settings)
+{
+    (void)ctx;
+    // A radio is set up before it is enabled again
+    if (settings->enabled &&
+        (wifi_setRadioTransmitPower(radio, (ULONG)settings->txPowerPercent) != RETURN_OK ||
+         wifi_setRadioTxChainMask(radio, settings->streams) != RETURN_OK ||
+         wifi_setRadioRxChainMask(radio, settings->streams) != RETURN_OK))
+        return -1;
+    if (wifi_setRadioEnable(radio, settings->enabled) != RETURN_OK)
+        return -1;
+    return (wifi_applyRadioSettings(radio) == RETURN_OK) ? 0 : -1;
+}
+
+static const PWRMGR_WifiOps pwrMgrWifiHalOps = {
+    PwrMgr_WifiHal_Count,
+    PwrMgr_WifiHal_Read,
+    PwrMgr_WifiHal_Write,
+};
+
+/**
+ *  @brief Open the Wi-Fi actuator on wifi_hal
+ *  @return 0 on success, -1 if the radios cannot be read
+ */
+int PwrMgr_Wifi_OpenHal(PWRMGR_WifiActuator *act, const char *baselinePath)
+{
+    return PwrMgr_Wifi_Open(act, &pwrMgrWifiHalOps, NULL, baselinePath);
+}
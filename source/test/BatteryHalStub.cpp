@@ -0,0 +1,53 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "BatteryHalStub.h"
+
+const PWRMGR_BatteryOps BatteryHalStub::stubOps = {
+    BatteryHalStub::read
+};
+
+BatteryHalStub::BatteryHalStub(long capacityMah, const std::vector<int> &loadMaPerLevel)
+    : capacityMah(capacityMah), chargeMah(capacityMah), loadMa(loadMaPerLevel), lastLevel(0),
+      onBattery(false), failing(false), gaugeEstimate(true)
+{
+}
+
+bool BatteryHalStub::discharge(long ms, int level)
+{
+    lastLevel = (level < (int)loadMa.size()) ? level : (int)loadMa.size() - 1;
+    if (onBattery)
+        chargeMah -= loadMa[lastLevel] * (double)ms / 3600000.0;
+    if (chargeMah < 0)
+        chargeMah = 0;
+    return chargeMah > 0;
+}
+
+int BatteryHalStub::read(void *ctx, PWRMGR_BatteryReading *reading)
+{
+    BatteryHalStub *self = static_cast<BatteryHalStub *>(ctx);
+
+    if (self->failing)
+        return -1;
+    reading->onBattery = self->onBattery;
+    reading->chargeMah = (long)self->chargeMah;
+    reading->capacityMah = self->capacityMah;
+    reading->minutes = self->gaugeEstimate ? (long)(self->chargeMah * 60 / self->loadMa[self->lastLevel]) : -1;
+    return 0;
+}
@@ -0,0 +1,57 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef _BATTERY_HAL_STUB_H_
+#define _BATTERY_HAL_STUB_H_
+
+#include <vector>
+#include "pwrMgr_battery.h"
+
+// Simulated mta battery: discharges at a load that depends on the shedding
+// level, the gauge estimate assumes the current load stays as it is.
+class BatteryHalStub
+{
+public:
+    BatteryHalStub(long capacityMah, const std::vector<int> &loadMaPerLevel);
+
+    void setOnBattery(bool on) { onBattery = on; }
+    void setFailing(bool fail) { failing = fail; }
+    void setGaugeEstimate(bool on) { gaugeEstimate = on; }
+    // Drain for ms at the load of level, returns false once empty
+    bool discharge(long ms, int level);
+
+    const PWRMGR_BatteryOps *ops() const { return &stubOps; }
+    void *ctx() { return this; }
+    double charge() const { return chargeMah; }
+
+private:
+    static int read(void *ctx, PWRMGR_BatteryReading *reading);
+
+    static const PWRMGR_BatteryOps stubOps;
+
+    long capacityMah;
+    double chargeMah;
+    std::vector<int> loadMa;
+    int lastLevel;
+    bool onBattery;
+    bool failing;
+    bool gaugeEstimate;
+};
+
+#endif
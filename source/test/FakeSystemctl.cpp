@@ -0,0 +1,87 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <fstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include "FakeSystemctl.h"
+
+FakeSystemctl::FakeSystemctl()
+{
+    char tmpl[] = "/tmp/pwrMgrSystemctlXXXXXX";
+
+    if (mkdtemp(tmpl) != NULL)
+        dir = tmpl;
+    script = dir + "/systemctl";
+    writeFile("systemctl", "#!/bin/sh\n"
+                           "dir=$(dirname \"$0\")\n"
+                           "echo \"systemctl $*\" >> \"$dir/log\"\n"
+                           "for unit; do :; done\n"
+                           "[ -e \"$dir/hang.$unit\" ] && exec sleep 3600\n"
+                           "[ -e \"$dir/delay.$unit\" ] && sleep \"$(cat \"$dir/delay.$unit\")\"\n"
+                           "[ -e \"$dir/fail.$unit\" ] && exit 1\n"
+                           "exit 0\n");
+    chmod(script.c_str(), 0755);
+}
+
+FakeSystemctl::~FakeSystemctl()
+{
+    std::string cmd = "rm -rf " + dir;
+
+    if (!dir.empty() && system(cmd.c_str()) != 0)
+        perror(cmd.c_str());
+}
+
+void FakeSystemctl::setDelay(const std::string &unit, int ms)
+{
+    if (ms < 0)
+        writeFile("hang." + unit, "");
+    else
+        writeFile("delay." + unit, std::to_string(ms / 1000.0));
+}
+
+void FakeSystemctl::setFailing(const std::string &unit)
+{
+    writeFile("fail." + unit, "");
+}
+
+std::vector<std::string> FakeSystemctl::commands() const
+{
+    std::vector<std::string> lines;
+    std::ifstream log(dir + "/log");
+    std::string line;
+
+    while (std::getline(log, line))
+        lines.push_back(line);
+    return lines;
+}
+
+void FakeSystemctl::reset()
+{
+    std::string cmd = "rm -f " + dir + "/log " + dir + "/hang.* " + dir + "/delay.* " + dir + "/fail.*";
+
+    if (system(cmd.c_str()) != 0)
+        perror(cmd.c_str());
+}
+
+void FakeSystemctl::writeFile(const std::string &name, const std::string &value)
+{
+    std::ofstream(dir + "/" + name) << value;
+}
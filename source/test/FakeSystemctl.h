@@ -0,0 +1,52 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef _FAKE_SYSTEMCTL_H_
+#define _FAKE_SYSTEMCTL_H_
+
+#include <string>
+#include <vector>
+
+// A systemctl in a temporary directory that logs its command line. Its
+// jobs finish at once unless told otherwise, like a real one would for an
+// idle unit.
+class FakeSystemctl
+{
+public:
+    FakeSystemctl();
+    ~FakeSystemctl();
+
+    // Jobs on unit take ms, or never finish when negative
+    void setDelay(const std::string &unit, int ms);
+    // Every command on unit fails, is-active reports it inactive
+    void setFailing(const std::string &unit);
+    // Command lines in the order they were run, as "systemctl <args>"
+    std::vector<std::string> commands() const;
+    void reset();
+
+    const char *path() const { return script.c_str(); }
+
+private:
+    void writeFile(const std::string &name, const std::string &value);
+
+    std::string dir;
+    std::string script;
+};
+
+#endif
@@ -0,0 +1,141 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <csignal>
+#include <thread>
+#include "MockUnitCtl.h"
+
+const PWRMGR_UnitCtlOps MockUnitCtl::mockOps = {
+    "mock",
+    MockUnitCtl::submit,
+    MockUnitCtl::wait,
+    NULL,
+    MockUnitCtl::active,
+    MockUnitCtl::kill,
+    MockUnitCtl::freeze,
+    MockUnitCtl::forget
+};
+
+MockUnitCtl::MockUnitCtl() : defaultLatencyMs(0), activeCount(0)
+{
+    unitCtl.ops = &mockOps;
+    unitCtl.ctx = this;
+}
+
+int MockUnitCtl::submit(void *ctx, PWRMGR_UnitOp op, const char *unit, int jobId)
+{
+    MockUnitCtl *self = static_cast<MockUnitCtl *>(ctx);
+    std::string name(unit);
+    int ms = self->latencyMs.count(name) ? self->latencyMs[name] : self->defaultLatencyMs;
+    Job job;
+
+    job.jobId = jobId;
+    job.op = op;
+    job.unit = name;
+    job.due = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+    job.hang = self->hanging.count(name) > 0 || (op == PWRMGR_UNIT_STOP && self->ignoringTerm.count(name) > 0);
+    job.fail = self->failing.count(name) > 0;
+    self->pending.push_back(job);
+    self->jobHistory.push_back(std::string(PwrMgr_UnitCtl_OpStr(op)) + " " + name);
+    return 0;
+}
+
+int MockUnitCtl::wait(void *ctx, int timeoutMs, int *jobId, PWRMGR_UnitJobResult *result)
+{
+    MockUnitCtl *self = static_cast<MockUnitCtl *>(ctx);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    std::vector<Job>::iterator next = self->pending.end();
+
+    for (auto it = self->pending.begin(); it != self->pending.end(); ++it)
+    {
+        if (!it->hang && (next == self->pending.end() || it->due < next->due))
+            next = it;
+    }
+
+    if (next == self->pending.end() || next->due > deadline)
+    {
+        if (self->pending.empty())
+            return -1;
+        std::this_thread::sleep_until(deadline);
+        return 1;
+    }
+
+    std::this_thread::sleep_until(next->due);
+    *jobId = next->jobId;
+    *result = next->fail ? PWRMGR_UNIT_JOB_FAILED : PWRMGR_UNIT_JOB_DONE;
+    if (next->op == PWRMGR_UNIT_STOP || next->fail)
+        self->activeFrom[next->unit] = std::chrono::steady_clock::time_point::max();
+    else if (self->activationMs.count(next->unit) && self->activationMs[next->unit] < 0)
+        self->activeFrom[next->unit] = std::chrono::steady_clock::time_point::max();
+    else
+        self->activeFrom[next->unit] = next->due + std::chrono::milliseconds(self->activationMs[next->unit]);
+    self->pending.erase(next);
+    return 0;
+}
+
+int MockUnitCtl::active(void *ctx, const char *unit)
+{
+    MockUnitCtl *self = static_cast<MockUnitCtl *>(ctx);
+    auto it = self->activeFrom.find(unit);
+
+    self->activeCount++;
+    if (it == self->activeFrom.end())
+        return 1;
+    return std::chrono::steady_clock::now() >= it->second ? 1 : 0;
+}
+
+int MockUnitCtl::kill(void *ctx, const char *unit, int signal)
+{
+    MockUnitCtl *self = static_cast<MockUnitCtl *>(ctx);
+    std::string name(unit);
+
+    self->jobHistory.push_back("kill " + name);
+    if (signal != SIGKILL || (self->ignoringTerm.count(name) && self->ignoringTerm[name]))
+        return 0;
+    for (auto &job : self->pending)
+    {
+        if (job.unit == name && job.op == PWRMGR_UNIT_STOP)
+        {
+            job.hang = false;
+            job.due = std::chrono::steady_clock::now();
+        }
+    }
+    return 0;
+}
+
+int MockUnitCtl::freeze(void *ctx, const char *unit)
+{
+    MockUnitCtl *self = static_cast<MockUnitCtl *>(ctx);
+
+    self->jobHistory.push_back("freeze " + std::string(unit));
+    return 0;
+}
+
+void MockUnitCtl::forget(void *ctx, int jobId)
+{
+    MockUnitCtl *self = static_cast<MockUnitCtl *>(ctx);
+
+    for (auto it = self->pending.begin(); it != self->pending.end();)
+    {
+        if (jobId < 0 || it->jobId == jobId)
+            it = self->pending.erase(it);
+        else
+            ++it;
+    }
+}
@@ -0,0 +1,87 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef _MOCK_UNIT_CTL_H_
+#define _MOCK_UNIT_CTL_H_
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include "pwrMgr_unitctl.h"
+
+// Mock systemd bus: every job settles after a per-unit latency, jobs run
+// concurrently like they do inside systemd.
+class MockUnitCtl
+{
+public:
+    MockUnitCtl();
+
+    void setLatency(const std::string &unit, int ms) { latencyMs[unit] = ms; }
+    void setDefaultLatency(int ms) { defaultLatencyMs = ms; }
+    void setFailure(const std::string &unit) { failing[unit] = true; }
+    void setHang(const std::string &unit) { hanging[unit] = true; }
+    // Active ms after its start job is done, never when negative
+    void setActivation(const std::string &unit, int ms) { activationMs[unit] = ms; }
+    // Its stop job only finishes once it is sent SIGKILL, or never with ignoreKill
+    void setIgnoreTerm(const std::string &unit, bool ignoreKill = false) { ignoringTerm[unit] = ignoreKill; }
+
+    PWRMGR_UnitCtl *ctl() { return &unitCtl; }
+    // Units in submission order, prefixed with "stop ", "start ", "kill " or "freeze "
+    const std::vector<std::string> &history() const { return jobHistory; }
+    // Jobs submitted and neither finished nor forgotten
+    size_t pendingCount() const { return pending.size(); }
+    // Times a unit was asked whether it is active
+    int activeQueries() const { return activeCount; }
+
+private:
+    struct Job
+    {
+        int jobId;
+        PWRMGR_UnitOp op;
+        std::string unit;
+        std::chrono::steady_clock::time_point due;
+        bool hang;
+        bool fail;
+    };
+
+    static int submit(void *ctx, PWRMGR_UnitOp op, const char *unit, int jobId);
+    static int wait(void *ctx, int timeoutMs, int *jobId, PWRMGR_UnitJobResult *result);
+    static int active(void *ctx, const char *unit);
+    static int kill(void *ctx, const char *unit, int signal);
+    static int freeze(void *ctx, const char *unit);
+    static void forget(void *ctx, int jobId);
+
+    static const PWRMGR_UnitCtlOps mockOps;
+
+    PWRMGR_UnitCtl unitCtl;
+    std::map<std::string, int> latencyMs;
+    std::map<std::string, bool> failing;
+    std::map<std::string, bool> hanging;
+    std::map<std::string, int> activationMs;
+    std::map<std::string, bool> ignoringTerm;
+    // Units not in here have not been touched and count as running
+    std::map<std::string, std::chrono::steady_clock::time_point> activeFrom;
+    int defaultLatencyMs;
+    int activeCount;
+    std::vector<Job> pending;
+    std::vector<std::string> jobHistory;
+};
+
+#endif
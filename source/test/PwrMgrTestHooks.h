@@ -0,0 +1,36 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef _PWRMGR_TEST_HOOKS_H_
+#define _PWRMGR_TEST_HOOKS_H_
+
+#include "pwrMgr_unitctl.h"
+#include "pwrMgr_wifi.h"
+
+// Hooks pwrMgr.c exposes when built with GTEST_ENABLE
+extern "C"
+{
+    void PwrMgr_UseUnitCtl(const PWRMGR_UnitCtl *ctl);
+    void PwrMgr_UsePolicyFile(const char *path);
+    void PwrMgr_UseSystemctl(const char *path);
+    void PwrMgr_UseWifiOps(const PWRMGR_WifiOps *ops, void *ctx);
+    bool PwrMgr_WaitIdle(int timeoutMs);
+}
+
+#endif
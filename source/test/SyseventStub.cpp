@@ -0,0 +1,295 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "SyseventStub.h"
+#include "sysevent/sysevent.h"
+#include "secure_wrapper.h"
+
+namespace
+{
+    struct SetRecord
+    {
+        std::string value;
+        SyseventStub::Clock::time_point when;
+    };
+
+    // A connection is an eventfd, readable while notifications are queued for it
+    struct Connection
+    {
+        bool alive;
+        bool notify;
+    };
+
+    // Never destroyed: daemon threads may still use these at exit
+    std::mutex &lock = *new std::mutex;
+    std::condition_variable &changed = *new std::condition_variable;
+    std::map<int, Connection> connections;
+    int openFailures = 0;
+    int registrations = 0;
+    std::deque<std::pair<std::string, std::string> > notifications;
+    std::map<std::string, std::vector<SetRecord> > sets;
+    std::vector<std::string> systemCommands;
+    std::map<std::string, std::string> syscfg;
+}
+
+void SyseventStub::reset()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    openFailures = 0;
+    notifications.clear();
+    sets.clear();
+    systemCommands.clear();
+}
+
+void SyseventStub::failOpens(int count)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    openFailures = count;
+}
+
+static void wake(int fd, uint64_t count)
+{
+    if (write(fd, &count, sizeof(count)) != sizeof(count))
+        perror("SyseventStub eventfd write");
+}
+
+static int listeners()
+{
+    int count = 0;
+    for (auto &conn : connections)
+        count += (conn.second.alive && conn.second.notify) ? 1 : 0;
+    return count;
+}
+
+void SyseventStub::inject(const std::string &name, const std::string &value)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    notifications.push_back(std::make_pair(name, value));
+    for (auto &conn : connections)
+    {
+        if (conn.second.alive && conn.second.notify)
+            wake(conn.first, 1);
+    }
+    changed.notify_all();
+}
+
+void SyseventStub::restart(int failedOpens)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    // Existing connections hang up, whatever was queued for them is gone
+    for (auto &conn : connections)
+    {
+        if (conn.second.alive)
+        {
+            conn.second.alive = false;
+            wake(conn.first, 1);
+        }
+    }
+    notifications.clear();
+    openFailures = failedOpens;
+    changed.notify_all();
+}
+
+bool SyseventStub::waitForRegistration(int count, int timeoutMs, Clock::time_point *when)
+{
+    std::unique_lock<std::mutex> guard(lock);
+    bool found = changed.wait_for(guard, std::chrono::milliseconds(timeoutMs), [&] { return registrations >= count; });
+    if (found && when)
+        *when = Clock::now();
+    return found;
+}
+
+bool SyseventStub::waitForSet(const std::string &name, int count, int timeoutMs, Clock::time_point *when, std::string *value)
+{
+    std::unique_lock<std::mutex> guard(lock);
+    bool found = changed.wait_for(guard, std::chrono::milliseconds(timeoutMs),
+                                  [&] { return sets.count(name) && (int)sets[name].size() >= count; });
+    if (found)
+    {
+        const SetRecord &record = sets[name][count - 1];
+        if (when)
+            *when = record.when;
+        if (value)
+            *value = record.value;
+    }
+    return found;
+}
+
+int SyseventStub::setCount(const std::string &name)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return sets.count(name) ? (int)sets[name].size() : 0;
+}
+
+bool SyseventStub::waitDrained(int timeoutMs)
+{
+    std::unique_lock<std::mutex> guard(lock);
+    return changed.wait_for(guard, std::chrono::milliseconds(timeoutMs),
+                            [] { return notifications.empty() && listeners() > 0; });
+}
+
+void SyseventStub::setSyscfg(const std::string &name, const std::string &value)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    syscfg[name] = value;
+}
+
+std::vector<std::string> SyseventStub::commands()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return systemCommands;
+}
+
+extern "C" int sysevent_open(char *ip, unsigned short port, int version, char *id, token_t *token)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    (void)ip; (void)port; (void)version; (void)id;
+    if (openFailures > 0)
+    {
+        openFailures--;
+        return -1;
+    }
+    int fd = eventfd(0, EFD_SEMAPHORE | EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0)
+        return -1;
+    connections[fd] = Connection{ true, false };
+    *token = 1;
+    return fd;
+}
+
+extern "C" int sysevent_close(const int fd, const token_t token)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    (void)token;
+    if (!connections.count(fd))
+        return -1;
+    connections.erase(fd);
+    close(fd);
+    return 0;
+}
+
+extern "C" int sysevent_set(const int fd, const token_t token, const char *name, const char *value, int value_length)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    SetRecord record;
+    (void)token; (void)value_length;
+    if (!connections.count(fd) || !connections[fd].alive)
+        return -1;
+    record.value = value ? value : "";
+    record.when = SyseventStub::Clock::now();
+    sets[name].push_back(record);
+    changed.notify_all();
+    return 0;
+}
+
+extern "C" int sysevent_get(const int fd, const token_t token, const char *inbuf, char *outbuf, int outbytes)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    (void)fd; (void)token;
+    if (outbytes <= 0)
+        return -1;
+    outbuf[0] = '\0';
+    if (sets.count(inbuf) && !sets[inbuf].empty())
+        snprintf(outbuf, outbytes, "%s", sets[inbuf].back().value.c_str());
+    return 0;
+}
+
+extern "C" int sysevent_setnotification(const int fd, const token_t token, char *name, async_id_t *async_id)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    (void)token; (void)name;
+    if (!connections.count(fd) || !connections[fd].alive)
+        return -1;
+    connections[fd].notify = true;
+    // Notifications queued before anyone listened are delivered now
+    if (!notifications.empty())
+        wake(fd, notifications.size());
+    registrations++;
+    changed.notify_all();
+    async_id->action_id = 1;
+    async_id->trigger_id = 1;
+    return 0;
+}
+
+extern "C" int sysevent_getnotification(const int fd, const token_t token, char *namebuf, int *namelen, char *valbuf, int *vallen, async_id_t *async_id)
+{
+    std::unique_lock<std::mutex> guard(lock);
+    uint64_t count;
+    (void)token; (void)async_id;
+    if (!connections.count(fd) || !connections[fd].alive)
+        return -1;
+    // Blocks like the real call when nothing is queued
+    changed.wait(guard, [&] { return !notifications.empty() || !connections[fd].alive; });
+    if (!connections[fd].alive)
+        return -1;
+    if (read(fd, &count, sizeof(count)) != sizeof(count))
+        perror("SyseventStub eventfd read");
+
+    std::pair<std::string, std::string> event = notifications.front();
+    notifications.pop_front();
+    *namelen = snprintf(namebuf, *namelen, "%s", event.first.c_str());
+    *vallen = snprintf(valbuf, *vallen, "%s", event.second.c_str());
+    return 0;
+}
+
+extern "C" int sysevent_set_options(const int fd, const token_t token, char *name, unsigned int flags)
+{
+    (void)fd; (void)token; (void)name; (void)flags;
+    return 0;
+}
+
+extern "C" int v_secure_system(const char *format, ...)
+{
+    char command[256];
+    va_list args;
+
+    va_start(args, format);
+    vsnprintf(command, sizeof(command), format, args);
+    va_end(args);
+
+    std::lock_guard<std::mutex> guard(lock);
+    systemCommands.push_back(command);
+    return 0;
+}
+
+extern "C" int syscfg_init()
+{
+    return 0;
+}
+
+extern "C" int syscfg_get(const char *ns, const char *name, char *out_value, int outbufsz)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    (void)ns;
+    if (outbufsz > 0)
+        out_value[0] = '\0';
+    if (!syscfg.count(name))
+        return -1;
+    snprintf(out_value, outbufsz, "%s", syscfg[name].c_str());
+    return 0;
+}
@@ -0,0 +1,54 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef _SYSEVENT_STUB_H_
+#define _SYSEVENT_STUB_H_
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+// In-process stand-in for syseventd. The power manager links against it
+// instead of libsysevent so its real init and event handling can run in tests.
+namespace SyseventStub
+{
+    typedef std::chrono::steady_clock Clock;
+
+    void reset();
+    // Make the next count sysevent_open calls fail
+    void failOpens(int count);
+    // Queue an rdkb notification as if "sysevent set name value" was run
+    void inject(const std::string &name, const std::string &value);
+    // syseventd restarts: every connection hangs up and the next failedOpens opens fail
+    void restart(int failedOpens);
+    // Wait until the notification has been registered count times in total
+    bool waitForRegistration(int count, int timeoutMs, Clock::time_point *when);
+    // Wait until name has been set at least count times, reports the time and value of that set
+    bool waitForSet(const std::string &name, int count, int timeoutMs, Clock::time_point *when, std::string *value);
+    // Number of times name has been set
+    int setCount(const std::string &name);
+    // Wait until every injected notification was read and a listener is registered
+    bool waitDrained(int timeoutMs);
+    // Commands passed to v_secure_system
+    std::vector<std::string> commands();
+    // Value syscfg_get returns for name, kept across reset()
+    void setSyscfg(const std::string &name, const std::string &value);
+}
+
+#endif
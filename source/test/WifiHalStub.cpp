@@ -0,0 +1,93 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "WifiHalStub.h"
+
+const PWRMGR_WifiOps WifiHalStub::stubOps = {
+    WifiHalStub::count,
+    WifiHalStub::read,
+    WifiHalStub::write
+};
+
+void WifiHalStub::addRadio(PWRMGR_WifiBand band, int streams, int txPowerPercent)
+{
+    PWRMGR_WifiRadio r = { band, true, txPowerPercent, streams };
+    std::lock_guard<std::mutex> guard(lock);
+
+    config.push_back(r);
+    radios.push_back(r);
+    failing.push_back(false);
+}
+
+void WifiHalStub::setFailing(int radio, bool fail)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    failing[radio] = fail;
+}
+
+void WifiHalStub::restartAgent()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    radios = config;
+}
+
+PWRMGR_WifiRadio WifiHalStub::radio(int i)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return radios[i];
+}
+
+int WifiHalStub::writeCount()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return writes;
+}
+
+int WifiHalStub::count(void *ctx)
+{
+    WifiHalStub *self = static_cast<WifiHalStub *>(ctx);
+    std::lock_guard<std::mutex> guard(self->lock);
+
+    return (int)self->radios.size();
+}
+
+int WifiHalStub::read(void *ctx, int radio, PWRMGR_WifiRadio *settings)
+{
+    WifiHalStub *self = static_cast<WifiHalStub *>(ctx);
+    std::lock_guard<std::mutex> guard(self->lock);
+
+    if (self->failing[radio])
+        return -1;
+    *settings = self->radios[radio];
+    return 0;
+}
+
+int WifiHalStub::write(void *ctx, int radio, const PWRMGR_WifiRadio *settings)
+{
+    WifiHalStub *self = static_cast<WifiHalStub *>(ctx);
+    std::lock_guard<std::mutex> guard(self->lock);
+
+    self->writes++;
+    if (self->failing[radio])
+        return -1;
+    self->radios[radio].enabled = settings->enabled;
+    self->radios[radio].txPowerPercent = settings->txPowerPercent;
+    self->radios[radio].streams = settings->streams;
+    return 0;
+}
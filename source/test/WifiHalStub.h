@@ -0,0 +1,58 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#ifndef _WIFI_HAL_STUB_H_
+#define _WIFI_HAL_STUB_H_
+
+#include <mutex>
+#include <vector>
+#include "pwrMgr_wifi.h"
+
+// Simulated radios behind wifi_hal. The agent keeps a configuration the
+// radios go back to when it restarts.
+class WifiHalStub
+{
+public:
+    WifiHalStub() : writes(0) {}
+
+    void addRadio(PWRMGR_WifiBand band, int streams, int txPowerPercent = 100);
+    void setFailing(int radio, bool fail);
+    // The agent came back up with its configuration
+    void restartAgent();
+    PWRMGR_WifiRadio radio(int i);
+    int writeCount();
+
+    const PWRMGR_WifiOps *ops() const { return &stubOps; }
+    void *ctx() { return this; }
+
+private:
+    static int count(void *ctx);
+    static int read(void *ctx, int radio, PWRMGR_WifiRadio *settings);
+    static int write(void *ctx, int radio, const PWRMGR_WifiRadio *settings);
+
+    static const PWRMGR_WifiOps stubOps;
+
+    std::mutex lock;
+    std::vector<PWRMGR_WifiRadio> config;
+    std::vector<PWRMGR_WifiRadio> radios;
+    std::vector<bool> failing;
+    int writes;
+};
+
+#endif
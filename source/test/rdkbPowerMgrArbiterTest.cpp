@@ -0,0 +1,58 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "gtest/gtest.h"
+#include "pwrMgr_arbiter.h"
+
+TEST(Arbiter, AxesMoveIndependently)
+{
+    PWRMGR_PowerVector vec;
+
+    PwrMgr_Arbiter_Init(&vec, PWRMGR_STATE_HOT);
+    EXPECT_EQ(PWRMGR_STATE_AC, vec.axis[PWRMGR_AXIS_SUPPLY]);
+    EXPECT_EQ(PWRMGR_STATE_HOT, vec.axis[PWRMGR_AXIS_THERMAL]);
+
+    EXPECT_EQ(PWRMGR_STATE_HOT, PwrMgr_Arbiter_Set(&vec, PWRMGR_STATE_COOLED));
+    EXPECT_EQ(PWRMGR_STATE_AC, PwrMgr_Arbiter_Get(&vec, PWRMGR_STATE_AC));
+    EXPECT_EQ(PWRMGR_STATE_COOLED, PwrMgr_Arbiter_Get(&vec, PWRMGR_STATE_CRITICAL));
+    EXPECT_EQ(PWRMGR_AXIS_THERMAL, PwrMgr_Arbiter_Axis(PWRMGR_STATE_WARM));
+    EXPECT_EQ(PWRMGR_AXIS_SUPPLY, PwrMgr_Arbiter_Axis(PWRMGR_STATE_AC));
+}
+
+TEST(Arbiter, RunsWhatNoAxisSheds)
+{
+    PWRMGR_CompMask runMask[PWRMGR_STATE_TOTAL] = {};
+    PWRMGR_PowerVector vec;
+
+    // A supply that sheds component 0 and thermal levels that shed from the top
+    runMask[PWRMGR_STATE_AC] = 0xE;
+    runMask[PWRMGR_STATE_COOLED] = 0xF;
+    runMask[PWRMGR_STATE_WARM] = 0x7;
+    runMask[PWRMGR_STATE_HOT] = 0x3;
+
+    PwrMgr_Arbiter_Init(&vec, PWRMGR_STATE_AC);
+    EXPECT_EQ(0xEu, PwrMgr_Arbiter_RunMask(&vec, runMask));
+    PwrMgr_Arbiter_Set(&vec, PWRMGR_STATE_HOT);
+    EXPECT_EQ(0x2u, PwrMgr_Arbiter_RunMask(&vec, runMask));
+    // Cooling down keeps the supply's constraint
+    PwrMgr_Arbiter_Set(&vec, PWRMGR_STATE_WARM);
+    EXPECT_EQ(0x6u, PwrMgr_Arbiter_RunMask(&vec, runMask));
+    PwrMgr_Arbiter_Set(&vec, PWRMGR_STATE_COOLED);
+    EXPECT_EQ(0xEu, PwrMgr_Arbiter_RunMask(&vec, runMask));
+}
@@ -0,0 +1,190 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <stdio.h>
+#include <vector>
+#include "gtest/gtest.h"
+#include "BatteryHalStub.h"
+#include "pwrMgr_battery.h"
+#include "pwrMgr_compgraph.h"
+
+class BatteryTest : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        PwrMgr_Battery_DefaultConfig(&cfg);
+    }
+
+    void TearDown()
+    {
+        PwrMgr_Battery_Close(&mon);
+    }
+
+    static void notify(void *ctx, int level, long minutes, int percent)
+    {
+        BatteryTest *self = static_cast<BatteryTest *>(ctx);
+        (void)percent;
+        if (self->levels.empty() || self->levels.back() != level)
+            self->levels.push_back(level);
+        self->published.push_back(minutes);
+    }
+
+    // Sample at the policy's own pace until the simulated battery is empty
+    long runUntilEmpty(BatteryHalStub &hal)
+    {
+        long nowMs = 0;
+        int intervalMs = 0;
+
+        while (hal.discharge(intervalMs, mon.level))
+        {
+            nowMs += intervalMs;
+            intervalMs = PwrMgr_Battery_Sample(&mon, nowMs);
+        }
+        return nowMs / 60000;
+    }
+
+    PWRMGR_BatteryConfig cfg;
+    PWRMGR_BatteryMonitor mon;
+    std::vector<int> levels;
+    std::vector<long> published;
+};
+
+// Load in mA with nothing, telemetry, MoCA and Wi-Fi shed; voice stays up throughout
+static const std::vector<int> loadCurve = { 1100, 900, 700, 250 };
+
+TEST_F(BatteryTest, NothingShedOnAc)
+{
+    BatteryHalStub hal(3000, loadCurve);
+
+    ASSERT_EQ(0, PwrMgr_Battery_Open(&mon, &cfg, hal.ops(), hal.ctx(), notify, this));
+    EXPECT_EQ(cfg.acMs, PwrMgr_Battery_Sample(&mon, 0));
+    EXPECT_EQ(0, mon.level);
+    EXPECT_EQ(-1, mon.minutes);
+    EXPECT_EQ(100, mon.percent);
+    // Only the charge is published
+    EXPECT_EQ(std::vector<int>{ 0 }, levels);
+}
+
+TEST_F(BatteryTest, ShedsTiersInOrderAndBackOnAc)
+{
+    BatteryHalStub hal(3000, loadCurve);
+
+    ASSERT_EQ(0, PwrMgr_Battery_Open(&mon, &cfg, hal.ops(), hal.ctx(), notify, this));
+    hal.setOnBattery(true);
+    long runtime = runUntilEmpty(hal);
+
+    ASSERT_EQ((std::vector<int>{ 1, 2, 3 }), levels);
+    // The projection never jumps back up enough to undo a tier
+    EXPECT_EQ(3, mon.level);
+    printf("battery-runtime: %ld minutes with tiered shedding\n", runtime);
+
+    hal.setOnBattery(false);
+    EXPECT_EQ(cfg.acMs, PwrMgr_Battery_Sample(&mon, runtime * 60000 + 1000));
+    EXPECT_EQ(0, mon.level);
+    EXPECT_EQ(0, levels.back());
+}
+
+TEST_F(BatteryTest, TieredSheddingExtendsRuntime)
+{
+    BatteryHalStub flat(3000, loadCurve);
+    BatteryHalStub tiered(3000, loadCurve);
+
+    // Without deeper tiers only the on-battery level is ever shed
+    cfg.tierCount = 0;
+    ASSERT_EQ(0, PwrMgr_Battery_Open(&mon, &cfg, flat.ops(), flat.ctx(), notify, this));
+    flat.setOnBattery(true);
+    long flatRuntime = runUntilEmpty(flat);
+    PwrMgr_Battery_Close(&mon);
+
+    PwrMgr_Battery_DefaultConfig(&cfg);
+    ASSERT_EQ(0, PwrMgr_Battery_Open(&mon, &cfg, tiered.ops(), tiered.ctx(), notify, this));
+    tiered.setOnBattery(true);
+    long tieredRuntime = runUntilEmpty(tiered);
+
+    EXPECT_NEAR(200, flatRuntime, 2);
+    EXPECT_GT(tieredRuntime, flatRuntime * 3 / 2);
+    printf("battery-runtime: flat %ld minutes, tiered %ld minutes\n", flatRuntime, tieredRuntime);
+}
+
+TEST_F(BatteryTest, ProjectsFromDrainWithoutGauge)
+{
+    BatteryHalStub hal(3000, loadCurve);
+
+    ASSERT_EQ(0, PwrMgr_Battery_Open(&mon, &cfg, hal.ops(), hal.ctx(), notify, this));
+    hal.setGaugeEstimate(false);
+    hal.setOnBattery(true);
+    PwrMgr_Battery_Sample(&mon, 0);
+    EXPECT_EQ(-1, mon.minutes);
+    EXPECT_EQ(1, mon.level);
+
+    // 900 mA for ten minutes is 150 mAh
+    hal.discharge(600000, 1);
+    EXPECT_EQ(cfg.batteryMs, PwrMgr_Battery_Sample(&mon, 600000));
+    EXPECT_NEAR(2850 / 15, mon.minutes, 1);
+    EXPECT_EQ(mon.minutes, published.back());
+}
+
+TEST_F(BatteryTest, PollsFasterNearTheNextTier)
+{
+    BatteryHalStub hal(3000, loadCurve);
+
+    ASSERT_EQ(0, PwrMgr_Battery_Open(&mon, &cfg, hal.ops(), hal.ctx(), notify, this));
+    hal.setOnBattery(true);
+    // 1890 mAh at 900 mA is 126 minutes, within the margin of the 120 minute tier
+    hal.discharge(4400000, 1);
+    EXPECT_EQ(cfg.fastMs, PwrMgr_Battery_Sample(&mon, 0));
+    EXPECT_EQ(1, mon.level);
+}
+
+TEST_F(BatteryTest, UnreadableHalKeepsLevel)
+{
+    BatteryHalStub hal(3000, loadCurve);
+
+    ASSERT_EQ(0, PwrMgr_Battery_Open(&mon, &cfg, hal.ops(), hal.ctx(), notify, this));
+    hal.setOnBattery(true);
+    PwrMgr_Battery_Sample(&mon, 0);
+    ASSERT_EQ(1u, levels.size());
+
+    hal.setFailing(true);
+    EXPECT_EQ(cfg.batteryMs, PwrMgr_Battery_Sample(&mon, 1000));
+    EXPECT_EQ(1, mon.level);
+    EXPECT_EQ(1u, published.size());
+}
+
+TEST(CompGraph, BatteryTiersKeepWifiLongest)
+{
+    PWRMGR_CompGraph graph;
+    char line[] = "battery_shed wifi 4";
+    char bad[] = "battery_shed wifi 9";
+
+    PwrMgr_CompGraph_LoadDefaults(&graph);
+    PWRMGR_CompMask telemetry = PWRMGR_COMP_BIT(PwrMgr_CompGraph_Find(&graph, "harvester")) |
+                                PWRMGR_COMP_BIT(PwrMgr_CompGraph_Find(&graph, "lmlite"));
+    PWRMGR_CompMask moca = PWRMGR_COMP_BIT(PwrMgr_CompGraph_Find(&graph, "moca"));
+    PWRMGR_CompMask wifi = PWRMGR_COMP_BIT(PwrMgr_CompGraph_Find(&graph, "wifi"));
+
+    EXPECT_EQ(0u, PwrMgr_CompGraph_BattShedMask(&graph, 0));
+    EXPECT_EQ(telemetry, PwrMgr_CompGraph_BattShedMask(&graph, 1));
+    EXPECT_EQ(telemetry | moca, PwrMgr_CompGraph_BattShedMask(&graph, 2));
+    EXPECT_EQ(telemetry | moca | wifi, PwrMgr_CompGraph_BattShedMask(&graph, 3));
+    EXPECT_EQ(-1, PwrMgr_CompGraph_ParseLine(&graph, bad));
+    EXPECT_EQ(0, PwrMgr_CompGraph_ParseLine(&graph, line));
+    EXPECT_EQ(telemetry | moca, PwrMgr_CompGraph_BattShedMask(&graph, 3));
+}
@@ -0,0 +1,447 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+// End-to-end transition benchmark. Drives the real daemon logic from pwrMgr.c
+// through the in-process sysevent stand-in, with a fake unit controller whose
+// jobs take --latency-ms each, and reports latency, throughput and memory.
+//
+// Scenarios:
+//   single  one transition at a time, latency from request to rdkb-power-state
+//   flap    back to back HOT/COOLED requests, coalesced by the hysteresis
+//   burst   a large stream of mixed requests, events/sec the daemon takes in
+//
+// Afterwards the cost of reading the state from the shared memory telemetry
+// is measured, the alternative to asking syseventd, and the per call cost of
+// a log line through the async logger against the old two fprintf macro.
+//
+// With --freeze the components that opt in are frozen in a fake cgroupfs
+// instead of being stopped, compare the single latencies with a plain run.
+//
+// Exits non-zero when a scenario does not converge on the last requested
+// state or a --max-p99-ms / --min-events-per-sec limit is exceeded.
+
+#include <algorithm>
+#include <chrono>
+#include <initializer_list>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "SyseventStub.h"
+#include "MockUnitCtl.h"
+#include "PwrMgrTestHooks.h"
+#include "pwrMgr.h"
+#include "pwrMgr_checkpoint.h"
+#include "pwrMgr_log.h"
+#include "pwrMgr_stats.h"
+#include "pwrMgr_telemetry.h"
+
+namespace
+{
+    struct Options
+    {
+        int iterations = 100;
+        int flapEvents = 1000;
+        int burstEvents = 10000;
+        int latencyMs = 5;
+        int hysteresisMs = 20;
+        long maxP99Ms = 0;
+        long minEventsPerSec = 0;
+        bool verbose = false;
+        bool freeze = false;
+    };
+
+    struct Request
+    {
+        const char *trans;
+        const char *state;
+    };
+
+    // All on the thermal axis, an AC request while on AC changes nothing
+    const Request requests[] = {
+        { "POWER_TRANS_WARM", "ThermalWarm" },
+        { "POWER_TRANS_HOT", "ThermalHot" },
+        { "POWER_TRANS_COOLED", "ThermalCooled" },
+    };
+
+    const int idleTimeoutMs = 60000;
+
+    double msSince(SyseventStub::Clock::time_point start, SyseventStub::Clock::time_point end)
+    {
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    double percentile(std::vector<double> samples, int percent)
+    {
+        if (samples.empty())
+            return 0;
+        std::sort(samples.begin(), samples.end());
+        size_t rank = (samples.size() * percent + 99) / 100;
+        return samples[rank ? rank - 1 : 0];
+    }
+
+    long procStatusKb(const char *field)
+    {
+        char line[128];
+        long kb = -1;
+        FILE *fp = fopen("/proc/self/status", "r");
+
+        if (fp == NULL)
+            return -1;
+        while (fgets(line, sizeof(line), fp))
+        {
+            if (strncmp(line, field, strlen(field)) == 0)
+            {
+                kb = atol(line + strlen(field));
+                break;
+            }
+        }
+        fclose(fp);
+        return kb;
+    }
+
+    std::string lastState()
+    {
+        std::string value;
+        int count = SyseventStub::setCount("rdkb-power-state");
+        SyseventStub::waitForSet("rdkb-power-state", count, 0, NULL, &value);
+        return value;
+    }
+
+    // Wait for the daemon to settle and check it ended up in the last requested state
+    bool converged(const char *scenario, const Request &last)
+    {
+        if (!SyseventStub::waitDrained(idleTimeoutMs) || !PwrMgr_WaitIdle(idleTimeoutMs))
+        {
+            printf("scenario=%s error=timeout\n", scenario);
+            return false;
+        }
+        if (lastState() != last.state)
+        {
+            printf("scenario=%s error=state expected=%s published=%s\n", scenario, last.state, lastState().c_str());
+            return false;
+        }
+        return true;
+    }
+
+    void printDaemonStats(const char *scenario)
+    {
+        PWRMGR_Stats stats;
+        const PWRMGR_Histogram *total = &stats.phase[PWRMGR_PHASE_TOTAL];
+
+        PwrMgr_Stats_Get(&stats);
+        printf("scenario=%s daemon_transitions=%u daemon_p50_ms=%.1f daemon_p99_ms=%.1f\n", scenario, total->count,
+               PwrMgr_Hist_Percentile(total, 50) / 1000.0, PwrMgr_Hist_Percentile(total, 99) / 1000.0);
+    }
+
+    bool runSingle(const Options &opt, double *p99)
+    {
+        std::vector<double> samples;
+
+        PwrMgr_Stats_Reset();
+        for (int i = 0; i < opt.iterations; i++)
+        {
+            // AC -> HOT -> COOLED -> HOT -> COOLED ...
+            const Request &req = requests[(i % 2) ? 2 : 1];
+            int count = SyseventStub::setCount("rdkb-power-state");
+            SyseventStub::Clock::time_point published;
+            SyseventStub::Clock::time_point start = SyseventStub::Clock::now();
+
+            SyseventStub::inject("rdkb-power-transition", req.trans);
+            if (!SyseventStub::waitForSet("rdkb-power-state", count + 1, idleTimeoutMs, &published, NULL) ||
+                !converged("single", req))
+                return false;
+            samples.push_back(msSince(start, published));
+        }
+
+        *p99 = percentile(samples, 99);
+        printf("scenario=single transitions=%zu p50_ms=%.2f p99_ms=%.2f max_ms=%.2f\n", samples.size(),
+               percentile(samples, 50), *p99, percentile(samples, 100));
+        printDaemonStats("single");
+        return true;
+    }
+
+    bool runStorm(const char *scenario, int events, bool flap, double *eventsPerSec)
+    {
+        unsigned int seed = 1;
+        int before = SyseventStub::setCount("rdkb-power-state");
+        const Request *last = NULL;
+
+        PwrMgr_Stats_Reset();
+        SyseventStub::Clock::time_point start = SyseventStub::Clock::now();
+        for (int i = 0; i < events; i++)
+        {
+            if (flap)
+            {
+                // Starts from COOLED where single left off, ends on HOT when events is even
+                last = &requests[(i % 2) ? 1 : 2];
+            }
+            else
+            {
+                seed = seed * 1103515245 + 12345;
+                last = &requests[(seed >> 16) % 3];
+            }
+            SyseventStub::inject("rdkb-power-transition", last->trans);
+        }
+
+        if (!SyseventStub::waitDrained(idleTimeoutMs))
+        {
+            printf("scenario=%s error=timeout\n", scenario);
+            return false;
+        }
+        SyseventStub::Clock::time_point drained = SyseventStub::Clock::now();
+        if (!converged(scenario, *last))
+            return false;
+        SyseventStub::Clock::time_point settled = SyseventStub::Clock::now();
+
+        *eventsPerSec = events / (msSince(start, drained) / 1000.0);
+        printf("scenario=%s events=%d events_per_sec=%.0f drain_ms=%.2f settle_ms=%.2f published=%d\n", scenario, events,
+               *eventsPerSec, msSince(start, drained), msSince(start, settled),
+               SyseventStub::setCount("rdkb-power-state") - before);
+        printDaemonStats(scenario);
+        return true;
+    }
+
+    // Fake cgroupfs with a group for every built-in component that opts in to freezing
+    bool makeCgroupRoot(std::string *root)
+    {
+        char tmpl[] = "/tmp/pwrMgrBenchCgroupXXXXXX";
+
+        if (mkdtemp(tmpl) == NULL)
+            return false;
+        *root = tmpl;
+        for (const char *unit : { "ccspwifiagent.service", "CcspMoca.service" })
+        {
+            std::string dir = *root + "/" + unit;
+            FILE *fp;
+
+            if (mkdir(dir.c_str(), 0755) != 0 || (fp = fopen((dir + "/cgroup.freeze").c_str(), "w")) == NULL)
+                return false;
+            fputs("0", fp);
+            fclose(fp);
+        }
+        return true;
+    }
+
+    // What a consumer polling the telemetry pays per read
+    bool runTelemetry()
+    {
+        const int reads = 1000000;
+        const PWRMGR_Telemetry *shm = PwrMgr_Telemetry_Attach(PWRMGR_TELEMETRY_SHM);
+        PWRMGR_Telemetry t;
+
+        if (shm == NULL || PwrMgr_Telemetry_Read(shm, &t) != 0 || lastState() != t.stateNames[t.state])
+        {
+            printf("scenario=telemetry error=read\n");
+            PwrMgr_Telemetry_Detach(shm);
+            return false;
+        }
+        SyseventStub::Clock::time_point start = SyseventStub::Clock::now();
+        for (int i = 0; i < reads; i++)
+            PwrMgr_Telemetry_Read(shm, &t);
+        printf("scenario=telemetry reads=%d read_ns=%.1f transitions=%u energy_saved_mj=%llu\n", reads,
+               msSince(start, SyseventStub::Clock::now()) * 1000000.0 / reads, t.transitions,
+               (unsigned long long)(t.energySavedUj / 1000));
+        PwrMgr_Telemetry_Detach(shm);
+        return true;
+    }
+
+    // Bursts of half a ring, the time between them to drain is not counted
+    bool runLog()
+    {
+        const int bursts = 200, perBurst = PWRMGR_LOG_RING_SLOTS / 2;
+        const char *path = "/tmp/pwrMgrBenchLog.txt";
+        double legacyMs = 0, asyncMs = 0;
+        unsigned long dropped;
+        FILE *fp = fopen(path, "w");
+        int fd;
+
+        if (fp == NULL)
+            return false;
+        setvbuf(fp, NULL, _IONBF, 0);       // stderr is unbuffered
+        for (int b = 0; b < bursts; b++)
+        {
+            SyseventStub::Clock::time_point start = SyseventStub::Clock::now();
+            for (int i = 0; i < perBurst; i++)
+            {
+                fprintf(fp, "PowerMgrLog<%s:%d> ", __FUNCTION__, __LINE__);
+                fprintf(fp, "transition %d to %s took %d ms\n", i, "ThermalHot", b);
+            }
+            legacyMs += msSince(start, SyseventStub::Clock::now());
+        }
+        fclose(fp);
+
+        fd = open(path, O_WRONLY | O_TRUNC);
+        PwrMgr_Log_Stop();
+        if (fd < 0 || PwrMgr_Log_Start(fd) != 0)
+            return false;
+        dropped = PwrMgr_Log_Dropped();
+        for (int b = 0; b < bursts; b++)
+        {
+            SyseventStub::Clock::time_point start = SyseventStub::Clock::now();
+            for (int i = 0; i < perBurst; i++)
+                PWRMGRLOG(INFO, "transition %d to %s took %d ms\n", i, "ThermalHot", b)
+            asyncMs += msSince(start, SyseventStub::Clock::now());
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        PwrMgr_Log_Stop();
+        dropped = PwrMgr_Log_Dropped() - dropped;
+        close(fd);
+        unlink(path);
+        PwrMgr_Log_Start(STDERR_FILENO);
+
+        printf("scenario=log lines=%d legacy_ns=%.1f async_ns=%.1f dropped=%lu\n", bursts * perBurst,
+               legacyMs * 1000000.0 / (bursts * perBurst), asyncMs * 1000000.0 / (bursts * perBurst), dropped);
+        return true;
+    }
+
+    bool parseArgs(int argc, char *argv[], Options *opt)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+            if (arg == "--verbose")
+            {
+                opt->verbose = true;
+                continue;
+            }
+            if (arg == "--freeze")
+            {
+                opt->freeze = true;
+                continue;
+            }
+            if (value == NULL)
+                return false;
+            i++;
+            if (arg == "--iterations")
+                opt->iterations = atoi(value);
+            else if (arg == "--flap")
+                opt->flapEvents = atoi(value);
+            else if (arg == "--burst")
+                opt->burstEvents = atoi(value);
+            else if (arg == "--latency-ms")
+                opt->latencyMs = atoi(value);
+            else if (arg == "--hysteresis-ms")
+                opt->hysteresisMs = atoi(value);
+            else if (arg == "--max-p99-ms")
+                opt->maxP99Ms = atol(value);
+            else if (arg == "--min-events-per-sec")
+                opt->minEventsPerSec = atol(value);
+            else
+                return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    Options opt;
+    MockUnitCtl units;
+    std::string cgroupRoot;
+    double p99 = 0, flapRate = 0, burstRate = 0;
+    bool ok;
+
+    if (!parseArgs(argc, argv, &opt))
+    {
+        fprintf(stderr, "usage: %s [--iterations N] [--flap N] [--burst N] [--latency-ms N] [--hysteresis-ms N]\n"
+                        "       [--max-p99-ms N] [--min-events-per-sec N] [--freeze] [--verbose]\n", argv[0]);
+        return 2;
+    }
+    // The daemon logs every event to stderr, that is not what is being measured
+    if (!opt.verbose && freopen("/dev/null", "w", stderr) == NULL)
+        return 2;
+    PwrMgr_Log_Start(STDERR_FILENO);
+
+    for (const char *state : { "AC", "Battery", "ThermalWarm", "ThermalHot", "ThermalCooled" })
+    {
+        SyseventStub::setSyscfg(std::string("PwrMgrHysteresisMs_") + state, std::to_string(opt.hysteresisMs));
+        SyseventStub::setSyscfg(std::string("PwrMgrMinDwellMs_") + state, "0");
+    }
+    // Only scripted requests, not whatever the build host's sensors say
+    SyseventStub::setSyscfg("PwrMgrThermalMonitor", "false");
+    SyseventStub::setSyscfg("PwrMgrCpuActuator", "false");
+    if (opt.freeze)
+    {
+        if (!makeCgroupRoot(&cgroupRoot))
+        {
+            printf("error=cgroup\n");
+            return 1;
+        }
+        SyseventStub::setSyscfg("PwrMgrCgroupRoot", cgroupRoot);
+    }
+    else
+    {
+        SyseventStub::setSyscfg("PwrMgrFreezeMode", "false");
+    }
+    units.setDefaultLatency(opt.latencyMs);
+    PwrMgr_UseUnitCtl(units.ctl());
+    unlink(PWRMGR_CHECKPOINT_FILE);
+
+    if (PwrMgr_Init() != 0)
+    {
+        printf("error=init\n");
+        return 1;
+    }
+    std::thread loop(PwrMgr_Run);
+    if (!SyseventStub::waitForSet("rdkb-power-state", 1, idleTimeoutMs, NULL, NULL))
+    {
+        printf("error=init\n");
+        _exit(1);
+    }
+
+    ok = runSingle(opt, &p99) &&
+         runStorm("flap", opt.flapEvents, true, &flapRate) &&
+         runStorm("burst", opt.burstEvents, false, &burstRate) &&
+         runTelemetry() &&
+         runLog();
+
+    printf("unit_jobs=%zu\n", units.history().size());
+    printf("rss_kb=%ld rss_peak_kb=%ld\n", procStatusKb("VmRSS:"), procStatusKb("VmHWM:"));
+
+    // Same path as the unit's ExecStop
+    SyseventStub::Clock::time_point stopping = SyseventStub::Clock::now();
+    pthread_kill(loop.native_handle(), SIGHUP);
+    loop.join();
+    PwrMgr_Term();
+    PwrMgr_Log_Stop();
+    printf("shutdown_ms=%.2f\n", msSince(stopping, SyseventStub::Clock::now()));
+    if (!cgroupRoot.empty())
+        ok = (system(("rm -rf " + cgroupRoot).c_str()) == 0) && ok;
+
+    if (ok && opt.maxP99Ms > 0 && p99 > opt.maxP99Ms)
+    {
+        printf("error=p99 %.2f ms above %ld ms\n", p99, opt.maxP99Ms);
+        ok = false;
+    }
+    if (ok && opt.minEventsPerSec > 0 && std::min(flapRate, burstRate) < opt.minEventsPerSec)
+    {
+        printf("error=events_per_sec %.0f below %ld\n", std::min(flapRate, burstRate), opt.minEventsPerSec);
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
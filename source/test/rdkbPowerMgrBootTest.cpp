@@ -0,0 +1,245 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include "gtest/gtest.h"
+#include "FakeSystemctl.h"
+#include "PwrMgrTestHooks.h"
+#include "SyseventStub.h"
+#include "WifiHalStub.h"
+#include "pwrMgr.h"
+#include "pwrMgr_checkpoint.h"
+#include "pwrMgr_inhibit.h"
+#include "pwrMgr_loop.h"
+#include "pwrMgr_telemetry.h"
+
+// The daemon keeps global state, these tests share one instance and run in order
+static std::thread loop;
+// A policy file the tests can replace while the daemon runs
+static std::string policyDir;
+static std::string policyPath;
+// Radios of the Wi-Fi agent the daemon degrades
+static WifiHalStub wifi;
+// Without sd-bus the daemon drives the units through systemctl
+static FakeSystemctl systemctl;
+
+// Whether the daemon ran command
+static bool ran(const std::string &command)
+{
+    std::vector<std::string> commands = systemctl.commands();
+
+    return std::find(commands.begin(), commands.end(), command) != commands.end();
+}
+
+// Connect to the daemon's inhibitor socket, -1 if it hangs up instead of answering
+static int inhibitClient()
+{
+    struct sockaddr_un addr;
+    struct timeval timeout = { 2, 0 };
+    char reply[PWRMGR_INHIBIT_MSG_LEN];
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s/inhibit.sock", policyDir.c_str());
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || send(fd, "list", 4, MSG_NOSIGNAL) < 0 ||
+        recv(fd, reply, sizeof(reply), 0) <= 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void installPolicy(const std::string &extra)
+{
+    std::string tmp = policyDir + "/.new";
+    FILE *fp = fopen(tmp.c_str(), "w");
+
+    ASSERT_NE(nullptr, fp);
+    fputs("component harvester harvester.service\n"
+          "component lmlite CcspLMLite.service\n"
+          "component wifi ccspwifiagent.service\n"
+          "component moca CcspMoca.service\n"
+          "thermal_shed harvester warm\n"
+          "thermal_shed lmlite warm\n"
+          "thermal_shed wifi critical\n", fp);
+    fputs(extra.c_str(), fp);
+    fclose(fp);
+    ASSERT_EQ(0, rename(tmp.c_str(), policyPath.c_str()));
+}
+
+// Boot-time benchmark: time from PwrMgr_Init() to the first rdkb-power-state.
+// The daemon used to sleep 10 seconds before it published anything.
+TEST(Boot, TimeToFirstPublishedState)
+{
+    SyseventStub::Clock::time_point published;
+    std::string state;
+
+    SyseventStub::reset();
+    SyseventStub::setSyscfg("PwrMgrThermalMonitor", "false");
+    // Leave the build host's clocks and cores alone
+    SyseventStub::setSyscfg("PwrMgrCpuActuator", "false");
+    // syseventd is still coming up for the first two attempts
+    SyseventStub::failOpens(2);
+    // A fresh boot, not a restart
+    unlink(PWRMGR_CHECKPOINT_FILE);
+    unlink(PWRMGR_WIFI_BASELINE_FILE);
+    wifi.addRadio(PWRMGR_WIFI_BAND_2G, 4);
+    wifi.addRadio(PWRMGR_WIFI_BAND_5G, 4);
+    wifi.addRadio(PWRMGR_WIFI_BAND_6G, 2);
+    PwrMgr_UseWifiOps(wifi.ops(), wifi.ctx());
+    char dir[] = "/tmp/pwrMgrBootXXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(dir));
+    policyDir = dir;
+    policyPath = policyDir + "/pwrMgr_components.conf";
+    installPolicy("");
+    PwrMgr_UsePolicyFile(policyPath.c_str());
+    PwrMgr_UseSystemctl(systemctl.path());
+    SyseventStub::setSyscfg("PwrMgrInhibitSocket", policyDir + "/inhibit.sock");
+
+    SyseventStub::Clock::time_point start = SyseventStub::Clock::now();
+    ASSERT_EQ(0, PwrMgr_Init());
+    loop = std::thread(PwrMgr_Run);
+    ASSERT_TRUE(SyseventStub::waitForSet("rdkb-power-state", 1, 5000, &published, &state));
+
+    long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(published - start).count();
+    EXPECT_EQ("AC", state);
+    EXPECT_LT(elapsed, 1000);
+    printf("time-to-first-published-state: %ld ms (two failed sysevent connects)\n", elapsed);
+
+    // The same state without going through sysevent
+    const PWRMGR_Telemetry *shm = PwrMgr_Telemetry_Attach(PWRMGR_TELEMETRY_SHM);
+    PWRMGR_Telemetry telemetry;
+    ASSERT_NE(nullptr, shm);
+    ASSERT_EQ(0, PwrMgr_Telemetry_Read(shm, &telemetry));
+    EXPECT_EQ((uint32_t)getpid(), telemetry.pid);
+    EXPECT_STREQ("AC", telemetry.stateNames[telemetry.state]);
+    PwrMgr_Telemetry_Detach(shm);
+}
+
+// Event-loss window: from syseventd restarting to the daemon listening again
+TEST(Boot, ReconnectsAfterSyseventdRestart)
+{
+    SyseventStub::Clock::time_point registered;
+    std::string state;
+
+    ASSERT_TRUE(loop.joinable());
+    ASSERT_TRUE(SyseventStub::waitForRegistration(1, 1000, NULL));
+    int published = SyseventStub::setCount("rdkb-power-state");
+
+    // Inhibitor clients cannot take the loop slot the reconnect needs
+    std::vector<int> clients;
+    for (int i = 0; i < PWRMGR_LOOP_MAX_SOURCES; i++)
+    {
+        int fd = inhibitClient();
+        if (fd >= 0)
+            clients.push_back(fd);
+    }
+    EXPECT_EQ(PWRMGR_INHIBIT_MAX_CLIENTS, (int)clients.size());
+
+    // The first two reconnect attempts hit a syseventd that is not up yet
+    SyseventStub::Clock::time_point restart = SyseventStub::Clock::now();
+    SyseventStub::restart(2);
+    ASSERT_TRUE(SyseventStub::waitForRegistration(2, 5000, &registered));
+    long window = std::chrono::duration_cast<std::chrono::milliseconds>(registered - restart).count();
+    EXPECT_LT(window, 1000);
+    printf("sysevent-loss-window: %ld ms (two failed opens)\n", window);
+
+    // The state is published again for the restarted daemon, then events flow
+    ASSERT_TRUE(SyseventStub::waitForSet("rdkb-power-state", published + 1, 1000, NULL, &state));
+    EXPECT_EQ("AC", state);
+    for (int fd : clients)
+        close(fd);
+    SyseventStub::inject("rdkb-power-transition", "POWER_TRANS_HOT");
+    ASSERT_TRUE(SyseventStub::waitForSet("rdkb-power-state", published + 2, 5000, NULL, &state));
+    EXPECT_EQ("ThermalHot", state);
+
+    // Only the components ThermalHot sheds are stopped, Wi-Fi is kept until critical
+    EXPECT_TRUE(ran("systemctl stop harvester.service"));
+    EXPECT_TRUE(ran("systemctl stop CcspLMLite.service"));
+    EXPECT_FALSE(ran("systemctl stop ccspwifiagent.service"));
+
+    // The agent keeps running on degraded radios
+    EXPECT_TRUE(wifi.radio(0).enabled);
+    EXPECT_EQ(50, wifi.radio(1).txPowerPercent);
+    EXPECT_EQ(2, wifi.radio(1).streams);
+    EXPECT_FALSE(wifi.radio(2).enabled);
+}
+
+TEST(Boot, ReloadsPolicyWithoutRestart)
+{
+    std::string value;
+
+    ASSERT_TRUE(loop.joinable());
+    int reloads = SyseventStub::setCount("rdkb-power-policy-reloads");
+    int published = SyseventStub::setCount("rdkb-power-state");
+
+    installPolicy("state ThermalCritical off\n"
+                  "timing ThermalHot 0 0\n"
+                  "timing ThermalCooled 0 0\n");
+    ASSERT_TRUE(SyseventStub::waitForSet("rdkb-power-policy-reloads", reloads + 1, 5000, NULL, &value));
+    EXPECT_EQ("1", value);
+
+    // This device no longer has a critical state
+    SyseventStub::inject("rdkb-power-transition", "POWER_TRANS_CRITICAL");
+    ASSERT_TRUE(PwrMgr_WaitIdle(5000));
+    EXPECT_EQ(published, SyseventStub::setCount("rdkb-power-state"));
+
+    // New components wait for a restart, the timing above still applies
+    installPolicy("component xdns CcspXdns.service\n");
+    SyseventStub::inject("rdkb-power-transition", "POWER_TRANS_COOLED");
+    ASSERT_TRUE(SyseventStub::waitForSet("rdkb-power-state", published + 1, 5000, NULL, &value));
+    EXPECT_EQ("ThermalCooled", value);
+    EXPECT_TRUE(ran("systemctl start harvester.service"));
+    EXPECT_FALSE(ran("systemctl start ccspwifiagent.service"));
+    EXPECT_EQ(reloads + 1, SyseventStub::setCount("rdkb-power-policy-reloads"));
+    EXPECT_EQ(100, wifi.radio(1).txPowerPercent);
+    EXPECT_EQ(4, wifi.radio(1).streams);
+    EXPECT_TRUE(wifi.radio(2).enabled);
+}
+
+TEST(Boot, ShutsDownOnSighup)
+{
+    ASSERT_TRUE(loop.joinable());
+
+    auto start = std::chrono::steady_clock::now();
+    // What the unit's ExecStop sends
+    pthread_kill(loop.native_handle(), SIGHUP);
+    loop.join();
+    PwrMgr_Term();
+    unlink(PWRMGR_WIFI_BASELINE_FILE);
+    unlink(policyPath.c_str());
+    rmdir(policyDir.c_str());
+    long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_LT(elapsed, 500);
+    printf("shutdown: %ld ms\n", elapsed);
+}
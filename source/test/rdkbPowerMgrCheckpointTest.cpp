@@ -0,0 +1,112 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <string>
+#include "gtest/gtest.h"
+#include "pwrMgr_checkpoint.h"
+
+class CheckpointTest : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        path = "/tmp/pwrMgrCheckpointTest." + std::to_string(getpid());
+        unlink(path.c_str());
+    }
+
+    void TearDown()
+    {
+        unlink(path.c_str());
+    }
+
+    PWRMGR_Checkpoint sample()
+    {
+        PWRMGR_Checkpoint cp = {};
+        cp.seq = 7;
+        cp.state = PWRMGR_STATE_AC;
+        cp.target = PWRMGR_STATE_HOT;
+        cp.axes[PWRMGR_AXIS_SUPPLY] = PWRMGR_STATE_AC;
+        cp.axes[PWRMGR_AXIS_THERMAL] = PWRMGR_STATE_HOT;
+        cp.running = 0x5;
+        cp.compCount = 4;
+        return cp;
+    }
+
+    std::string path;
+};
+
+TEST_F(CheckpointTest, RoundTrip)
+{
+    PWRMGR_Checkpoint cp = sample();
+    PWRMGR_Checkpoint loaded;
+
+    ASSERT_EQ(0, PwrMgr_Checkpoint_Save(path.c_str(), &cp));
+    ASSERT_EQ(0, PwrMgr_Checkpoint_Load(path.c_str(), &loaded));
+    EXPECT_EQ(7u, loaded.seq);
+    EXPECT_EQ(PWRMGR_STATE_AC, loaded.state);
+    EXPECT_EQ(PWRMGR_STATE_HOT, loaded.target);
+    EXPECT_EQ(PWRMGR_STATE_HOT, loaded.axes[PWRMGR_AXIS_THERMAL]);
+    EXPECT_EQ(0x5u, loaded.running);
+    EXPECT_EQ(4, loaded.compCount);
+    // Nothing left behind from the atomic replace
+    EXPECT_NE(0, access((path + ".tmp").c_str(), F_OK));
+}
+
+TEST_F(CheckpointTest, RejectsDamagedFiles)
+{
+    PWRMGR_Checkpoint cp = sample();
+    PWRMGR_Checkpoint loaded;
+    char byte;
+    int fd;
+
+    EXPECT_NE(0, PwrMgr_Checkpoint_Load(path.c_str(), &loaded));
+
+    ASSERT_EQ(0, PwrMgr_Checkpoint_Save(path.c_str(), &cp));
+    fd = open(path.c_str(), O_RDWR);
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(1, pread(fd, &byte, 1, 16));
+    byte ^= 0x40;
+    ASSERT_EQ(1, pwrite(fd, &byte, 1, 16));
+    close(fd);
+    EXPECT_NE(0, PwrMgr_Checkpoint_Load(path.c_str(), &loaded));
+
+    ASSERT_EQ(0, PwrMgr_Checkpoint_Save(path.c_str(), &cp));
+    ASSERT_EQ(0, truncate(path.c_str(), sizeof(cp) - 1));
+    EXPECT_NE(0, PwrMgr_Checkpoint_Load(path.c_str(), &loaded));
+
+    // A thermal level saved as the supply
+    cp.axes[PWRMGR_AXIS_SUPPLY] = PWRMGR_STATE_HOT;
+    ASSERT_EQ(0, PwrMgr_Checkpoint_Save(path.c_str(), &cp));
+    EXPECT_NE(0, PwrMgr_Checkpoint_Load(path.c_str(), &loaded));
+}
+
+TEST_F(CheckpointTest, LockAllowsOneInstance)
+{
+    int first = PwrMgr_Checkpoint_Lock(path.c_str());
+    ASSERT_GE(first, 0);
+    EXPECT_LT(PwrMgr_Checkpoint_Lock(path.c_str()), 0);
+
+    // A stale pid file is no obstacle once its owner is gone
+    close(first);
+    int second = PwrMgr_Checkpoint_Lock(path.c_str());
+    EXPECT_GE(second, 0);
+    close(second);
+}
@@ -0,0 +1,103 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "gtest/gtest.h"
+#include "pwrMgr_coalesce.h"
+
+class CoalesceTest : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        PwrMgr_Coalesce_Init(&co, PWRMGR_STATE_AC, 0);
+        PwrMgr_Coalesce_SetTiming(&co, PWRMGR_STATE_AC, 2000, 0);
+        PwrMgr_Coalesce_SetTiming(&co, PWRMGR_STATE_HOT, 0, 30000);
+        PwrMgr_Coalesce_SetTiming(&co, PWRMGR_STATE_COOLED, 5000, 0);
+    }
+
+    PWRMGR_Coalescer co;
+};
+
+TEST_F(CoalesceTest, RequestForCurrentStateIsDropped)
+{
+    PWRMGR_PwrState target;
+
+    PwrMgr_Coalesce_Post(&co, PWRMGR_STATE_AC, 10);
+    EXPECT_EQ(-1, PwrMgr_Coalesce_Next(&co, 10, &target));
+    EXPECT_EQ(1u, co.stats.sameState);
+}
+
+TEST_F(CoalesceTest, LatestRequestWins)
+{
+    PWRMGR_PwrState target = PWRMGR_STATE_UNKNOWN;
+
+    PwrMgr_Coalesce_Post(&co, PWRMGR_STATE_COOLED, 0);
+    PwrMgr_Coalesce_Post(&co, PWRMGR_STATE_HOT, 100);
+    EXPECT_EQ(0, PwrMgr_Coalesce_Next(&co, 100, &target));
+    EXPECT_EQ(PWRMGR_STATE_HOT, target);
+    EXPECT_EQ(1u, co.stats.coalesced);
+    EXPECT_EQ(1u, co.stats.executed);
+}
+
+TEST_F(CoalesceTest, HysteresisAbsorbsFlapping)
+{
+    PWRMGR_PwrState target;
+
+    PwrMgr_Coalesce_Done(&co, PWRMGR_STATE_COOLED, 0);
+    // Supply flaps AC/cooled five times within the AC hysteresis window
+    for (int i = 0; i < 5; i++)
+    {
+        PwrMgr_Coalesce_Post(&co, PWRMGR_STATE_AC, 100 + i * 200);
+        EXPECT_EQ(2000, PwrMgr_Coalesce_Next(&co, 100 + i * 200, &target));
+        PwrMgr_Coalesce_Post(&co, PWRMGR_STATE_COOLED, 200 + i * 200);
+        EXPECT_EQ(-1, PwrMgr_Coalesce_Next(&co, 200 + i * 200, &target));
+    }
+    EXPECT_EQ(0u, co.stats.executed);
+    EXPECT_EQ(5u, co.stats.flapped);
+    EXPECT_EQ(5u, PwrMgr_Coalesce_Suppressed(&co));
+}
+
+TEST_F(CoalesceTest, MinimumDwellDelaysLeavingHot)
+{
+    PWRMGR_PwrState target = PWRMGR_STATE_UNKNOWN;
+
+    PwrMgr_Coalesce_Done(&co, PWRMGR_STATE_HOT, 1000);
+    PwrMgr_Coalesce_Post(&co, PWRMGR_STATE_COOLED, 2000);
+    // Dwell (1000 + 30000) outlasts the cooled hysteresis (2000 + 5000)
+    EXPECT_EQ(29000, PwrMgr_Coalesce_Next(&co, 2000, &target));
+    EXPECT_EQ(0, PwrMgr_Coalesce_Next(&co, 31000, &target));
+    EXPECT_EQ(PWRMGR_STATE_COOLED, target);
+}
+
+TEST_F(CoalesceTest, EscalationSkipsDwell)
+{
+    PWRMGR_PwrState target = PWRMGR_STATE_UNKNOWN;
+
+    PwrMgr_Coalesce_SetTiming(&co, PWRMGR_STATE_CRITICAL, 0, 30000);
+    PwrMgr_Coalesce_SetSeverity(&co, PWRMGR_STATE_HOT, 2);
+    PwrMgr_Coalesce_SetSeverity(&co, PWRMGR_STATE_CRITICAL, 3);
+    PwrMgr_Coalesce_Done(&co, PWRMGR_STATE_HOT, 1000);
+    // Getting hotter must not wait out the HOT dwell
+    PwrMgr_Coalesce_Post(&co, PWRMGR_STATE_CRITICAL, 2000);
+    EXPECT_EQ(0, PwrMgr_Coalesce_Next(&co, 2000, &target));
+    EXPECT_EQ(PWRMGR_STATE_CRITICAL, target);
+    PwrMgr_Coalesce_Done(&co, PWRMGR_STATE_CRITICAL, 2000);
+    PwrMgr_Coalesce_Post(&co, PWRMGR_STATE_HOT, 3000);
+    EXPECT_EQ(29000, PwrMgr_Coalesce_Next(&co, 3000, &target));
+}
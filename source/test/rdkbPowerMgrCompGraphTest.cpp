@@ -0,0 +1,294 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include "gtest/gtest.h"
+#include "MockUnitCtl.h"
+#include "pwrMgr_compgraph.h"
+
+static long position(const std::vector<std::string> &history, const std::string &entry)
+{
+    return std::find(history.begin(), history.end(), entry) - history.begin();
+}
+
+TEST(CompGraph, RejectsCycleAndUnknownNames)
+{
+    PWRMGR_CompGraph graph;
+    char bad[] = "stop_before a nosuch";
+
+    PwrMgr_CompGraph_Init(&graph);
+    PwrMgr_CompGraph_AddComponent(&graph, "a", "a.service");
+    PwrMgr_CompGraph_AddComponent(&graph, "b", "b.service");
+    EXPECT_EQ(-1, PwrMgr_CompGraph_ParseLine(&graph, bad));
+    EXPECT_EQ(0, PwrMgr_CompGraph_AddStopBefore(&graph, "a", "b"));
+    EXPECT_EQ(0, PwrMgr_CompGraph_Validate(&graph));
+    EXPECT_EQ(0, PwrMgr_CompGraph_AddStopBefore(&graph, "b", "a"));
+    EXPECT_EQ(-1, PwrMgr_CompGraph_Validate(&graph));
+}
+
+TEST(CompGraph, StopHonoursEdgesAndRunsCriticalPath)
+{
+    MockUnitCtl mock;
+    PWRMGR_CompGraph graph;
+    PWRMGR_CompMask failed = 1;
+
+    PwrMgr_CompGraph_LoadDefaults(&graph);
+    mock.setDefaultLatency(40);
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(0, PwrMgr_CompGraph_Run(&graph, mock.ctl(), PWRMGR_UNIT_STOP, PwrMgr_CompGraph_AllMask(&graph), 1000, NULL, NULL, NULL, &failed));
+    long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_EQ(0u, failed);
+    // harvester/lmlite -> wifi is the critical path, moca runs alongside
+    EXPECT_GE(elapsed, 80);
+    EXPECT_LT(elapsed, 150);
+    const std::vector<std::string> &h = mock.history();
+    EXPECT_LT(position(h, "stop harvester.service"), position(h, "stop ccspwifiagent.service"));
+    EXPECT_LT(position(h, "stop CcspLMLite.service"), position(h, "stop ccspwifiagent.service"));
+    printf("stop via graph: %ld ms (serial would be 160 ms)\n", elapsed);
+}
+
+TEST(CompGraph, StartSubsetIgnoresEdgesOutsideMask)
+{
+    MockUnitCtl mock;
+    PWRMGR_CompGraph graph;
+    PWRMGR_CompMask failed = 0;
+
+    PwrMgr_CompGraph_LoadDefaults(&graph);
+    mock.setFailure("CcspMoca.service");
+
+    // wifi is already running, harvester must not wait for it
+    PWRMGR_CompMask mask = PWRMGR_COMP_BIT(PwrMgr_CompGraph_Find(&graph, "harvester")) |
+                           PWRMGR_COMP_BIT(PwrMgr_CompGraph_Find(&graph, "moca"));
+    EXPECT_EQ(-1, PwrMgr_CompGraph_Run(&graph, mock.ctl(), PWRMGR_UNIT_START, mask, 1000, NULL, NULL, NULL, &failed));
+    EXPECT_EQ(PWRMGR_COMP_BIT(PwrMgr_CompGraph_Find(&graph, "moca")), failed);
+    EXPECT_EQ(2u, mock.history().size());
+}
+
+static bool cancelAfterFirstJob(void *arg)
+{
+    return static_cast<MockUnitCtl *>(arg)->history().size() >= 1;
+}
+
+TEST(CompGraph, CancelledRunDrainsInflightJobs)
+{
+    MockUnitCtl mock;
+    PWRMGR_CompGraph graph;
+    PWRMGR_CompMask completed = 0;
+    PWRMGR_CompMask failed = 1;
+    char line1[] = "component a a.service";
+    char line2[] = "component b b.service";
+    char line3[] = "stop_before a b";
+
+    PwrMgr_CompGraph_Init(&graph);
+    PwrMgr_CompGraph_ParseLine(&graph, line1);
+    PwrMgr_CompGraph_ParseLine(&graph, line2);
+    PwrMgr_CompGraph_ParseLine(&graph, line3);
+    mock.setDefaultLatency(10);
+
+    EXPECT_EQ(0, PwrMgr_CompGraph_Run(&graph, mock.ctl(), PWRMGR_UNIT_STOP, PwrMgr_CompGraph_AllMask(&graph), 1000,
+                                      cancelAfterFirstJob, &mock, &completed, &failed));
+    EXPECT_EQ(PWRMGR_COMP_BIT(0), completed);
+    EXPECT_EQ(0u, failed);
+    EXPECT_EQ(1u, mock.history().size());
+}
+
+TEST(CompGraph, StartWaitsUntilComponentsAreUp)
+{
+    MockUnitCtl mock;
+    PWRMGR_CompGraph graph;
+    PWRMGR_CompMask failed = 1;
+    char path[] = "/tmp/pwrMgrReadyXXXXXX";
+    int fd = mkstemp(path);
+    std::string ready = std::string("ready wifi 1000 ") + path;
+
+    ASSERT_GE(fd, 0);
+    close(fd);
+    unlink(path);
+    PwrMgr_CompGraph_LoadDefaults(&graph);
+    ASSERT_EQ(0, PwrMgr_CompGraph_ParseLine(&graph, &ready[0]));
+    mock.setDefaultLatency(20);
+    // The start job is done long before the Wi-Fi agent is
+    mock.setActivation("ccspwifiagent.service", 100);
+    std::thread agent([&path] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(120));
+        close(open(path, O_CREAT | O_WRONLY, 0644));
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(0, PwrMgr_CompGraph_Run(&graph, mock.ctl(), PWRMGR_UNIT_START, PwrMgr_CompGraph_AllMask(&graph), 1000, NULL, NULL, NULL, &failed));
+    long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    agent.join();
+    unlink(path);
+
+    EXPECT_EQ(0u, failed);
+    // harvester and LMLite only start once wifi is up
+    EXPECT_GE(elapsed, 140);
+    EXPECT_LT(elapsed, 250);
+    printf("start with readiness: %ld ms\n", elapsed);
+}
+
+TEST(CompGraph, ComponentNotUpByItsDeadlineFails)
+{
+    MockUnitCtl mock;
+    PWRMGR_CompGraph graph;
+    PWRMGR_CompMask completed = 0;
+    PWRMGR_CompMask failed = 0;
+    char path[] = "/tmp/pwrMgrReadyXXXXXX";
+    int fd = mkstemp(path);
+    std::string ready = std::string("ready moca 100 ") + path;
+    char hang[] = "ready wifi 100";
+
+    ASSERT_GE(fd, 0);
+    close(fd);
+    unlink(path);
+    PwrMgr_CompGraph_LoadDefaults(&graph);
+    ASSERT_EQ(0, PwrMgr_CompGraph_ParseLine(&graph, &ready[0]));
+    ASSERT_EQ(0, PwrMgr_CompGraph_ParseLine(&graph, hang));
+    EXPECT_EQ(100, graph.comps[PwrMgr_CompGraph_Find(&graph, "moca")].readyDeadlineMs);
+    EXPECT_STREQ(path, graph.comps[PwrMgr_CompGraph_Find(&graph, "moca")].readyFile);
+    mock.setHang("ccspwifiagent.service");
+
+    // MoCA never creates its file and the Wi-Fi start job never finishes
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(-1, PwrMgr_CompGraph_Run(&graph, mock.ctl(), PWRMGR_UNIT_START, PwrMgr_CompGraph_AllMask(&graph), 1000, NULL, NULL, &completed, &failed));
+    long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    PWRMGR_CompMask moca = PWRMGR_COMP_BIT(PwrMgr_CompGraph_Find(&graph, "moca"));
+    PWRMGR_CompMask wifi = PWRMGR_COMP_BIT(PwrMgr_CompGraph_Find(&graph, "wifi"));
+
+    EXPECT_EQ(moca | wifi, failed);
+    // A failure still releases the components that start after it
+    EXPECT_EQ(PwrMgr_CompGraph_AllMask(&graph) & ~(moca | wifi), completed);
+    EXPECT_GE(elapsed, 100);
+    EXPECT_LT(elapsed, 200);
+    EXPECT_EQ(0u, mock.pendingCount());
+    // Without its file the MoCA unit is never asked about
+    EXPECT_EQ(0, mock.activeQueries());
+
+    // Up once the file is there
+    fd = open(path, O_CREAT | O_WRONLY, 0644);
+    ASSERT_GE(fd, 0);
+    close(fd);
+    EXPECT_EQ(0, PwrMgr_CompGraph_Run(&graph, mock.ctl(), PWRMGR_UNIT_START, moca, 1000, NULL, NULL, &completed, &failed));
+    EXPECT_EQ(moca, completed);
+    EXPECT_EQ(1, mock.activeQueries());
+    unlink(path);
+}
+
+TEST(CompGraph, EmergencyKillsComponentIgnoringSigterm)
+{
+    MockUnitCtl mock;
+    PWRMGR_CompGraph graph;
+    PWRMGR_CompMask completed = 0;
+    PWRMGR_CompMask failed = 1;
+    PWRMGR_CompMask overrun = 0;
+    char budget[] = "stop_budget harvester 50";
+
+    PwrMgr_CompGraph_LoadDefaults(&graph);
+    ASSERT_EQ(0, PwrMgr_CompGraph_ParseLine(&graph, budget));
+    mock.setDefaultLatency(10);
+    mock.setIgnoreTerm("harvester.service");
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(0, PwrMgr_CompGraph_Shed(&graph, mock.ctl(), PwrMgr_CompGraph_AllMask(&graph), 1000,
+                                       NULL, NULL, &completed, &failed, &overrun));
+    long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_EQ(PwrMgr_CompGraph_AllMask(&graph), completed);
+    EXPECT_EQ(0u, failed);
+    EXPECT_EQ(PWRMGR_COMP_BIT(PwrMgr_CompGraph_Find(&graph, "harvester")), overrun);
+    // SIGKILL ends it, wifi follows without waiting out the deadline
+    auto &history = mock.history();
+    EXPECT_NE(history.end(), std::find(history.begin(), history.end(), "kill harvester.service"));
+    EXPECT_EQ(history.end(), std::find(history.begin(), history.end(), "freeze harvester.service"));
+    EXPECT_GE(elapsed, 50);
+    EXPECT_LT(elapsed, 200);
+}
+
+TEST(CompGraph, EmergencyFreezesWhatSurvivesByTheDeadline)
+{
+    MockUnitCtl mock;
+    PWRMGR_CompGraph graph;
+    PWRMGR_CompMask completed = 0;
+    PWRMGR_CompMask failed = 1;
+    PWRMGR_CompMask overrun = 0;
+    const char *lines[] = {
+        "component a a.service", "component b b.service", "component c c.service",
+        "stop_before b c", "stop_budget a 50",
+    };
+
+    PwrMgr_CompGraph_Init(&graph);
+    for (const char *l : lines) {
+        std::string line(l);
+        ASSERT_EQ(0, PwrMgr_CompGraph_ParseLine(&graph, &line[0]));
+    }
+    mock.setDefaultLatency(10);
+    // a is stuck even after SIGKILL, b ignores SIGTERM and has no budget of its own
+    mock.setIgnoreTerm("a.service", true);
+    mock.setIgnoreTerm("b.service");
+    mock.setLatency("c.service", 0);
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(0, PwrMgr_CompGraph_Shed(&graph, mock.ctl(), PwrMgr_CompGraph_AllMask(&graph), 300,
+                                       NULL, NULL, &completed, &failed, &overrun));
+    long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_EQ(PwrMgr_CompGraph_AllMask(&graph), completed);
+    EXPECT_EQ(0u, failed);
+    EXPECT_EQ(PWRMGR_COMP_BIT(0) | PWRMGR_COMP_BIT(1), overrun);
+    // Both are frozen at the deadline, c no longer waits for b once it has passed
+    std::vector<std::string> expected = {
+        "stop a.service", "stop b.service", "kill a.service", "freeze a.service",
+        "kill b.service", "freeze b.service", "stop c.service",
+    };
+    EXPECT_EQ(expected, mock.history());
+    // The stop jobs of the frozen units do not linger into the next run
+    EXPECT_EQ(0u, mock.pendingCount());
+    EXPECT_GE(elapsed, 290);
+    EXPECT_LT(elapsed, 400);
+    printf("emergency shedding with stuck units: %ld ms\n", elapsed);
+}
+
+TEST(CompGraph, ShedMaskGrowsWithThermalLevel)
+{
+    PWRMGR_CompGraph graph;
+    char line[] = "thermal_shed moca warm";
+    char bad[] = "thermal_shed moca scorching";
+
+    PwrMgr_CompGraph_LoadDefaults(&graph);
+    PWRMGR_CompMask telemetry = PWRMGR_COMP_BIT(PwrMgr_CompGraph_Find(&graph, "harvester")) |
+                                PWRMGR_COMP_BIT(PwrMgr_CompGraph_Find(&graph, "lmlite"));
+    PWRMGR_CompMask moca = PWRMGR_COMP_BIT(PwrMgr_CompGraph_Find(&graph, "moca"));
+    PWRMGR_CompMask wifi = PWRMGR_COMP_BIT(PwrMgr_CompGraph_Find(&graph, "wifi"));
+
+    EXPECT_EQ(telemetry, PwrMgr_CompGraph_ShedMask(&graph, PWRMGR_SHED_WARM));
+    EXPECT_EQ(telemetry | moca, PwrMgr_CompGraph_ShedMask(&graph, PWRMGR_SHED_HOT));
+    EXPECT_EQ(telemetry | moca | wifi, PwrMgr_CompGraph_ShedMask(&graph, PWRMGR_SHED_CRITICAL));
+
+    EXPECT_EQ(-1, PwrMgr_CompGraph_ParseLine(&graph, bad));
+    EXPECT_EQ(0, PwrMgr_CompGraph_ParseLine(&graph, line));
+    EXPECT_EQ(telemetry | moca, PwrMgr_CompGraph_ShedMask(&graph, PWRMGR_SHED_WARM));
+}
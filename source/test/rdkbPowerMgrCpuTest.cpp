@@ -0,0 +1,179 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "gtest/gtest.h"
+#include "pwrMgr_cpu.h"
+
+// Fake sysfs: cpu0..cpu3 at 400-2000 MHz, cpu0 cannot be hotplugged
+class CpuTest : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        char tmpl[] = "/tmp/pwrMgrCpuXXXXXX";
+        ASSERT_NE(nullptr, mkdtemp(tmpl));
+        root = tmpl;
+        baseline = root + "/baseline";
+        for (int i = 0; i < 4; i++)
+        {
+            std::string cpu = "cpu" + std::to_string(i);
+            ASSERT_EQ(0, mkdir((root + "/" + cpu).c_str(), 0755));
+            ASSERT_EQ(0, mkdir((root + "/" + cpu + "/cpufreq").c_str(), 0755));
+            if (i > 0)
+                writeFile(cpu + "/online", "1\n");
+            writeFile(cpu + "/cpufreq/scaling_governor", "schedutil\n");
+            writeFile(cpu + "/cpufreq/scaling_max_freq", "1800000\n");
+            writeFile(cpu + "/cpufreq/cpuinfo_max_freq", "2000000\n");
+            writeFile(cpu + "/cpufreq/cpuinfo_min_freq", "400000\n");
+        }
+    }
+
+    void TearDown()
+    {
+        std::string cmd = "rm -rf " + root;
+        ASSERT_EQ(0, system(cmd.c_str()));
+    }
+
+    void writeFile(const std::string &name, const std::string &value)
+    {
+        std::ofstream(root + "/" + name) << value;
+    }
+
+    std::string readFile(const std::string &name)
+    {
+        std::stringstream ss;
+        ss << std::ifstream(root + "/" + name).rdbuf();
+        std::string value = ss.str();
+        return value.substr(0, value.find('\n'));
+    }
+
+    std::string online()
+    {
+        std::string mask;
+        for (int i = 1; i < 4; i++)
+            mask += readFile("cpu" + std::to_string(i) + "/online");
+        return mask;
+    }
+
+    std::string root;
+    std::string baseline;
+    PWRMGR_CpuActuator act;
+};
+
+TEST_F(CpuTest, CapsThenRestores)
+{
+    ASSERT_EQ(0, PwrMgr_Cpu_Open(&act, root.c_str(), baseline.c_str()));
+    EXPECT_EQ(4, act.count);
+
+    // Warm: a lower clock, every core stays
+    ASSERT_EQ(0, PwrMgr_Cpu_Apply(&act, PWRMGR_STATE_WARM));
+    EXPECT_EQ("1600000", readFile("cpu3/cpufreq/scaling_max_freq"));
+    EXPECT_EQ("111", online());
+
+    // Hot: lower still, the top two cores parked
+    ASSERT_EQ(0, PwrMgr_Cpu_Apply(&act, PWRMGR_STATE_HOT));
+    EXPECT_EQ("1200000", readFile("cpu0/cpufreq/scaling_max_freq"));
+    EXPECT_EQ("1200000", readFile("cpu1/cpufreq/scaling_max_freq"));
+    EXPECT_EQ("100", online());
+
+    ASSERT_EQ(0, PwrMgr_Cpu_Apply(&act, PWRMGR_STATE_COOLED));
+    EXPECT_EQ("111", online());
+    for (int i = 0; i < 4; i++)
+    {
+        std::string cpu = "cpu" + std::to_string(i);
+        EXPECT_EQ("1800000", readFile(cpu + "/cpufreq/scaling_max_freq"));
+        EXPECT_EQ("schedutil", readFile(cpu + "/cpufreq/scaling_governor"));
+    }
+}
+
+TEST_F(CpuTest, BaselineSurvivesRestart)
+{
+    PWRMGR_CpuActuator restarted;
+
+    ASSERT_EQ(0, PwrMgr_Cpu_Open(&act, root.c_str(), baseline.c_str()));
+    ASSERT_EQ(0, PwrMgr_Cpu_Apply(&act, PWRMGR_STATE_CRITICAL));
+    EXPECT_EQ("powersave", readFile("cpu0/cpufreq/scaling_governor"));
+    EXPECT_EQ("000", online());
+
+    // A new instance sees the capped cores but restores what they were at boot
+    ASSERT_EQ(0, PwrMgr_Cpu_Open(&restarted, root.c_str(), baseline.c_str()));
+    ASSERT_EQ(0, PwrMgr_Cpu_Apply(&restarted, PWRMGR_STATE_AC));
+    EXPECT_EQ("111", online());
+    EXPECT_EQ("schedutil", readFile("cpu3/cpufreq/scaling_governor"));
+    EXPECT_EQ("1800000", readFile("cpu3/cpufreq/scaling_max_freq"));
+}
+
+TEST_F(CpuTest, LeavesOfflineCoresAlone)
+{
+    PWRMGR_CpuProfile profile = { "", 50, 3 };
+
+    writeFile("cpu1/online", "0\n");
+    ASSERT_EQ(0, PwrMgr_Cpu_Open(&act, root.c_str(), baseline.c_str()));
+    PwrMgr_Cpu_SetProfile(&act, PWRMGR_STATE_HOT, &profile);
+
+    // cpu1 was off at boot, the three cores left are cpu0, cpu2 and cpu3
+    ASSERT_EQ(0, PwrMgr_Cpu_Apply(&act, PWRMGR_STATE_HOT));
+    EXPECT_EQ("011", online());
+    EXPECT_EQ("1800000", readFile("cpu1/cpufreq/scaling_max_freq"));
+    EXPECT_EQ("1000000", readFile("cpu2/cpufreq/scaling_max_freq"));
+    ASSERT_EQ(0, PwrMgr_Cpu_Apply(&act, PWRMGR_STATE_AC));
+    EXPECT_EQ("011", online());
+}
+
+TEST_F(CpuTest, ClampsToHardwareMinimum)
+{
+    PWRMGR_CpuProfile profile = { "", 10, 0 };
+
+    ASSERT_EQ(0, PwrMgr_Cpu_Open(&act, root.c_str(), baseline.c_str()));
+    PwrMgr_Cpu_SetProfile(&act, PWRMGR_STATE_WARM, &profile);
+    ASSERT_EQ(0, PwrMgr_Cpu_Apply(&act, PWRMGR_STATE_WARM));
+    EXPECT_EQ("400000", readFile("cpu0/cpufreq/scaling_max_freq"));
+}
+
+TEST_F(CpuTest, MergesTheProfilesOfBothAxes)
+{
+    PWRMGR_CpuProfile supply = { "", 40, 0 };
+    PWRMGR_PwrState states[] = { PWRMGR_STATE_WARM, PWRMGR_STATE_HOT };
+
+    ASSERT_EQ(0, PwrMgr_Cpu_Open(&act, root.c_str(), baseline.c_str()));
+    PwrMgr_Cpu_SetProfile(&act, PWRMGR_STATE_WARM, &supply);
+
+    // The lower clock of one and the fewer cores of the other
+    ASSERT_EQ(0, PwrMgr_Cpu_ApplyStates(&act, states, 2));
+    EXPECT_EQ("800000", readFile("cpu0/cpufreq/scaling_max_freq"));
+    EXPECT_EQ("100", online());
+
+    // Powersave wins whichever axis asks for it
+    states[0] = PWRMGR_STATE_CRITICAL;
+    ASSERT_EQ(0, PwrMgr_Cpu_ApplyStates(&act, states, 2));
+    EXPECT_EQ("powersave", readFile("cpu0/cpufreq/scaling_governor"));
+    EXPECT_EQ("1200000", readFile("cpu0/cpufreq/scaling_max_freq"));
+    EXPECT_EQ("000", online());
+
+    // An unchanged merge writes nothing
+    writeFile("cpu0/cpufreq/scaling_max_freq", "1800000\n");
+    ASSERT_EQ(0, PwrMgr_Cpu_ApplyStates(&act, states, 2));
+    EXPECT_EQ("1800000", readFile("cpu0/cpufreq/scaling_max_freq"));
+}
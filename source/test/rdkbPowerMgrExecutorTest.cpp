@@ -0,0 +1,298 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "pwrMgr_executor.h"
+#include "pwrMgr_stats.h"
+
+// Fake component controller: components are handled one after the other,
+// each taking latencyMs, and cancellation is honoured between components.
+class FakeCompCtl
+{
+public:
+    FakeCompCtl() : latencyMs(40), reachedCount(0), lastReached(PWRMGR_STATE_UNKNOWN) {}
+
+    static int run(void *ctx, PWRMGR_PwrState target, PWRMGR_UnitOp op, PWRMGR_CompMask mask,
+                   PWRMGR_CancelFn cancelled, void *cancelArg, PWRMGR_CompMask *completed)
+    {
+        FakeCompCtl *self = static_cast<FakeCompCtl *>(ctx);
+        (void)target;
+        *completed = 0;
+        for (int i = 0; i < 32; i++)
+        {
+            if (!(mask & PWRMGR_COMP_BIT(i)))
+                continue;
+            if (cancelled(cancelArg))
+                break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(self->latencyMs));
+            *completed |= PWRMGR_COMP_BIT(i);
+            std::lock_guard<std::mutex> guard(self->lock);
+            self->history.push_back(std::string(PwrMgr_UnitCtl_OpStr(op)) + " " + std::to_string(i));
+        }
+        return 0;
+    }
+
+    static void reached(void *ctx, PWRMGR_PwrState from, PWRMGR_PwrState target, bool success)
+    {
+        FakeCompCtl *self = static_cast<FakeCompCtl *>(ctx);
+        (void)from;
+        std::lock_guard<std::mutex> guard(self->lock);
+        self->reachedCount++;
+        self->lastReached = target;
+        EXPECT_TRUE(success);
+    }
+
+    int count(const std::string &prefix)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        int n = 0;
+        for (size_t i = 0; i < history.size(); i++)
+            n += (history[i].compare(0, prefix.size(), prefix) == 0);
+        return n;
+    }
+
+    static void progress(void *ctx, PWRMGR_PwrState state, PWRMGR_PwrState target, PWRMGR_CompMask running)
+    {
+        FakeCompCtl *self = static_cast<FakeCompCtl *>(ctx);
+        std::lock_guard<std::mutex> guard(self->lock);
+        self->checkpoints.push_back(std::to_string(state) + ">" + std::to_string(target) + " " + std::to_string(running));
+    }
+
+    int latencyMs;
+    std::mutex lock;
+    std::vector<std::string> checkpoints;
+    std::vector<std::string> history;
+    int reachedCount;
+    PWRMGR_PwrState lastReached;
+};
+
+static const PWRMGR_ExecOps fakeOps = { FakeCompCtl::run, FakeCompCtl::reached, NULL };
+
+class ExecutorTest : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        PwrMgr_Exec_Init(&ex, &fakeOps, &fake, PWRMGR_STATE_AC, 0xF);
+        PwrMgr_Exec_SetRunMask(&ex, PWRMGR_STATE_AC, 0xF);
+        PwrMgr_Exec_SetRunMask(&ex, PWRMGR_STATE_COOLED, 0xF);
+        PwrMgr_Exec_SetRunMask(&ex, PWRMGR_STATE_HOT, 0);
+        ASSERT_EQ(0, PwrMgr_Exec_Start(&ex));
+    }
+
+    void TearDown()
+    {
+        PwrMgr_Exec_Stop(&ex);
+    }
+
+    FakeCompCtl fake;
+    PWRMGR_Executor ex;
+};
+
+TEST_F(ExecutorTest, CompletesTransition)
+{
+    PWRMGR_PwrState state;
+    PWRMGR_CompMask running;
+    PWRMGR_Stats stats;
+
+    PwrMgr_Stats_Reset();
+    PwrMgr_Exec_Post(&ex, PWRMGR_STATE_HOT);
+    ASSERT_TRUE(PwrMgr_Exec_WaitIdle(&ex, 2000));
+    PwrMgr_Exec_GetStatus(&ex, &state, &running, NULL, NULL);
+    EXPECT_EQ(PWRMGR_STATE_HOT, state);
+    EXPECT_EQ(0u, running);
+    EXPECT_EQ(4, fake.count("stop"));
+    EXPECT_EQ(1, fake.reachedCount);
+
+    // Four components at 40 ms each, end to end from the request
+    PwrMgr_Stats_Get(&stats);
+    EXPECT_EQ(1u, stats.phase[PWRMGR_PHASE_QUEUE].count);
+    EXPECT_EQ(1u, stats.phase[PWRMGR_PHASE_EXECUTE].count);
+    EXPECT_EQ(1u, stats.edge[PWRMGR_STATE_AC][PWRMGR_STATE_HOT].count);
+    EXPECT_GE(stats.edge[PWRMGR_STATE_AC][PWRMGR_STATE_HOT].maxUs, 160000u);
+    EXPECT_EQ(stats.lastTotalUs, stats.edge[PWRMGR_STATE_AC][PWRMGR_STATE_HOT].maxUs);
+}
+
+TEST_F(ExecutorTest, ReversalOnlyRestartsWhatWasStopped)
+{
+    PWRMGR_PwrState state;
+    PWRMGR_CompMask running;
+    PWRMGR_ExecStats stats;
+
+    PwrMgr_Exec_Post(&ex, PWRMGR_STATE_HOT);
+    // Cooled down again while the teardown is half way through
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    PwrMgr_Exec_Post(&ex, PWRMGR_STATE_COOLED);
+    ASSERT_TRUE(PwrMgr_Exec_WaitIdle(&ex, 2000));
+
+    PwrMgr_Exec_GetStatus(&ex, &state, &running, &stats, NULL);
+    EXPECT_EQ(PWRMGR_STATE_COOLED, state);
+    EXPECT_EQ(0xFu, running);
+    EXPECT_EQ(1u, stats.preempted);
+    EXPECT_LT(fake.count("stop"), 4);
+    EXPECT_EQ(fake.count("stop"), fake.count("start"));
+    EXPECT_EQ(PWRMGR_STATE_COOLED, fake.lastReached);
+}
+
+TEST_F(ExecutorTest, SupplyRequestKeepsThermalShedding)
+{
+    PWRMGR_PwrState state;
+    PWRMGR_CompMask running;
+    PWRMGR_PowerVector reached;
+
+    // AC -> HOT -> AC used to restart everything while still hot
+    PwrMgr_Exec_SetRunMask(&ex, PWRMGR_STATE_WARM, 0x3);
+    PwrMgr_Exec_Post(&ex, PWRMGR_STATE_HOT);
+    ASSERT_TRUE(PwrMgr_Exec_WaitIdle(&ex, 2000));
+    PwrMgr_Exec_Post(&ex, PWRMGR_STATE_AC);
+    ASSERT_TRUE(PwrMgr_Exec_WaitIdle(&ex, 2000));
+    PwrMgr_Exec_GetStatus(&ex, &state, &running, NULL, NULL);
+    EXPECT_EQ(PWRMGR_STATE_HOT, state);
+    EXPECT_EQ(0u, running);
+    EXPECT_EQ(0, fake.count("start"));
+
+    // Cooling down one level only starts what the new level runs
+    PwrMgr_Exec_Post(&ex, PWRMGR_STATE_WARM);
+    ASSERT_TRUE(PwrMgr_Exec_WaitIdle(&ex, 2000));
+    PwrMgr_Exec_GetStatus(&ex, &state, &running, NULL, NULL);
+    PwrMgr_Exec_GetVectors(&ex, &reached, NULL);
+    EXPECT_EQ(0x3u, running);
+    EXPECT_EQ(2, fake.count("start"));
+    EXPECT_EQ(PWRMGR_STATE_AC, reached.axis[PWRMGR_AXIS_SUPPLY]);
+    EXPECT_EQ(PWRMGR_STATE_WARM, reached.axis[PWRMGR_AXIS_THERMAL]);
+}
+
+TEST_F(ExecutorTest, FlapInsideHysteresisResumesTransition)
+{
+    PWRMGR_PwrState state;
+    PWRMGR_CompMask running;
+
+    PwrMgr_Exec_SetTiming(&ex, PWRMGR_STATE_COOLED, 500, 0);
+    PwrMgr_Exec_Post(&ex, PWRMGR_STATE_HOT);
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    // The sensor dips for a moment: the teardown holds, then carries on
+    PwrMgr_Exec_Post(&ex, PWRMGR_STATE_COOLED);
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    PwrMgr_Exec_Post(&ex, PWRMGR_STATE_HOT);
+    ASSERT_TRUE(PwrMgr_Exec_WaitIdle(&ex, 2000));
+
+    PwrMgr_Exec_GetStatus(&ex, &state, &running, NULL, NULL);
+    EXPECT_EQ(PWRMGR_STATE_HOT, state);
+    EXPECT_EQ(0u, running);
+    EXPECT_EQ(4, fake.count("stop"));
+    EXPECT_EQ(0, fake.count("start"));
+}
+
+static const PWRMGR_ExecOps checkpointOps = { FakeCompCtl::run, FakeCompCtl::reached, NULL, NULL, FakeCompCtl::progress };
+
+TEST(ExecutorResume, OnlyFinishesWhatIsLeft)
+{
+    FakeCompCtl fake;
+    PWRMGR_Executor ex;
+    PWRMGR_PwrState state;
+    PWRMGR_CompMask running;
+
+    // The last instance died with two of the four components stopped on the way to HOT
+    PwrMgr_Exec_Init(&ex, &checkpointOps, &fake, PWRMGR_STATE_AC, 0xC);
+    PwrMgr_Exec_SetRunMask(&ex, PWRMGR_STATE_AC, 0xF);
+    PwrMgr_Exec_SetRunMask(&ex, PWRMGR_STATE_HOT, 0);
+    PwrMgr_Exec_Resume(&ex, PWRMGR_STATE_HOT);
+    ASSERT_EQ(0, PwrMgr_Exec_Start(&ex));
+    ASSERT_TRUE(PwrMgr_Exec_WaitIdle(&ex, 2000));
+
+    PwrMgr_Exec_GetStatus(&ex, &state, &running, NULL, NULL);
+    PwrMgr_Exec_Stop(&ex);
+    EXPECT_EQ(PWRMGR_STATE_HOT, state);
+    EXPECT_EQ(0u, running);
+    EXPECT_EQ(2, fake.count("stop"));
+    EXPECT_EQ(0, fake.count("start"));
+
+    // Started, one stop step, reached: the last checkpoint is idle in HOT
+    std::string ac = std::to_string(PWRMGR_STATE_AC), hot = std::to_string(PWRMGR_STATE_HOT);
+    ASSERT_EQ(3u, fake.checkpoints.size());
+    EXPECT_EQ(ac + ">" + hot + " 12", fake.checkpoints[0]);
+    EXPECT_EQ(ac + ">" + hot + " 0", fake.checkpoints[1]);
+    EXPECT_EQ(hot + ">" + hot + " 0", fake.checkpoints[2]);
+}
+
+// Holds back the requests for HOT while holdMs is set
+static long holdHotMs = 0;
+
+static long holdHot(void *ctx, PWRMGR_PwrState target, PWRMGR_CompMask stops)
+{
+    (void)ctx;
+    return (target == PWRMGR_STATE_HOT && stops != 0) ? holdHotMs : 0;
+}
+
+static const PWRMGR_ExecOps inhibitOps = { FakeCompCtl::run, FakeCompCtl::reached, NULL, NULL, NULL, NULL, holdHot, NULL };
+
+TEST(ExecutorInhibit, HeldRequestWaitsForTheLock)
+{
+    FakeCompCtl fake;
+    PWRMGR_Executor ex;
+    PWRMGR_PwrState state;
+    PWRMGR_CompMask running;
+    PWRMGR_ExecStats stats;
+
+    fake.latencyMs = 0;
+    holdHotMs = 10000;
+    PwrMgr_Exec_Init(&ex, &inhibitOps, &fake, PWRMGR_STATE_AC, 0xF);
+    PwrMgr_Exec_SetRunMask(&ex, PWRMGR_STATE_AC, 0xF);
+    PwrMgr_Exec_SetRunMask(&ex, PWRMGR_STATE_COOLED, 0xF);
+    PwrMgr_Exec_SetRunMask(&ex, PWRMGR_STATE_WARM, 0x3);
+    PwrMgr_Exec_SetRunMask(&ex, PWRMGR_STATE_HOT, 0);
+    ASSERT_EQ(0, PwrMgr_Exec_Start(&ex));
+
+    // A held back request does not count as pending and stops nothing
+    PwrMgr_Exec_Post(&ex, PWRMGR_STATE_HOT);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    ASSERT_TRUE(PwrMgr_Exec_WaitIdle(&ex, 2000));
+    PwrMgr_Exec_GetStatus(&ex, &state, &running, &stats, NULL);
+    EXPECT_EQ(PWRMGR_STATE_AC, state);
+    EXPECT_EQ(0xFu, running);
+    EXPECT_EQ(0, fake.count("stop"));
+    EXPECT_EQ(1u, stats.deferred);
+
+    // Once the lock is gone a kick lets it through
+    holdHotMs = 0;
+    PwrMgr_Exec_Kick(&ex);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ASSERT_TRUE(PwrMgr_Exec_WaitIdle(&ex, 2000));
+    PwrMgr_Exec_GetStatus(&ex, &state, &running, &stats, NULL);
+    EXPECT_EQ(PWRMGR_STATE_HOT, state);
+    EXPECT_EQ(0u, running);
+    EXPECT_EQ(4, fake.count("stop"));
+    EXPECT_EQ(1u, stats.deferred);
+    EXPECT_GE(stats.deferredMs, 100u);
+
+    // A request that stops nothing is never held
+    holdHotMs = 10000;
+    PwrMgr_Exec_Post(&ex, PWRMGR_STATE_WARM);
+    ASSERT_TRUE(PwrMgr_Exec_WaitIdle(&ex, 2000));
+    PwrMgr_Exec_GetStatus(&ex, &state, &running, &stats, NULL);
+    PwrMgr_Exec_Stop(&ex);
+    EXPECT_EQ(PWRMGR_STATE_WARM, state);
+    EXPECT_EQ(0x3u, running);
+    EXPECT_EQ(1u, stats.deferred);
+}
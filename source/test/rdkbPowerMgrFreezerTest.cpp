@@ -0,0 +1,239 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "MockUnitCtl.h"
+#include "pwrMgr_freezer.h"
+#include "pwrMgr_compgraph.h"
+
+// Fake cgroupfs: a directory per unit holding cgroup.freeze, and optionally
+// cgroup.events, as plain files.
+class FreezerTest : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        char tmpl[] = "/tmp/pwrMgrCgroupXXXXXX";
+        ASSERT_NE(nullptr, mkdtemp(tmpl));
+        root = tmpl;
+        units.setDefaultLatency(5);
+        ASSERT_EQ(0, PwrMgr_Freezer_Open(&fz, root.c_str(), units.ctl(), &ctl));
+    }
+
+    void TearDown()
+    {
+        PwrMgr_UnitCtl_Close(&ctl);
+        std::string cmd = "rm -rf " + root;
+        ASSERT_EQ(0, system(cmd.c_str()));
+    }
+
+    void addCgroup(const std::string &unit, const char *freeze)
+    {
+        ASSERT_EQ(0, mkdir((root + "/" + unit).c_str(), 0755));
+        writeFile(unit + "/cgroup.freeze", freeze);
+    }
+
+    void writeFile(const std::string &name, const std::string &value)
+    {
+        std::ofstream(root + "/" + name) << value;
+    }
+
+    std::string readFile(const std::string &name)
+    {
+        std::stringstream ss;
+        ss << std::ifstream(root + "/" + name).rdbuf();
+        return ss.str();
+    }
+
+    int run(PWRMGR_UnitOp op, std::vector<const char *> list)
+    {
+        PWRMGR_UnitJobResult results[PWRMGR_UNIT_MAX_JOBS];
+        return PwrMgr_UnitCtl_RunBatch(&ctl, op, list.data(), (int)list.size(), 1000, results);
+    }
+
+    static long nowMs()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+    }
+
+    std::string root;
+    MockUnitCtl units;
+    PWRMGR_Freezer fz;
+    PWRMGR_UnitCtl ctl;
+};
+
+TEST_F(FreezerTest, FreezesInsteadOfStopping)
+{
+    addCgroup("ccspwifiagent.service", "0");
+    ASSERT_EQ(0, PwrMgr_Freezer_AddUnit(&fz, "ccspwifiagent.service", 60000, false));
+
+    ASSERT_EQ(0, run(PWRMGR_UNIT_STOP, { "ccspwifiagent.service", "harvester.service" }));
+    EXPECT_EQ("1", readFile("ccspwifiagent.service/cgroup.freeze"));
+    EXPECT_TRUE(PwrMgr_Freezer_IsFrozen(&fz, "ccspwifiagent.service"));
+
+    ASSERT_EQ(0, run(PWRMGR_UNIT_START, { "ccspwifiagent.service", "harvester.service" }));
+    EXPECT_EQ("0", readFile("ccspwifiagent.service/cgroup.freeze"));
+    EXPECT_FALSE(PwrMgr_Freezer_IsFrozen(&fz, "ccspwifiagent.service"));
+
+    // Only the unit that did not opt in went through systemd
+    std::vector<std::string> expected = { "stop harvester.service", "start harvester.service" };
+    EXPECT_EQ(expected, units.history());
+    EXPECT_EQ(1u, fz.stats.freezes);
+    EXPECT_EQ(1u, fz.stats.thaws);
+    printf("freezer: freeze %llu us, thaw %llu us\n", (unsigned long long)fz.stats.lastFreezeUs,
+           (unsigned long long)fz.stats.lastThawUs);
+}
+
+TEST_F(FreezerTest, StopsWhatCannotBeFrozen)
+{
+    // No cgroup v2 group for the unit
+    ASSERT_EQ(0, PwrMgr_Freezer_AddUnit(&fz, "CcspMoca.service", 60000, false));
+
+    ASSERT_EQ(0, run(PWRMGR_UNIT_STOP, { "CcspMoca.service" }));
+    ASSERT_EQ(0, run(PWRMGR_UNIT_START, { "CcspMoca.service" }));
+    std::vector<std::string> expected = { "stop CcspMoca.service", "start CcspMoca.service" };
+    EXPECT_EQ(expected, units.history());
+    EXPECT_EQ(1u, fz.stats.fallbacks);
+    EXPECT_EQ(0u, fz.stats.freezes);
+}
+
+TEST_F(FreezerTest, StopsAfterDwell)
+{
+    addCgroup("ccspwifiagent.service", "0");
+    ASSERT_EQ(0, PwrMgr_Freezer_AddUnit(&fz, "ccspwifiagent.service", 50, false));
+    EXPECT_EQ(-1, PwrMgr_Freezer_Expire(&fz, nowMs()));
+
+    ASSERT_EQ(0, run(PWRMGR_UNIT_STOP, { "ccspwifiagent.service" }));
+    long left = PwrMgr_Freezer_Expire(&fz, nowMs());
+    EXPECT_GT(left, 0);
+    EXPECT_LE(left, 50);
+    EXPECT_TRUE(units.history().empty());
+
+    // Thawed so it can shut down, then stopped for real
+    EXPECT_EQ(-1, PwrMgr_Freezer_Expire(&fz, nowMs() + 50));
+    EXPECT_EQ("0", readFile("ccspwifiagent.service/cgroup.freeze"));
+    EXPECT_FALSE(PwrMgr_Freezer_IsFrozen(&fz, "ccspwifiagent.service"));
+    EXPECT_EQ(1u, fz.stats.expired);
+
+    // Coming back is a regular start now
+    ASSERT_EQ(0, run(PWRMGR_UNIT_START, { "ccspwifiagent.service" }));
+    std::vector<std::string> expected = { "stop ccspwifiagent.service", "start ccspwifiagent.service" };
+    EXPECT_EQ(expected, units.history());
+}
+
+TEST_F(FreezerTest, AdoptsCgroupsLeftFrozen)
+{
+    addCgroup("ccspwifiagent.service", "1");
+    addCgroup("CcspMoca.service", "1");
+
+    // The checkpoint says Wi-Fi is shed and MoCA is running
+    ASSERT_EQ(0, PwrMgr_Freezer_AddUnit(&fz, "ccspwifiagent.service", 60000, true));
+    ASSERT_EQ(0, PwrMgr_Freezer_AddUnit(&fz, "CcspMoca.service", 60000, false));
+    EXPECT_TRUE(PwrMgr_Freezer_IsFrozen(&fz, "ccspwifiagent.service"));
+    EXPECT_EQ("1", readFile("ccspwifiagent.service/cgroup.freeze"));
+    EXPECT_FALSE(PwrMgr_Freezer_IsFrozen(&fz, "CcspMoca.service"));
+    EXPECT_EQ("0", readFile("CcspMoca.service/cgroup.freeze"));
+
+    ASSERT_EQ(0, run(PWRMGR_UNIT_START, { "ccspwifiagent.service" }));
+    EXPECT_EQ("0", readFile("ccspwifiagent.service/cgroup.freeze"));
+    EXPECT_TRUE(units.history().empty());
+}
+
+TEST_F(FreezerTest, EmergencyFreezesAnyUnit)
+{
+    addCgroup("harvester.service", "0");
+
+    // Never opted in, the freeze op still takes its cgroup
+    ASSERT_EQ(0, PwrMgr_UnitCtl_Freeze(&ctl, "harvester.service"));
+    EXPECT_EQ("1", readFile("harvester.service/cgroup.freeze"));
+    EXPECT_TRUE(PwrMgr_Freezer_IsFrozen(&fz, "harvester.service"));
+
+    // Its stop was cut short, so a start thaws it and goes to systemd as well
+    ASSERT_EQ(0, run(PWRMGR_UNIT_START, { "harvester.service" }));
+    EXPECT_EQ("0", readFile("harvester.service/cgroup.freeze"));
+    ASSERT_EQ(0, run(PWRMGR_UNIT_STOP, { "harvester.service" }));
+    EXPECT_EQ("0", readFile("harvester.service/cgroup.freeze"));
+    std::vector<std::string> expected = { "start harvester.service", "stop harvester.service" };
+    EXPECT_EQ(expected, units.history());
+
+    // Without a cgroup the wrapped backend is asked
+    ASSERT_EQ(0, PwrMgr_UnitCtl_Freeze(&ctl, "CcspMoca.service"));
+    EXPECT_EQ("freeze CcspMoca.service", units.history().back());
+}
+
+TEST_F(FreezerTest, EmergencyFreezeForgetsTheStopJob)
+{
+    PWRMGR_CompGraph graph;
+    PWRMGR_CompMask completed = 0;
+    PWRMGR_CompMask failed = 1;
+    char line[] = "component harvester harvester.service";
+
+    addCgroup("harvester.service", "0");
+    units.setIgnoreTerm("harvester.service", true);
+    PwrMgr_CompGraph_Init(&graph);
+    ASSERT_EQ(0, PwrMgr_CompGraph_ParseLine(&graph, line));
+
+    EXPECT_EQ(0, PwrMgr_CompGraph_Shed(&graph, &ctl, PWRMGR_COMP_BIT(0), 100, NULL, NULL, &completed, &failed, NULL));
+    EXPECT_EQ("1", readFile("harvester.service/cgroup.freeze"));
+    // The stuck stop job is gone from systemd's side as well
+    EXPECT_EQ(0u, units.pendingCount());
+}
+
+TEST_F(FreezerTest, WaitsForCgroupEvents)
+{
+    addCgroup("ccspwifiagent.service", "0");
+    writeFile("ccspwifiagent.service/cgroup.events", "populated 1\nfrozen 1\n");
+    ASSERT_EQ(0, PwrMgr_Freezer_AddUnit(&fz, "ccspwifiagent.service", 60000, false));
+    fz.settleMs = 50;
+
+    // Already reported frozen
+    ASSERT_EQ(0, run(PWRMGR_UNIT_STOP, { "ccspwifiagent.service" }));
+    EXPECT_LT(fz.stats.lastFreezeUs, 50000u);
+
+    // The kernel never confirms the thaw: give up after settleMs, the unit still counts as thawed
+    ASSERT_EQ(0, run(PWRMGR_UNIT_START, { "ccspwifiagent.service" }));
+    EXPECT_GE(fz.stats.lastThawUs, 50000u);
+    EXPECT_FALSE(PwrMgr_Freezer_IsFrozen(&fz, "ccspwifiagent.service"));
+}
+
+TEST(CompGraph, FreezeKeyword)
+{
+    PWRMGR_CompGraph graph;
+    char component[] = "component wifi ccspwifiagent.service";
+    char freeze[] = "freeze wifi 120000";
+    char bad[] = "freeze wifi 0";
+
+    PwrMgr_CompGraph_Init(&graph);
+    ASSERT_EQ(0, PwrMgr_CompGraph_ParseLine(&graph, component));
+    EXPECT_EQ(0, graph.comps[0].freezeDwellMs);
+    ASSERT_EQ(0, PwrMgr_CompGraph_ParseLine(&graph, freeze));
+    EXPECT_EQ(120000, graph.comps[0].freezeDwellMs);
+    EXPECT_EQ(-1, PwrMgr_CompGraph_ParseLine(&graph, bad));
+}
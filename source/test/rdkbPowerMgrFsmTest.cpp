@@ -0,0 +1,88 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include "gtest/gtest.h"
+#include "pwrMgr_fsm.h"
+
+TEST(Fsm, ResolvesRequestStrings)
+{
+    PWRMGR_Fsm fsm;
+
+    ASSERT_EQ(0, PwrMgr_Fsm_InitDefault(&fsm));
+    for (int i = PWRMGR_STATE_UNKNOWN + 1; i < PWRMGR_STATE_TOTAL; i++)
+    {
+        PWRMGR_PwrState state = (PWRMGR_PwrState)i;
+        EXPECT_EQ(state, PwrMgr_Fsm_FromTransStr(&fsm, PwrMgr_Fsm_TransStr(&fsm, state)));
+    }
+    EXPECT_STREQ("ThermalHot", PwrMgr_Fsm_StateStr(&fsm, PWRMGR_STATE_HOT));
+    EXPECT_EQ(PWRMGR_STATE_UNKNOWN, PwrMgr_Fsm_FromTransStr(&fsm, "POWER_TRANS_UNKNOWN"));
+    EXPECT_EQ(PWRMGR_STATE_UNKNOWN, PwrMgr_Fsm_FromTransStr(&fsm, "POWER_TRANS_HOTT"));
+    EXPECT_EQ(PWRMGR_STATE_UNKNOWN, PwrMgr_Fsm_FromTransStr(&fsm, ""));
+    EXPECT_STREQ("Unknown", PwrMgr_Fsm_StateStr(&fsm, PWRMGR_STATE_TOTAL));
+}
+
+TEST(Fsm, DefaultTableShedsBeforeRestoring)
+{
+    PWRMGR_Fsm fsm;
+    const PWRMGR_FsmTransition *trans;
+
+    ASSERT_EQ(0, PwrMgr_Fsm_InitDefault(&fsm));
+
+    trans = PwrMgr_Fsm_Lookup(&fsm, PWRMGR_STATE_AC, PWRMGR_STATE_HOT);
+    ASSERT_TRUE(trans != NULL);
+    EXPECT_EQ(PWRMGR_FSM_ACT_STOP, trans->actions[0]);
+    EXPECT_EQ(PWRMGR_STATE_HOT, trans->publish);
+
+    trans = PwrMgr_Fsm_Lookup(&fsm, PWRMGR_STATE_HOT, PWRMGR_STATE_COOLED);
+    ASSERT_TRUE(trans != NULL);
+    EXPECT_EQ(PWRMGR_FSM_ACT_START, trans->actions[0]);
+    EXPECT_EQ(PWRMGR_STATE_COOLED, trans->publish);
+
+    // No self transitions and nothing leads to Unknown
+    EXPECT_TRUE(PwrMgr_Fsm_Lookup(&fsm, PWRMGR_STATE_HOT, PWRMGR_STATE_HOT) == NULL);
+    EXPECT_FALSE(PwrMgr_Fsm_Allowed(&fsm, PWRMGR_STATE_AC, PWRMGR_STATE_UNKNOWN));
+    EXPECT_TRUE(PwrMgr_Fsm_Allowed(&fsm, PWRMGR_STATE_COOLED, PWRMGR_STATE_AC));
+}
+
+static bool rejectAll(PWRMGR_PwrState from, PWRMGR_PwrState to)
+{
+    (void)from; (void)to;
+    return false;
+}
+
+TEST(Fsm, CustomTableGuardsAndPublishes)
+{
+    PWRMGR_Fsm defaults;
+    PWRMGR_Fsm fsm;
+    PWRMGR_FsmTransition table[PWRMGR_STATE_TOTAL][PWRMGR_STATE_TOTAL] = {};
+
+    ASSERT_EQ(0, PwrMgr_Fsm_InitDefault(&defaults));
+    // COOLED is only reachable from HOT, and is published as AC
+    table[PWRMGR_STATE_HOT][PWRMGR_STATE_COOLED].actions[0] = PWRMGR_FSM_ACT_START;
+    table[PWRMGR_STATE_HOT][PWRMGR_STATE_COOLED].publish = PWRMGR_STATE_AC;
+    table[PWRMGR_STATE_AC][PWRMGR_STATE_HOT].guard = rejectAll;
+    table[PWRMGR_STATE_AC][PWRMGR_STATE_HOT].publish = PWRMGR_STATE_HOT;
+    ASSERT_EQ(0, PwrMgr_Fsm_Init(&fsm, defaults.states, (PWRMGR_FsmTable *)&table));
+
+    EXPECT_TRUE(PwrMgr_Fsm_Allowed(&fsm, PWRMGR_STATE_HOT, PWRMGR_STATE_COOLED));
+    EXPECT_FALSE(PwrMgr_Fsm_Allowed(&fsm, PWRMGR_STATE_AC, PWRMGR_STATE_COOLED));
+    EXPECT_FALSE(PwrMgr_Fsm_Allowed(&fsm, PWRMGR_STATE_AC, PWRMGR_STATE_HOT));
+    EXPECT_TRUE(PwrMgr_Fsm_Lookup(&fsm, PWRMGR_STATE_AC, PWRMGR_STATE_HOT) != NULL);
+    EXPECT_EQ(PWRMGR_STATE_AC, PwrMgr_Fsm_Lookup(&fsm, PWRMGR_STATE_HOT, PWRMGR_STATE_COOLED)->publish);
+}
@@ -0,0 +1,149 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <string.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "gtest/gtest.h"
+#include "pwrMgr_inhibit.h"
+
+class InhibitTest : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        PwrMgr_Inhibit_Init(&inh);
+    }
+
+    void TearDown()
+    {
+        PwrMgr_Inhibit_Destroy(&inh);
+    }
+
+    std::string command(int owner, const char *cmd, long nowMs)
+    {
+        char reply[PWRMGR_INHIBIT_MSG_LEN];
+
+        PwrMgr_Inhibit_Command(&inh, owner, cmd, nowMs, reply, sizeof(reply));
+        return reply;
+    }
+
+    PWRMGR_Inhibitor inh;
+};
+
+TEST_F(InhibitTest, LockHoldsOnlyItsClassUntilItRunsOut)
+{
+    char who[PWRMGR_INHIBIT_NAME_LEN] = "";
+    int id = PwrMgr_Inhibit_Take(&inh, 7, "voice", PWRMGR_INHIBIT_CLASS(PWRMGR_AXIS_THERMAL), 500, 1000);
+
+    ASSERT_GT(id, 0);
+    EXPECT_EQ(300, PwrMgr_Inhibit_Check(&inh, PWRMGR_AXIS_THERMAL, 1200, who, sizeof(who)));
+    EXPECT_STREQ("voice", who);
+    EXPECT_EQ(0, PwrMgr_Inhibit_Check(&inh, PWRMGR_AXIS_SUPPLY, 1200, NULL, 0));
+
+    // The soonest lock of the axis decides how long to wait
+    ASSERT_GT(PwrMgr_Inhibit_Take(&inh, 8, "fwupdate", PWRMGR_INHIBIT_ALL, 100, 1200), 0);
+    EXPECT_EQ(100, PwrMgr_Inhibit_Check(&inh, PWRMGR_AXIS_THERMAL, 1200, who, sizeof(who)));
+    EXPECT_STREQ("fwupdate", who);
+    EXPECT_EQ(100, PwrMgr_Inhibit_Check(&inh, PWRMGR_AXIS_SUPPLY, 1200, NULL, 0));
+
+    EXPECT_EQ(0, PwrMgr_Inhibit_Check(&inh, PWRMGR_AXIS_SUPPLY, 1300, NULL, 0));
+    EXPECT_EQ(0, PwrMgr_Inhibit_Check(&inh, PWRMGR_AXIS_THERMAL, 1500, NULL, 0));
+    EXPECT_EQ(2u, inh.stats.expired);
+    EXPECT_EQ(-1, PwrMgr_Inhibit_Release(&inh, 7, id));
+}
+
+TEST_F(InhibitTest, OnlyTheOwnerReleases)
+{
+    int id = PwrMgr_Inhibit_Take(&inh, 7, "voice", PWRMGR_INHIBIT_ALL, 10 * PWRMGR_INHIBIT_MAX_MS, 0);
+
+    ASSERT_GT(id, 0);
+    EXPECT_EQ(PWRMGR_INHIBIT_MAX_MS, PwrMgr_Inhibit_Check(&inh, PWRMGR_AXIS_SUPPLY, 0, NULL, 0));
+    EXPECT_EQ(-1, PwrMgr_Inhibit_Release(&inh, 8, id));
+    EXPECT_EQ(0, PwrMgr_Inhibit_Release(&inh, 7, id));
+    EXPECT_EQ(0, PwrMgr_Inhibit_Check(&inh, PWRMGR_AXIS_SUPPLY, 0, NULL, 0));
+
+    PwrMgr_Inhibit_Take(&inh, 7, "a", PWRMGR_INHIBIT_ALL, 1000, 0);
+    PwrMgr_Inhibit_Take(&inh, 7, "b", PWRMGR_INHIBIT_ALL, 1000, 0);
+    PwrMgr_Inhibit_ReleaseOwner(&inh, 7);
+    EXPECT_EQ(0, PwrMgr_Inhibit_Check(&inh, PWRMGR_AXIS_THERMAL, 0, NULL, 0));
+    EXPECT_EQ(3u, inh.stats.taken);
+    EXPECT_EQ(1u, inh.stats.released);
+    EXPECT_EQ(2u, inh.stats.expired);
+
+    EXPECT_EQ(-1, PwrMgr_Inhibit_Take(&inh, 7, "", PWRMGR_INHIBIT_ALL, 1000, 0));
+    EXPECT_EQ(-1, PwrMgr_Inhibit_Take(&inh, 7, "c", 0, 1000, 0));
+    EXPECT_EQ(-1, PwrMgr_Inhibit_Take(&inh, 7, "c", PWRMGR_INHIBIT_ALL, 0, 0));
+}
+
+TEST_F(InhibitTest, ParsesCommands)
+{
+    EXPECT_EQ("ok 1\n", command(3, "inhibit thermal voice 2000\n", 0));
+    EXPECT_EQ("ok 2\n", command(3, "inhibit all fwupdate 500", 0));
+    EXPECT_EQ("ok 2\n1 thermal voice 1900\n2 all fwupdate 400\n", command(3, "list", 100));
+    EXPECT_EQ("ok\n", command(3, "release 2", 100));
+    EXPECT_EQ("error no such lock\n", command(4, "release 1", 100));
+    EXPECT_EQ("error no such lock\n", command(3, "release x", 100));
+    EXPECT_EQ(0, strncmp("error usage", command(3, "inhibit battery x 100", 100).c_str(), 11));
+    EXPECT_EQ(0, strncmp("error usage", command(3, "inhibit all x 10s", 100).c_str(), 11));
+    EXPECT_EQ("error lock refused\n", command(3, "inhibit all x -5", 100));
+    EXPECT_EQ("error unknown command\n", command(3, "hold all", 100));
+    EXPECT_EQ("error unknown command\n", command(3, "", 100));
+}
+
+TEST_F(InhibitTest, DisconnectDropsLocks)
+{
+    char path[] = "/tmp/pwrMgrInhibitXXXXXX";
+    char reply[PWRMGR_INHIBIT_MSG_LEN];
+    struct sockaddr_un addr;
+    int listenFd, client, server;
+    ssize_t len;
+
+    ASSERT_EQ(0, close(mkstemp(path)));
+    listenFd = PwrMgr_Inhibit_Listen(path);
+    ASSERT_GE(listenFd, 0);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    client = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    ASSERT_EQ(0, connect(client, (struct sockaddr *)&addr, sizeof(addr)));
+    server = accept(listenFd, NULL, NULL);
+    ASSERT_GE(server, 0);
+
+    // Nothing to read yet
+    EXPECT_EQ(0, PwrMgr_Inhibit_Serve(&inh, server, 0));
+
+    ASSERT_GT(send(client, "inhibit supply voice 1000", 25, 0), 0);
+    EXPECT_EQ(0, PwrMgr_Inhibit_Serve(&inh, server, 0));
+    len = recv(client, reply, sizeof(reply) - 1, 0);
+    ASSERT_GT(len, 0);
+    reply[len] = '\0';
+    EXPECT_STREQ("ok 1\n", reply);
+    EXPECT_EQ(1000, PwrMgr_Inhibit_Check(&inh, PWRMGR_AXIS_SUPPLY, 0, NULL, 0));
+
+    close(client);
+    EXPECT_EQ(-1, PwrMgr_Inhibit_Serve(&inh, server, 0));
+    EXPECT_EQ(0, PwrMgr_Inhibit_Check(&inh, PWRMGR_AXIS_SUPPLY, 0, NULL, 0));
+    close(server);
+    close(listenFd);
+    unlink(path);
+}
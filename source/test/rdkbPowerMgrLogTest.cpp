@@ -0,0 +1,155 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include "gtest/gtest.h"
+#define PWRMGR_LOG_MIN_LEVEL WARNING
+#include "pwrMgr_log.h"
+
+static std::string ReadAll(int fd)
+{
+    std::string out;
+    char buf[4096];
+    ssize_t n;
+
+    lseek(fd, 0, SEEK_SET);
+    while ((n = read(fd, buf, sizeof(buf))) > 0)
+        out.append(buf, n);
+    return out;
+}
+
+static int TempFd()
+{
+    char path[] = "/tmp/pwrMgrLogTest.XXXXXX";
+    int fd = mkstemp(path);
+
+    unlink(path);
+    return fd;
+}
+
+TEST(Log, KeepsPerThreadOrder)
+{
+    const int perThread = 40;
+    int fd = TempFd();
+    unsigned long dropped = PwrMgr_Log_Dropped();
+    std::thread a, b;
+    std::string out;
+    int received = 0;
+
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(0, PwrMgr_Log_Start(fd));
+    auto worker = [](char id) {
+        for (int i = 0; i < perThread; i++)
+            PWRMGRLOG(WARNING, "thread %c seq %d\n", id, i)
+    };
+    a = std::thread(worker, 'a');
+    b = std::thread(worker, 'b');
+    a.join();
+    b.join();
+    PwrMgr_Log_Stop();
+
+    out = ReadAll(fd);
+    for (char id : { 'a', 'b' }) {
+        std::string tag = std::string("thread ") + id + " seq ";
+        size_t pos = 0;
+        int last = -1;
+
+        while ((pos = out.find(tag, pos)) != std::string::npos) {
+            int seq = atoi(out.c_str() + pos + tag.size());
+
+            EXPECT_GT(seq, last);
+            last = seq;
+            received++;
+            pos += tag.size();
+        }
+    }
+    EXPECT_EQ(2 * perThread, received + (int)(PwrMgr_Log_Dropped() - dropped));
+    EXPECT_NE(std::string::npos, out.find("PowerMgrLog<"));
+    close(fd);
+}
+
+TEST(Log, CompilesOutLevelsBelowMinimum)
+{
+    int fd = TempFd();
+    std::string out;
+
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(0, PwrMgr_Log_Start(fd));
+    PWRMGRLOG(INFO, "should not appear\n")
+    PWRMGRLOG(ERROR, "should appear\n")
+    PwrMgr_Log_Stop();
+
+    out = ReadAll(fd);
+    EXPECT_EQ(std::string::npos, out.find("should not appear"));
+    EXPECT_NE(std::string::npos, out.find("should appear"));
+    close(fd);
+}
+
+TEST(Log, CountsDropsWhenOutputStalls)
+{
+    int fds[2];
+    unsigned long dropped = PwrMgr_Log_Dropped();
+    std::string out;
+    std::thread reader;
+    char buf[4096];
+    ssize_t n;
+
+    ASSERT_EQ(0, pipe(fds));
+    fcntl(fds[1], F_SETPIPE_SZ, 4096);
+    ASSERT_EQ(0, PwrMgr_Log_Start(fds[1]));
+    // Nothing reads the pipe yet, so the flusher stalls and the ring fills up
+    for (int i = 0; i < 20 * PWRMGR_LOG_RING_SLOTS; i++)
+        PWRMGRLOG(WARNING, "stalled line %d padded to fill the pipe quickly ................\n", i)
+    EXPECT_GT(PwrMgr_Log_Dropped(), dropped);
+
+    reader = std::thread([&]() {
+        while ((n = read(fds[0], buf, sizeof(buf))) > 0)
+            out.append(buf, n);
+    });
+    PwrMgr_Log_Stop();
+    close(fds[1]);
+    reader.join();
+    close(fds[0]);
+
+    EXPECT_NE(std::string::npos, out.find("stalled line 0 "));
+    EXPECT_NE(std::string::npos, out.find("message(s) dropped"));
+}
+
+TEST(Log, TruncatesLongLinesWithNewline)
+{
+    int fd = TempFd();
+    std::string line(2 * PWRMGR_LOG_LINE_LEN, 'x');
+    std::string out;
+
+    ASSERT_GE(fd, 0);
+    ASSERT_EQ(0, PwrMgr_Log_Start(fd));
+    PWRMGRLOG(ERROR, "%s\n", line.c_str())
+    PWRMGRLOG(ERROR, "next\n")
+    PwrMgr_Log_Stop();
+
+    out = ReadAll(fd);
+    ASSERT_NE(std::string::npos, out.find('\n'));
+    EXPECT_EQ((size_t)PWRMGR_LOG_LINE_LEN - 1, out.find('\n') + 1);
+    EXPECT_NE(std::string::npos, out.find("next\n"));
+    close(fd);
+}
@@ -0,0 +1,241 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <unistd.h>
+#include "gtest/gtest.h"
+#include "pwrMgr_policy.h"
+
+class PolicyTest : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        char tmpl[] = "/tmp/pwrMgrPolicyXXXXXX";
+
+        ASSERT_NE(nullptr, mkdtemp(tmpl));
+        dir = tmpl;
+        path = dir + "/policy.conf";
+        ASSERT_EQ(0, PwrMgr_Fsm_InitDefault(&fsm));
+    }
+
+    void TearDown()
+    {
+        unlink(path.c_str());
+        unlink((dir + "/other.conf").c_str());
+        rmdir(dir.c_str());
+    }
+
+    // Written next to the policy and renamed over it, like a package update
+    void install(const std::string &conf, const std::string &name = "policy.conf")
+    {
+        std::string tmp = dir + "/.new";
+        FILE *fp = fopen(tmp.c_str(), "w");
+
+        ASSERT_NE(nullptr, fp);
+        fputs(conf.c_str(), fp);
+        fclose(fp);
+        ASSERT_EQ(0, rename(tmp.c_str(), (dir + "/" + name).c_str()));
+    }
+
+    int comp(const char *name)
+    {
+        return PwrMgr_CompGraph_Find(&policy.graph, name);
+    }
+
+    std::string dir;
+    std::string path;
+    PWRMGR_Fsm fsm;
+    PWRMGR_Policy policy;
+};
+
+static const char components[] = "component harvester harvester.service\n"
+                                 "component wifi ccspwifiagent.service\n"
+                                 "component moca CcspMoca.service\n"
+                                 "stop_before harvester wifi\n"
+                                 "thermal_shed harvester warm\n"
+                                 "thermal_shed moca hot\n"
+                                 "thermal_shed wifi critical\n";
+
+TEST_F(PolicyTest, CompilesStatesShedSetsAndTiming)
+{
+    install(std::string(components) +
+            "state ThermalCritical off\n"
+            "shed ThermalWarm harvester moca\n"
+            "shed ThermalCooled\n"
+            "timing ThermalHot 500 20000\n"
+            "timeout 15000\n"
+            "emergency ThermalHot 3000\n"
+            "emergency ThermalCritical 0\n"
+            "stop_budget wifi 1500\n");
+
+    ASSERT_EQ(0, PwrMgr_Policy_Load(&policy, &fsm, path.c_str()));
+    PWRMGR_CompMask all = PwrMgr_CompGraph_AllMask(&policy.graph);
+
+    EXPECT_TRUE(policy.enabled[PWRMGR_STATE_AC]);
+    EXPECT_FALSE(policy.enabled[PWRMGR_STATE_CRITICAL]);
+    // An explicit set replaces the thermal_shed levels, an empty one sheds nothing
+    EXPECT_EQ(all & ~(PWRMGR_COMP_BIT(comp("harvester")) | PWRMGR_COMP_BIT(comp("moca"))), policy.runMask[PWRMGR_STATE_WARM]);
+    EXPECT_EQ(all, policy.runMask[PWRMGR_STATE_COOLED]);
+    // Without one the levels still apply
+    EXPECT_EQ(PWRMGR_COMP_BIT(comp("wifi")), policy.runMask[PWRMGR_STATE_HOT]);
+    EXPECT_EQ(all, policy.runMask[PWRMGR_STATE_AC]);
+
+    EXPECT_EQ(500, policy.timing[PWRMGR_STATE_HOT].hysteresisMs);
+    EXPECT_EQ(20000, policy.timing[PWRMGR_STATE_HOT].minDwellMs);
+    EXPECT_EQ(15000, policy.jobTimeoutMs);
+    EXPECT_EQ(3000, policy.emergencyMs[PWRMGR_STATE_HOT]);
+    EXPECT_EQ(0, policy.emergencyMs[PWRMGR_STATE_CRITICAL]);
+    EXPECT_EQ(1500, policy.graph.comps[comp("wifi")].stopBudgetMs);
+}
+
+TEST_F(PolicyTest, LoadsTheComponentGraph)
+{
+    install("# test graph\n"
+            "component a a.service\n"
+            "component b b.service\n"
+            "\n"
+            "stop_before a b\n"
+            "start_after a b\n");
+
+    ASSERT_EQ(0, PwrMgr_Policy_Load(&policy, &fsm, path.c_str()));
+    EXPECT_EQ(2, policy.graph.count);
+    EXPECT_STREQ("b.service", policy.graph.comps[1].unit);
+    EXPECT_EQ(PWRMGR_COMP_BIT(0), policy.graph.comps[1].stopPrereq);
+    EXPECT_EQ(PWRMGR_COMP_BIT(1), policy.graph.comps[0].startPrereq);
+
+    // A cycle is refused like any other malformed policy
+    install("component a a.service\n"
+            "component b b.service\n"
+            "stop_before a b\n"
+            "stop_before b a\n");
+    EXPECT_EQ(-1, PwrMgr_Policy_Load(&policy, &fsm, path.c_str()));
+}
+
+TEST_F(PolicyTest, DefaultsMatchTheComponentGraph)
+{
+    PWRMGR_StateTiming timing[PWRMGR_STATE_TOTAL];
+    int i;
+
+    PwrMgr_Policy_LoadDefaults(&policy);
+    PwrMgr_Coalesce_DefaultTiming(timing);
+    EXPECT_EQ(PWRMGR_UNIT_JOB_TIMEOUT_MS, policy.jobTimeoutMs);
+    EXPECT_EQ(PWRMGR_EMERGENCY_DEADLINE_MS, policy.emergencyMs[PWRMGR_STATE_CRITICAL]);
+    EXPECT_EQ(0, policy.emergencyMs[PWRMGR_STATE_HOT]);
+    for (i = PWRMGR_STATE_UNKNOWN + 1; i < PWRMGR_STATE_TOTAL; i++) {
+        EXPECT_TRUE(policy.enabled[i]);
+        EXPECT_EQ(PwrMgr_CompGraph_StateMask(&policy.graph, (PWRMGR_PwrState)i), policy.runMask[i]);
+        EXPECT_EQ(timing[i].hysteresisMs, policy.timing[i].hysteresisMs);
+    }
+}
+
+TEST_F(PolicyTest, SkipsOtherBuildsStatesAndRejectsBadLines)
+{
+    char otherBuild[] = "state SolarOnly on";
+    char unknownComp[] = "shed ThermalHot harvester nosuch";
+    char badTiming[] = "timing ThermalHot fast 1000";
+    char noTimeout[] = "timeout 0";
+    char badEmergency[] = "emergency ThermalCritical soon";
+
+    PwrMgr_Policy_Init(&policy);
+    PwrMgr_CompGraph_AddComponent(&policy.graph, "harvester", "harvester.service");
+    EXPECT_EQ(0, PwrMgr_Policy_ParseLine(&policy, &fsm, otherBuild));
+    EXPECT_EQ(-1, PwrMgr_Policy_ParseLine(&policy, &fsm, unknownComp));
+    EXPECT_EQ(-1, PwrMgr_Policy_ParseLine(&policy, &fsm, badTiming));
+    EXPECT_EQ(-1, PwrMgr_Policy_ParseLine(&policy, &fsm, noTimeout));
+    EXPECT_EQ(-1, PwrMgr_Policy_ParseLine(&policy, &fsm, badEmergency));
+
+    // The daemon has to have somewhere to start
+    install(std::string(components) + "state AC off\n");
+    EXPECT_EQ(-1, PwrMgr_Policy_Load(&policy, &fsm, path.c_str()));
+}
+
+TEST_F(PolicyTest, EcoWindowsFromTheFileOrASpec)
+{
+    PWRMGR_EcoWindow windows[PWRMGR_SCHED_MAX_WINDOWS];
+    int count = -1;
+
+    install(std::string(components) +
+            "eco 01:00-05:30 harvester moca\n"
+            "eco 22:00-24:00\n");
+    ASSERT_EQ(0, PwrMgr_Policy_Load(&policy, &fsm, path.c_str()));
+    ASSERT_EQ(2, policy.ecoCount);
+    EXPECT_EQ(60, policy.eco[0].startMin);
+    EXPECT_EQ(330, policy.eco[0].endMin);
+    EXPECT_EQ(PWRMGR_COMP_BIT(comp("harvester")) | PWRMGR_COMP_BIT(comp("moca")), policy.eco[0].shed);
+    // 24:00 is midnight, a window without components sheds nothing
+    EXPECT_EQ(0, policy.eco[1].endMin);
+    EXPECT_EQ(0u, policy.eco[1].shed);
+
+    ASSERT_EQ(0, PwrMgr_Policy_ParseEco(&policy, "23:00-02:00 wifi; 13:00-14:00 moca;", windows, &count));
+    ASSERT_EQ(2, count);
+    EXPECT_EQ(23 * 60, windows[0].startMin);
+    EXPECT_EQ(PWRMGR_COMP_BIT(comp("wifi")), windows[0].shed);
+    EXPECT_EQ(PWRMGR_COMP_BIT(comp("moca")), windows[1].shed);
+    EXPECT_EQ(0, PwrMgr_Policy_ParseEco(&policy, "none", windows, &count));
+    EXPECT_EQ(0, count);
+
+    EXPECT_EQ(-1, PwrMgr_Policy_ParseEco(&policy, "01:00-25:00 wifi", windows, &count));
+    EXPECT_EQ(-1, PwrMgr_Policy_ParseEco(&policy, "1am-5am wifi", windows, &count));
+    EXPECT_EQ(-1, PwrMgr_Policy_ParseEco(&policy, "01:00-05:00 nosuch", windows, &count));
+    EXPECT_EQ(-1, PwrMgr_Policy_ParseEco(&policy, "01:60-05:00 wifi", windows, &count));
+}
+
+TEST_F(PolicyTest, ReloadKeepsTheComponents)
+{
+    PWRMGR_Policy next;
+
+    install(components);
+    ASSERT_EQ(0, PwrMgr_Policy_Load(&policy, &fsm, path.c_str()));
+
+    // Shed sets, edges and timing may change at run time
+    install(std::string(components) + "shed ThermalHot wifi\nstop_before moca wifi\ntiming AC 0 0\n");
+    ASSERT_EQ(0, PwrMgr_Policy_Load(&next, &fsm, path.c_str()));
+    EXPECT_TRUE(PwrMgr_Policy_SameComponents(&policy, &next));
+
+    // The checkpoint and the freezer are indexed by the components
+    install(std::string(components) + "freeze wifi 1000\n");
+    ASSERT_EQ(0, PwrMgr_Policy_Load(&next, &fsm, path.c_str()));
+    EXPECT_FALSE(PwrMgr_Policy_SameComponents(&policy, &next));
+    install("component harvester harvester.service\ncomponent wifi OneWifi.service\ncomponent moca CcspMoca.service\n");
+    ASSERT_EQ(0, PwrMgr_Policy_Load(&next, &fsm, path.c_str()));
+    EXPECT_FALSE(PwrMgr_Policy_SameComponents(&policy, &next));
+}
+
+TEST_F(PolicyTest, WatchSeesTheFileReplaced)
+{
+    install(components);
+    int fd = PwrMgr_Policy_Watch(path.c_str());
+
+    ASSERT_GE(fd, 0);
+    EXPECT_FALSE(PwrMgr_Policy_Changed(fd, path.c_str()));
+    install(components, "other.conf");
+    EXPECT_FALSE(PwrMgr_Policy_Changed(fd, path.c_str()));
+    install(std::string(components) + "state ThermalWarm off\n");
+    EXPECT_TRUE(PwrMgr_Policy_Changed(fd, path.c_str()));
+    // Written in place
+    FILE *fp = fopen(path.c_str(), "a");
+    ASSERT_NE(nullptr, fp);
+    fputs("timeout 1000\n", fp);
+    fclose(fp);
+    EXPECT_TRUE(PwrMgr_Policy_Changed(fd, path.c_str()));
+    close(fd);
+}
@@ -0,0 +1,136 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <time.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include <vector>
+#include "gtest/gtest.h"
+#include "pwrMgr_sched.h"
+
+// Local time on a winter day, no DST change around it
+static time_t at(int day, int hour, int minute)
+{
+    struct tm tm = {};
+
+    tm.tm_year = 2026 - 1900;
+    tm.tm_mon = 0;
+    tm.tm_mday = day;
+    tm.tm_hour = hour;
+    tm.tm_min = minute;
+    tm.tm_isdst = -1;
+    return mktime(&tm);
+}
+
+static void recordShed(void *ctx, PWRMGR_CompMask shed)
+{
+    static_cast<std::vector<PWRMGR_CompMask> *>(ctx)->push_back(shed);
+}
+
+class SchedTest : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        ASSERT_EQ(0, PwrMgr_Sched_Open(&sched, recordShed, &changes));
+    }
+
+    void TearDown()
+    {
+        PwrMgr_Sched_Close(&sched);
+    }
+
+    PWRMGR_Scheduler sched;
+    std::vector<PWRMGR_CompMask> changes;
+};
+
+TEST(SchedWindow, RunsPastMidnightOrAllDay)
+{
+    PWRMGR_EcoWindow night = {23 * 60, 2 * 60, 0x1};
+    PWRMGR_EcoWindow early = {60, 5 * 60, 0x2};
+    PWRMGR_EcoWindow allDay = {600, 600, 0x4};
+    PWRMGR_EcoWindow both[] = {night, early};
+
+    EXPECT_TRUE(PwrMgr_Sched_WindowOpen(&night, at(14, 23, 30)));
+    EXPECT_TRUE(PwrMgr_Sched_WindowOpen(&night, at(15, 1, 59)));
+    EXPECT_FALSE(PwrMgr_Sched_WindowOpen(&night, at(15, 2, 0)));
+    EXPECT_FALSE(PwrMgr_Sched_WindowOpen(&early, at(14, 5, 0)));
+    EXPECT_TRUE(PwrMgr_Sched_WindowOpen(&allDay, at(14, 3, 0)));
+
+    // Overlapping windows shed the components of both
+    EXPECT_EQ(0x3u, PwrMgr_Sched_ShedAt(both, 2, at(15, 1, 30)));
+    EXPECT_EQ(0x2u, PwrMgr_Sched_ShedAt(both, 2, at(15, 3, 0)));
+    EXPECT_EQ(0u, PwrMgr_Sched_ShedAt(both, 2, at(15, 12, 0)));
+}
+
+TEST_F(SchedTest, EachEdgeChangesWhatIsShed)
+{
+    PWRMGR_EcoWindow windows[] = {{60, 5 * 60, 0x3}, {23 * 60, 2 * 60, 0x4}};
+
+    ASSERT_EQ(0, PwrMgr_Sched_Set(&sched, windows, 2, at(14, 22, 0)));
+    EXPECT_TRUE(changes.empty());
+    EXPECT_EQ(0u, sched.shed);
+
+    // The next edge is the night window opening at 23:00
+    EXPECT_EQ(3600, PwrMgr_Sched_Run(&sched, at(14, 22, 0)));
+    EXPECT_EQ(2 * 3600, PwrMgr_Sched_Run(&sched, at(14, 23, 0)));
+    EXPECT_EQ(0x4u, sched.shed);
+    EXPECT_EQ(3600, PwrMgr_Sched_Run(&sched, at(15, 1, 0)));
+    EXPECT_EQ(0x7u, sched.shed);
+    EXPECT_EQ(3 * 3600, PwrMgr_Sched_Run(&sched, at(15, 2, 0)));
+    EXPECT_EQ(0x3u, sched.shed);
+    EXPECT_EQ(18 * 3600, PwrMgr_Sched_Run(&sched, at(15, 5, 0)));
+
+    EXPECT_EQ((std::vector<PWRMGR_CompMask>{0x4, 0x7, 0x3, 0x0}), changes);
+    EXPECT_EQ(4u, sched.fired);
+}
+
+TEST_F(SchedTest, MissedEdgesAndNewWindowsFollowTheClock)
+{
+    PWRMGR_EcoWindow windows[] = {{60, 5 * 60, 0x3}};
+    PWRMGR_EcoWindow tooMany[PWRMGR_SCHED_MAX_WINDOWS + 1] = {};
+    PWRMGR_EcoWindow outOfRange[] = {{60, PWRMGR_SCHED_DAY_MIN, 0x1}};
+    struct itimerspec its;
+
+    // The timer runs on the real clock, the next edge is less than a day away
+    ASSERT_EQ(0, PwrMgr_Sched_Set(&sched, windows, 1, time(NULL)));
+    ASSERT_EQ(0, timerfd_gettime(PwrMgr_Sched_Fd(&sched), &its));
+    EXPECT_GT(its.it_value.tv_sec + its.it_value.tv_nsec, 0);
+    EXPECT_LE(its.it_value.tv_sec, 24 * 3600);
+    ASSERT_EQ(0, PwrMgr_Sched_Set(&sched, windows, 0, at(14, 12, 0)));
+    changes.clear();
+
+    // Set in the middle of the window, a restart at 03:00 does not bring them back
+    ASSERT_EQ(0, PwrMgr_Sched_Set(&sched, windows, 1, at(14, 3, 0)));
+    EXPECT_EQ((std::vector<PWRMGR_CompMask>{0x3}), changes);
+
+    // A clock jumping a day ahead lands outside the window
+    PwrMgr_Sched_Run(&sched, at(15, 12, 0));
+    EXPECT_EQ(0u, sched.shed);
+
+    EXPECT_EQ(-1, PwrMgr_Sched_Set(&sched, tooMany, PWRMGR_SCHED_MAX_WINDOWS + 1, at(15, 12, 0)));
+    EXPECT_EQ(-1, PwrMgr_Sched_Set(&sched, outOfRange, 1, at(15, 12, 0)));
+
+    // Without windows nothing is shed and the timer is disarmed
+    ASSERT_EQ(0, PwrMgr_Sched_Set(&sched, windows, 0, at(15, 12, 0)));
+    EXPECT_EQ(-1, PwrMgr_Sched_Run(&sched, at(15, 12, 0)));
+    ASSERT_EQ(0, timerfd_gettime(PwrMgr_Sched_Fd(&sched), &its));
+    EXPECT_EQ(0, its.it_value.tv_sec);
+    EXPECT_EQ(0, its.it_value.tv_nsec);
+}
@@ -0,0 +1,195 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "pwrMgr_sim.h"
+
+class SimTest : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        PwrMgr_Sim_DefaultPolicy(&policy);
+        ASSERT_EQ(0, PwrMgr_Sim_SetOption(&policy, "PwrMgrSimStopMs", "1000"));
+        ASSERT_EQ(0, PwrMgr_Sim_SetOption(&policy, "PwrMgrSimStartMs", "3000"));
+        ASSERT_EQ(0, PwrMgr_Sim_SetOption(&policy, "PwrMgrFreezeMode", "false"));
+    }
+
+    int comp(const char *name)
+    {
+        return PwrMgr_CompGraph_Find(&policy.power.graph, name);
+    }
+
+    int replay(std::vector<std::string> lines)
+    {
+        PwrMgr_Sim_Init(&sim, &policy, PWRMGR_STATE_AC, 0);
+        for (std::string &line : lines) {
+            if (PwrMgr_Sim_ReplayLine(&sim, &line[0]) < 0)
+                return -1;
+        }
+        PwrMgr_Sim_Finish(&sim, &report);
+        return 0;
+    }
+
+    PWRMGR_SimPolicy policy;
+    PWRMGR_Sim sim;
+    PWRMGR_SimReport report;
+};
+
+TEST_F(SimTest, ShedAndRestoreTakeTheModelledTime)
+{
+    // ThermalHot sheds harvester, lmlite and moca in parallel, ThermalCooled
+    // waits out its 5 s hysteresis and starts them again
+    ASSERT_EQ(0, replay({ "0 trans POWER_TRANS_HOT", "100000 trans POWER_TRANS_COOLED" }));
+
+    EXPECT_EQ(2u, report.transitions);
+    EXPECT_EQ(0u, report.preempted);
+    EXPECT_EQ(108000, report.durationMs);
+    EXPECT_EQ(1000, report.timeInStateMs[PWRMGR_STATE_AC]);
+    EXPECT_EQ(107000, report.timeInStateMs[PWRMGR_STATE_HOT]);
+    EXPECT_EQ(107000, report.degradedMs);
+    EXPECT_EQ(4000, report.transitionMs);
+    EXPECT_EQ(108000, report.downtimeMs[comp("harvester")]);
+    EXPECT_EQ(108000, report.downtimeMs[comp("moca")]);
+    EXPECT_EQ(0, report.downtimeMs[comp("wifi")]);
+    EXPECT_EQ(3 * 108000, report.totalDowntimeMs);
+}
+
+TEST_F(SimTest, FlapInsideHysteresisIsCoalesced)
+{
+    ASSERT_EQ(0, replay({ "0 trans POWER_TRANS_WARM", "1000 trans POWER_TRANS_COOLED", "1500 trans POWER_TRANS_COOLED" }));
+
+    EXPECT_EQ(3u, report.requests);
+    EXPECT_EQ(0u, report.transitions);
+    EXPECT_EQ(2u, report.suppressed);
+    EXPECT_EQ(0, report.totalDowntimeMs);
+    EXPECT_EQ(1500, report.timeInStateMs[PWRMGR_STATE_AC]);
+}
+
+TEST_F(SimTest, SupplyRequestDoesNotRestoreThermalShedding)
+{
+    // Already on AC, so AC changes nothing while the box is still hot
+    ASSERT_EQ(0, replay({ "0 trans POWER_TRANS_HOT", "60000 trans POWER_TRANS_AC" }));
+
+    EXPECT_EQ(1u, report.transitions);
+    EXPECT_EQ(1u, report.suppressed);
+    EXPECT_EQ(PWRMGR_STATE_HOT, sim.state);
+    EXPECT_EQ(60000, report.downtimeMs[comp("moca")]);
+}
+
+TEST_F(SimTest, NewerRequestPreemptsAndOnlyFinishesSubmittedJobs)
+{
+    // ThermalCritical stops wifi once harvester and lmlite are down at 1 s.
+    // ThermalHot at 0.5 s waits for the 30 s dwell but cancels the run, wifi
+    // is never submitted and ThermalHot has nothing left to do.
+    ASSERT_EQ(0, replay({ "0 trans POWER_TRANS_CRITICAL", "500 trans POWER_TRANS_HOT" }));
+
+    EXPECT_EQ(1u, report.preempted);
+    EXPECT_EQ(1u, report.transitions);
+    EXPECT_EQ(PWRMGR_STATE_HOT, sim.state);
+    EXPECT_EQ(0, report.downtimeMs[comp("wifi")]);
+    EXPECT_EQ(30000, report.downtimeMs[comp("moca")]);
+    EXPECT_EQ(30000, report.durationMs);
+}
+
+TEST_F(SimTest, FrozenComponentsThawUntilTheirDwellRunsOut)
+{
+    ASSERT_EQ(0, PwrMgr_Sim_SetOption(&policy, "PwrMgrFreezeMode", "true"));
+
+    ASSERT_EQ(0, replay({ "0 trans POWER_TRANS_HOT", "100000 trans POWER_TRANS_COOLED" }));
+    // Frozen in 50 ms and thawed in 50 ms at 105 s
+    EXPECT_EQ(105050, report.downtimeMs[comp("moca")]);
+
+    ASSERT_EQ(0, replay({ "0 trans POWER_TRANS_HOT", "400000 trans POWER_TRANS_COOLED" }));
+    // Stopped once frozen for 300 s, a full start at 405 s
+    EXPECT_EQ(408000, report.downtimeMs[comp("moca")]);
+}
+
+TEST_F(SimTest, TemperaturesFollowTheTripPoints)
+{
+    ASSERT_EQ(0, PwrMgr_Sim_SetOption(&policy, "PwrMgrThermalOnMilliC_ThermalHot", "90000"));
+    // Hot at 91 C now, still hot above 88 C, warm below it
+    ASSERT_EQ(0, replay({ "0 temp 91000", "10000 temp 89000", "20000 temp 87000", "30000 temp 87000" }));
+
+    EXPECT_EQ(4u, report.events);
+    EXPECT_EQ(2u, report.requests);
+    EXPECT_EQ(2u, report.transitions);
+    EXPECT_EQ(PWRMGR_STATE_WARM, sim.state);
+}
+
+TEST_F(SimTest, FollowsThePowerPolicy)
+{
+    // A device without a critical state that keeps MoCA up when hot
+    policy.power.enabled[PWRMGR_STATE_CRITICAL] = false;
+    policy.power.shed[PWRMGR_STATE_HOT] = PWRMGR_COMP_BIT(comp("harvester")) | PWRMGR_COMP_BIT(comp("lmlite"));
+    policy.power.shedSet[PWRMGR_STATE_HOT] = true;
+    ASSERT_EQ(0, PwrMgr_Policy_Compile(&policy.power));
+
+    ASSERT_EQ(0, replay({ "0 trans POWER_TRANS_HOT", "60000 trans POWER_TRANS_CRITICAL" }));
+    EXPECT_EQ(1u, report.rejected);
+    EXPECT_EQ(PWRMGR_STATE_HOT, sim.state);
+    EXPECT_EQ(0, report.downtimeMs[comp("moca")]);
+    EXPECT_GT(report.downtimeMs[comp("harvester")], 0);
+}
+
+TEST_F(SimTest, RejectsMalformedTraces)
+{
+    std::vector<std::string> bad = { "x temp 1", "10 temp", "10 temp 1 2", "10 volts 5", "10 trans POWER_TRANS_NOPE" };
+    std::string comment = "  # just a comment";
+    std::string later = "20 temp 50000";
+    std::string earlier = "10 temp 50000";
+
+    PwrMgr_Sim_Init(&sim, &policy, PWRMGR_STATE_AC, 0);
+    for (std::string &line : bad)
+        EXPECT_EQ(-1, PwrMgr_Sim_ReplayLine(&sim, &line[0])) << line;
+    EXPECT_EQ(1, PwrMgr_Sim_ReplayLine(&sim, &comment[0]));
+    EXPECT_EQ(0, PwrMgr_Sim_ReplayLine(&sim, &later[0]));
+    EXPECT_EQ(-1, PwrMgr_Sim_ReplayLine(&sim, &earlier[0]));
+
+    EXPECT_EQ(-1, PwrMgr_Sim_SetOption(&policy, "PwrMgrHysteresisMs_Nowhere", "1"));
+    EXPECT_EQ(-1, PwrMgr_Sim_SetOption(&policy, "PwrMgrSimStopMs_nothing", "1"));
+    EXPECT_EQ(-1, PwrMgr_Sim_SetOption(&policy, "PwrMgrSimStopMs", "soon"));
+    EXPECT_EQ(0, PwrMgr_Sim_SetOption(&policy, "PwrMgrSimStopMs_wifi", "7000"));
+    EXPECT_EQ(7000, policy.cost[comp("wifi")].stopMs);
+}
+
+TEST_F(SimTest, ReplaysAWeekQuickly)
+{
+    const long weekMs = 7L * 24 * 3600 * 1000;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    long elapsedMs;
+
+    PwrMgr_Sim_Init(&sim, &policy, PWRMGR_STATE_AC, -1);
+    // A sample every 10 s, hot for a while every afternoon
+    for (long t = 0; t < weekMs; t += 10000) {
+        long hour = (t / 3600000) % 24;
+        ASSERT_EQ(0, PwrMgr_Sim_Temperature(&sim, t, (hour >= 14 && hour < 16) ? 96000 : 70000));
+    }
+    PwrMgr_Sim_Finish(&sim, &report);
+    elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    // Hot, then warm for one sample on the way down, then cooled, every day
+    EXPECT_EQ(21u, report.transitions);
+    EXPECT_GE(report.durationMs, weekMs - 10000);
+    EXPECT_NEAR(7 * 2 * 3600000L, report.timeInStateMs[PWRMGR_STATE_HOT], 7 * 60000L);
+    EXPECT_LT(elapsedMs, 2000);
+}
@@ -0,0 +1,99 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "gtest/gtest.h"
+#include "pwrMgr_stats.h"
+#include "MockUnitCtl.h"
+
+TEST(Stats, HistogramBuckets)
+{
+    PWRMGR_Histogram hist = {};
+
+    PwrMgr_Hist_Record(&hist, 500);        // <= 1 ms
+    PwrMgr_Hist_Record(&hist, 1000);       // <= 1 ms, bounds are inclusive
+    PwrMgr_Hist_Record(&hist, 1001);       // <= 2 ms
+    PwrMgr_Hist_Record(&hist, 90000000);   // overflow
+
+    EXPECT_EQ(4u, hist.count);
+    EXPECT_EQ(2u, hist.buckets[0]);
+    EXPECT_EQ(1u, hist.buckets[1]);
+    EXPECT_EQ(1u, hist.buckets[PWRMGR_HIST_BUCKETS - 1]);
+    EXPECT_EQ(90000000u, hist.maxUs);
+    EXPECT_EQ(500u + 1000u + 1001u + 90000000u, hist.sumUs);
+}
+
+TEST(Stats, Percentiles)
+{
+    PWRMGR_Histogram hist = {};
+
+    EXPECT_EQ(0u, PwrMgr_Hist_Percentile(&hist, 50));
+    for (int i = 0; i < 98; i++)
+        PwrMgr_Hist_Record(&hist, 3000);   // <= 5 ms
+    PwrMgr_Hist_Record(&hist, 150000);     // <= 200 ms
+    PwrMgr_Hist_Record(&hist, 150000);
+
+    EXPECT_EQ(5000u, PwrMgr_Hist_Percentile(&hist, 50));
+    EXPECT_EQ(5000u, PwrMgr_Hist_Percentile(&hist, 98));
+    // Capped at the largest sample rather than the bucket bound
+    EXPECT_EQ(150000u, PwrMgr_Hist_Percentile(&hist, 99));
+    EXPECT_EQ(150000u, PwrMgr_Hist_Percentile(&hist, 100));
+}
+
+TEST(Stats, ComponentLatencyRecordedByGraphRun)
+{
+    PWRMGR_CompGraph graph;
+    MockUnitCtl mock;
+    PWRMGR_Stats stats;
+    const char *names[PWRMGR_STATE_TOTAL];
+    const char *path = "/tmp/rdkbPowerMgr_stats_test";
+
+    PwrMgr_Stats_Reset();
+    PwrMgr_CompGraph_LoadDefaults(&graph);
+    mock.setDefaultLatency(5);
+    mock.setLatency("ccspwifiagent.service", 30);
+    ASSERT_EQ(0, PwrMgr_CompGraph_Run(&graph, mock.ctl(), PWRMGR_UNIT_STOP, PwrMgr_CompGraph_AllMask(&graph), 1000,
+                                      NULL, NULL, NULL, NULL));
+
+    PwrMgr_Stats_Get(&stats);
+    int wifi = PwrMgr_CompGraph_Find(&graph, "wifi");
+    ASSERT_GE(wifi, 0);
+    for (int i = 0; i < graph.count; i++) {
+        EXPECT_EQ(1u, stats.component[i][PWRMGR_UNIT_STOP].count);
+        EXPECT_EQ(0u, stats.component[i][PWRMGR_UNIT_START].count);
+    }
+    EXPECT_GE(stats.component[wifi][PWRMGR_UNIT_STOP].maxUs, 30000u);
+
+    PwrMgr_Stats_RecordEdge(PWRMGR_STATE_AC, PWRMGR_STATE_HOT, 42000);
+    for (int i = 0; i < PWRMGR_STATE_TOTAL; i++)
+        names[i] = "S";
+    names[PWRMGR_STATE_AC] = "AC";
+    names[PWRMGR_STATE_HOT] = "ThermalHot";
+    ASSERT_EQ(0, PwrMgr_Stats_WriteFile(path, names, &graph));
+
+    std::ifstream in(path);
+    std::stringstream dump;
+    dump << in.rdbuf();
+    EXPECT_NE(std::string::npos, dump.str().find("edge AC->ThermalHot count=1 sum_us=42000"));
+    EXPECT_NE(std::string::npos, dump.str().find("component wifi:stop count=1"));
+    EXPECT_EQ(std::string::npos, dump.str().find(":start"));
+    remove(path);
+}
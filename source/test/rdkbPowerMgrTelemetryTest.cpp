@@ -0,0 +1,113 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include "gtest/gtest.h"
+#include "pwrMgr_telemetry.h"
+
+class TelemetryTest : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        const char *names[] = { "Unknown", "AC", "ThermalHot" };
+
+        name = "/pwrMgrTelemetryTest." + std::to_string(getpid());
+        ASSERT_EQ(0, PwrMgr_Telemetry_Open(&writer, name.c_str(), names, 3));
+        shm = PwrMgr_Telemetry_Attach(name.c_str());
+        ASSERT_NE(nullptr, shm);
+    }
+
+    void TearDown()
+    {
+        PwrMgr_Telemetry_Detach(shm);
+        PwrMgr_Telemetry_Close(&writer);
+        shm_unlink(name.c_str());
+    }
+
+    std::string name;
+    PWRMGR_TelemetryWriter writer;
+    const PWRMGR_Telemetry *shm;
+};
+
+TEST_F(TelemetryTest, AccountsTimeAndEnergy)
+{
+    PWRMGR_Telemetry t;
+
+    ASSERT_EQ(0, PwrMgr_Telemetry_Read(shm, &t));
+    EXPECT_EQ(PWRMGR_TELEMETRY_VERSION, t.version);
+    EXPECT_EQ(sizeof(PWRMGR_Telemetry), t.size);
+    EXPECT_EQ((uint32_t)getpid(), t.pid);
+    EXPECT_STREQ("ThermalHot", t.stateNames[2]);
+    EXPECT_EQ(-1, t.state);
+
+    PwrMgr_Telemetry_Update(&writer, 1, 1, 0xF, 0, 1000);
+    PwrMgr_Telemetry_Update(&writer, 1, 2, 0x3, 600, 1100);
+    PwrMgr_Telemetry_Update(&writer, 2, 2, 0x0, 1000, 1150);
+    PwrMgr_Telemetry_Update(&writer, 2, 2, 0x0, 1000, 1350);
+    PwrMgr_Telemetry_SetLatency(&writer, 4321);
+
+    ASSERT_EQ(0, PwrMgr_Telemetry_Read(shm, &t));
+    EXPECT_EQ(2, t.state);
+    EXPECT_EQ(0u, t.running);
+    EXPECT_EQ(150u, t.timeInStateMs[1]);
+    EXPECT_EQ(200u, t.timeInStateMs[2]);
+    EXPECT_EQ(1u, t.entries[1]);
+    EXPECT_EQ(1u, t.entries[2]);
+    EXPECT_EQ(1u, t.transitions);
+    EXPECT_EQ(1150u, t.stateSinceMs);
+    EXPECT_EQ(1350u, t.updatedMs);
+    // 600 mW for 50 ms, then 1000 mW for 200 ms
+    EXPECT_EQ(30000u + 200000u, t.energySavedUj);
+    EXPECT_EQ(4321u, t.lastLatencyUs);
+}
+
+TEST_F(TelemetryTest, ReadersNeverSeeTornUpdates)
+{
+    std::atomic<bool> done(false);
+    unsigned long reads = 0;
+
+    // Every update keeps running and savingMw equal
+    std::thread writerThread([&]() {
+        for (uint32_t i = 1; i <= 200000; i++)
+            PwrMgr_Telemetry_Update(&writer, 1 + (i & 1), 1, i, i, i);
+        done = true;
+    });
+    while (!done)
+    {
+        PWRMGR_Telemetry t;
+
+        if (PwrMgr_Telemetry_Read(shm, &t) != 0)
+            continue;
+        ASSERT_EQ(t.running, t.savingMw);
+        ASSERT_EQ(t.running, t.updatedMs);
+        reads++;
+    }
+    writerThread.join();
+    EXPECT_GT(reads, 0u);
+}
+
+TEST(Telemetry, AttachWithoutDaemon)
+{
+    EXPECT_EQ(nullptr, PwrMgr_Telemetry_Attach("/pwrMgrTelemetryTest.missing"));
+}
@@ -0,0 +1,211 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <chrono>
+#include <condition_variable>
+#include <fcntl.h>
+#include <fstream>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "gtest/gtest.h"
+#include "pwrMgr_loop.h"
+#include "pwrMgr_thermal.h"
+
+// Fake /sys/class/thermal tree in a temporary directory
+class ThermalTest : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        char tmpl[] = "/tmp/pwrMgrThermalXXXXXX";
+        ASSERT_TRUE(mkdtemp(tmpl) != NULL);
+        root = tmpl;
+        addZone(0, 40000);
+        addZone(1, 45000);
+
+        PwrMgr_Thermal_DefaultConfig(&cfg);
+        snprintf(cfg.root, sizeof(cfg.root), "%s", root.c_str());
+        cfg.slowMs = 200;
+        cfg.fastMs = 10;
+    }
+
+    void TearDown()
+    {
+        PwrMgr_Thermal_Close(&mon);
+        for (int i = 0; i < zones; i++)
+        {
+            std::string dir = root + "/thermal_zone" + std::to_string(i);
+            unlink((dir + "/temp").c_str());
+            rmdir(dir.c_str());
+        }
+        rmdir(root.c_str());
+    }
+
+    void addZone(int index, int milliC)
+    {
+        mkdir((root + "/thermal_zone" + std::to_string(index)).c_str(), 0755);
+        setTemp(index, milliC);
+        zones = index + 1;
+    }
+
+    // Rewrite in place with one write so the sampling thread never sees an empty file
+    void setTemp(int index, int milliC)
+    {
+        std::string text = std::to_string(milliC) + "\n";
+        int fd = open((root + "/thermal_zone" + std::to_string(index) + "/temp").c_str(), O_WRONLY | O_CREAT, 0644);
+        ASSERT_GE(fd, 0);
+        EXPECT_EQ((ssize_t)text.size(), pwrite(fd, text.data(), text.size(), 0));
+        EXPECT_EQ(0, ftruncate(fd, text.size()));
+        close(fd);
+    }
+
+    static void notify(void *ctx, PWRMGR_PwrState state, int milliC)
+    {
+        ThermalTest *self = static_cast<ThermalTest *>(ctx);
+        (void)milliC;
+        std::lock_guard<std::mutex> guard(self->lock);
+        self->requested.push_back(state);
+        self->changed.notify_all();
+    }
+
+    bool waitFor(size_t count, int timeoutMs)
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        return changed.wait_for(guard, std::chrono::milliseconds(timeoutMs), [&] { return requested.size() >= count; });
+    }
+
+    std::string root;
+    int zones = 0;
+    PWRMGR_ThermalConfig cfg;
+    PWRMGR_ThermalMonitor mon;
+    std::mutex lock;
+    std::condition_variable changed;
+    std::vector<PWRMGR_PwrState> requested;
+};
+
+TEST_F(ThermalTest, TripWithHysteresisAndAdaptiveRate)
+{
+    ASSERT_EQ(0, PwrMgr_Thermal_Open(&mon, &cfg, notify, this));
+    EXPECT_EQ(2, mon.zoneCount);
+
+    // Cool: no request, slow sampling
+    EXPECT_EQ(cfg.slowMs, PwrMgr_Thermal_Sample(&mon));
+    EXPECT_TRUE(requested.empty());
+
+    // Within the margin of the first trip: sample fast
+    setTemp(1, 81000);
+    EXPECT_EQ(cfg.fastMs, PwrMgr_Thermal_Sample(&mon));
+    EXPECT_TRUE(requested.empty());
+
+    // The hottest zone decides, heating up skips WARM
+    setTemp(1, 96000);
+    PwrMgr_Thermal_Sample(&mon);
+    ASSERT_EQ(1u, requested.size());
+    EXPECT_EQ(PWRMGR_STATE_HOT, requested[0]);
+
+    // Between the off and on temperatures nothing changes
+    setTemp(1, 90000);
+    EXPECT_EQ(cfg.fastMs, PwrMgr_Thermal_Sample(&mon));
+    EXPECT_EQ(1u, requested.size());
+
+    // Cooling down restores one level per sample
+    setTemp(1, 70000);
+    PwrMgr_Thermal_Sample(&mon);
+    PwrMgr_Thermal_Sample(&mon);
+    ASSERT_EQ(3u, requested.size());
+    EXPECT_EQ(PWRMGR_STATE_WARM, requested[1]);
+    EXPECT_EQ(PWRMGR_STATE_COOLED, requested[2]);
+    EXPECT_EQ(cfg.slowMs, PwrMgr_Thermal_Sample(&mon));
+}
+
+TEST_F(ThermalTest, GradedLevels)
+{
+    ASSERT_EQ(0, PwrMgr_Thermal_Open(&mon, &cfg, notify, this));
+
+    setTemp(0, 86000);
+    PwrMgr_Thermal_Sample(&mon);
+    setTemp(0, 95000);
+    PwrMgr_Thermal_Sample(&mon);
+    setTemp(0, 106000);
+    PwrMgr_Thermal_Sample(&mon);
+    setTemp(0, 97000);
+    PwrMgr_Thermal_Sample(&mon);
+
+    std::vector<PWRMGR_PwrState> expected = { PWRMGR_STATE_WARM, PWRMGR_STATE_HOT, PWRMGR_STATE_CRITICAL, PWRMGR_STATE_HOT };
+    EXPECT_EQ(expected, requested);
+    EXPECT_EQ(2, mon.level);
+}
+
+TEST_F(ThermalTest, UnreadableZoneIsSkipped)
+{
+    ASSERT_EQ(0, PwrMgr_Thermal_Open(&mon, &cfg, notify, this));
+    std::ofstream(root + "/thermal_zone0/temp") << "garbage\n";
+    setTemp(1, 97000);
+    PwrMgr_Thermal_Sample(&mon);
+    ASSERT_EQ(1u, requested.size());
+    EXPECT_EQ(97000, mon.lastMilliC);
+}
+
+TEST_F(ThermalTest, NoZonesFailsToOpen)
+{
+    snprintf(cfg.root, sizeof(cfg.root), "%s/missing", root.c_str());
+    EXPECT_EQ(-1, PwrMgr_Thermal_Open(&mon, &cfg, notify, this));
+}
+
+static void dispatch(void *arg, int fd, uint32_t events)
+{
+    (void)fd;
+    (void)events;
+    PwrMgr_Thermal_Dispatch(static_cast<PWRMGR_ThermalMonitor *>(arg));
+}
+
+// Reaction latency benchmark: time from the zone crossing the trip to the request
+TEST_F(ThermalTest, ReactionLatency)
+{
+    PWRMGR_Loop loop;
+
+    ASSERT_EQ(0, PwrMgr_Thermal_Open(&mon, &cfg, notify, this));
+    // Sampled on an event loop like the daemon's
+    ASSERT_EQ(0, PwrMgr_Loop_Init(&loop));
+    ASSERT_EQ(0, PwrMgr_Loop_Add(&loop, PwrMgr_Thermal_Fd(&mon), dispatch, &mon));
+    std::thread thread(PwrMgr_Loop_Run, &loop);
+
+    // Approach the first trip so the monitor switches to fast sampling
+    setTemp(0, 82000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(cfg.slowMs + 50));
+    EXPECT_EQ(cfg.fastMs, mon.intervalMs);
+
+    auto start = std::chrono::steady_clock::now();
+    setTemp(0, 99000);
+    ASSERT_TRUE(waitFor(1, 1000));
+    long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_EQ(PWRMGR_STATE_HOT, requested[0]);
+    EXPECT_LE(elapsed, cfg.fastMs * 5);
+    printf("thermal-reaction-latency: %ld ms (fast sampling every %d ms)\n", elapsed, cfg.fastMs);
+
+    PwrMgr_Loop_Quit(&loop);
+    thread.join();
+    PwrMgr_Loop_Close(&loop);
+}
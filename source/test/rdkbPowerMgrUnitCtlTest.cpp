@@ -0,0 +1,150 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include "gtest/gtest.h"
+#include "FakeSystemctl.h"
+#include "MockUnitCtl.h"
+
+static const char *shedUnits[] = { "harvester.service", "CcspLMLite.service",
+                                   "ccspwifiagent.service", "CcspMoca.service" };
+
+TEST(UnitCtl, BatchRunsConcurrently)
+{
+    MockUnitCtl mock;
+    PWRMGR_UnitJobResult results[4];
+
+    mock.setDefaultLatency(60);
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(0, PwrMgr_UnitCtl_RunBatch(mock.ctl(), PWRMGR_UNIT_STOP, shedUnits, 4, 1000, results));
+    long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    // Serial systemctl calls would take 4 x 60ms
+    EXPECT_GE(elapsed, 60);
+    EXPECT_LT(elapsed, 180);
+    for (int i = 0; i < 4; i++)
+        EXPECT_EQ(PWRMGR_UNIT_JOB_DONE, results[i]);
+    printf("transition latency with mock bus: %ld ms (serial would be 240 ms)\n", elapsed);
+}
+
+TEST(UnitCtl, FailedJobIsReported)
+{
+    MockUnitCtl mock;
+    PWRMGR_UnitJobResult results[4];
+
+    mock.setFailure("ccspwifiagent.service");
+    EXPECT_EQ(-1, PwrMgr_UnitCtl_RunBatch(mock.ctl(), PWRMGR_UNIT_START, shedUnits, 4, 1000, results));
+    EXPECT_EQ(PWRMGR_UNIT_JOB_DONE, results[0]);
+    EXPECT_EQ(PWRMGR_UNIT_JOB_FAILED, results[2]);
+    EXPECT_EQ("start CcspMoca.service", mock.history()[3]);
+}
+
+TEST(UnitCtl, HungJobTimesOut)
+{
+    MockUnitCtl mock;
+    PWRMGR_UnitJobResult results[4];
+
+    mock.setHang("CcspMoca.service");
+    EXPECT_EQ(-1, PwrMgr_UnitCtl_RunBatch(mock.ctl(), PWRMGR_UNIT_STOP, shedUnits, 4, 50, results));
+    EXPECT_EQ(PWRMGR_UNIT_JOB_DONE, results[1]);
+    EXPECT_EQ(PWRMGR_UNIT_JOB_TIMEOUT, results[3]);
+    EXPECT_EQ(0u, mock.pendingCount());
+}
+
+TEST(UnitCtl, TimedOutJobIsNotCreditedToTheNextBatch)
+{
+    MockUnitCtl mock;
+    PWRMGR_UnitJobResult results[1];
+    const char *lmlite[] = { "CcspLMLite.service" };
+    const char *wifi[] = { "ccspwifiagent.service" };
+
+    mock.setLatency("CcspLMLite.service", 100);
+    EXPECT_EQ(-1, PwrMgr_UnitCtl_RunBatch(mock.ctl(), PWRMGR_UNIT_STOP, lmlite, 1, 30, results));
+    EXPECT_EQ(PWRMGR_UNIT_JOB_TIMEOUT, results[0]);
+
+    // The abandoned job would finish first as job 0 and hide this failure
+    mock.setLatency("ccspwifiagent.service", 200);
+    mock.setFailure("ccspwifiagent.service");
+    EXPECT_EQ(-1, PwrMgr_UnitCtl_RunBatch(mock.ctl(), PWRMGR_UNIT_START, wifi, 1, 1000, results));
+    EXPECT_EQ(PWRMGR_UNIT_JOB_FAILED, results[0]);
+}
+
+TEST(UnitCtl, SystemctlTouchesOnlyTheGivenUnits)
+{
+    FakeSystemctl systemctl;
+    PWRMGR_UnitCtl ctl;
+    PWRMGR_UnitJobResult results[2];
+
+    ASSERT_EQ(0, PwrMgr_UnitCtl_OpenSystemctl(&ctl, systemctl.path()));
+    EXPECT_EQ(0, PwrMgr_UnitCtl_RunBatch(&ctl, PWRMGR_UNIT_STOP, shedUnits, 2, 1000, results));
+    EXPECT_EQ(PWRMGR_UNIT_JOB_DONE, results[1]);
+    EXPECT_EQ(1, PwrMgr_UnitCtl_IsActive(&ctl, "ccspwifiagent.service"));
+    PwrMgr_UnitCtl_Close(&ctl);
+
+    std::vector<std::string> commands = systemctl.commands();
+    std::sort(commands.begin(), commands.begin() + 2);
+    std::vector<std::string> expected = { "systemctl stop CcspLMLite.service", "systemctl stop harvester.service",
+                                          "systemctl is-active --quiet ccspwifiagent.service" };
+    EXPECT_EQ(expected, commands);
+}
+
+TEST(UnitCtl, SystemctlRunsTheBatchConcurrently)
+{
+    FakeSystemctl systemctl;
+    PWRMGR_UnitCtl ctl;
+    PWRMGR_UnitJobResult results[4];
+
+    for (int i = 0; i < 4; i++)
+        systemctl.setDelay(shedUnits[i], 200);
+    systemctl.setFailing("CcspMoca.service");
+    ASSERT_EQ(0, PwrMgr_UnitCtl_OpenSystemctl(&ctl, systemctl.path()));
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(-1, PwrMgr_UnitCtl_RunBatch(&ctl, PWRMGR_UNIT_STOP, shedUnits, 4, 2000, results));
+    long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    PwrMgr_UnitCtl_Close(&ctl);
+
+    // One systemctl after the other would take 800 ms
+    EXPECT_GE(elapsed, 200);
+    EXPECT_LT(elapsed, 600);
+    EXPECT_EQ(PWRMGR_UNIT_JOB_DONE, results[0]);
+    EXPECT_EQ(PWRMGR_UNIT_JOB_FAILED, results[3]);
+}
+
+TEST(UnitCtl, SystemctlGivesUpOnAHungJob)
+{
+    FakeSystemctl systemctl;
+    PWRMGR_UnitCtl ctl;
+    PWRMGR_UnitJobResult results[2];
+
+    systemctl.setDelay("CcspLMLite.service", -1);
+    ASSERT_EQ(0, PwrMgr_UnitCtl_OpenSystemctl(&ctl, systemctl.path()));
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(-1, PwrMgr_UnitCtl_RunBatch(&ctl, PWRMGR_UNIT_STOP, shedUnits, 2, 100, results));
+    long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    // The deadline holds and the child is killed rather than waited for
+    EXPECT_EQ(PWRMGR_UNIT_JOB_DONE, results[0]);
+    EXPECT_EQ(PWRMGR_UNIT_JOB_TIMEOUT, results[1]);
+    EXPECT_LT(elapsed, 500);
+    int jobId;
+    PWRMGR_UnitJobResult result;
+    EXPECT_EQ(-1, PwrMgr_UnitCtl_Wait(&ctl, 0, &jobId, &result));
+    PwrMgr_UnitCtl_Close(&ctl);
+}
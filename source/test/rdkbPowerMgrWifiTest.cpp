@@ -0,0 +1,181 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <string>
+#include "gtest/gtest.h"
+#include "WifiHalStub.h"
+#include "pwrMgr_wifi.h"
+
+// Tri-band gateway: 4x4 on 2.4 and 5 GHz, 2x2 on 6 GHz at 80 % power
+class WifiTest : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        char path[] = "/tmp/pwrMgrWifiXXXXXX";
+
+        ASSERT_EQ(0, close(mkstemp(path)));
+        baselinePath = path;
+        unlink(path);
+        stub.addRadio(PWRMGR_WIFI_BAND_2G, 4);
+        stub.addRadio(PWRMGR_WIFI_BAND_5G, 4);
+        stub.addRadio(PWRMGR_WIFI_BAND_6G, 2, 80);
+    }
+
+    void TearDown()
+    {
+        unlink(baselinePath.c_str());
+    }
+
+    void expectRadio(int i, bool enabled, int txPowerPercent, int streams)
+    {
+        PWRMGR_WifiRadio r = stub.radio(i);
+
+        EXPECT_EQ(enabled, r.enabled) << "radio " << i;
+        EXPECT_EQ(txPowerPercent, r.txPowerPercent) << "radio " << i;
+        EXPECT_EQ(streams, r.streams) << "radio " << i;
+    }
+
+    WifiHalStub stub;
+    std::string baselinePath;
+};
+
+TEST_F(WifiTest, DegradesInStepsAndRestores)
+{
+    PWRMGR_WifiActuator act;
+
+    ASSERT_EQ(0, PwrMgr_Wifi_Open(&act, stub.ops(), stub.ctx(), baselinePath.c_str()));
+    EXPECT_EQ(3, act.count);
+    EXPECT_EQ(0, PwrMgr_Wifi_Apply(&act, PWRMGR_STATE_AC));
+    expectRadio(0, true, 100, 4);
+    expectRadio(2, true, 80, 2);
+
+    // Power first, relative to the baseline of each radio
+    EXPECT_EQ(0, PwrMgr_Wifi_Apply(&act, PWRMGR_STATE_WARM));
+    expectRadio(0, true, 75, 4);
+    expectRadio(1, true, 75, 4);
+    expectRadio(2, true, 60, 2);
+
+    // Then streams, and 6 GHz goes off
+    EXPECT_EQ(0, PwrMgr_Wifi_Apply(&act, PWRMGR_STATE_HOT));
+    expectRadio(0, true, 50, 2);
+    expectRadio(1, true, 50, 2);
+    EXPECT_FALSE(stub.radio(2).enabled);
+
+    EXPECT_EQ(0, PwrMgr_Wifi_Apply(&act, PWRMGR_STATE_CRITICAL));
+    expectRadio(0, true, 25, 1);
+    EXPECT_FALSE(stub.radio(1).enabled);
+    EXPECT_FALSE(stub.radio(2).enabled);
+
+    EXPECT_EQ(0, PwrMgr_Wifi_Apply(&act, PWRMGR_STATE_COOLED));
+    expectRadio(0, true, 100, 4);
+    expectRadio(1, true, 100, 4);
+    expectRadio(2, true, 80, 2);
+
+    // Radios that already match are not touched
+    int writes = stub.writeCount();
+    EXPECT_EQ(0, PwrMgr_Wifi_Apply(&act, PWRMGR_STATE_AC));
+    EXPECT_EQ(writes, stub.writeCount());
+}
+
+TEST_F(WifiTest, NeverDisables24GHz)
+{
+    PWRMGR_WifiActuator act;
+    PWRMGR_WifiProfile off = { 0, 0, ~0u };
+    unsigned bands;
+
+    ASSERT_EQ(0, PwrMgr_Wifi_Open(&act, stub.ops(), stub.ctx(), baselinePath.c_str()));
+    PwrMgr_Wifi_SetProfile(&act, PWRMGR_STATE_WARM, &off);
+    EXPECT_EQ(0, PwrMgr_Wifi_Apply(&act, PWRMGR_STATE_WARM));
+    expectRadio(0, true, 100, 4);
+    EXPECT_FALSE(stub.radio(1).enabled);
+    EXPECT_FALSE(stub.radio(2).enabled);
+
+    EXPECT_EQ(0, PwrMgr_Wifi_ParseBands("5GHz,6GHz", &bands));
+    EXPECT_EQ(PWRMGR_WIFI_BAND_BIT(PWRMGR_WIFI_BAND_5G) | PWRMGR_WIFI_BAND_BIT(PWRMGR_WIFI_BAND_6G), bands);
+    EXPECT_EQ(0, PwrMgr_Wifi_ParseBands("6g", &bands));
+    EXPECT_EQ(PWRMGR_WIFI_BAND_BIT(PWRMGR_WIFI_BAND_6G), bands);
+    EXPECT_EQ(0, PwrMgr_Wifi_ParseBands("none", &bands));
+    EXPECT_EQ(0u, bands);
+    EXPECT_EQ(0, PwrMgr_Wifi_ParseBands("", &bands));
+    EXPECT_EQ(-1, PwrMgr_Wifi_ParseBands("2.4GHz", &bands));
+    EXPECT_EQ(-1, PwrMgr_Wifi_ParseBands("5GHz 7GHz", &bands));
+}
+
+TEST_F(WifiTest, RestartedDaemonKeepsTheBaseline)
+{
+    PWRMGR_WifiActuator act;
+
+    ASSERT_EQ(0, PwrMgr_Wifi_Open(&act, stub.ops(), stub.ctx(), baselinePath.c_str()));
+    EXPECT_EQ(0, PwrMgr_Wifi_Apply(&act, PWRMGR_STATE_HOT));
+
+    // The degraded radios are not mistaken for the baseline
+    ASSERT_EQ(0, PwrMgr_Wifi_Open(&act, stub.ops(), stub.ctx(), baselinePath.c_str()));
+    EXPECT_EQ(0, PwrMgr_Wifi_Apply(&act, PWRMGR_STATE_AC));
+    expectRadio(0, true, 100, 4);
+    expectRadio(1, true, 100, 4);
+    expectRadio(2, true, 80, 2);
+}
+
+TEST_F(WifiTest, ResetRewritesAfterAgentRestart)
+{
+    PWRMGR_WifiActuator act;
+
+    ASSERT_EQ(0, PwrMgr_Wifi_Open(&act, stub.ops(), stub.ctx(), baselinePath.c_str()));
+    EXPECT_EQ(0, PwrMgr_Wifi_Apply(&act, PWRMGR_STATE_HOT));
+    stub.restartAgent();
+    expectRadio(0, true, 100, 4);
+
+    PwrMgr_Wifi_Reset(&act);
+    EXPECT_EQ(0, PwrMgr_Wifi_Apply(&act, PWRMGR_STATE_HOT));
+    expectRadio(0, true, 50, 2);
+    EXPECT_FALSE(stub.radio(2).enabled);
+
+    // A radio that refuses does not keep the others back
+    stub.setFailing(1, true);
+    EXPECT_EQ(-1, PwrMgr_Wifi_Apply(&act, PWRMGR_STATE_WARM));
+    expectRadio(0, true, 75, 4);
+    expectRadio(1, true, 50, 2);
+    expectRadio(2, true, 60, 2);
+}
+
+TEST_F(WifiTest, MergesTheProfilesOfBothAxes)
+{
+    PWRMGR_WifiActuator act;
+    PWRMGR_WifiProfile supply = { 20, 0, PWRMGR_WIFI_BAND_BIT(PWRMGR_WIFI_BAND_5G) };
+    PWRMGR_PwrState states[] = { PWRMGR_STATE_WARM, PWRMGR_STATE_HOT };
+
+    ASSERT_EQ(0, PwrMgr_Wifi_Open(&act, stub.ops(), stub.ctx(), baselinePath.c_str()));
+    PwrMgr_Wifi_SetProfile(&act, PWRMGR_STATE_WARM, &supply);
+
+    // The power of one, the streams of the other and the bands of both
+    EXPECT_EQ(0, PwrMgr_Wifi_ApplyStates(&act, states, 2));
+    expectRadio(0, true, 20, 2);
+    EXPECT_FALSE(stub.radio(1).enabled);
+    EXPECT_FALSE(stub.radio(2).enabled);
+
+    int writes = stub.writeCount();
+    EXPECT_EQ(0, PwrMgr_Wifi_ApplyStates(&act, states, 2));
+    EXPECT_EQ(writes, stub.writeCount());
+
+    states[0] = PWRMGR_STATE_UNKNOWN;
+    EXPECT_EQ(-1, PwrMgr_Wifi_ApplyStates(&act, states, 2));
+}
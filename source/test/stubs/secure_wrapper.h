@@ -0,0 +1,35 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+// Test stand-in for secure_wrapper, see SyseventStub.cpp
+
+#ifndef _SECURE_WRAPPER_STUB_H_
+#define _SECURE_WRAPPER_STUB_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int v_secure_system(const char *format, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,52 @@
+/*
+* If not stated otherwise in this file or this component's LICENSE
+* file the following copyright and licenses apply:
+*
+* Copyright 2016 RDK Management
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*/
+
+// Test stand-in for the utopia sysevent client API, see SyseventStub.cpp
+
+#ifndef _SYSEVENT_STUB_SYSEVENT_H_
+#define _SYSEVENT_STUB_SYSEVENT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef unsigned int token_t;
+typedef struct
+{
+    unsigned int action_id;
+    unsigned int trigger_id;
+} async_id_t;
+
+#define SE_SERVER_WELL_KNOWN_PORT 52367
+#define SE_VERSION 1
+#define TUPLE_FLAG_EVENT 0x00000002
+
+int sysevent_open(char *ip, unsigned short port, int version, char *id, token_t *token);
+int sysevent_close(const int fd, const token_t token);
+int sysevent_set(const int fd, const token_t token, const char *name, const char *value, int value_length);
+int sysevent_get(const int fd, const token_t token, const char *inbuf, char *outbuf, int outbytes);
+int sysevent_setnotification(const int fd, const token_t token, char *name, async_id_t *async_id);
+int sysevent_getnotification(const int fd, const token_t token, char *namebuf, int *namelen, char *valbuf, int *vallen, async_id_t *async_id);
+int sysevent_set_options(const int fd, const token_t token, char *name, unsigned int flags);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif